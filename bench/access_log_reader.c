@@ -0,0 +1,301 @@
+/*
+ * access_log_reader.c
+ *
+ * Lettore del log binario degli accessi del server (opzione -a,
+ * server-project/src/access_log.h). I segmenti sono mappati in memoria e
+ * letti in sequenza, senza copie.
+ *
+ * Uso: access_log_reader [-c] segmento.wlog...
+ *   senza opzioni: riepilogo (richieste, frequenza, esiti, tempi di servizio,
+ *                  città più richieste)
+ *   -c:            un record per riga in CSV su stdout
+ *
+ * Compilazione:
+ *   gcc -O2 -Iserver-project/src -o access_log_reader bench/access_log_reader.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h>
+#include "access_log.h"
+
+#define LATENCY_BUCKETS 64              // Istogramma: 2 bucket per potenza di due di ns
+#define CITY_TABLE_SIZE 4096            // Potenza di due
+#define TOP_CITIES 10
+#define CSV_BUFFER_SIZE (1 << 20)
+
+static const char *kind_names[ACCESS_KIND_COUNT] = { "udp", "shm", "subscribe", "aggregate", "nearest" };
+static const char *status_names[] = { "ok", "not_found", "invalid", "busy" };
+
+typedef struct {
+	char name[64];
+	uint64_t count;
+} city_count_t;
+
+typedef struct {
+	uint64_t records;
+	uint64_t first_ns;
+	uint64_t last_ns;
+	uint64_t per_kind[ACCESS_KIND_COUNT];
+	uint64_t per_status[4];
+	uint64_t per_type[256];
+	uint64_t latency[LATENCY_BUCKETS];
+	uint64_t service_ns_total;
+	uint32_t service_ns_max;
+	city_count_t cities[CITY_TABLE_SIZE];
+	uint64_t cities_overflow;       // Record di città oltre la capienza della tabella
+} summary_t;
+
+/* Bucket logaritmico: esponente e mezzo passo per avere percentili entro ~30% */
+static int latency_bucket(uint32_t ns) {
+	if (ns < 2) {
+		return 0;
+	}
+	int log2 = 31 - __builtin_clz(ns);
+	int half = (ns >> (log2 - 1)) & 1;
+	int bucket = log2 * 2 + half;
+	return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/* Limite superiore (ns) del bucket */
+static double bucket_upper_ns(int bucket) {
+	int log2 = bucket / 2;
+	return (double)(1ull << log2) * (bucket % 2 ? 2.0 : 1.5);
+}
+
+static double latency_percentile(const summary_t *summary, double percentile) {
+	uint64_t target = (uint64_t)(summary->records * percentile);
+	uint64_t seen = 0;
+	int i;
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += summary->latency[i];
+		if (seen > target) {
+			break;
+		}
+	}
+	double bound = bucket_upper_ns(i < LATENCY_BUCKETS ? i : LATENCY_BUCKETS - 1);
+	return bound < summary->service_ns_max ? bound : summary->service_ns_max;
+}
+
+/* Tabella a indirizzamento aperto (FNV-1a) */
+static void count_city(summary_t *summary, const char *city) {
+	uint32_t hash = 2166136261u;
+	for (const char *p = city; *p; p++) {
+		hash = (hash ^ (uint8_t)*p) * 16777619u;
+	}
+	for (uint32_t probe = 0; probe < CITY_TABLE_SIZE; probe++) {
+		city_count_t *slot = &summary->cities[(hash + probe) & (CITY_TABLE_SIZE - 1)];
+		if (slot->count == 0) {
+			strncpy(slot->name, city, sizeof(slot->name) - 1);
+			slot->count = 1;
+			return;
+		}
+		if (strcmp(slot->name, city) == 0) {
+			slot->count++;
+			return;
+		}
+	}
+	summary->cities_overflow++;
+}
+
+static int compare_city_count(const void *a, const void *b) {
+	const city_count_t *x = (const city_count_t *)a;
+	const city_count_t *y = (const city_count_t *)b;
+	return x->count < y->count ? 1 : (x->count > y->count ? -1 : strcmp(x->name, y->name));
+}
+
+static void add_record(summary_t *summary, const access_record_t *record) {
+	if (summary->records == 0 || record->timestamp_ns < summary->first_ns) {
+		summary->first_ns = record->timestamp_ns;
+	}
+	if (record->timestamp_ns > summary->last_ns) {
+		summary->last_ns = record->timestamp_ns;
+	}
+	summary->records++;
+	if (record->kind < ACCESS_KIND_COUNT) {
+		summary->per_kind[record->kind]++;
+	}
+	if (record->status < 4) {
+		summary->per_status[record->status]++;
+	}
+	summary->per_type[(uint8_t)record->type]++;
+	summary->latency[latency_bucket(record->service_ns)]++;
+	summary->service_ns_total += record->service_ns;
+	if (record->service_ns > summary->service_ns_max) {
+		summary->service_ns_max = record->service_ns;
+	}
+	if (record->city[0] != '\0') {
+		count_city(summary, record->city);
+	}
+}
+
+static void print_csv(const access_record_t *record) {
+	char ip[INET_ADDRSTRLEN] = "";
+	if (record->client_ip != 0) {
+		struct in_addr addr;
+		addr.s_addr = record->client_ip;
+		inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+	}
+	char city[65];
+	memcpy(city, record->city, 64);
+	city[64] = '\0';
+
+	printf("%llu.%09llu,%s,%s,%u,%c,%s,%.3f,%u,\"%s\"\n",
+	       (unsigned long long)(record->timestamp_ns / 1000000000u),
+	       (unsigned long long)(record->timestamp_ns % 1000000000u),
+	       record->kind < ACCESS_KIND_COUNT ? kind_names[record->kind] : "?",
+	       ip, ntohs(record->client_port),
+	       record->type ? record->type : '-',
+	       record->status < 4 ? status_names[record->status] : "?",
+	       record->value, record->service_ns, city);
+}
+
+/*
+ * Mappa un segmento e passa i suoi record al CSV o al riepilogo
+ * Ritorna il numero di record letti, -1 se il file non è un segmento valido
+ */
+static long read_segment(const char *path, int csv, summary_t *summary) {
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: impossibile aprire '%s'.\n", path);
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_size < ACCESS_LOG_HEADER_SIZE) {
+		fprintf(stderr, "Errore: '%s' non è un segmento di log.\n", path);
+		close(fd);
+		return -1;
+	}
+	size_t size = (size_t)st.st_size;
+	uint8_t *base = (uint8_t *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		fprintf(stderr, "Errore: mmap di '%s' fallita.\n", path);
+		return -1;
+	}
+	madvise(base, size, MADV_SEQUENTIAL);
+
+	const access_log_header_t *header = (const access_log_header_t *)base;
+	if (header->magic != ACCESS_LOG_MAGIC || header->version != ACCESS_LOG_VERSION ||
+	    header->record_size != sizeof(access_record_t)) {
+		fprintf(stderr, "Errore: '%s' non è un segmento di log (versione %u).\n", path, header->version);
+		munmap(base, size);
+		return -1;
+	}
+
+	// Record validi: il minimo tra il contatore e quelli presenti nel file
+	// (un server terminato bruscamente lascia il file alla dimensione pre-allocata)
+	uint64_t available = (size - ACCESS_LOG_HEADER_SIZE) / sizeof(access_record_t);
+	uint64_t count = header->count < available ? header->count : available;
+	const access_record_t *records = (const access_record_t *)(base + ACCESS_LOG_HEADER_SIZE);
+
+	long read_count = 0;
+	for (uint64_t i = 0; i < count; i++) {
+		if (records[i].timestamp_ns == 0) {
+			break; // Pagina mai scritta
+		}
+		if (csv) {
+			print_csv(&records[i]);
+		} else {
+			add_record(summary, &records[i]);
+		}
+		read_count++;
+	}
+
+	munmap(base, size);
+	return read_count;
+}
+
+static void print_summary(summary_t *summary) {
+	printf("Record: %llu\n", (unsigned long long)summary->records);
+	if (summary->records == 0) {
+		return;
+	}
+
+	double span_s = (summary->last_ns - summary->first_ns) / 1e9;
+	printf("Intervallo: %.3f s", span_s);
+	if (span_s > 0) {
+		printf(" (%.1f richieste/s)", summary->records / span_s);
+	}
+	printf("\n");
+
+	printf("Tipo di accesso:");
+	for (int i = 0; i < ACCESS_KIND_COUNT; i++) {
+		if (summary->per_kind[i] > 0) {
+			printf(" %s=%llu", kind_names[i], (unsigned long long)summary->per_kind[i]);
+		}
+	}
+	printf("\nEsito:");
+	for (int i = 0; i < 4; i++) {
+		if (summary->per_status[i] > 0) {
+			printf(" %s=%llu", status_names[i], (unsigned long long)summary->per_status[i]);
+		}
+	}
+	printf("\nTipo meteo:");
+	for (int i = 1; i < 256; i++) {
+		if (summary->per_type[i] > 0) {
+			printf(" %c=%llu", i, (unsigned long long)summary->per_type[i]);
+		}
+	}
+	printf("\n");
+
+	printf("Tempo di servizio: media %.1f us, p50 <%.1f us, p99 <%.1f us, p99.9 <%.1f us, massimo %.1f us\n",
+	       summary->service_ns_total / (double)summary->records / 1e3,
+	       latency_percentile(summary, 0.50) / 1e3, latency_percentile(summary, 0.99) / 1e3,
+	       latency_percentile(summary, 0.999) / 1e3, summary->service_ns_max / 1e3);
+
+	qsort(summary->cities, CITY_TABLE_SIZE, sizeof(city_count_t), compare_city_count);
+	printf("Città più richieste:\n");
+	for (int i = 0; i < TOP_CITIES && summary->cities[i].count > 0; i++) {
+		printf("  %-24s %llu\n", summary->cities[i].name, (unsigned long long)summary->cities[i].count);
+	}
+	if (summary->cities_overflow > 0) {
+		printf("  (%llu record su città oltre la capienza della tabella)\n",
+		       (unsigned long long)summary->cities_overflow);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	int csv = 0;
+	int first = 1;
+	if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+		csv = 1;
+		first = 2;
+	}
+	if (first >= argc) {
+		fprintf(stderr, "Uso: %s [-c] segmento.wlog...\n", argv[0]);
+		return 1;
+	}
+
+	summary_t *summary = (summary_t *)calloc(1, sizeof(summary_t));
+	if (!summary) {
+		fprintf(stderr, "Errore: memoria insufficiente.\n");
+		return 1;
+	}
+
+	if (csv) {
+		static char csv_buffer[CSV_BUFFER_SIZE];
+		setvbuf(stdout, csv_buffer, _IOFBF, sizeof(csv_buffer));
+		printf("timestamp,kind,client_ip,client_port,type,status,value,service_ns,city\n");
+	}
+
+	int errors = 0;
+	for (int i = first; i < argc; i++) {
+		if (read_segment(argv[i], csv, summary) < 0) {
+			errors++;
+		}
+	}
+
+	if (!csv) {
+		print_summary(summary);
+	}
+	fflush(stdout);
+	free(summary);
+	return errors ? 1 : 0;
+}
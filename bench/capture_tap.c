@@ -0,0 +1,166 @@
+/*
+ * capture_tap.c
+ *
+ * Presa passiva del traffico verso un server già in esecuzione: legge i
+ * pacchetti IPv4/UDP diretti alla porta indicata da un socket AF_PACKET e
+ * li scrive nello stesso formato della cattura del server (-w), senza
+ * toccare il server né il percorso dei pacchetti.
+ *
+ * Uso: capture_tap -p porta -w file.wcap [-i interfaccia] [-d secondi]
+ * Richiede Linux e CAP_NET_RAW (root). Termina con Ctrl+C o dopo -d secondi.
+ *
+ * Compilazione:
+ *   gcc -O2 -Iserver-project/src -o capture_tap bench/capture_tap.c server-project/src/capture.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include "capture.h"
+
+#define TAP_POLL_MS 200                 // Controllo periodico di Ctrl+C e della durata
+#define TAP_RCVBUF (8 << 20)
+
+static volatile sig_atomic_t tap_running = 1;
+
+static void handle_termination(int signum) {
+	(void)signum;
+	tap_running = 0;
+}
+
+static uint64_t monotonic_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+	int port = 0;
+	const char *path = NULL;
+	const char *interface_name = NULL;
+	int duration_s = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+			port = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			path = argv[++i];
+		} else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+			interface_name = argv[++i];
+		} else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+			duration_s = atoi(argv[++i]);
+		} else {
+			fprintf(stderr, "Errore: opzione non valida '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (port <= 0 || port > 65535 || !path) {
+		fprintf(stderr, "Uso: %s -p porta -w file.wcap [-i interfaccia] [-d secondi]\n", argv[0]);
+		return 1;
+	}
+
+	// SOCKET DI CATTURA: pacchetti IPv4 senza intestazione di livello 2
+	int sock = socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+	if (sock < 0) {
+		perror("Errore: socket(AF_PACKET) fallita (serve CAP_NET_RAW)");
+		return 1;
+	}
+	if (interface_name) {
+		struct sockaddr_ll bind_addr;
+		memset(&bind_addr, 0, sizeof(bind_addr));
+		bind_addr.sll_family = AF_PACKET;
+		bind_addr.sll_protocol = htons(ETH_P_IP);
+		bind_addr.sll_ifindex = (int)if_nametoindex(interface_name);
+		if (bind_addr.sll_ifindex == 0 || bind(sock, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+			fprintf(stderr, "Errore: interfaccia '%s' non valida.\n", interface_name);
+			close(sock);
+			return 1;
+		}
+	}
+	int rcvbuf = TAP_RCVBUF;
+	setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	struct timeval poll_timeout = { 0, TAP_POLL_MS * 1000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &poll_timeout, sizeof(poll_timeout));
+
+	capture_writer_t capture;
+	if (capture_open(&capture, path) != 0) {
+		close(sock);
+		return 1;
+	}
+
+	signal(SIGINT, handle_termination);
+	signal(SIGTERM, handle_termination);
+	printf("Cattura dei datagrammi UDP verso la porta %d in %s...\n", port, path);
+
+	uint64_t deadline_ns = duration_s > 0 ? monotonic_ns() + (uint64_t)duration_s * 1000000000u : 0;
+	uint64_t skipped = 0;
+	uint8_t packet[65536];
+
+	while (tap_running && capture.file) {
+		if (deadline_ns && monotonic_ns() >= deadline_ns) {
+			break;
+		}
+
+		struct sockaddr_ll from;
+		socklen_t from_len = sizeof(from);
+		ssize_t n = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr *)&from, &from_len);
+		if (n < 0) {
+			continue; // Timeout del poll o segnale
+		}
+		uint64_t receive_ns = monotonic_ns();
+
+		// Su loopback ogni pacchetto passa due volte: si tiene solo la copia in ingresso
+		if (from.sll_pkttype == PACKET_OUTGOING) {
+			continue;
+		}
+
+		// INTESTAZIONE IPv4: versione, protocollo UDP, nessun frammento successivo al primo
+		if (n < 20 || (packet[0] >> 4) != 4 || packet[9] != 17) {
+			continue;
+		}
+		int ip_header_len = (packet[0] & 0x0F) * 4;
+		uint16_t fragment = (uint16_t)((packet[6] << 8) | packet[7]);
+		if ((fragment & 0x3FFF) != 0) {
+			skipped++; // Datagrammi frammentati: fuori dal protocollo
+			continue;
+		}
+		if (n < ip_header_len + 8) {
+			continue;
+		}
+
+		// INTESTAZIONE UDP: porta di destinazione e lunghezza
+		const uint8_t *udp = packet + ip_header_len;
+		uint16_t dst_port = (uint16_t)((udp[2] << 8) | udp[3]);
+		if (dst_port != port) {
+			continue;
+		}
+		int udp_len = (udp[4] << 8) | udp[5];
+		int payload_len = udp_len - 8;
+		if (payload_len < 0 || ip_header_len + udp_len > n) {
+			skipped++;
+			continue;
+		}
+
+		uint32_t src_addr;
+		uint16_t src_port;
+		memcpy(&src_addr, packet + 12, sizeof(src_addr)); // Già in network byte order
+		memcpy(&src_port, udp, sizeof(src_port));
+		capture_write(&capture, receive_ns, src_addr, src_port, udp + 8, payload_len);
+	}
+
+	printf("Cattura: %llu datagrammi, %llu byte, %llu pacchetti scartati\n",
+	       (unsigned long long)capture.datagrams, (unsigned long long)capture.bytes,
+	       (unsigned long long)skipped);
+	capture_close(&capture);
+	close(sock);
+	return 0;
+}
@@ -0,0 +1,115 @@
+#!/bin/sh
+#
+# handoff.sh
+#
+# Riavvii del server sotto carico: più client in benchmark (una richiesta in
+# volo ciascuno, nessuna ritrasmissione) mentre il server viene sostituito
+# più volte.
+#
+# Per ogni scenario conta le richieste perse (errori del benchmark):
+#   - handoff   il nuovo server eredita i socket con -U (e lo stato con -K)
+#   - riavvio   il vecchio server termina e il nuovo apre socket propri
+# Fallisce se l'handoff perde anche una sola richiesta; il riavvio senza
+# handoff è solo il termine di paragone.
+#
+# Uso: bench/handoff.sh [richieste per client] [client] [riavvii]
+#
+
+set -eu
+
+REQUESTS=${1:-200000}
+CLIENTS=${2:-4}
+RESTARTS=${3:-5}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+LDLIBS=${LDLIBS:-"-lm -pthread"}
+
+SERVER_PORT=57900
+HANDOFF_SOCKET="$BUILD_DIR/handoff.sock"
+TIMEOUT_MS=1000
+RESTART_INTERVAL=0.5
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+# COMPILAZIONE
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -o "$BUILD_DIR/server" "$ROOT"/server-project/src/*.c $LDLIBS
+$CC $CFLAGS -o "$BUILD_DIR/client" "$ROOT"/client-project/src/*.c
+
+SERVER_PID=""
+cleanup() {
+	if [ -n "$SERVER_PID" ]; then
+		kill "$SERVER_PID" 2>/dev/null || true
+	fi
+	wait 2>/dev/null || true
+}
+trap cleanup EXIT INT TERM
+
+# SCENARI: nome e modalità di sostituzione del server
+run_scenario() {
+	name=$1
+	mode=$2
+
+	rm -f "$HANDOFF_SOCKET"
+	"$BUILD_DIR/server" -q -p $SERVER_PORT -U "$HANDOFF_SOCKET" >/dev/null &
+	SERVER_PID=$!
+	sleep 0.3
+
+	client_pids=""
+	for c in $(seq 1 "$CLIENTS"); do
+		"$BUILD_DIR/client" -s 127.0.0.1:$SERVER_PORT -t $TIMEOUT_MS -b "$REQUESTS" -r "t bari" \
+			>"$BUILD_DIR/handoff_client_$c.out" 2>/dev/null &
+		client_pids="$client_pids $!"
+	done
+
+	for r in $(seq 1 "$RESTARTS"); do
+		sleep $RESTART_INTERVAL
+		old_pid=$SERVER_PID
+		if [ "$mode" = "handoff" ]; then
+			# Il vecchio server cede i socket e termina da solo
+			"$BUILD_DIR/server" -q -p $SERVER_PORT -U "$HANDOFF_SOCKET" -K >/dev/null &
+			SERVER_PID=$!
+			wait "$old_pid" 2>/dev/null || true
+		else
+			kill "$old_pid" 2>/dev/null || true
+			wait "$old_pid" 2>/dev/null || true
+			"$BUILD_DIR/server" -q -p $SERVER_PORT >/dev/null &
+			SERVER_PID=$!
+		fi
+	done
+
+	for pid in $client_pids; do
+		wait "$pid" 2>/dev/null || true
+	done
+	kill "$SERVER_PID" 2>/dev/null || true
+	wait "$SERVER_PID" 2>/dev/null || true
+	SERVER_PID=""
+
+	# Errori = richieste senza risposta entro TIMEOUT_MS
+	answered=0
+	lost=0
+	for c in $(seq 1 "$CLIENTS"); do
+		line=$(grep '^Benchmark' "$BUILD_DIR/handoff_client_$c.out" || true)
+		ok=$(echo "$line" | sed -n 's/.*: \([0-9]*\) risposte, \([0-9]*\) errori.*/\1/p')
+		ko=$(echo "$line" | sed -n 's/.*: \([0-9]*\) risposte, \([0-9]*\) errori.*/\2/p')
+		answered=$((answered + ${ok:-0}))
+		lost=$((lost + ${ko:-0}))
+	done
+	echo "== $name: $RESTARTS sostituzioni, $answered risposte, $lost richieste perse"
+	if [ "$answered" -eq 0 ]; then
+		echo "Errore: nessuna risposta in $name" >&2
+		exit 1
+	fi
+	SCENARIO_LOST=$lost
+}
+
+run_scenario "handoff (-U -K)" handoff
+handoff_lost=$SCENARIO_LOST
+run_scenario "riavvio senza handoff" restart
+
+if [ "$handoff_lost" -gt 0 ]; then
+	echo "Errore: $handoff_lost richieste perse durante l'handoff" >&2
+	exit 1
+fi
+echo "Handoff senza perdite"
@@ -0,0 +1,90 @@
+#!/bin/sh
+#
+# impairment.sh
+#
+# Benchmark su rete degradata: client e server comunicano attraverso il
+# proxy (proxy-project) con perdita, jitter, riordino, duplicazione e
+# limite di banda generati da un seme fisso, quindi ripetibili.
+#
+# Per ogni scenario misura:
+#   - udp     richiesta singola verso un server (una sola via)
+#   - hedged  richieste hedged su due vie indipendenti verso lo stesso server
+#   - push    sottoscrizione: percentuale di aggiornamenti ricevuti
+#
+# Uso: bench/impairment.sh [richieste] [seme]
+#
+
+set -eu
+
+REQUESTS=${1:-2000}
+SEED=${2:-42}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+LDLIBS=${LDLIBS:-"-lm -pthread"}
+
+SERVER_PORT=57700
+PROXY_A_PORT=57801
+PROXY_B_PORT=57802
+TIMEOUT_MS=200
+PUSH_INTERVAL_MS=100
+PUSH_SECONDS=3
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+# COMPILAZIONE
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -o "$BUILD_DIR/server" "$ROOT"/server-project/src/*.c $LDLIBS
+$CC $CFLAGS -o "$BUILD_DIR/client" "$ROOT"/client-project/src/*.c
+$CC $CFLAGS -o "$BUILD_DIR/proxy" "$ROOT"/proxy-project/src/*.c
+
+PIDS=""
+cleanup() {
+	for pid in $PIDS; do
+		kill "$pid" 2>/dev/null || true
+	done
+	wait 2>/dev/null || true
+}
+trap cleanup EXIT INT TERM
+
+"$BUILD_DIR/server" -q -p $SERVER_PORT >/dev/null &
+PIDS="$PIDS $!"
+
+# SCENARI: nome e opzioni del proxy (stesse opzioni su entrambe le vie)
+run_scenario() {
+	name=$1
+	shift
+
+	"$BUILD_DIR/proxy" -l $PROXY_A_PORT -u 127.0.0.1:$SERVER_PORT -S "$SEED" "$@" >/dev/null 2>&1 &
+	proxy_a=$!
+	"$BUILD_DIR/proxy" -l $PROXY_B_PORT -u 127.0.0.1:$SERVER_PORT -S $((SEED + 1000)) "$@" >/dev/null 2>&1 &
+	proxy_b=$!
+	sleep 0.2
+
+	echo "== $name ($*)"
+
+	"$BUILD_DIR/client" -s 127.0.0.1:$PROXY_A_PORT -t $TIMEOUT_MS -b "$REQUESTS" -r "t bari" |
+		grep -E '^(Benchmark|Goodput)' | sed 's/^/  udp:    /'
+
+	"$BUILD_DIR/client" -s 127.0.0.1:$PROXY_A_PORT,127.0.0.1:$PROXY_B_PORT -t $TIMEOUT_MS -b "$REQUESTS" -r "t bari" |
+		grep -E '^(Benchmark|Goodput|Hedge)' | sed 's/^/  hedged: /'
+
+	# Push: aggiornamenti attesi = durata / intervallo
+	"$BUILD_DIR/client" -s 127.0.0.1:$PROXY_A_PORT -S $PUSH_INTERVAL_MS -r "t bari" >"$BUILD_DIR/push.out" 2>/dev/null &
+	sub=$!
+	sleep $PUSH_SECONDS
+	kill -INT $sub 2>/dev/null || true
+	wait $sub 2>/dev/null || true
+	received=$(grep -c '^Ricevuto' "$BUILD_DIR/push.out" || true)
+	expected=$((PUSH_SECONDS * 1000 / PUSH_INTERVAL_MS))
+	echo "  push:   $received/$expected aggiornamenti ricevuti"
+
+	kill $proxy_a $proxy_b 2>/dev/null || true
+	wait $proxy_a $proxy_b 2>/dev/null || true
+}
+
+run_scenario "rete pulita"
+run_scenario "perdita 1%" -L 1
+run_scenario "perdita 5%, ritardo 2 ms, jitter 1 ms" -L 5 -d 2 -j 1
+run_scenario "riordino 10%, duplicazione 5%" -o 10 -D 5 -d 1
+run_scenario "banda 256 kbps, coda 20 ms" -r 256 -Q 20
@@ -0,0 +1,858 @@
+/*
+ * netsim.c
+ *
+ * Harness deterministico in un solo processo: il servizio del server
+ * (server-project/src/service.c) e molti client simulati si scambiano
+ * datagrammi su una rete virtuale con perdita, ritardo, jitter, riordino e
+ * duplicazione (proxy-project/src/impairment.c), con un orologio virtuale.
+ * Nessun socket e nessuna attesa: il tempo salta da un evento al successivo,
+ * quindi milioni di richieste girano più in fretta del tempo reale e lo
+ * stesso seme dà sempre lo stesso risultato (riga "Impronta").
+ *
+ * Modello del server:
+ *   - una coda per corsia (normale e prioritaria) di -Q datagrammi; quando
+ *     è piena il datagramma viene scartato, come un buffer del socket pieno
+ *   - a ogni risveglio preleva fino a -B datagrammi, in un lotto composto
+ *     da lane_policy_batch() come nel loop del server (stretta o pesata -W),
+ *     e li serve uno alla volta con service_handle_datagram()
+ *   - ogni risveglio costa -w us, ogni richiesta -s us di tempo virtuale
+ *   - risposte, push delle sottoscrizioni (subscription_advance) e conferme
+ *     escono dal trasporto del servizio verso la rete virtuale
+ * Modello dei client: una richiesta in volo ciascuno, serializzata con
+ * serialize_request() del client; timeout -t e fino a -r ritrasmissioni,
+ * risposta letta con deserialize_response(); pausa -z tra due richieste.
+ * Modello dei sottoscrittori (-U): nessuna richiesta, una sottoscrizione a
+ * tutti i tipi di una città con intervallo -u, rinnovata ogni terzo di lease.
+ *
+ * Uso: netsim [-c client] [-n richieste] [-S seme] [-L perdita%] [-d ritardo_ms]
+ *             [-j jitter_ms] [-o riordino%] [-D duplicazione%] [-t timeout_ms]
+ *             [-r ritrasmissioni] [-B lotto] [-Q coda] [-s costo_us] [-w risveglio_us]
+ *             [-z pausa_ms] [-P prioritari%] [-W peso] [-U sottoscrittori] [-u intervallo_ms]
+ *
+ * Compilazione: bench/netsim.sh
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+#include "service.h"
+#include "lane_policy.h"
+#include "impairment.h"
+
+#define NETSIM_MAX_CLIENTS (IMPAIR_QUEUE_CAPACITY / 2) // Datagrammi in volo per direzione
+#define NETSIM_MAX_QUEUE 65536
+#define NETSIM_MAX_BATCH 1024
+#define NETSIM_DATAGRAM_SIZE 128        // Più grande di ogni richiesta del protocollo
+#define NETSIM_SERVER_SOCK 3            // Socket fittizio passato al servizio (mai usato per l'I/O)
+#define NETSIM_CLIENT_NET 0x0A000000u   // Client su 10.0.0.0/8: indirizzo = rete + indice + 1
+#define NETSIM_CLIENT_PORT 40000
+#define NETSIM_START_SPREAD_US 1000     // Partenza dei client sparsa nel primo millisecondo
+#define NETSIM_DAY_SECONDS 43200.0      // Ora simulata di partenza (mezzogiorno), non quella locale
+
+#define TIMER_NONE 0
+#define TIMER_SEND 1                    // Nuova richiesta
+#define TIMER_TIMEOUT 2                 // Nessuna risposta: ritrasmissione o fallimento
+#define TIMER_RENEW 3                   // Sottoscrittore: rinnovo del lease
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	int clients;
+	long requests;
+	unsigned long long seed;
+	impairment_config_t network;
+	uint32_t timeout_us;
+	int retries;
+	int batch;
+	int queue;
+	uint32_t cost_us;               // Servizio di una richiesta
+	uint32_t wake_us;               // Risveglio del server (una lettura a lotti)
+	uint32_t think_us;              // Pausa del client tra due richieste
+	double priority_percent;        // Client sulla corsia prioritaria
+	int weight;                     // 0 = priorità stretta (come -W del server)
+	int subscribers;                // Sottoscrittori dopo i client (-U)
+	uint32_t push_interval_ms;      // Intervallo dei push richiesto (-u)
+} netsim_config_t;
+
+/* Datagramma nella coda di una corsia del server */
+typedef struct {
+	uint64_t receive_us;
+	int client;
+	int length;
+	uint8_t data[NETSIM_DATAGRAM_SIZE];
+} netsim_datagram_t;
+
+typedef struct {
+	netsim_datagram_t *slots;
+	int head;
+	int count;
+
+	// Statistiche
+	uint64_t received;
+	uint64_t dropped;               // Coda piena
+	uint64_t served;
+	uint64_t wait_us_total;
+} netsim_queue_t;
+
+typedef struct {
+	endpoint_addr_t addr;
+	int lane;
+	weather_request_t request;
+	uint8_t payload[REQUEST_SIZE];
+	uint64_t first_send_us;
+	int attempts;
+	int outstanding;
+
+	// Timer del client (uno solo alla volta) e posizione nello heap
+	int timer_kind;
+	uint64_t timer_us;
+	int heap_index;
+} netsim_client_t;
+
+typedef struct {
+	netsim_config_t config;
+	uint64_t rng_state;
+
+	netsim_client_t *clients;
+	int *timer_heap;                // Indici dei client, min-heap per (timer_us, indice)
+	int timer_count;
+
+	impaired_link_t to_server;
+	impaired_link_t to_client;
+
+	netsim_queue_t queues[LANE_COUNT];
+	int credit;                     // Come lane_set_t.credit (politica pesata)
+	netsim_datagram_t batch[NETSIM_MAX_BATCH];
+	int batch_count;
+	int batch_pos;
+	int busy;
+	uint64_t next_done_us;
+
+	// Risultati
+	long issued;
+	long finished;                  // Risposte più richieste fallite
+	long answered;
+	long failed;
+	long invalid;                   // Risposta con stato di errore
+	uint64_t retransmissions;
+	uint64_t late;                  // Risposte arrivate senza una richiesta in volo
+	uint64_t pushes;                // Push arrivati ai sottoscrittori
+	uint64_t subscribe_acks;        // Conferme di sottoscrizione arrivate
+	uint64_t batches;
+	int batch_max;
+	uint64_t busy_us;
+	uint32_t *latency_us[LANE_COUNT];
+	long latency_count[LANE_COUNT];
+	uint64_t fingerprint;           // FNV-1a degli esiti, in ordine
+} netsim_t;
+
+/*
+ * ============================================================================
+ * OROLOGIO VIRTUALE
+ * ============================================================================
+ * Sostituisce l'orologio monotono del server (protocol.h) per tutti i moduli
+ */
+
+static uint64_t virtual_now_us = 0;
+
+uint64_t get_monotonic_ms(void) {
+	return virtual_now_us / 1000u;
+}
+
+uint64_t get_monotonic_ns(void) {
+	return virtual_now_us * 1000u;
+}
+
+/*
+ * Generatore pseudocasuale xorshift64* dei client (stato mai nullo)
+ */
+static uint64_t rng_next(netsim_t *sim) {
+	uint64_t x = sim->rng_state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	sim->rng_state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+static double rng_uniform(netsim_t *sim) {
+	return (double)(rng_next(sim) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void fingerprint_add(netsim_t *sim, uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		sim->fingerprint ^= (value >> (8 * i)) & 0xFFu;
+		sim->fingerprint *= 0x100000001B3ULL;
+	}
+}
+
+/*
+ * ============================================================================
+ * TIMER DEI CLIENT
+ * ============================================================================
+ * Min-heap indicizzato: ogni client ha al più un timer, spostato sul posto
+ */
+
+static int timer_before(const netsim_t *sim, int a, int b) {
+	if (sim->clients[a].timer_us != sim->clients[b].timer_us) {
+		return sim->clients[a].timer_us < sim->clients[b].timer_us;
+	}
+	return a < b;
+}
+
+static void timer_place(netsim_t *sim, int index, int client) {
+	sim->timer_heap[index] = client;
+	sim->clients[client].heap_index = index;
+}
+
+static void timer_sift(netsim_t *sim, int index) {
+	int client = sim->timer_heap[index];
+	while (index > 0) {
+		int parent = (index - 1) / 2;
+		if (!timer_before(sim, client, sim->timer_heap[parent])) {
+			break;
+		}
+		timer_place(sim, index, sim->timer_heap[parent]);
+		index = parent;
+	}
+	while (1) {
+		int child = 2 * index + 1;
+		if (child >= sim->timer_count) {
+			break;
+		}
+		if (child + 1 < sim->timer_count && timer_before(sim, sim->timer_heap[child + 1], sim->timer_heap[child])) {
+			child++;
+		}
+		if (!timer_before(sim, sim->timer_heap[child], client)) {
+			break;
+		}
+		timer_place(sim, index, sim->timer_heap[child]);
+		index = child;
+	}
+	timer_place(sim, index, client);
+}
+
+static void timer_set(netsim_t *sim, int client, int kind, uint64_t due_us) {
+	netsim_client_t *c = &sim->clients[client];
+	c->timer_kind = kind;
+	c->timer_us = due_us;
+	if (c->heap_index < 0) {
+		c->heap_index = sim->timer_count++;
+		sim->timer_heap[c->heap_index] = client;
+	}
+	timer_sift(sim, c->heap_index);
+}
+
+static void timer_clear(netsim_t *sim, int client) {
+	netsim_client_t *c = &sim->clients[client];
+	int index = c->heap_index;
+	c->timer_kind = TIMER_NONE;
+	if (index < 0) {
+		return;
+	}
+	c->heap_index = -1;
+	int last = sim->timer_heap[--sim->timer_count];
+	if (index < sim->timer_count) {
+		timer_place(sim, index, last);
+		timer_sift(sim, index);
+	}
+}
+
+/*
+ * ============================================================================
+ * CLIENT SIMULATI
+ * ============================================================================
+ */
+
+static void client_send_new(netsim_t *sim, int client) {
+	static const char types[] = { TYPE_TEMPERATURE, TYPE_HUMIDITY, TYPE_WIND, TYPE_PRESSURE };
+	netsim_client_t *c = &sim->clients[client];
+	if (sim->issued >= sim->config.requests) {
+		timer_clear(sim, client);
+		return;
+	}
+	sim->issued++;
+
+	int city_count = 0;
+	const city_entry_t *cities = service_supported_cities(&city_count);
+	memset(&c->request, 0, sizeof(c->request));
+	c->request.type = types[rng_next(sim) % 4u];
+	strncpy(c->request.city, cities[rng_next(sim) % (uint64_t)city_count].name, sizeof(c->request.city) - 1);
+	serialize_request(&c->request, c->payload);
+
+	c->first_send_us = virtual_now_us;
+	c->attempts = 1;
+	c->outstanding = 1;
+	impaired_link_submit(&sim->to_server, client, c->payload, REQUEST_SIZE, virtual_now_us);
+	timer_set(sim, client, TIMER_TIMEOUT, virtual_now_us + sim->config.timeout_us);
+}
+
+/* Richiesta conclusa (risposta o tentativi esauriti): la prossima dopo la pausa */
+static void client_finish(netsim_t *sim, int client) {
+	sim->clients[client].outstanding = 0;
+	sim->finished++;
+	timer_set(sim, client, TIMER_SEND, virtual_now_us + sim->config.think_us);
+}
+
+static void client_timeout(netsim_t *sim, int client) {
+	netsim_client_t *c = &sim->clients[client];
+	if (c->attempts <= sim->config.retries) {
+		c->attempts++;
+		sim->retransmissions++;
+		impaired_link_submit(&sim->to_server, client, c->payload, REQUEST_SIZE, virtual_now_us);
+		timer_set(sim, client, TIMER_TIMEOUT, virtual_now_us + sim->config.timeout_us);
+		return;
+	}
+	sim->failed++;
+	fingerprint_add(sim, ((uint64_t)client << 32) | 0xFFFFFFFFu);
+	client_finish(sim, client);
+}
+
+static void client_receive(netsim_t *sim, int client, const uint8_t *data, int length) {
+	netsim_client_t *c = &sim->clients[client];
+	weather_response_t response;
+	if (!c->outstanding || length < (int)RESPONSE_SIZE || deserialize_response(data, &response) != 0 ||
+	    (response.status == STATUS_SUCCESS && response.type != c->request.type)) {
+		sim->late++; // Risposta a una richiesta già conclusa, oppure duplicato
+		return;
+	}
+
+	uint64_t latency_us = virtual_now_us - c->first_send_us;
+	if (response.status != STATUS_SUCCESS) {
+		sim->invalid++;
+	}
+	sim->answered++;
+	sim->latency_us[c->lane][sim->latency_count[c->lane]++] = (uint32_t)(latency_us < UINT32_MAX ? latency_us
+	                                                                                             : UINT32_MAX);
+	uint32_t value_bits;
+	memcpy(&value_bits, &response.value, sizeof(value_bits));
+	fingerprint_add(sim, ((uint64_t)client << 32) | (uint64_t)c->attempts);
+	fingerprint_add(sim, (latency_us << 32) | value_bits);
+	client_finish(sim, client);
+}
+
+/* Sottoscrittore: (ri)sottoscrive tutti i tipi della sua città */
+static void subscriber_renew(netsim_t *sim, int client) {
+	netsim_client_t *c = &sim->clients[client];
+	subscribe_request_t request;
+	memset(&request, 0, sizeof(request));
+	memcpy(request.city, c->request.city, sizeof(request.city)); // Già terminata
+	request.types = SUB_MASK_ALL;
+	request.interval_ms = sim->config.push_interval_ms;
+
+	uint8_t payload[SUBSCRIBE_SIZE];
+	serialize_subscribe(&request, payload);
+	impaired_link_submit(&sim->to_server, client, payload, SUBSCRIBE_SIZE, virtual_now_us);
+	timer_set(sim, client, TIMER_RENEW, virtual_now_us + SUBSCRIPTION_LEASE_MS * 1000u / 3u);
+}
+
+static void subscriber_receive(netsim_t *sim, int client, const uint8_t *data, int length) {
+	weather_response_t response;
+	if (length < (int)RESPONSE_SIZE || deserialize_response(data, &response) != 0) {
+		return;
+	}
+	if (response.type == TYPE_SUBSCRIBE) {
+		sim->subscribe_acks++;
+		return;
+	}
+	uint32_t value_bits;
+	memcpy(&value_bits, &response.value, sizeof(value_bits));
+	sim->pushes++;
+	fingerprint_add(sim, ((uint64_t)client << 32) | (uint64_t)(uint8_t)response.type);
+	fingerprint_add(sim, (virtual_now_us << 32) | value_bits);
+}
+
+/*
+ * ============================================================================
+ * SERVER VIRTUALE
+ * ============================================================================
+ */
+
+/* Trasporto del servizio: la risposta entra nella rete verso il client */
+static int virtual_send(void *context, int sock, const uint8_t *data, int length, const endpoint_addr_t *addr,
+                        int addr_len) {
+	netsim_t *sim = (netsim_t *)context;
+	(void)sock;
+	(void)addr_len;
+	int client = (int)(ntohl(addr->v4.sin_addr.s_addr) - NETSIM_CLIENT_NET) - 1;
+	if (client < 0 || client >= sim->config.clients + sim->config.subscribers) {
+		return -1;
+	}
+	impaired_link_submit(&sim->to_client, client, data, (size_t)length, virtual_now_us);
+	return length;
+}
+
+static void queue_push(netsim_t *sim, int client, const uint8_t *data, int length) {
+	netsim_queue_t *queue = &sim->queues[sim->clients[client].lane];
+	queue->received++;
+	if (queue->count >= sim->config.queue || length > NETSIM_DATAGRAM_SIZE) {
+		queue->dropped++;
+		return;
+	}
+	netsim_datagram_t *slot = &queue->slots[(queue->head + queue->count) % sim->config.queue];
+	slot->receive_us = virtual_now_us;
+	slot->client = client;
+	slot->length = length;
+	memcpy(slot->data, data, (size_t)length);
+	queue->count++;
+}
+
+/* Prelievo di un lotto composto come in lanes_take_batch() */
+static int take_batch(netsim_t *sim) {
+	int pending[LANE_COUNT] = { sim->queues[LANE_PRIORITY].count, sim->queues[LANE_BULK].count };
+	int order[NETSIM_MAX_BATCH];
+	int count = lane_policy_batch(pending, sim->config.batch, sim->config.weight, &sim->credit, order);
+	for (int i = 0; i < count; i++) {
+		netsim_queue_t *queue = &sim->queues[order[i]];
+		sim->batch[i] = queue->slots[queue->head];
+		queue->head = (queue->head + 1) % sim->config.queue;
+		queue->count--;
+		queue->served++;
+		queue->wait_us_total += virtual_now_us - sim->batch[i].receive_us;
+	}
+	return count;
+}
+
+/*
+ * Avanza il server fino a virtual_now_us: richieste completate, poi un
+ * nuovo lotto se il server è libero e le code non sono vuote
+ */
+static void server_advance(netsim_t *sim, service_t *service) {
+	while (1) {
+		if (sim->busy) {
+			if (sim->next_done_us > virtual_now_us) {
+				return;
+			}
+			const netsim_datagram_t *datagram = &sim->batch[sim->batch_pos++];
+			service_handle_datagram(service, NETSIM_SERVER_SOCK, datagram->data, datagram->length,
+			                        &sim->clients[datagram->client].addr, (int)sizeof(struct sockaddr_in),
+			                        datagram->receive_us * 1000u);
+			if (sim->batch_pos < sim->batch_count) {
+				sim->next_done_us += sim->config.cost_us;
+				sim->busy_us += sim->config.cost_us;
+				continue;
+			}
+			sim->busy = 0;
+		}
+
+		service_advance(service, get_monotonic_ms());
+		subscription_advance(service->subscriptions, get_monotonic_ms());
+		sim->batch_count = take_batch(sim);
+		if (sim->batch_count == 0) {
+			return;
+		}
+		sim->batches++;
+		if (sim->batch_count > sim->batch_max) {
+			sim->batch_max = sim->batch_count;
+		}
+		sim->batch_pos = 0;
+		sim->busy = 1;
+		sim->next_done_us = virtual_now_us + sim->config.wake_us + sim->config.cost_us;
+		sim->busy_us += sim->config.wake_us + sim->config.cost_us;
+	}
+}
+
+/*
+ * ============================================================================
+ * CICLO DEGLI EVENTI
+ * ============================================================================
+ */
+
+/* Prossimo istante con qualcosa da fare, UINT64_MAX se nessuno */
+static uint64_t next_event_us(const netsim_t *sim, const service_t *service) {
+	uint64_t next = UINT64_MAX;
+	int64_t wait_us = impaired_link_next_timeout_us(&sim->to_server, virtual_now_us);
+	if (wait_us >= 0 && virtual_now_us + (uint64_t)wait_us < next) {
+		next = virtual_now_us + (uint64_t)wait_us;
+	}
+	wait_us = impaired_link_next_timeout_us(&sim->to_client, virtual_now_us);
+	if (wait_us >= 0 && virtual_now_us + (uint64_t)wait_us < next) {
+		next = virtual_now_us + (uint64_t)wait_us;
+	}
+	if (sim->timer_count > 0 && sim->clients[sim->timer_heap[0]].timer_us < next) {
+		next = sim->clients[sim->timer_heap[0]].timer_us;
+	}
+	if (sim->busy && sim->next_done_us < next) {
+		next = sim->next_done_us;
+	}
+
+	// Push: solo a server libero, come i timer del loop tra due lotti
+	int push_wait_ms = subscription_next_timeout_ms(service->subscriptions, get_monotonic_ms());
+	if (!sim->busy && push_wait_ms >= 0) {
+		uint64_t push_us = (get_monotonic_ms() + (uint64_t)push_wait_ms) * 1000u;
+		if (push_us < virtual_now_us) {
+			push_us = virtual_now_us;
+		}
+		if (push_us < next) {
+			next = push_us;
+		}
+	}
+	return next;
+}
+
+static void run(netsim_t *sim, service_t *service) {
+	while (sim->finished < sim->config.requests) {
+		uint64_t next = next_event_us(sim, service);
+		if (next == UINT64_MAX) {
+			break;
+		}
+		virtual_now_us = next;
+
+		// RETE: consegne al server, poi ai client
+		impaired_datagram_t *datagram;
+		while ((datagram = impaired_link_pop_ready(&sim->to_server, virtual_now_us)) != NULL) {
+			queue_push(sim, datagram->session, datagram->data, datagram->length);
+			impaired_link_release(&sim->to_server, datagram);
+		}
+		while ((datagram = impaired_link_pop_ready(&sim->to_client, virtual_now_us)) != NULL) {
+			if (datagram->session >= sim->config.clients) {
+				subscriber_receive(sim, datagram->session, datagram->data, datagram->length);
+			} else {
+				client_receive(sim, datagram->session, datagram->data, datagram->length);
+			}
+			impaired_link_release(&sim->to_client, datagram);
+		}
+
+		// TIMER DEI CLIENT
+		while (sim->timer_count > 0 && sim->clients[sim->timer_heap[0]].timer_us <= virtual_now_us) {
+			int client = sim->timer_heap[0];
+			int kind = sim->clients[client].timer_kind;
+			timer_clear(sim, client);
+			if (kind == TIMER_SEND) {
+				client_send_new(sim, client);
+			} else if (kind == TIMER_RENEW) {
+				subscriber_renew(sim, client);
+			} else {
+				client_timeout(sim, client);
+			}
+		}
+
+		// SERVER
+		server_advance(sim, service);
+	}
+}
+
+/*
+ * ============================================================================
+ * RISULTATI
+ * ============================================================================
+ */
+
+static int compare_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static double percentile_ms(const uint32_t *sorted, long count, double fraction) {
+	if (count == 0) {
+		return 0.0;
+	}
+	long index = (long)(fraction * (double)(count - 1) + 0.5);
+	return sorted[index] / 1000.0;
+}
+
+static void print_latency(const char *label, uint32_t *samples, long count) {
+	if (count == 0) {
+		return;
+	}
+	qsort(samples, (size_t)count, sizeof(uint32_t), compare_u32);
+	printf("Latenza %s: %ld risposte, p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, massima %.3f ms\n", label, count,
+	       percentile_ms(samples, count, 0.50), percentile_ms(samples, count, 0.99),
+	       percentile_ms(samples, count, 0.999), samples[count - 1] / 1000.0);
+}
+
+static void print_results(netsim_t *sim, const subscription_table_t *subscriptions, double wall_s) {
+	const netsim_config_t *cfg = &sim->config;
+	double virtual_s = virtual_now_us / 1e6;
+
+	printf("Client: %d (%d prioritari), %ld richieste, timeout %.1f ms, %d ritrasmissioni, pausa %.3f ms\n",
+	       cfg->clients, (int)(cfg->clients * cfg->priority_percent / 100.0 + 0.5), cfg->requests,
+	       cfg->timeout_us / 1000.0, cfg->retries, cfg->think_us / 1000.0);
+	printf("Rete: perdita %.2f%%, ritardo %.3f ms, jitter %.3f ms, riordino %.2f%%, duplicazione %.2f%%\n",
+	       cfg->network.loss_percent, cfg->network.delay_us / 1000.0, cfg->network.jitter_us / 1000.0,
+	       cfg->network.reorder_percent, cfg->network.duplicate_percent);
+	printf("Server: lotto %d, coda %d, %u us per richiesta, %u us per risveglio, %s\n", cfg->batch, cfg->queue,
+	       cfg->cost_us, cfg->wake_us, cfg->weight == 0 ? "priorità stretta" : "priorità pesata");
+
+	printf("Esito: %ld risposte (%ld con errore), %ld fallite, %llu ritrasmissioni, %llu risposte tardive\n",
+	       sim->answered, sim->invalid, sim->failed, (unsigned long long)sim->retransmissions,
+	       (unsigned long long)sim->late);
+	if (cfg->subscribers > 0) {
+		printf("Push: %llu ricevuti da %d sottoscrittori (%llu inviati), %llu conferme, %d sottoscrizioni attive\n",
+		       (unsigned long long)sim->pushes, cfg->subscribers, (unsigned long long)subscriptions->pushes_sent,
+		       (unsigned long long)sim->subscribe_acks, subscriptions->count);
+	}
+	printf("Rete virtuale: %llu persi verso il server, %llu persi verso i client, %llu duplicati\n",
+	       (unsigned long long)(sim->to_server.lost + sim->to_server.queue_drops),
+	       (unsigned long long)(sim->to_client.lost + sim->to_client.queue_drops),
+	       (unsigned long long)(sim->to_server.duplicated + sim->to_client.duplicated));
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		const netsim_queue_t *queue = &sim->queues[lane];
+		if (queue->received == 0) {
+			continue;
+		}
+		printf("Coda %s: %llu ricevuti, %llu scartati (coda piena), attesa media %.3f ms\n",
+		       lane == LANE_PRIORITY ? "prioritaria" : "normale", (unsigned long long)queue->received,
+		       (unsigned long long)queue->dropped,
+		       queue->served ? queue->wait_us_total / (double)queue->served / 1000.0 : 0.0);
+	}
+	printf("Lotti: %llu, media %.1f, massimo %d; server occupato %.1f%%\n", (unsigned long long)sim->batches,
+	       sim->batches ? (double)(sim->queues[0].served + sim->queues[1].served) / (double)sim->batches : 0.0,
+	       sim->batch_max, virtual_s > 0.0 ? 100.0 * sim->busy_us / 1e6 / virtual_s : 0.0);
+	print_latency("prioritaria", sim->latency_us[LANE_PRIORITY], sim->latency_count[LANE_PRIORITY]);
+	print_latency("normale", sim->latency_us[LANE_BULK], sim->latency_count[LANE_BULK]);
+	printf("Throughput: %.0f risposte/s in %.3f s virtuali\n", virtual_s > 0.0 ? sim->answered / virtual_s : 0.0,
+	       virtual_s);
+	printf("Impronta: %016llx\n", (unsigned long long)sim->fingerprint);
+	printf("Tempo reale: %.3f s (%.1fx il tempo virtuale)\n", wall_s, wall_s > 0.0 ? virtual_s / wall_s : 0.0);
+}
+
+/*
+ * ============================================================================
+ * MAIN
+ * ============================================================================
+ */
+
+static uint64_t wall_clock_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Valore dell'opzione argv[*i], con messaggio di errore se manca */
+static const char *option_value(int argc, char *argv[], int *i) {
+	if (*i + 1 < argc) {
+		return argv[++(*i)];
+	}
+	fprintf(stderr, "Errore: manca il valore per %s\n", argv[*i]);
+	return NULL;
+}
+
+static void print_usage(const char *program) {
+	fprintf(stderr, "Uso: %s [-c client] [-n richieste] [-S seme] [-L perdita%%] [-d ritardo_ms] [-j jitter_ms]\n"
+	                "       [-o riordino%%] [-D duplicazione%%] [-t timeout_ms] [-r ritrasmissioni] [-B lotto]\n"
+	                "       [-Q coda] [-s costo_us] [-w risveglio_us] [-z pausa_ms] [-P prioritari%%] [-W peso]\n"
+	                "       [-U sottoscrittori] [-u intervallo_ms]\n",
+	        program);
+}
+
+int main(int argc, char *argv[]) {
+	netsim_config_t config;
+	memset(&config, 0, sizeof(config));
+	config.clients = 64;
+	config.requests = 1000000;
+	config.seed = 1;
+	config.network.delay_us = 500;
+	config.network.reorder_us = IMPAIR_DEFAULT_REORDER_MS * 1000u;
+	config.timeout_us = 200000;
+	config.retries = 3;
+	config.batch = ENDPOINT_BATCH;
+	config.queue = 256;
+	config.cost_us = 5;
+	config.wake_us = 20;
+	config.push_interval_ms = 1000;
+
+	// PARSING ARGOMENTI
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		if (strlen(option) != 2 || option[0] != '-' || !strchr("cnSLdjoDtrBQswzPWUu", option[1])) {
+			print_usage(argv[0]);
+			return 1;
+		}
+
+		const char *value = option_value(argc, argv, &i);
+		if (!value) {
+			return 1;
+		}
+
+		switch (option[1]) {
+			case 'c':
+				config.clients = atoi(value);
+				break;
+			case 'n':
+				config.requests = atol(value);
+				break;
+			case 'S':
+				config.seed = strtoull(value, NULL, 10);
+				break;
+			case 'L':
+				config.network.loss_percent = atof(value);
+				break;
+			case 'd':
+				config.network.delay_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'j':
+				config.network.jitter_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'o':
+				config.network.reorder_percent = atof(value);
+				break;
+			case 'D':
+				config.network.duplicate_percent = atof(value);
+				break;
+			case 't':
+				config.timeout_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'r':
+				config.retries = atoi(value);
+				break;
+			case 'B':
+				config.batch = atoi(value);
+				break;
+			case 'Q':
+				config.queue = atoi(value);
+				break;
+			case 's':
+				config.cost_us = (uint32_t)atoi(value);
+				break;
+			case 'w':
+				config.wake_us = (uint32_t)atoi(value);
+				break;
+			case 'z':
+				config.think_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'P':
+				config.priority_percent = atof(value);
+				break;
+			case 'W':
+				config.weight = atoi(value);
+				break;
+			case 'U':
+				config.subscribers = atoi(value);
+				break;
+			case 'u':
+				config.push_interval_ms = (uint32_t)atoi(value);
+				break;
+		}
+	}
+
+	if (config.clients <= 0 || config.subscribers < 0 || config.clients + config.subscribers > NETSIM_MAX_CLIENTS) {
+		fprintf(stderr, "Errore: client e sottoscrittori non validi %d + %d (al più %d in tutto)\n", config.clients,
+		        config.subscribers, NETSIM_MAX_CLIENTS);
+		return 1;
+	}
+	if (config.requests <= 0 || config.timeout_us == 0 || config.retries < 0 || config.weight < 0 ||
+	    config.push_interval_ms == 0) {
+		fprintf(stderr, "Errore: richieste, timeout, ritrasmissioni, peso o intervallo dei push non validi\n");
+		return 1;
+	}
+	if (config.batch <= 0 || config.batch > NETSIM_MAX_BATCH || config.queue <= 0 || config.queue > NETSIM_MAX_QUEUE) {
+		fprintf(stderr, "Errore: lotto (1-%d) o coda (1-%d) non validi\n", NETSIM_MAX_BATCH, NETSIM_MAX_QUEUE);
+		return 1;
+	}
+	if (config.network.loss_percent < 0.0 || config.network.loss_percent > 100.0 ||
+	    config.network.reorder_percent < 0.0 || config.network.reorder_percent > 100.0 ||
+	    config.network.duplicate_percent < 0.0 || config.network.duplicate_percent > 100.0 ||
+	    config.priority_percent < 0.0 || config.priority_percent > 100.0) {
+		fprintf(stderr, "Errore: le percentuali devono essere comprese tra 0 e 100\n");
+		return 1;
+	}
+
+	static netsim_t sim;
+	sim.config = config;
+	sim.rng_state = config.seed * 2u + 3u;
+	int sessions = config.clients + config.subscribers;
+	sim.clients = (netsim_client_t *)calloc((size_t)sessions, sizeof(netsim_client_t));
+	sim.timer_heap = (int *)malloc((size_t)sessions * sizeof(int));
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		sim.queues[lane].slots = (netsim_datagram_t *)malloc((size_t)config.queue * sizeof(netsim_datagram_t));
+		sim.latency_us[lane] = (uint32_t *)malloc((size_t)config.requests * sizeof(uint32_t));
+	}
+	sim.fingerprint = 0xCBF29CE484222325ULL;
+
+	// RETE VIRTUALE: una direzione per verso, semi derivati come nel proxy
+	if (!sim.clients || !sim.timer_heap || !sim.queues[0].slots || !sim.queues[1].slots || !sim.latency_us[0] ||
+	    !sim.latency_us[1] || impaired_link_init(&sim.to_server, &config.network, config.seed * 2u + 1u) != 0 ||
+	    impaired_link_init(&sim.to_client, &config.network, config.seed * 2u + 2u) != 0) {
+		fprintf(stderr, "Errore: memoria insufficiente.\n");
+		return 1;
+	}
+
+	// SERVIZIO: stessi moduli del server, stato costruito qui
+	static city_catalogue_t catalogue;
+	static simulation_t simulation;
+	static history_t history;
+	static spatial_index_t spatial_index;
+	static suggest_index_t suggest_index;
+	static subscription_table_t subscriptions;
+	static service_t service;
+	service.catalogue = &catalogue;
+	service.simulation = &simulation;
+	service.history = &history;
+	service.spatial_index = &spatial_index;
+	service.suggest_index = &suggest_index;
+	service.subscriptions = &subscriptions;
+	service.access_log = NULL;
+	service.transport.send = virtual_send;
+	service.transport.send_batch = NULL; // I lotti dei push arrivano un segmento alla volta
+	service.transport.context = &sim;
+	service.quiet = 1;
+	service_activate(&service);
+
+	int supported_count = 0;
+	const city_entry_t *supported_cities = service_supported_cities(&supported_count);
+	if (catalogue_init(&catalogue, supported_cities, supported_count) != 0 ||
+	    spatial_index_build(&spatial_index, catalogue.latitude, catalogue.longitude, catalogue.count) != 0 ||
+	    suggest_index_build(&suggest_index, &catalogue) != 0 ||
+	    simulation_init_at(&simulation, get_city_count(), (uint32_t)config.seed, SIM_DEFAULT_TICK_MS,
+	                       SIM_DEFAULT_TIME_SCALE, get_monotonic_ms(), NETSIM_DAY_SECONDS) != 0 ||
+	    history_init(&history, get_city_count(), HISTORY_DEFAULT_CAPACITY) != 0 ||
+	    subscription_table_init(&subscriptions, SUBSCRIPTION_DEFAULT_CAPACITY, &service.transport, get_monotonic_ms()) != 0) {
+		fprintf(stderr, "Errore: inizializzazione del servizio fallita.\n");
+		return 1;
+	}
+
+	// CLIENT: indirizzi distinti, corsia decisa dalla percentuale, partenze sparse
+	int priority_clients = (int)(config.clients * config.priority_percent / 100.0 + 0.5);
+	for (int i = 0; i < config.clients; i++) {
+		netsim_client_t *c = &sim.clients[i];
+		c->addr.v4.sin_family = AF_INET;
+		c->addr.v4.sin_addr.s_addr = htonl(NETSIM_CLIENT_NET + (uint32_t)i + 1u);
+		c->addr.v4.sin_port = htons(NETSIM_CLIENT_PORT);
+		c->lane = i < priority_clients ? LANE_PRIORITY : LANE_BULK;
+		c->heap_index = -1;
+		timer_set(&sim, i, TIMER_SEND, (uint64_t)(rng_uniform(&sim) * NETSIM_START_SPREAD_US));
+	}
+
+	// SOTTOSCRITTORI: indirizzi dopo i client, una città ciascuno, corsia normale
+	for (int i = config.clients; i < sessions; i++) {
+		netsim_client_t *c = &sim.clients[i];
+		c->addr.v4.sin_family = AF_INET;
+		c->addr.v4.sin_addr.s_addr = htonl(NETSIM_CLIENT_NET + (uint32_t)i + 1u);
+		c->addr.v4.sin_port = htons(NETSIM_CLIENT_PORT);
+		c->lane = LANE_BULK;
+		c->heap_index = -1;
+		strncpy(c->request.city, supported_cities[rng_next(&sim) % (uint64_t)supported_count].name,
+		        sizeof(c->request.city) - 1);
+		timer_set(&sim, i, TIMER_RENEW, (uint64_t)(rng_uniform(&sim) * NETSIM_START_SPREAD_US));
+	}
+
+	uint64_t wall_start_ns = wall_clock_ns();
+	run(&sim, &service);
+	double wall_s = (wall_clock_ns() - wall_start_ns) / 1e9;
+	print_results(&sim, &subscriptions, wall_s);
+
+	subscription_table_free(&subscriptions);
+	history_free(&history);
+	simulation_free(&simulation);
+	suggest_index_free(&suggest_index);
+	spatial_index_free(&spatial_index);
+	catalogue_free(&catalogue);
+	impaired_link_free(&sim.to_server);
+	impaired_link_free(&sim.to_client);
+	for (int lane = 0; lane < LANE_COUNT; lane++) {
+		free(sim.queues[lane].slots);
+		free(sim.latency_us[lane]);
+	}
+	free(sim.timer_heap);
+	free(sim.clients);
+	return sim.failed > 0 && sim.answered == 0 ? 1 : 0;
+}
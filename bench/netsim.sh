@@ -0,0 +1,89 @@
+#!/bin/sh
+#
+# netsim.sh
+#
+# Simulazione deterministica: il servizio del server e molti client simulati
+# in un solo processo, su una rete virtuale degradata e con orologio virtuale
+# (bench/netsim.c). Nessun socket: milioni di richieste in pochi secondi e
+# risultati identici a parità di seme.
+#
+# Per ogni scenario stampa esito, scarti, lotti, latenza per corsia e la
+# riga "Impronta", e la confronta con quella registrata in
+# bench/netsim-golden.txt per le stesse richieste e lo stesso seme: un
+# cambiamento fa fallire lo script. Infine ripete uno scenario e fallisce se
+# l'impronta cambia (regressione del determinismo).
+#
+# Un cambiamento voluto del comportamento si registra con
+# NETSIM_UPDATE_GOLDEN=1, che riscrive le impronte delle combinazioni eseguite.
+#
+# Uso: bench/netsim.sh [richieste] [seme]
+#
+
+set -eu
+
+REQUESTS=${1:-1000000}
+SEED=${2:-42}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+UPDATE_GOLDEN=${NETSIM_UPDATE_GOLDEN:-0}
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+SERVER_SRC="$ROOT/server-project/src"
+GOLDEN="$ROOT/bench/netsim-golden.txt"
+
+# COMPILAZIONE: servizio e moduli del server, codifica del client, rete del proxy
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -I"$SERVER_SRC" -I"$ROOT/proxy-project/src" -o "$BUILD_DIR/netsim" \
+	"$ROOT/bench/netsim.c" \
+	"$SERVER_SRC/service.c" "$SERVER_SRC/catalogue.c" "$SERVER_SRC/spatial.c" "$SERVER_SRC/suggest.c" \
+	"$SERVER_SRC/simulation.c" "$SERVER_SRC/history.c" "$SERVER_SRC/subscription.c" \
+	"$SERVER_SRC/access_log.c" "$SERVER_SRC/endpoints.c" "$SERVER_SRC/lane_policy.c" "$SERVER_SRC/transport.c" \
+	"$ROOT/client-project/src/codec.c" "$ROOT/proxy-project/src/impairment.c" -lm
+
+# SCENARI: identificativo, nome e opzioni di netsim; impronta confrontata con GOLDEN
+changed=0
+run_scenario() {
+	id=$1
+	name=$2
+	shift 2
+	echo "== $name ($*)"
+	output=$("$BUILD_DIR/netsim" -n "$REQUESTS" -S "$SEED" "$@")
+	echo "$output" | grep -E '^(Esito|Push|Coda|Lotti|Latenza|Throughput|Impronta|Tempo reale)' | sed 's/^/  /'
+
+	key="$REQUESTS $SEED $id"
+	fingerprint=$(echo "$output" | sed -n 's/^Impronta: //p')
+	expected=$(grep "^$key " "$GOLDEN" 2>/dev/null | cut -d' ' -f4 || true)
+	if [ "$UPDATE_GOLDEN" = 1 ]; then
+		{ grep -v "^$key " "$GOLDEN" 2>/dev/null || true; echo "$key $fingerprint"; } > "$GOLDEN.tmp"
+		mv "$GOLDEN.tmp" "$GOLDEN"
+	elif [ -z "$expected" ]; then
+		echo "  Attenzione: nessuna impronta registrata per $key"
+	elif [ "$expected" != "$fingerprint" ]; then
+		echo "  Errore: impronta cambiata, registrata $expected" >&2
+		changed=$((changed + 1))
+	fi
+}
+
+run_scenario pulita "rete pulita" -c 64
+run_scenario perdita1 "perdita 1%, jitter 1 ms" -c 64 -L 1 -j 1
+run_scenario perdita5 "perdita 5%, riordino 10%, duplicazione 2%" -c 64 -L 5 -o 10 -D 2 -d 2
+run_scenario lotto1 "sovraccarico, lotto 1" -c 1024 -B 1 -Q 64
+run_scenario lotto32 "sovraccarico, lotto 32" -c 1024 -B 32 -Q 64
+run_scenario stretta "sovraccarico, 10% prioritari (stretta)" -c 1024 -Q 64 -P 10
+run_scenario pesata4 "sovraccarico, 10% prioritari (peso 4)" -c 1024 -Q 64 -P 10 -W 4
+run_scenario push "256 sottoscrittori, push ogni 100 ms, perdita 1%" -c 64 -U 256 -u 100 -L 1
+
+# DETERMINISMO: stesso seme, stessa impronta
+first=$("$BUILD_DIR/netsim" -n "$REQUESTS" -S "$SEED" -c 64 -L 1 -j 1 -o 5 | grep '^Impronta')
+second=$("$BUILD_DIR/netsim" -n "$REQUESTS" -S "$SEED" -c 64 -L 1 -j 1 -o 5 | grep '^Impronta')
+if [ "$first" != "$second" ]; then
+	echo "Errore: esecuzioni con lo stesso seme divergenti ($first / $second)" >&2
+	exit 1
+fi
+echo "Determinismo: $first in entrambe le esecuzioni"
+
+if [ "$changed" -gt 0 ]; then
+	echo "Errore: $changed scenari con impronta diversa da $GOLDEN (NETSIM_UPDATE_GOLDEN=1 se voluto)" >&2
+	exit 1
+fi
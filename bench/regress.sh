@@ -0,0 +1,289 @@
+#!/bin/sh
+#
+# regress.sh
+#
+# Suite di regressione delle prestazioni end-to-end su loopback: compila
+# client e server con ottimizzazioni ed esegue una matrice fissa di scenari
+# (richieste, dimensione delle risposte, client concorrenti, modalità del
+# server). La matrice è ripetuta RUNS volte e ogni ripetizione di uno
+# scenario avvia un server nuovo: il rumore comprende così la variabilità
+# tra un avvio e l'altro (layout di memoria, thread, cache) e la deriva
+# della macchina durante la suite, non solo quella dentro un processo.
+# Per ogni metrica si salvano la mediana e il rumore relativo (1.4826 x
+# deviazione mediana assoluta / mediana, una deviazione standard robusta
+# ai valori anomali):
+#   - throughput  risposte al secondo di tutti i client insieme
+#   - cpu_us      tempo di CPU del server per risposta (tutti i thread)
+#   - p50_us, p99_us, p999_us  latenza del client peggiore
+#
+# Con "salva" i risultati diventano la baseline; con "confronta" (default)
+# sono confrontati con la baseline e lo script fallisce se una metrica
+# peggiora oltre la soglia: max(soglia minima della metrica,
+# 3 x (rumore della baseline + rumore attuale)).
+# La baseline dipende dalla macchina: va salvata su quella del confronto.
+#
+# Uso: bench/regress.sh [confronta|salva] [baseline.tsv]
+# Variabili: REQUESTS (richieste per ripetizione, divise tra i client), RUNS
+#
+
+set -eu
+
+MODE=${1:-confronta}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BASELINE=${2:-"$ROOT/bench/regress-baseline.tsv"}
+REQUESTS=${REQUESTS:-40000}
+RUNS=${RUNS:-5}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+LDLIBS=${LDLIBS:-"-lm -pthread"}
+
+SERVER_PORT=57900
+PRIORITY_PORT=57901
+TIMEOUT_MS=1000
+WARMUP_REQUESTS=2000
+
+case "$MODE" in
+	confronta|salva) ;;
+	*)
+		echo "Uso: $0 [confronta|salva] [baseline.tsv]" >&2
+		exit 1
+		;;
+esac
+if [ "$MODE" = confronta ] && [ ! -f "$BASELINE" ]; then
+	echo "Errore: baseline $BASELINE assente (crearla con: $0 salva)" >&2
+	exit 1
+fi
+
+# COMPILAZIONE
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -o "$BUILD_DIR/server" "$ROOT"/server-project/src/*.c $LDLIBS
+$CC $CFLAGS -o "$BUILD_DIR/client" "$ROOT"/client-project/src/*.c
+
+RESULTS="$BUILD_DIR/regress.tsv"
+SAMPLES="$BUILD_DIR/regress.samples"
+: >"$SAMPLES"
+
+SERVER_PID=""
+cleanup() {
+	if [ -n "$SERVER_PID" ]; then
+		kill "$SERVER_PID" 2>/dev/null || true
+		wait "$SERVER_PID" 2>/dev/null || true
+	fi
+}
+trap cleanup EXIT INT TERM
+
+# CPU del server in nanosecondi, somma di tutti i thread
+server_cpu_ns() {
+	if [ -r "/proc/$SERVER_PID/task/$SERVER_PID/schedstat" ]; then
+		cat /proc/"$SERVER_PID"/task/*/schedstat 2>/dev/null | awk '{ s += $1 } END { printf "%.0f\n", s }'
+	else
+		# Senza schedstat: utime + stime in tick
+		awk -v hz="$(getconf CLK_TCK)" '{ printf "%.0f\n", ($14 + $15) * 1e9 / hz }' "/proc/$SERVER_PID/stat"
+	fi
+}
+
+now_ns() {
+	date +%s%N
+}
+
+start_server() {
+	"$BUILD_DIR/server" -q -p $SERVER_PORT "$@" >"$BUILD_DIR/regress-server.log" 2>&1 &
+	SERVER_PID=$!
+	tries=0
+	until "$BUILD_DIR/client" -p $SERVER_PORT -t 100 -r "t bari" >/dev/null 2>&1; do
+		tries=$((tries + 1))
+		if [ $tries -ge 50 ] || ! kill -0 "$SERVER_PID" 2>/dev/null; then
+			echo "Errore: il server non risponde ($*)" >&2
+			cat "$BUILD_DIR/regress-server.log" >&2
+			exit 1
+		fi
+		sleep 0.1
+	done
+}
+
+stop_server() {
+	kill "$SERVER_PID" 2>/dev/null || true
+	wait "$SERVER_PID" 2>/dev/null || true
+	SERVER_PID=""
+}
+
+# Avvia i client di una ripetizione e attende la fine
+# I client ruotano su richieste (REQUEST_LIST) e porte (PORT_LIST)
+run_clients() {
+	count=$1
+	clients=$2
+	shift 2
+	request_total=$(printf '%s\n' "$REQUEST_LIST" | wc -l)
+	port_total=$(printf '%s\n' "$PORT_LIST" | wc -l)
+	pids=""
+	i=0
+	while [ $i -lt "$clients" ]; do
+		request=$(printf '%s\n' "$REQUEST_LIST" | sed -n "$((i % request_total + 1))p")
+		port=$(printf '%s\n' "$PORT_LIST" | sed -n "$((i % port_total + 1))p")
+		"$BUILD_DIR/client" -p "$port" -t $TIMEOUT_MS "$@" -b "$count" -r "$request" \
+			>"$BUILD_DIR/regress-client.$i" 2>&1 &
+		pids="$pids $!"
+		i=$((i + 1))
+	done
+	for pid in $pids; do
+		wait "$pid" || true
+	done
+}
+
+# SCENARI: nome, opzioni del server, opzioni del client, porte, client, richieste...
+# Una ripetizione: server nuovo, riscaldamento, misura, arresto
+run_scenario() {
+	name=$1
+	server_opts=$2
+	client_opts=$3
+	PORT_LIST=$(printf '%s\n' $4)
+	clients=$5
+	shift 5
+	REQUEST_LIST=$(for request in "$@"; do printf '%s\n' "$request"; done)
+	per_client=$((REQUESTS / clients))
+
+	echo "  $name ($clients client)"
+	start_server $server_opts
+	run_clients $WARMUP_REQUESTS "$clients" $client_opts
+
+	cpu_start=$(server_cpu_ns)
+	wall_start=$(now_ns)
+	run_clients $per_client "$clients" $client_opts
+	wall_end=$(now_ns)
+	cpu_end=$(server_cpu_ns)
+
+	# Somma delle risposte e latenza del client peggiore
+	cat "$BUILD_DIR"/regress-client.* | awk -v name="$name" -v wall=$((wall_end - wall_start)) \
+		-v cpu=$((cpu_end - cpu_start)) '
+		/^Benchmark/ {
+			for (f = 1; f <= NF; f++) {
+				if ($(f + 1) == "risposte,") responses += $f
+				if ($(f + 1) == "errori,") errors += $f
+				if ($f == "p50" && $(f + 1) > p50) p50 = $(f + 1)
+				if ($f == "p99" && $(f + 1) > p99) p99 = $(f + 1)
+				if ($f == "p99.9" && $(f + 1) > p999) p999 = $(f + 1)
+			}
+		}
+		END {
+			if (responses == 0) {
+				printf "Errore: nessuna risposta in %s\n", name > "/dev/stderr"
+				exit 1
+			}
+			if (errors > 0) {
+				printf "Attenzione: %d richieste senza risposta in %s\n", errors, name > "/dev/stderr"
+			}
+			printf "%s\tthroughput\t%.1f\n", name, responses / (wall / 1e9)
+			printf "%s\tcpu_us\t%.3f\n", name, cpu / 1000.0 / responses
+			printf "%s\tp50_us\t%.1f\n", name, p50
+			printf "%s\tp99_us\t%.1f\n", name, p99
+			printf "%s\tp999_us\t%.1f\n", name, p999
+		}' >>"$SAMPLES"
+	stop_server
+	rm -f "$BUILD_DIR"/regress-client.* "$BUILD_DIR"/regress-access.*
+}
+
+# MATRICE: ripetizioni alternate tra gli scenari, così una deriva lenta
+# della macchina finisce nel rumore di tutti invece che in uno solo
+run=1
+while [ $run -le "$RUNS" ]; do
+	echo "== Ripetizione $run di $RUNS"
+	run_scenario udp-temp-c1 "" "" "$SERVER_PORT" 1 "t bari"
+	run_scenario udp-mix-c4 "" "" "$SERVER_PORT" 4 "t bari" "h roma" "w milano" "p napoli"
+	run_scenario udp-mix-c16 "" "" "$SERVER_PORT" 16 "t bari" "h roma" "w milano" "p napoli"
+	run_scenario udp-notfound-c4 "" "-k 0" "$SERVER_PORT" 4 "t atlantide"
+	run_scenario udp-suggest-c4 "" "-k 5" "$SERVER_PORT" 4 "t bariii" "h romaa" "w milan" "p napol"
+	run_scenario log-mix-c4 "-a $BUILD_DIR/regress-access" "" "$SERVER_PORT" 4 "t bari" "h roma" "w milano" "p napoli"
+	run_scenario lanes-mix-c4 "-P $PRIORITY_PORT" "" "$SERVER_PORT $PRIORITY_PORT" 4 "t bari" "h roma" "w milano" "p napoli"
+	run_scenario shm-temp-c1 "-m" "-m" "$SERVER_PORT" 1 "t bari"
+	run=$((run + 1))
+done
+
+# RISULTATI: mediana e rumore di ogni metrica
+{
+	echo "# commit $(git -C "$ROOT" rev-parse --short HEAD 2>/dev/null || echo sconosciuto)"
+	echo "# cflags $CFLAGS"
+	echo "# cpu $(nproc 2>/dev/null || echo 1)"
+	echo "# richieste $REQUESTS, ripetizioni $RUNS"
+	printf 'scenario\tmetrica\tmediana\trumore\n'
+	# Metriche nell'ordine della matrice
+	awk -F '\t' '
+		function median_of(a, n,   i, j, t) {
+			for (i = 2; i <= n; i++) {
+				t = a[i]
+				for (j = i - 1; j >= 1 && a[j] > t; j--) a[j + 1] = a[j]
+				a[j + 1] = t
+			}
+			return n % 2 ? a[(n + 1) / 2] : (a[n / 2] + a[n / 2 + 1]) / 2
+		}
+		!(($1 "\t" $2) in count) { order[++keys] = $1 "\t" $2 }
+		{ samples[$1 "\t" $2, ++count[$1 "\t" $2]] = $3 }
+		END {
+			for (k = 1; k <= keys; k++) {
+				key = order[k]
+				n = count[key]
+				for (i = 1; i <= n; i++) v[i] = samples[key, i]
+				median = median_of(v, n)
+				for (i = 1; i <= n; i++) d[i] = samples[key, i] > median ? samples[key, i] - median : median - samples[key, i]
+				mad = median_of(d, n)
+				printf "%s\t%.3f\t%.4f\n", key, median, (median > 0 ? 1.4826 * mad / median : 0)
+			}
+		}' "$SAMPLES"
+} >"$RESULTS"
+if command -v column >/dev/null 2>&1; then
+	grep -v '^#' "$RESULTS" | column -t -s "$(printf '\t')"
+else
+	grep -v '^#' "$RESULTS"
+fi
+
+if [ "$MODE" = salva ]; then
+	cp "$RESULTS" "$BASELINE"
+	echo "Baseline salvata in $BASELINE"
+	exit 0
+fi
+
+# CONFRONTO: peggioramento relativo oltre la soglia = regressione
+for key in cflags cpu; do
+	old=$(grep "^# $key " "$BASELINE" | cut -d' ' -f3- || true)
+	new=$(grep "^# $key " "$RESULTS" | cut -d' ' -f3-)
+	if [ "$old" != "$new" ]; then
+		echo "Attenzione: $key diverso dalla baseline ($old / $new)" >&2
+	fi
+done
+
+echo "Confronto con $BASELINE ($(grep '^# commit' "$BASELINE" | cut -d' ' -f3))"
+awk -F '\t' '
+	BEGIN {
+		# Soglie minime: su loopback anche throughput e CPU per risposta
+		# variano di oltre il 15% tra esecuzioni identiche; la coda di più
+		minimum["throughput"] = 0.25
+		minimum["cpu_us"] = 0.25
+		minimum["p50_us"] = 0.15
+		minimum["p99_us"] = 0.25
+		minimum["p999_us"] = 0.50
+	}
+	/^#/ || $1 == "scenario" { next }
+	FNR == NR { base[$1 "\t" $2] = $3; base_noise[$1 "\t" $2] = $4; next }
+	{
+		key = $1 "\t" $2
+		if (!(key in base)) {
+			printf "  %-18s %-11s %12.3f  nuovo\n", $1, $2, $3
+			next
+		}
+		if (base[key] <= 0) next
+		# Peggioramento: throughput più basso, tutto il resto più alto
+		change = $2 == "throughput" ? (base[key] - $3) / base[key] : ($3 - base[key]) / base[key]
+		threshold = 3 * (base_noise[key] + $4)
+		if (threshold < minimum[$2]) threshold = minimum[$2]
+		verdict = change > threshold ? "REGRESSIONE" : "ok"
+		if (change > threshold) failed++
+		printf "  %-18s %-11s %12.3f -> %12.3f  %+6.1f%% (soglia %.1f%%)  %s\n", $1, $2, base[key], $3,
+		       ($2 == "throughput" ? -change : change) * 100, threshold * 100, verdict
+	}
+	END {
+		if (failed > 0) {
+			printf "Errore: %d metriche peggiorate oltre la soglia\n", failed > "/dev/stderr"
+			exit 1
+		}
+		print "Nessuna regressione"
+	}' "$BASELINE" "$RESULTS"
@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+# spatial.sh
+#
+# Benchmark dell'indice spaziale per la ricerca per coordinate:
+# k-d tree contro scansione lineare sullo stesso catalogo sintetico
+# (punti uniformi sulla sfera, seme fisso).
+#
+# Uso: bench/spatial.sh [città] [query] [catalogo.csv]
+# Il catalogo generato può essere passato al server con -G.
+#
+
+set -eu
+
+CITIES=${1:-500000}
+QUERIES=${2:-1000000}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -I"$ROOT/server-project/src" -o "$BUILD_DIR/spatial_bench" \
+	"$ROOT/bench/spatial_bench.c" "$ROOT/server-project/src/spatial.c" -lm
+
+if [ $# -ge 3 ]; then
+	"$BUILD_DIR/spatial_bench" "$CITIES" "$QUERIES" "$3"
+else
+	"$BUILD_DIR/spatial_bench" "$CITIES" "$QUERIES"
+fi
@@ -0,0 +1,130 @@
+/*
+ * spatial_bench.c
+ *
+ * Benchmark dell'indice spaziale (server-project/src/spatial.c):
+ * k-d tree contro scansione lineare su un catalogo sintetico.
+ * Verifica anche che le due ricerche diano la stessa distanza.
+ *
+ * Uso: spatial_bench [città] [query] [catalogo.csv]
+ * Con il terzo argomento scrive il catalogo generato (per il server, opzione -G)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "spatial.h"
+
+#define BRUTE_FORCE_QUERIES 200
+
+static uint64_t rng_state = 0x243F6A8885A308D3ULL;
+
+static double uniform(void) {
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (double)((rng_state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Punto uniforme sulla sfera */
+static void random_coordinates(float *latitude, float *longitude) {
+	*latitude = (float)(asin(2.0 * uniform() - 1.0) * 180.0 / 3.14159265358979323846);
+	*longitude = (float)(uniform() * 360.0 - 180.0);
+}
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[]) {
+	int32_t cities = argc > 1 ? atoi(argv[1]) : 500000;
+	int32_t queries = argc > 2 ? atoi(argv[2]) : 1000000;
+	const char *csv_path = argc > 3 ? argv[3] : NULL;
+
+	if (cities <= 0 || queries <= 0) {
+		fprintf(stderr, "Uso: %s [città] [query] [catalogo.csv]\n", argv[0]);
+		return 1;
+	}
+
+	float *latitude = (float *)malloc((size_t)cities * sizeof(float));
+	float *longitude = (float *)malloc((size_t)cities * sizeof(float));
+	float *query_lat = (float *)malloc((size_t)queries * sizeof(float));
+	float *query_lon = (float *)malloc((size_t)queries * sizeof(float));
+	if (!latitude || !longitude || !query_lat || !query_lon) {
+		fprintf(stderr, "Errore: memoria insufficiente.\n");
+		return 1;
+	}
+
+	for (int32_t i = 0; i < cities; i++) {
+		random_coordinates(&latitude[i], &longitude[i]);
+	}
+	for (int32_t i = 0; i < queries; i++) {
+		random_coordinates(&query_lat[i], &query_lon[i]);
+	}
+
+	if (csv_path) {
+		FILE *csv = fopen(csv_path, "w");
+		if (!csv) {
+			fprintf(stderr, "Errore: impossibile scrivere '%s'.\n", csv_path);
+			return 1;
+		}
+		fprintf(csv, "# nome,latitudine,longitudine\n");
+		for (int32_t i = 0; i < cities; i++) {
+			fprintf(csv, "Localita%07d,%.5f,%.5f\n", i, latitude[i], longitude[i]);
+		}
+		fclose(csv);
+	}
+
+	// COSTRUZIONE
+	spatial_index_t index;
+	uint64_t start = now_ns();
+	if (spatial_index_build(&index, latitude, longitude, cities) != 0) {
+		fprintf(stderr, "Errore: costruzione indice fallita.\n");
+		return 1;
+	}
+	double build_ms = (now_ns() - start) / 1e6;
+
+	// K-D TREE
+	int64_t checksum = 0;
+	start = now_ns();
+	for (int32_t i = 0; i < queries; i++) {
+		checksum += spatial_index_nearest(&index, query_lat[i], query_lon[i], NULL);
+	}
+	double tree_ns = (double)(now_ns() - start) / queries;
+
+	// SCANSIONE LINEARE (poche query: costo O(città) ciascuna)
+	int32_t brute_queries = queries < BRUTE_FORCE_QUERIES ? queries : BRUTE_FORCE_QUERIES;
+	start = now_ns();
+	for (int32_t i = 0; i < brute_queries; i++) {
+		checksum += spatial_nearest_brute_force(&index, query_lat[i], query_lon[i], NULL);
+	}
+	double brute_ns = (double)(now_ns() - start) / brute_queries;
+
+	// VERIFICA: stessa distanza (a parità di distanza l'indice può differire)
+	int mismatches = 0;
+	for (int32_t i = 0; i < brute_queries; i++) {
+		float tree_km;
+		float brute_km;
+		spatial_index_nearest(&index, query_lat[i], query_lon[i], &tree_km);
+		spatial_nearest_brute_force(&index, query_lat[i], query_lon[i], &brute_km);
+		if (fabsf(tree_km - brute_km) > 1e-3f) {
+			mismatches++;
+		}
+	}
+
+	printf("Città: %d, costruzione k-d tree: %.1f ms\n", cities, build_ms);
+	printf("k-d tree: %.1f ns/query (%d query)\n", tree_ns, queries);
+	printf("Scansione lineare: %.1f ns/query (%d query), accelerazione %.0fx\n",
+	       brute_ns, brute_queries, brute_ns / tree_ns);
+	printf("Verifica: %d risultati diversi su %d (checksum %lld)\n",
+	       mismatches, brute_queries, (long long)checksum);
+
+	spatial_index_free(&index);
+	free(latitude);
+	free(longitude);
+	free(query_lat);
+	free(query_lon);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+/*
+ * udp_probe.c
+ *
+ * Sonda UDP per gli script di bench: invia una raffica di datagrammi verso
+ * un indirizzo IPv4 o IPv6 e conta le risposte arrivate entro un'attesa.
+ * Il contenuto è una richiesta del protocollo (-q "tipo città"), un testo
+ * (-m, ad esempio "stats" per la porta di amministrazione, con le risposte
+ * stampate) oppure -l byte a zero, per le dimensioni fuori protocollo.
+ *
+ * Uso: udp_probe [-n conteggio] [-q "tipo città" | -m testo | -l byte] [-w attesa_ms]
+ *                indirizzo porta
+ * Stampa "inviati N risposte M" (con -m le risposte stesse).
+ *
+ * Compilazione:
+ *   gcc -O2 -Iserver-project/src -o udp_probe bench/udp_probe.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+
+#define PROBE_MAX_PAYLOAD 2048
+#define PROBE_DEFAULT_WAIT_MS 300       // Silenzio dopo l'ultima risposta prima di terminare
+
+int main(int argc, char *argv[]) {
+	long count = 1;
+	int wait_ms = PROBE_DEFAULT_WAIT_MS;
+	const char *query = NULL;
+	const char *text = NULL;
+	int length = -1;
+	const char *address = NULL;
+	const char *port = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			count = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+			query = argv[++i];
+		} else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+			text = argv[++i];
+		} else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+			length = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			wait_ms = atoi(argv[++i]);
+		} else if (argv[i][0] != '-' && !address) {
+			address = argv[i];
+		} else if (argv[i][0] != '-' && !port) {
+			port = argv[i];
+		} else {
+			fprintf(stderr, "Errore: opzione non valida '%s'\n", argv[i]);
+			return 1;
+		}
+	}
+	if (!address || !port || count <= 0 || (!query && !text && (length < 0 || length > PROBE_MAX_PAYLOAD))) {
+		fprintf(stderr, "Uso: %s [-n conteggio] [-q \"tipo città\" | -m testo | -l byte] [-w attesa_ms] "
+		                "indirizzo porta\n", argv[0]);
+		return 1;
+	}
+
+	// CONTENUTO: richiesta serializzata come nel client (tipo + città su 64 byte)
+	uint8_t payload[PROBE_MAX_PAYLOAD];
+	memset(payload, 0, sizeof(payload));
+	if (query) {
+		if (strlen(query) < 3 || query[1] != ' ') {
+			fprintf(stderr, "Errore: richiesta non valida '%s' (\"tipo città\")\n", query);
+			return 1;
+		}
+		payload[0] = (uint8_t)query[0];
+		strncpy((char *)payload + 1, query + 2, 63);
+		length = (int)REQUEST_SIZE;
+	} else if (text) {
+		length = (int)strlen(text) < PROBE_MAX_PAYLOAD ? (int)strlen(text) : PROBE_MAX_PAYLOAD;
+		memcpy(payload, text, (size_t)length);
+	}
+
+	// DESTINAZIONE: indirizzo numerico IPv4 o IPv6
+	struct addrinfo hints;
+	struct addrinfo *target = NULL;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+	if (getaddrinfo(address, port, &hints, &target) != 0) {
+		fprintf(stderr, "Errore: indirizzo non valido %s porta %s\n", address, port);
+		return 1;
+	}
+	int sock = socket(target->ai_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0 || connect(sock, target->ai_addr, target->ai_addrlen) < 0) {
+		perror("Errore: socket verso la destinazione");
+		freeaddrinfo(target);
+		return 1;
+	}
+	freeaddrinfo(target);
+
+	// RAFFICA: un errore di invio (ad esempio ICMP di porta chiusa) non la interrompe
+	long sent = 0;
+	for (long i = 0; i < count; i++) {
+		if (send(sock, payload, (size_t)length, 0) == length) {
+			sent++;
+		}
+	}
+
+	// RISPOSTE: fino a wait_ms di silenzio
+	long replies = 0;
+	uint8_t reply[PROBE_MAX_PAYLOAD + 1];
+	struct pollfd pfd = { sock, POLLIN, 0 };
+	while (poll(&pfd, 1, wait_ms) > 0) {
+		ssize_t received = recv(sock, reply, PROBE_MAX_PAYLOAD, 0);
+		if (received < 0) {
+			continue;
+		}
+		replies++;
+		if (text) {
+			reply[received] = '\0';
+			fputs((const char *)reply, stdout);
+		}
+	}
+
+	printf("inviati %ld risposte %ld\n", sent, replies);
+	close(sock);
+	return 0;
+}
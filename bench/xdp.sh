@@ -0,0 +1,181 @@
+#!/bin/sh
+#
+# xdp.sh
+#
+# Verifica del filtro XDP (-X) su una coppia veth tra due namespace di rete:
+# il server ascolta in IPv4 e IPv6 dietro il filtro, la sonda udp_probe
+# invia traffico dall'altro capo e lo script controlla i contatori del
+# comando "stats" della porta di amministrazione.
+#
+#   IPv4 valido            risposte a tutte, contati come passati
+#   IPv4 dimensione errata scartati prima del socket (scartati_dimensione)
+#   IPv4 raffica           oltre il limite per sorgente (scartati_frequenza)
+#   IPv6 valido, dimensione errata e raffica
+#                          il filtro è solo IPv4: arrivano al socket e i
+#                          contatori non cambiano
+#
+# Fallisce al primo controllo non rispettato. Richiede Linux, root e
+# ip netns; senza, il test è saltato.
+#
+# Uso: bench/xdp.sh [limite]
+#
+
+set -eu
+
+LIMIT=${1:-100}
+BUILD_DIR=${BUILD_DIR:-/tmp/weather-bench}
+CC=${CC:-gcc}
+CFLAGS=${CFLAGS:-"-std=gnu11 -O2"}
+LDLIBS=${LDLIBS:-"-lm -pthread"}
+
+SERVER_PORT=57950
+ADMIN_PORT=57951
+NS_SERVER="wxdp-s$$"
+NS_CLIENT="wxdp-c$$"
+VETH_SERVER="wxs$$"
+VETH_CLIENT="wxc$$"
+SERVER_V4=10.200.0.1
+CLIENT_V4=10.200.0.2
+SERVER_V6=fd00:200::1
+CLIENT_V6=fd00:200::2
+VALID=$((LIMIT / 2))             # Entro il limite anche se la finestra è la stessa
+WRONG=100
+FLOOD=$((LIMIT * 10))
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+
+# REQUISITI
+if [ "$LIMIT" -lt 2 ]; then
+	echo "Errore: limite non valido $LIMIT (almeno 2)" >&2
+	exit 1
+fi
+if [ "$(uname -s)" != "Linux" ] || [ "$(id -u)" -ne 0 ]; then
+	echo "Attenzione: il filtro XDP richiede Linux e root, test saltato"
+	exit 0
+fi
+if ! ip netns add "$NS_SERVER" 2>/dev/null; then
+	echo "Attenzione: ip netns non disponibile, test saltato"
+	exit 0
+fi
+
+# COMPILAZIONE
+mkdir -p "$BUILD_DIR"
+$CC $CFLAGS -o "$BUILD_DIR/server" "$ROOT"/server-project/src/*.c $LDLIBS
+$CC $CFLAGS -I"$ROOT/server-project/src" -o "$BUILD_DIR/udp_probe" "$ROOT/bench/udp_probe.c"
+
+SERVER_PID=""
+cleanup() {
+	if [ -n "$SERVER_PID" ]; then
+		kill "$SERVER_PID" 2>/dev/null || true
+		wait "$SERVER_PID" 2>/dev/null || true
+	fi
+	ip netns del "$NS_CLIENT" 2>/dev/null || true
+	ip netns del "$NS_SERVER" 2>/dev/null || true
+}
+trap cleanup EXIT INT TERM
+
+# RETE: veth tra i due namespace, IPv4 e IPv6 (senza DAD, subito utilizzabile)
+ip netns add "$NS_CLIENT"
+ip link add "$VETH_SERVER" type veth peer name "$VETH_CLIENT"
+ip link set "$VETH_SERVER" netns "$NS_SERVER"
+ip link set "$VETH_CLIENT" netns "$NS_CLIENT"
+ip -n "$NS_SERVER" addr add "$SERVER_V4/24" dev "$VETH_SERVER"
+ip -n "$NS_CLIENT" addr add "$CLIENT_V4/24" dev "$VETH_CLIENT"
+ip -n "$NS_SERVER" addr add "$SERVER_V6/64" dev "$VETH_SERVER" nodad
+ip -n "$NS_CLIENT" addr add "$CLIENT_V6/64" dev "$VETH_CLIENT" nodad
+for ns in "$NS_SERVER" "$NS_CLIENT"; do
+	ip -n "$ns" link set lo up
+done
+ip -n "$NS_SERVER" link set "$VETH_SERVER" up
+ip -n "$NS_CLIENT" link set "$VETH_CLIENT" up
+
+# SERVER: filtro XDP sulla veth, porta di amministrazione sul loopback del namespace
+ip netns exec "$NS_SERVER" "$BUILD_DIR/server" -q -l "$SERVER_V4:$SERVER_PORT" -l "[$SERVER_V6]:$SERVER_PORT" \
+	-X "$VETH_SERVER,$LIMIT" -A "127.0.0.1:$ADMIN_PORT" >"$BUILD_DIR/xdp_server.out" 2>&1 &
+SERVER_PID=$!
+sleep 0.5
+if ! kill -0 "$SERVER_PID" 2>/dev/null; then
+	echo "Errore: server con -X non avviato" >&2
+	cat "$BUILD_DIR/xdp_server.out" >&2
+	exit 1
+fi
+
+probe() {
+	ip netns exec "$NS_CLIENT" "$BUILD_DIR/udp_probe" "$@" | sed -n 's/^inviati [0-9]* risposte //p'
+}
+
+# CONTATORI: passati, scartati_dimensione, scartati_frequenza e ricevuti dai due socket
+read_stats() {
+	stats=$(ip netns exec "$NS_SERVER" "$BUILD_DIR/udp_probe" -m stats 127.0.0.1 "$ADMIN_PORT")
+	passed=$(echo "$stats" | sed -n 's/^xdp .* passati \([0-9]*\) .*/\1/p')
+	dropped_size=$(echo "$stats" | sed -n 's/^xdp .* scartati_dimensione \([0-9]*\) .*/\1/p')
+	dropped_rate=$(echo "$stats" | sed -n 's/^xdp .* scartati_frequenza \([0-9]*\)$/\1/p')
+	received_v4=$(echo "$stats" | awk -v name="$SERVER_V4:$SERVER_PORT" '$1 == "socket" && $2 == name { print $5 }')
+	received_v6=$(echo "$stats" | awk -v name="[$SERVER_V6]:$SERVER_PORT" '$1 == "socket" && $2 == name { print $5 }')
+	if [ -z "$passed" ] || [ -z "$dropped_size" ] || [ -z "$dropped_rate" ]; then
+		echo "Errore: contatori XDP assenti da stats" >&2
+		echo "$stats" >&2
+		exit 1
+	fi
+}
+
+# Differenze rispetto all'ultima lettura
+snapshot() {
+	read_stats
+	prev_passed=$passed
+	prev_size=$dropped_size
+	prev_rate=$dropped_rate
+	prev_v4=$received_v4
+	prev_v6=$received_v6
+}
+
+check() {
+	description=$1
+	shift
+	if [ "$@" ]; then
+		echo "  ok: $description"
+	else
+		echo "Errore: $description" >&2
+		echo "$stats" >&2
+		exit 1
+	fi
+}
+
+echo "== XDP su $VETH_SERVER, limite $LIMIT datagrammi/s per sorgente"
+
+# IPV4 VALIDO
+snapshot
+replies=$(probe -n $VALID -q "t Roma" "$SERVER_V4" "$SERVER_PORT")
+read_stats
+check "IPv4 valido: $replies/$VALID risposte" "$replies" -eq $VALID
+check "IPv4 valido: $((passed - prev_passed)) passati" $((passed - prev_passed)) -eq $VALID
+check "IPv4 valido: nessuno scartato" $((dropped_size + dropped_rate - prev_size - prev_rate)) -eq 0
+
+# IPV4 DIMENSIONE ERRATA
+snapshot
+replies=$(probe -n $WRONG -l 3 "$SERVER_V4" "$SERVER_PORT")
+read_stats
+check "IPv4 dimensione errata: $((dropped_size - prev_size))/$WRONG scartati" $((dropped_size - prev_size)) -eq $WRONG
+check "IPv4 dimensione errata: nessuno al socket" $((received_v4 - prev_v4)) -eq 0
+
+# IPV4 RAFFICA: in una finestra passano al più LIMIT (due se la raffica la scavalca)
+snapshot
+replies=$(probe -n $FLOOD -q "t Roma" "$SERVER_V4" "$SERVER_PORT")
+read_stats
+check "IPv4 raffica: $((dropped_rate - prev_rate)) scartati per frequenza" $((dropped_rate - prev_rate)) -gt 0
+check "IPv4 raffica: $((passed - prev_passed)) passati (al più $((2 * LIMIT)))" $((passed - prev_passed)) -le $((2 * LIMIT))
+
+# IPV6: nessun controllo del filtro, contatori invariati
+snapshot
+replies=$(probe -n $VALID -q "t Roma" "$SERVER_V6" "$SERVER_PORT")
+check "IPv6 valido: $replies/$VALID risposte" "$replies" -eq $VALID
+replies=$(probe -n $WRONG -l 3 "$SERVER_V6" "$SERVER_PORT")
+read_stats
+check "IPv6 dimensione errata: $((received_v6 - prev_v6 - VALID))/$WRONG al socket" \
+	$((received_v6 - prev_v6 - VALID)) -eq $WRONG
+replies=$(probe -n $FLOOD -q "t Roma" "$SERVER_V6" "$SERVER_PORT")
+read_stats
+check "IPv6: contatori XDP invariati" \
+	$((passed + dropped_size + dropped_rate - prev_passed - prev_size - prev_rate)) -eq 0
+
+echo "Filtro XDP verificato"
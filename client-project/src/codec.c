@@ -0,0 +1,271 @@
+/*
+ * codec.c
+ *
+ * Serializzazione dei messaggi lato client (prototipi in protocol.h)
+ * Separata da main.c per l'harness di simulazione (bench/netsim.c), che
+ * genera le richieste e legge le risposte con le stesse funzioni del client.
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+#include <string.h>
+#include "protocol.h"
+
+/*
+ * Serializzazione manuale della richiesta
+ */
+int serialize_request(const weather_request_t *request, uint8_t *buffer) {
+	if (!request || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo type: 1 byte
+	buffer[offset] = (uint8_t)request->type;
+	offset += 1;
+
+	// Campo city: 64 byte
+	memcpy(buffer + offset, request->city, 64);
+	offset += 64;
+
+	return offset; // Ritorna 65 byte
+}
+
+/*
+ * Serializzazione manuale della sottoscrizione
+ */
+int serialize_subscribe(const subscribe_request_t *request, uint8_t *buffer) {
+	if (!request || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo type: 1 byte, sempre TYPE_SUBSCRIBE
+	buffer[offset] = (uint8_t)TYPE_SUBSCRIBE;
+	offset += 1;
+
+	// Campo city: 64 byte
+	memcpy(buffer + offset, request->city, 64);
+	offset += 64;
+
+	// Campo types: 1 byte
+	buffer[offset] = request->types;
+	offset += 1;
+
+	// Campo interval_ms: 4 byte uint32_t - CONVERSIONE in network byte order
+	uint32_t net_interval = htonl(request->interval_ms);
+	memcpy(buffer + offset, &net_interval, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	return offset; // Ritorna 70 byte
+}
+
+/*
+ * Deserializzazione della risposta
+ */
+int deserialize_response(const uint8_t *buffer, weather_response_t *response) {
+	if (!buffer || !response) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo status: 4 byte uint32_t - CONVERSIONE da network byte order
+	uint32_t net_status;
+	memcpy(&net_status, buffer + offset, sizeof(uint32_t));
+	response->status = ntohl(net_status);
+	offset += sizeof(uint32_t);
+
+	// Campo type: 1 byte - nessuna conversione
+	response->type = (char)buffer[offset];
+	offset += 1;
+
+	// Campo value: 4 byte float - CONVERSIONE da network byte order
+	// Tecnica: float -> uint32_t -> ntohl() -> float
+	uint32_t net_bits;
+	memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
+	uint32_t host_bits = ntohl(net_bits);
+	memcpy(&response->value, &host_bits, sizeof(float));
+	offset += sizeof(float);
+
+	return 0; // Successo
+}
+
+/*
+ * Serializzazione query aggregata
+ */
+int serialize_aggregate_request(const aggregate_request_t *request, uint8_t *buffer) {
+	if (!request || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo type: 1 byte, sempre TYPE_AGGREGATE
+	buffer[offset] = (uint8_t)TYPE_AGGREGATE;
+	offset += 1;
+
+	// Campo city: 64 byte
+	memcpy(buffer + offset, request->city, 64);
+	offset += 64;
+
+	// Campo type del dato: 1 byte
+	buffer[offset] = (uint8_t)request->type;
+	offset += 1;
+
+	// Campo window_s: 4 byte uint32_t - CONVERSIONE in network byte order
+	uint32_t net_window = htonl(request->window_s);
+	memcpy(buffer + offset, &net_window, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	return offset; // Ritorna 70 byte
+}
+
+/*
+ * Deserializzazione risposta aggregata
+ */
+int deserialize_aggregate_response(const uint8_t *buffer, aggregate_response_t *response) {
+	if (!buffer || !response) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_status;
+	memcpy(&net_status, buffer + offset, sizeof(uint32_t));
+	response->status = ntohl(net_status);
+	offset += sizeof(uint32_t);
+
+	response->type = (char)buffer[offset];
+	offset += 1;
+
+	uint32_t net_count;
+	memcpy(&net_count, buffer + offset, sizeof(uint32_t));
+	response->count = ntohl(net_count);
+	offset += sizeof(uint32_t);
+
+	// min, max, avg: buffer -> ntohl() -> uint32_t -> float
+	float values[3];
+	for (int i = 0; i < 3; i++) {
+		uint32_t net_bits;
+		memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
+		uint32_t bits = ntohl(net_bits);
+		memcpy(&values[i], &bits, sizeof(float));
+		offset += sizeof(uint32_t);
+	}
+	response->min = values[0];
+	response->max = values[1];
+	response->avg = values[2];
+
+	return 0;
+}
+
+/*
+ * Serializzazione ricerca per coordinate
+ */
+int serialize_nearest_request(const nearest_request_t *request, uint8_t *buffer) {
+	if (!request || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo type: 1 byte, sempre TYPE_NEAREST
+	buffer[offset] = (uint8_t)TYPE_NEAREST;
+	offset += 1;
+
+	// Campi latitude e longitude: float -> uint32_t -> htonl() -> buffer
+	const float coordinates[2] = { request->latitude, request->longitude };
+	for (int i = 0; i < 2; i++) {
+		uint32_t bits;
+		memcpy(&bits, &coordinates[i], sizeof(float));
+		uint32_t net_bits = htonl(bits);
+		memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+	}
+
+	// Campo type del dato: 1 byte
+	buffer[offset] = (uint8_t)request->type;
+	offset += 1;
+
+	return offset; // Ritorna 10 byte
+}
+
+/*
+ * Deserializzazione risposta per coordinate
+ */
+int deserialize_nearest_response(const uint8_t *buffer, nearest_response_t *response) {
+	if (!buffer || !response) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_status;
+	memcpy(&net_status, buffer + offset, sizeof(uint32_t));
+	response->status = ntohl(net_status);
+	offset += sizeof(uint32_t);
+
+	response->type = (char)buffer[offset];
+	offset += 1;
+
+	// value, distance_km: buffer -> ntohl() -> uint32_t -> float
+	float values[2];
+	for (int i = 0; i < 2; i++) {
+		uint32_t net_bits;
+		memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
+		uint32_t bits = ntohl(net_bits);
+		memcpy(&values[i], &bits, sizeof(float));
+		offset += sizeof(uint32_t);
+	}
+	response->value = values[0];
+	response->distance_km = values[1];
+
+	memcpy(response->city, buffer + offset, 64);
+	response->city[63] = '\0'; // Assicura null-termination
+
+	return 0;
+}
+
+/*
+ * Deserializzazione suggerimenti (byte successivi alla risposta)
+ */
+int deserialize_suggestions(const uint8_t *buffer, int length, city_suggestions_t *suggestions) {
+	if (!buffer || !suggestions || length < 1) {
+		return -1;
+	}
+
+	memset(suggestions, 0, sizeof(*suggestions));
+	int offset = 0;
+
+	// Campo count: 1 byte
+	uint8_t count = buffer[offset];
+	offset += 1;
+	if (count > SUGGEST_MAX_COUNT) {
+		return -1;
+	}
+
+	// Nomi: lunghezza (1 byte) + caratteri, entro i byte ricevuti
+	for (int i = 0; i < count; i++) {
+		if (offset >= length) {
+			return -1;
+		}
+		uint8_t name_length = buffer[offset];
+		offset += 1;
+		if (name_length > 63 || offset + name_length > length) {
+			return -1;
+		}
+		memcpy(suggestions->names[i], buffer + offset, name_length);
+		suggestions->names[i][name_length] = '\0';
+		offset += name_length;
+	}
+	suggestions->count = count;
+
+	return 0;
+}
@@ -0,0 +1,308 @@
+/*
+ * listener.c
+ *
+ * Ricezione e ricostruzione dello snapshot multicast
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+#else
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#define closesocket close
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "listener.h"
+
+/* Oltre questa distanza all'indietro la sequenza viene considerata ripartita */
+#define SNAPSHOT_RESYNC_WINDOW 1024
+
+/*
+ * Deserializzazione intestazione snapshot
+ */
+int deserialize_snapshot_header(const uint8_t *buffer, snapshot_header_t *header) {
+	if (!buffer || !header) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_magic;
+	memcpy(&net_magic, buffer + offset, sizeof(uint32_t));
+	if (ntohl(net_magic) != SNAPSHOT_MAGIC) {
+		return -1;
+	}
+	offset += sizeof(uint32_t);
+
+	uint32_t net_seq;
+	memcpy(&net_seq, buffer + offset, sizeof(uint32_t));
+	header->seq = ntohl(net_seq);
+	offset += sizeof(uint32_t);
+
+	uint32_t net_id;
+	memcpy(&net_id, buffer + offset, sizeof(uint32_t));
+	header->snapshot_id = ntohl(net_id);
+	offset += sizeof(uint32_t);
+
+	uint16_t net_part;
+	memcpy(&net_part, buffer + offset, sizeof(uint16_t));
+	header->part = ntohs(net_part);
+	offset += sizeof(uint16_t);
+
+	uint16_t net_count;
+	memcpy(&net_count, buffer + offset, sizeof(uint16_t));
+	header->part_count = ntohs(net_count);
+	offset += sizeof(uint16_t);
+
+	uint16_t net_records;
+	memcpy(&net_records, buffer + offset, sizeof(uint16_t));
+	header->record_count = ntohs(net_records);
+
+	return 0;
+}
+
+int listener_open(const char *group_ip, int port, const char *interface_ip) {
+	if (!group_ip) {
+		return -1;
+	}
+
+	int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		fprintf(stderr, "Errore: creazione socket multicast fallita.\n");
+		return -1;
+	}
+
+	// Più listener sullo stesso host condividono la porta
+	int reuse = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+	struct sockaddr_in local_addr;
+	memset(&local_addr, 0, sizeof(local_addr));
+	local_addr.sin_family = AF_INET;
+	local_addr.sin_port = htons((unsigned short)port);
+	local_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (bind(sock, (struct sockaddr *)&local_addr, sizeof(local_addr)) < 0) {
+		fprintf(stderr, "Errore: bind() sulla porta %d fallita.\n", port);
+		closesocket(sock);
+		return -1;
+	}
+
+	// ISCRIZIONE AL GRUPPO
+	struct ip_mreq membership;
+	memset(&membership, 0, sizeof(membership));
+	membership.imr_multiaddr.s_addr = inet_addr(group_ip);
+	membership.imr_interface.s_addr = interface_ip ? inet_addr(interface_ip) : htonl(INADDR_ANY);
+
+	if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const char *)&membership, sizeof(membership)) < 0) {
+		fprintf(stderr, "Errore: iscrizione al gruppo %s fallita.\n", group_ip);
+		closesocket(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+static int table_reserve(snapshot_table_t *table, int capacity) {
+	if (table->capacity >= capacity) {
+		return 0;
+	}
+	snapshot_city_t *cities = (snapshot_city_t *)realloc(table->cities, (size_t)capacity * sizeof(snapshot_city_t));
+	if (!cities) {
+		return -1;
+	}
+	table->cities = cities;
+	table->capacity = capacity;
+	return 0;
+}
+
+void snapshot_cache_free(snapshot_cache_t *cache) {
+	if (!cache) {
+		return;
+	}
+	free(cache->current.cities);
+	free(cache->staging.cities);
+	free(cache->part_seen);
+	memset(cache, 0, sizeof(*cache));
+}
+
+/* Inizia la ricostruzione di un nuovo snapshot */
+static int staging_reset(snapshot_cache_t *cache, const snapshot_header_t *header) {
+	if (cache->staging_active && cache->staging_received < cache->staging_parts) {
+		cache->snapshots_incomplete++;
+	}
+
+	if (cache->part_seen_capacity < header->part_count) {
+		uint8_t *seen = (uint8_t *)realloc(cache->part_seen, header->part_count);
+		if (!seen) {
+			return -1;
+		}
+		cache->part_seen = seen;
+		cache->part_seen_capacity = header->part_count;
+	}
+	memset(cache->part_seen, 0, header->part_count);
+
+	cache->staging.count = 0;
+	cache->staging.snapshot_id = header->snapshot_id;
+	cache->staging_parts = header->part_count;
+	cache->staging_received = 0;
+	cache->staging_active = 1;
+	return 0;
+}
+
+int snapshot_process_datagram(snapshot_cache_t *cache, const uint8_t *buffer, int length,
+                              const struct sockaddr_in *from) {
+	if (!cache || !buffer || length < SNAPSHOT_HEADER_SIZE) {
+		return -1;
+	}
+
+	snapshot_header_t header;
+	if (deserialize_snapshot_header(buffer, &header) != 0 ||
+	    header.part_count == 0 || header.part >= header.part_count) {
+		return -1;
+	}
+
+	// RILEVAMENTO BUCHI: seq cresce di 1 per datagramma
+	cache->datagrams_received++;
+	if (cache->seq_valid) {
+		int32_t gap = (int32_t)(header.seq - cache->expected_seq);
+		if (gap > 0) {
+			cache->datagrams_lost += (uint64_t)gap;
+		}
+		if (gap < 0 && gap > -SNAPSHOT_RESYNC_WINDOW) {
+			return 0; // Duplicato o fuori ordine rispetto a datagrammi già visti
+		}
+		if (gap < 0) {
+			// Salto all'indietro molto grande: il server è stato riavviato
+			cache->staging_active = 0;
+			cache->current.snapshot_id = header.snapshot_id - 1;
+		}
+	}
+	cache->expected_seq = header.seq + 1;
+	cache->seq_valid = 1;
+
+	// SNAPSHOT DI APPARTENENZA
+	if (cache->has_snapshot && header.snapshot_id == cache->current.snapshot_id) {
+		return 0;
+	}
+	if (!cache->staging_active || header.snapshot_id != cache->staging.snapshot_id) {
+		if (cache->staging_active && (int32_t)(header.snapshot_id - cache->staging.snapshot_id) < 0) {
+			return 0; // Snapshot più vecchio di quello in ricostruzione
+		}
+		if (staging_reset(cache, &header) != 0) {
+			return -1;
+		}
+	}
+	if (header.part_count != cache->staging_parts || cache->part_seen[header.part]) {
+		return 0;
+	}
+
+	// DESERIALIZZAZIONE RECORD
+	if (table_reserve(&cache->staging, cache->staging.count + header.record_count) != 0) {
+		return -1;
+	}
+
+	int offset = SNAPSHOT_HEADER_SIZE;
+	for (int r = 0; r < header.record_count; r++) {
+		if (offset + 1 > length) {
+			return -1;
+		}
+		int name_len = buffer[offset];
+		offset += 1;
+		if (name_len >= 64 || offset + name_len + SNAPSHOT_METRICS * (int)sizeof(uint32_t) > length) {
+			return -1;
+		}
+
+		snapshot_city_t *city = &cache->staging.cities[cache->staging.count + r];
+		memcpy(city->name, buffer + offset, (size_t)name_len);
+		city->name[name_len] = '\0';
+		offset += name_len;
+
+		for (int m = 0; m < SNAPSHOT_METRICS; m++) {
+			// Tecnica: buffer -> uint32_t -> ntohl() -> float
+			uint32_t net_bits;
+			memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
+			uint32_t host_bits = ntohl(net_bits);
+			memcpy(&city->values[m], &host_bits, sizeof(float));
+			offset += sizeof(uint32_t);
+		}
+	}
+	cache->staging.count += header.record_count;
+	cache->part_seen[header.part] = 1;
+	cache->staging_received++;
+
+	if (cache->staging_received < cache->staging_parts) {
+		return 0;
+	}
+
+	// SNAPSHOT COMPLETO: diventa quello corrente
+	snapshot_table_t completed = cache->staging;
+	cache->staging = cache->current;
+	cache->current = completed;
+	cache->staging_active = 0;
+	cache->has_snapshot = 1;
+	cache->snapshots_completed++;
+	if (from) {
+		cache->source = *from;
+	}
+	return 1;
+}
+
+static int equals_ignore_case(const char *a, const char *b) {
+	while (*a && *b) {
+		if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+			return 0;
+		}
+		a++;
+		b++;
+	}
+	return *a == '\0' && *b == '\0';
+}
+
+int snapshot_lookup(const snapshot_cache_t *cache, const weather_request_t *request,
+                    weather_response_t *response) {
+	if (!cache || !request || !response || !cache->has_snapshot) {
+		return -1;
+	}
+
+	memset(response, 0, sizeof(*response));
+	response->type = request->type;
+
+	// Stesse regole di validazione del server
+	int metric;
+	switch (request->type) {
+		case TYPE_TEMPERATURE: metric = 0; break;
+		case TYPE_HUMIDITY: metric = 1; break;
+		case TYPE_WIND: metric = 2; break;
+		case TYPE_PRESSURE: metric = 3; break;
+		default:
+			response->status = STATUS_INVALID_REQUEST;
+			return 0;
+	}
+	for (const char *c = request->city; *c; c++) {
+		if (!isalnum((unsigned char)*c) && *c != ' ') {
+			response->status = STATUS_INVALID_REQUEST;
+			return 0;
+		}
+	}
+
+	for (int i = 0; i < cache->current.count; i++) {
+		if (equals_ignore_case(request->city, cache->current.cities[i].name)) {
+			response->status = STATUS_SUCCESS;
+			response->value = cache->current.cities[i].values[metric];
+			return 0;
+		}
+	}
+
+	response->status = STATUS_CITY_NOT_FOUND;
+	return 0;
+}
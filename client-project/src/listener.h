@@ -0,0 +1,80 @@
+/*
+ * listener.h
+ *
+ * Ricezione dello snapshot multicast pubblicato dal server
+ * Il client tiene in memoria l'ultimo snapshot completo e risponde alle
+ * richieste "type city" localmente, senza round trip verso il server.
+ */
+
+#ifndef LISTENER_H_
+#define LISTENER_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include <stdint.h>
+#include "protocol.h"
+
+/* Valori di una città nello snapshot */
+typedef struct {
+	char name[64];
+	float values[SNAPSHOT_METRICS];  // t, h, w, p
+} snapshot_city_t;
+
+/* Insieme di città (snapshot completo oppure in ricostruzione) */
+typedef struct {
+	snapshot_city_t *cities;
+	int count;
+	int capacity;
+	uint32_t snapshot_id;
+} snapshot_table_t;
+
+typedef struct {
+	snapshot_table_t current;        // Ultimo snapshot completo
+	int has_snapshot;                // 1 dopo il primo snapshot completo
+	struct sockaddr_in source;       // Mittente dell'ultimo snapshot completo
+
+	snapshot_table_t staging;        // Snapshot in ricostruzione
+	int staging_active;
+	uint16_t staging_parts;          // Datagrammi attesi
+	uint16_t staging_received;       // Datagrammi ricevuti
+	uint8_t *part_seen;              // Un flag per datagramma (scarta i duplicati)
+	int part_seen_capacity;
+
+	/* Rilevamento buchi nella sequenza */
+	uint32_t expected_seq;
+	int seq_valid;
+	uint64_t datagrams_received;
+	uint64_t datagrams_lost;
+	uint64_t snapshots_completed;
+	uint64_t snapshots_incomplete;   // Snapshot abbandonati per datagrammi mancanti
+} snapshot_cache_t;
+
+/*
+ * Crea un socket iscritto al gruppo multicast group_ip:port
+ * interface_ip: interfaccia su cui ricevere (NULL = scelta del kernel)
+ * Ritorna il socket oppure -1 in caso di errore
+ */
+int listener_open(const char *group_ip, int port, const char *interface_ip);
+
+/* Libera la memoria della cache */
+void snapshot_cache_free(snapshot_cache_t *cache);
+
+/*
+ * Elabora un datagramma snapshot
+ * Ritorna 1 se ha completato un nuovo snapshot, 0 altrimenti, -1 se il datagramma non è valido
+ */
+int snapshot_process_datagram(snapshot_cache_t *cache, const uint8_t *buffer, int length,
+                              const struct sockaddr_in *from);
+
+/*
+ * Risponde a una richiesta dall'ultimo snapshot completo
+ * Ritorna 0 e riempie response (status come il server), -1 se non c'è ancora uno snapshot
+ */
+int snapshot_lookup(const snapshot_cache_t *cache, const weather_request_t *request,
+                    weather_response_t *response);
+
+#endif /* LISTENER_H_ */
@@ -15,6 +15,8 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <errno.h>
+#include <sys/select.h>
 #define closesocket close
 #endif
 
@@ -22,7 +24,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <signal.h>
+#include <time.h>
 #include "protocol.h"
+#include "listener.h"
+#include "shm_transport.h"
+#include "replicas.h"
+#include "replay.h"
+#include "response_cache.h"
 
 void clearwinsock() {
 #if defined WIN32
@@ -97,55 +106,73 @@ int parse_weather_request(const char *input, weather_request_t *request) {
 }
 
 /*
- * Serializzazione manuale della richiesta
+ * Conversione tipo -> bit della maschera di sottoscrizione
  */
-int serialize_request(const weather_request_t *request, uint8_t *buffer) {
-	if (!request || !buffer) {
-		return -1;
+uint8_t type_to_sub_mask(char type) {
+	switch (type) {
+		case TYPE_TEMPERATURE:
+			return SUB_MASK_TEMPERATURE;
+		case TYPE_HUMIDITY:
+			return SUB_MASK_HUMIDITY;
+		case TYPE_WIND:
+			return SUB_MASK_WIND;
+		case TYPE_PRESSURE:
+			return SUB_MASK_PRESSURE;
+		default:
+			return 0;
 	}
-
-	int offset = 0;
-
-	// Campo type: 1 byte
-	buffer[offset] = (uint8_t)request->type;
-	offset += 1;
-
-	// Campo city: 64 byte
-	memcpy(buffer + offset, request->city, 64);
-	offset += 64;
-
-	return offset; // Ritorna 65 byte
 }
 
 /*
- * Deserializzazione della risposta
+ * Parsing della richiesta di sottoscrizione: "types city"
+ * Il primo token può contenere più tipi (es. "th roma" = temperatura e umidità)
  */
-int deserialize_response(const uint8_t *buffer, weather_response_t *response) {
-	if (!buffer || !response) {
-		return -1;
+int parse_subscribe_request(const char *input, subscribe_request_t *request) {
+	if (input == NULL || request == NULL || strlen(input) < 3) {
+		return 0;
+	}
+
+	if (strchr(input, '\t') != NULL) {
+		fprintf(stderr, "Errore: la richiesta non può contenere caratteri di tabulazione.\n");
+		return 0;
+	}
+
+	const char *first_space = strchr(input, ' ');
+	if (!first_space) {
+		fprintf(stderr, "Errore: formato richiesta invalido. Usa: \"tipi città\"\n");
+		return 0;
 	}
 
-	int offset = 0;
+	// PARSING DEI TIPI
+	request->types = 0;
+	for (const char *t = input; t < first_space; t++) {
+		uint8_t mask = type_to_sub_mask(*t);
+		if (mask == 0) {
+			fprintf(stderr, "Errore: tipo '%c' non valido ('t', 'h', 'w', 'p').\n", *t);
+			return 0;
+		}
+		request->types |= mask;
+	}
 
-	// Campo status: 4 byte uint32_t - CONVERSIONE da network byte order
-	uint32_t net_status;
-	memcpy(&net_status, buffer + offset, sizeof(uint32_t));
-	response->status = ntohl(net_status);
-	offset += sizeof(uint32_t);
+	const char *cursor = first_space;
+	while (*cursor == ' ') {
+		cursor++;
+	}
 
-	// Campo type: 1 byte - nessuna conversione
-	response->type = (char)buffer[offset];
-	offset += 1;
+	if (*cursor == '\0') {
+		fprintf(stderr, "Errore: nome città mancante.\n");
+		return 0;
+	}
 
-	// Campo value: 4 byte float - CONVERSIONE da network byte order
-	// Tecnica: float -> uint32_t -> ntohl() -> float
-	uint32_t net_bits;
-	memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
-	uint32_t host_bits = ntohl(net_bits);
-	memcpy(&response->value, &host_bits, sizeof(float));
-	offset += sizeof(float);
+	if (strlen(cursor) >= 64) {
+		fprintf(stderr, "Errore: nome città troppo lungo (massimo 63 caratteri).\n");
+		return 0;
+	}
 
-	return 0; // Successo
+	strncpy(request->city, cursor, sizeof(request->city) - 1);
+	request->city[sizeof(request->city) - 1] = '\0';
+
+	return 1;
 }
 
 /*
@@ -199,6 +226,32 @@ int resolve_host(const char *input, char *hostname_out, size_t hostname_size, ch
 	return 0;
 }
 
+/*
+ * Orologio monotono
+ */
+uint64_t get_monotonic_ms(void) {
+#if defined WIN32
+	return (uint64_t)GetTickCount64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000u + (uint64_t)(ts.tv_nsec / 1000000);
+#endif
+}
+
+uint64_t get_monotonic_ns(void) {
+#if defined WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
 /*
  * Stampa il risultato formattato
  */
@@ -244,11 +297,841 @@ void print_result(const weather_response_t *response, const weather_request_t *r
 	}
 }
 
+/*
+ * Modalità sottoscrizione
+ */
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int signum) {
+	(void)signum;
+	stop_requested = 1;
+}
+
+static int send_subscribe(int sock, const struct sockaddr_in *server_addr, const subscribe_request_t *sub) {
+	uint8_t send_buffer[SUBSCRIBE_SIZE];
+	int serialized_len = serialize_subscribe(sub, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
+		return -1;
+	}
+
+	int bytes_sent = sendto(sock, (char *)send_buffer, serialized_len, 0,
+	                        (const struct sockaddr *)server_addr, sizeof(*server_addr));
+	if (bytes_sent != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+		return -1;
+	}
+	return 0;
+}
+
+/*
+ * Registra la sottoscrizione sulla prima replica, stampa i push ricevuti e
+ * rinnova il lease fino a Ctrl+C; all'uscita annulla la sottoscrizione
+ */
+int run_subscription(int sock, const replica_set_t *replicas, subscribe_request_t *sub,
+                     const char *server_name, const char *server_ip) {
+	const struct sockaddr_in *server_addr = &replicas->replicas[0].addr;
+	// Per print_result() basta la città
+	weather_request_t request;
+	memset(&request, 0, sizeof(request));
+	memcpy(request.city, sub->city, sizeof(request.city));
+
+	signal(SIGINT, handle_sigint);
+
+	const uint64_t renew_period_ms = SUBSCRIPTION_LEASE_MS / 3;
+	uint64_t next_renew_ms = 0;
+	int exit_code = 0;
+
+	while (!stop_requested) {
+		uint64_t now_ms = get_monotonic_ms();
+
+		// RINNOVO LEASE (il primo invio registra la sottoscrizione)
+		if (now_ms >= next_renew_ms) {
+			if (send_subscribe(sock, server_addr, sub) != 0) {
+				exit_code = 1;
+				break;
+			}
+			next_renew_ms = now_ms + renew_period_ms;
+		}
+
+		// Attesa con timeout limitato per controllare Ctrl+C anche su Windows
+		uint64_t wait_ms = next_renew_ms - now_ms;
+		if (wait_ms > 1000) {
+			wait_ms = 1000;
+		}
+
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+		struct timeval timeout;
+		timeout.tv_sec = (long)(wait_ms / 1000);
+		timeout.tv_usec = (long)(wait_ms % 1000) * 1000;
+
+		int ready = select(sock + 1, &read_set, NULL, NULL, &timeout);
+		if (ready <= 0) {
+			continue; // Timeout o interruzione da segnale
+		}
+
+		uint8_t recv_buffer[RESPONSE_SIZE];
+		struct sockaddr_in from_addr;
+#if defined WIN32
+		int from_len = sizeof(from_addr);
+#else
+		socklen_t from_len = sizeof(from_addr);
+#endif
+
+		int bytes_received = recvfrom(sock, (char *)recv_buffer, RESPONSE_SIZE, 0,
+		                              (struct sockaddr *)&from_addr, &from_len);
+		if (bytes_received != (int)RESPONSE_SIZE) {
+			continue;
+		}
+
+		// VALIDAZIONE SORGENTE: indirizzo e porta di una replica configurata
+		if (replica_set_find(replicas, &from_addr) < 0) {
+			fprintf(stderr, "Errore: ricevuto pacchetto da sorgente sconosciuta.\n");
+			continue;
+		}
+
+		weather_response_t response;
+		if (deserialize_response(recv_buffer, &response) != 0) {
+			print_error("Errore: deserializzazione fallita.\n");
+			continue;
+		}
+
+		// CONFERMA DEL SERVER
+		if (response.type == TYPE_SUBSCRIBE) {
+			if (response.status == STATUS_SUCCESS) {
+				continue; // Lease rinnovato
+			}
+			if (response.status == STATUS_SERVER_BUSY) {
+				printf("Ricevuto risultato dal server %s (ip %s). Server sovraccarico\n",
+				       server_name, server_ip);
+			} else {
+				print_result(&response, &request, server_name, server_ip);
+			}
+			exit_code = 1;
+			break;
+		}
+
+		// PUSH PERIODICO
+		print_result(&response, &request, server_name, server_ip);
+		fflush(stdout);
+	}
+
+	// ANNULLAMENTO: il server smette subito di inviare, senza attendere il lease
+	if (stop_requested) {
+		sub->interval_ms = 0;
+		send_subscribe(sock, server_addr, sub);
+	}
+
+	return exit_code;
+}
+
+/*
+ * Attesa di una risposta di expected_size byte da una replica, entro timeout_ms
+ * Datagrammi da altre sorgenti o di dimensione diversa sono scartati
+ * Ritorna 0 se la risposta è in buffer, -1 allo scadere del timeout
+ */
+static int receive_reply(int sock, const replica_set_t *replicas, uint8_t *buffer,
+                         size_t expected_size, int timeout_ms) {
+	uint8_t recv_buffer[BUFFER_SIZE];
+	struct sockaddr_in from_addr;
+	uint64_t deadline = get_monotonic_ms() + (uint64_t)timeout_ms;
+
+	while (1) {
+		uint64_t now = get_monotonic_ms();
+		if (now >= deadline) {
+			fprintf(stderr, "Errore: nessuna risposta dal server entro %d ms.\n", timeout_ms);
+			return -1;
+		}
+		uint64_t wait_ms = deadline - now;
+
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+		struct timeval timeout;
+		timeout.tv_sec = (long)(wait_ms / 1000u);
+		timeout.tv_usec = (long)(wait_ms % 1000u) * 1000L;
+		if (select(sock + 1, &read_set, NULL, NULL, &timeout) <= 0) {
+			continue;
+		}
+
+#if defined WIN32
+		int from_len = sizeof(from_addr);
+#else
+		socklen_t from_len = sizeof(from_addr);
+#endif
+		int bytes_received = recvfrom(sock, (char *)recv_buffer, sizeof(recv_buffer), 0,
+		                              (struct sockaddr *)&from_addr, &from_len);
+
+		// VALIDAZIONE DIMENSIONE E SORGENTE (indirizzo e porta di una replica)
+		if (bytes_received == (int)expected_size && replica_set_find(replicas, &from_addr) >= 0) {
+			memcpy(buffer, recv_buffer, expected_size);
+			return 0;
+		}
+	}
+}
+
+/*
+ * Query aggregata: min, max e media sullo storico del server
+ */
+int run_aggregate(int sock, const replica_set_t *replicas, const weather_request_t *request,
+                  uint32_t window_s, int timeout_ms, const char *server_name, const char *server_ip) {
+	const struct sockaddr_in *server_addr = &replicas->replicas[0].addr;
+	aggregate_request_t query;
+	memset(&query, 0, sizeof(query));
+	memcpy(query.city, request->city, sizeof(query.city));
+	query.type = request->type;
+	query.window_s = window_s;
+
+	uint8_t send_buffer[AGGREGATE_REQUEST_SIZE];
+	int serialized_len = serialize_aggregate_request(&query, send_buffer);
+	if (sendto(sock, (const char *)send_buffer, serialized_len, 0,
+	           (const struct sockaddr *)server_addr, sizeof(*server_addr)) != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+		return 1;
+	}
+
+	// ATTESA RISPOSTA con timeout
+	uint8_t recv_buffer[AGGREGATE_RESPONSE_SIZE];
+	if (receive_reply(sock, replicas, recv_buffer, AGGREGATE_RESPONSE_SIZE, timeout_ms) != 0) {
+		return 1;
+	}
+
+	aggregate_response_t response;
+	deserialize_aggregate_response(recv_buffer, &response);
+
+	char city_display[64];
+	strncpy(city_display, request->city, 64);
+	if (city_display[0] >= 'a' && city_display[0] <= 'z') {
+		city_display[0] = city_display[0] - 'a' + 'A';
+	}
+
+	switch (response.status) {
+		case STATUS_SUCCESS: {
+			const char *label = "";
+			const char *unit = "";
+			switch (response.type) {
+				case TYPE_TEMPERATURE: label = "Temperatura"; unit = "°C"; break;
+				case TYPE_HUMIDITY: label = "Umidità"; unit = "%"; break;
+				case TYPE_WIND: label = "Vento"; unit = " km/h"; break;
+				case TYPE_PRESSURE: label = "Pressione"; unit = " hPa"; break;
+			}
+			printf("Ricevuto risultato dal server %s (ip %s). %s: %s ", server_name, server_ip, city_display, label);
+			if (window_s > 0) {
+				printf("ultimi %u s", window_s);
+			} else {
+				printf("intero storico");
+			}
+			if (response.count == 0) {
+				printf(": nessun campione\n");
+			} else {
+				printf(": min = %.1f%s, max = %.1f%s, media = %.1f%s (%u campioni)\n",
+				       response.min, unit, response.max, unit, response.avg, unit, response.count);
+			}
+			break;
+		}
+
+		case STATUS_CITY_NOT_FOUND:
+			printf("Ricevuto risultato dal server %s (ip %s). Città non disponibile\n",
+			       server_name, server_ip);
+			break;
+
+		default:
+			printf("Ricevuto risultato dal server %s (ip %s). Richiesta non valida\n",
+			       server_name, server_ip);
+			break;
+	}
+	return 0;
+}
+
+/*
+ * Ricerca per coordinate: meteo della città del catalogo più vicina
+ */
+int run_nearest(int sock, const replica_set_t *replicas, float latitude, float longitude, char type,
+                int timeout_ms, const char *server_name, const char *server_ip) {
+	const struct sockaddr_in *server_addr = &replicas->replicas[0].addr;
+	nearest_request_t query;
+	query.latitude = latitude;
+	query.longitude = longitude;
+	query.type = type;
+
+	uint8_t send_buffer[NEAREST_REQUEST_SIZE];
+	int serialized_len = serialize_nearest_request(&query, send_buffer);
+	if (sendto(sock, (const char *)send_buffer, serialized_len, 0,
+	           (const struct sockaddr *)server_addr, sizeof(*server_addr)) != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+		return 1;
+	}
+
+	uint8_t recv_buffer[NEAREST_RESPONSE_SIZE];
+	if (receive_reply(sock, replicas, recv_buffer, NEAREST_RESPONSE_SIZE, timeout_ms) != 0) {
+		return 1;
+	}
+
+	nearest_response_t response;
+	deserialize_nearest_response(recv_buffer, &response);
+
+	if (response.status == STATUS_SUCCESS) {
+		printf("Città più vicina a (%.4f, %.4f): %s, distanza %.1f km\n",
+		       latitude, longitude, response.city, response.distance_km);
+	}
+
+	// Stessa stampa delle richieste per nome
+	weather_request_t shown;
+	memset(&shown, 0, sizeof(shown));
+	shown.type = response.type;
+	memcpy(shown.city, response.city, sizeof(shown.city));
+	weather_response_t plain;
+	plain.status = response.status;
+	plain.type = response.type;
+	plain.value = response.value;
+	print_result(&plain, &shown, server_name, server_ip);
+	return 0;
+}
+
+/*
+ * Modalità listener: risposte dall'ultimo snapshot multicast, senza round trip
+ */
+#define LISTENER_FIRST_SNAPSHOT_MS 5000  // Attesa massima del primo snapshot completo
+
+/* Risponde a una richiesta dallo snapshot e stampa il risultato */
+static int answer_from_snapshot(const snapshot_cache_t *cache, const char *input) {
+	weather_request_t request;
+	memset(&request, 0, sizeof(request));
+	if (parse_weather_request(input, &request) == 0) {
+		return 1;
+	}
+
+	weather_response_t response;
+	if (snapshot_lookup(cache, &request, &response) != 0) {
+		fprintf(stderr, "Errore: nessuno snapshot ricevuto.\n");
+		return 1;
+	}
+
+	// Il "server" è il publisher dello snapshot
+	char server_hostname[256];
+	char server_ip[16];
+	if (resolve_host(inet_ntoa(cache->source.sin_addr), server_hostname, sizeof(server_hostname),
+	                 server_ip, sizeof(server_ip)) != 0) {
+		return 1;
+	}
+
+	print_result(&response, &request, server_hostname, server_ip);
+	fflush(stdout);
+	return 0;
+}
+
+/* Legge e applica un datagramma snapshot dal socket */
+static void receive_snapshot(int sock, snapshot_cache_t *cache) {
+	uint8_t recv_buffer[SNAPSHOT_MAX_DATAGRAM];
+	struct sockaddr_in from_addr;
+#if defined WIN32
+	int from_len = sizeof(from_addr);
+#else
+	socklen_t from_len = sizeof(from_addr);
+#endif
+
+	int bytes_received = recvfrom(sock, (char *)recv_buffer, sizeof(recv_buffer), 0,
+	                              (struct sockaddr *)&from_addr, &from_len);
+	if (bytes_received > 0) {
+		snapshot_process_datagram(cache, recv_buffer, bytes_received, &from_addr);
+	}
+}
+
+/*
+ * Con request_string: attende il primo snapshot completo e risponde.
+ * Senza: risponde a ogni riga "type city" letta da stdin usando l'ultimo
+ * snapshot, che viene aggiornato in background fino a fine input.
+ */
+int run_listener(const char *group_ip, int port, const char *interface_ip, const char *request_string) {
+	int sock = listener_open(group_ip, port, interface_ip);
+	if (sock < 0) {
+		return 1;
+	}
+
+	static snapshot_cache_t cache;
+	int exit_code = 0;
+
+	if (request_string) {
+		uint64_t deadline_ms = get_monotonic_ms() + LISTENER_FIRST_SNAPSHOT_MS;
+		while (!cache.has_snapshot) {
+			uint64_t now_ms = get_monotonic_ms();
+			if (now_ms >= deadline_ms) {
+				break;
+			}
+			uint64_t wait_ms = deadline_ms - now_ms;
+
+			fd_set read_set;
+			FD_ZERO(&read_set);
+			FD_SET(sock, &read_set);
+			struct timeval timeout;
+			timeout.tv_sec = (long)(wait_ms / 1000);
+			timeout.tv_usec = (long)(wait_ms % 1000) * 1000;
+
+			if (select(sock + 1, &read_set, NULL, NULL, &timeout) > 0) {
+				receive_snapshot(sock, &cache);
+			}
+		}
+		exit_code = answer_from_snapshot(&cache, request_string);
+	} else {
+#if defined WIN32
+		// select() su Windows non accetta stdin
+		fprintf(stderr, "Errore: su Windows la modalità listener richiede -r.\n");
+		exit_code = 1;
+#else
+		char line[BUFFER_SIZE];
+		while (1) {
+			fd_set read_set;
+			FD_ZERO(&read_set);
+			FD_SET(sock, &read_set);
+			FD_SET(STDIN_FILENO, &read_set);
+
+			int max_fd = sock > STDIN_FILENO ? sock : STDIN_FILENO;
+			if (select(max_fd + 1, &read_set, NULL, NULL, NULL) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				break;
+			}
+
+			if (FD_ISSET(sock, &read_set)) {
+				receive_snapshot(sock, &cache);
+			}
+
+			if (FD_ISSET(STDIN_FILENO, &read_set)) {
+				if (!fgets(line, sizeof(line), stdin)) {
+					break; // Fine input
+				}
+				line[strcspn(line, "\r\n")] = '\0';
+				if (line[0] != '\0') {
+					answer_from_snapshot(&cache, line);
+				}
+			}
+		}
+#endif
+	}
+
+	fprintf(stderr, "Snapshot ricevuti: %llu, incompleti: %llu, datagrammi persi: %llu\n",
+	        (unsigned long long)cache.snapshots_completed,
+	        (unsigned long long)cache.snapshots_incomplete,
+	        (unsigned long long)cache.datagrams_lost);
+
+	snapshot_cache_free(&cache);
+	closesocket(sock);
+	return exit_code;
+}
+
+/*
+ * Benchmark di latenza: stessa richiesta ripetuta su UDP o memoria condivisa
+ */
+#define SHM_REQUEST_TIMEOUT_MS 1000   // Attesa massima di una risposta in memoria condivisa
+#define BENCH_TIMEOUT_MS 1000         // Attesa massima di una risposta UDP nel benchmark (default di -t)
+
+static int compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Stampa media e percentili (campioni in nanosecondi, ordinati sul posto) */
+void print_latency_stats(const char *label, uint64_t *samples_ns, int count, int failures) {
+	if (count <= 0) {
+		printf("Benchmark %s: nessuna risposta (%d errori)\n", label, failures);
+		return;
+	}
+
+	qsort(samples_ns, (size_t)count, sizeof(uint64_t), compare_u64);
+
+	double sum = 0.0;
+	for (int i = 0; i < count; i++) {
+		sum += (double)samples_ns[i];
+	}
+
+	printf("Benchmark %s: %d risposte, %d errori, media %.1f us, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+	       label, count, failures, sum / count / 1000.0,
+	       samples_ns[count / 2] / 1000.0,
+	       samples_ns[(int)((count - 1) * 0.99)] / 1000.0,
+	       samples_ns[(int)((count - 1) * 0.999)] / 1000.0,
+	       samples_ns[count - 1] / 1000.0);
+}
+
+int run_benchmark(int sock, replica_set_t *replicas, int use_shm, int port,
+                  const uint8_t *request, size_t request_len, int count, int timeout_ms) {
+	uint64_t *samples = (uint64_t *)malloc((size_t)count * sizeof(uint64_t));
+	if (!samples) {
+		print_error("Errore: memoria insufficiente per il benchmark.\n");
+		return 1;
+	}
+
+	shm_client_t shm_client;
+	if (use_shm && shm_client_open(&shm_client, port) != 0) {
+		free(samples);
+		return 1;
+	}
+
+	int completed = 0;
+	int failures = 0;
+	uint8_t response[SUGGEST_RESPONSE_MAX_SIZE];
+	uint64_t bench_start = get_monotonic_ns();
+
+	for (int i = 0; i < count; i++) {
+		uint64_t start = get_monotonic_ns();
+		int ok;
+
+		if (use_shm) {
+			ok = shm_client_request(&shm_client, request, response, SHM_REQUEST_TIMEOUT_MS) == 0;
+		} else {
+			// Una risposta persa non blocca il benchmark: hedge e timeout come per la richiesta singola
+			ok = hedged_exchange(sock, replicas, request, request_len, response, sizeof(response), NULL,
+			                     timeout_ms) >= 0;
+		}
+
+		if (ok) {
+			samples[completed++] = get_monotonic_ns() - start;
+		} else {
+			failures++;
+		}
+	}
+
+	// GOODPUT: risposte utili per secondo di esecuzione, errori e attese comprese
+	double elapsed_s = (double)(get_monotonic_ns() - bench_start) / 1e9;
+	print_latency_stats(use_shm ? "shm" : "udp", samples, completed, failures);
+	printf("Goodput: %.0f risposte/s in %.3f s\n", elapsed_s > 0.0 ? completed / elapsed_s : 0.0, elapsed_s);
+
+	if (use_shm) {
+		shm_client_close(&shm_client);
+	} else {
+		for (int r = 0; r < replicas->count; r++) {
+			const replica_t *replica = &replicas->replicas[r];
+			printf("Replica %s (ip %s): inviate %llu, vinte %llu, EWMA %.1f us\n",
+			       replica->hostname, replica->ip, (unsigned long long)replica->requests_sent,
+			       (unsigned long long)replica->responses_won, replica->ewma_us);
+		}
+		printf("Hedge inviati: %llu, timeout: %llu, ritardo hedge finale %u us\n",
+		       (unsigned long long)replicas->hedges_sent, (unsigned long long)replicas->timeouts,
+		       replica_hedge_delay_us(replicas));
+	}
+	free(samples);
+	return failures == count ? 1 : 0;
+}
+
+/*
+ * Replay di una cattura
+ */
+
+#define REPLAY_TIMEOUT_MS 1000        // Attesa massima di una risposta nel replay (default di -t)
+
+/* Socket del replay: le richieste in volo sono una coda FIFO, come le serve il server */
+typedef struct {
+	int sock;
+	int pending[REPLAY_WINDOW];     // Indici dei datagrammi in volo
+	uint64_t sent_ns[REPLAY_WINDOW];
+	int head;
+	int count;
+} replay_socket_t;
+
+/*
+ * Valida la risposta con il deserializzatore del messaggio originale
+ * Ritorna 1 se corrisponde (dimensione e tipo attesi), 0 altrimenti
+ */
+static int replay_response_matches(const replay_datagram_t *datagram, const uint8_t *buffer, int length,
+                                   uint32_t *status) {
+	char type = '\0';
+
+	switch (datagram->kind) {
+		case REPLAY_KIND_WEATHER: {
+			weather_response_t response;
+			if (length < (int)RESPONSE_SIZE || deserialize_response(buffer, &response) != 0) {
+				return 0;
+			}
+			*status = response.status;
+			type = response.type;
+			break;
+		}
+		case REPLAY_KIND_AGGREGATE: {
+			aggregate_response_t response;
+			if (length != (int)AGGREGATE_RESPONSE_SIZE || deserialize_aggregate_response(buffer, &response) != 0) {
+				return 0;
+			}
+			*status = response.status;
+			type = response.type;
+			break;
+		}
+		case REPLAY_KIND_NEAREST: {
+			nearest_response_t response;
+			if (length != (int)NEAREST_RESPONSE_SIZE || deserialize_nearest_response(buffer, &response) != 0) {
+				return 0;
+			}
+			*status = response.status;
+			type = response.type;
+			break;
+		}
+		default:
+			return 0;
+	}
+
+	// Le richieste non valide possono tornare con type = '\0'
+	return type == datagram->type || type == '\0';
+}
+
+/*
+ * Riproduce i datagrammi catturati verso il server
+ * speed: 1 = tempi originali, N = N volte più veloce, 0 = il più veloce possibile
+ * Ogni mittente originale è assegnato sempre allo stesso socket: l'ordine
+ * delle sue richieste è preservato
+ */
+int run_replay(const char *path, const replica_t *target, int socket_count, double speed, int timeout_ms) {
+	capture_trace_t trace;
+	if (capture_trace_load(&trace, path) != 0) {
+		return 1;
+	}
+	if (trace.count == 0) {
+		print_error("Errore: nessuna richiesta da riprodurre nella cattura.\n");
+		capture_trace_free(&trace);
+		return 1;
+	}
+
+	uint64_t *samples = (uint64_t *)malloc((size_t)trace.count * sizeof(uint64_t));
+	uint8_t *sample_kinds = (uint8_t *)malloc((size_t)trace.count);
+	replay_socket_t *sockets = (replay_socket_t *)calloc((size_t)socket_count, sizeof(replay_socket_t));
+	if (!samples || !sample_kinds || !sockets) {
+		print_error("Errore: memoria insufficiente per il replay.\n");
+		free(samples);
+		free(sample_kinds);
+		free(sockets);
+		capture_trace_free(&trace);
+		return 1;
+	}
+
+	int created = 0;
+	for (; created < socket_count; created++) {
+		sockets[created].sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (sockets[created].sock < 0) {
+			print_error("Errore: creazione socket UDP fallita.\n");
+			break;
+		}
+	}
+	if (created < socket_count) {
+		for (int i = 0; i < created; i++) {
+			closesocket(sockets[i].sock);
+		}
+		free(samples);
+		free(sample_kinds);
+		free(sockets);
+		capture_trace_free(&trace);
+		return 1;
+	}
+
+	printf("Replay di %d richieste (%d mittenti, %.3f s originali, %d datagrammi saltati) verso %s (ip %s)\n",
+	       trace.count, trace.flows, trace.duration_ns / 1e9, trace.skipped, target->hostname, target->ip);
+	if (speed > 0.0) {
+		printf("Velocità %gx su %d socket\n", speed, socket_count);
+	} else {
+		printf("Velocità massima su %d socket (%d richieste in volo per socket)\n", socket_count, REPLAY_WINDOW);
+	}
+
+	signal(SIGINT, handle_sigint);
+
+	uint64_t timeout_ns = (uint64_t)timeout_ms * 1000000u;
+	int next = 0;
+	int in_flight = 0;
+	int completed = 0;
+	int lost = 0;
+	int mismatched = 0;
+	int send_errors = 0;
+	int error_status = 0;
+	uint64_t lag_total_ns = 0;
+	uint64_t lag_max_ns = 0;
+	uint8_t buffer[BUFFER_SIZE];
+	uint64_t start = get_monotonic_ns();
+
+	while ((next < trace.count || in_flight > 0) && !stop_requested) {
+		uint64_t now = get_monotonic_ns();
+
+		// INVII SCADUTI: con la finestra piena il flusso attende (gli invii successivi slittano)
+		uint64_t next_due = 0;
+		while (next < trace.count) {
+			const replay_datagram_t *datagram = &trace.datagrams[next];
+			uint64_t due = speed > 0.0 ? start + (uint64_t)(datagram->time_ns / speed) : now;
+			if (due > now) {
+				next_due = due;
+				break;
+			}
+			replay_socket_t *s = &sockets[datagram->flow % (uint32_t)socket_count];
+			if (s->count == REPLAY_WINDOW) {
+				break;
+			}
+
+			if (sendto(s->sock, (const char *)datagram->data, datagram->length, 0,
+			           (const struct sockaddr *)&target->addr, sizeof(target->addr)) != datagram->length) {
+				send_errors++;
+				next++;
+				continue;
+			}
+			int slot = (s->head + s->count) % REPLAY_WINDOW;
+			s->pending[slot] = next;
+			s->sent_ns[slot] = now;
+			s->count++;
+			in_flight++;
+
+			uint64_t lag = now - due;
+			lag_total_ns += lag;
+			if (lag > lag_max_ns) {
+				lag_max_ns = lag;
+			}
+			next++;
+			now = get_monotonic_ns();
+		}
+
+		// TIMEOUT: la richiesta più vecchia di ogni socket è considerata persa
+		uint64_t wait_ns = timeout_ns;
+		for (int i = 0; i < socket_count; i++) {
+			replay_socket_t *s = &sockets[i];
+			while (s->count > 0 && now - s->sent_ns[s->head] >= timeout_ns) {
+				s->head = (s->head + 1) % REPLAY_WINDOW;
+				s->count--;
+				in_flight--;
+				lost++;
+			}
+			if (s->count > 0 && s->sent_ns[s->head] + timeout_ns - now < wait_ns) {
+				wait_ns = s->sent_ns[s->head] + timeout_ns - now;
+			}
+		}
+
+		// ATTESA: una risposta, il prossimo invio o la prossima scadenza
+		if (next < trace.count) {
+			if (next_due > now) {
+				wait_ns = next_due - now < wait_ns ? next_due - now : wait_ns;
+			} else if (speed <= 0.0 || next_due == 0) {
+				// Velocità massima o invio in ritardo: solo le risposte già arrivate, se la finestra non è piena
+				const replay_datagram_t *datagram = &trace.datagrams[next];
+				if (sockets[datagram->flow % (uint32_t)socket_count].count < REPLAY_WINDOW) {
+					wait_ns = 0;
+				}
+			}
+		}
+
+		fd_set read_fds;
+		FD_ZERO(&read_fds);
+		int max_fd = 0;
+		for (int i = 0; i < socket_count; i++) {
+			FD_SET(sockets[i].sock, &read_fds);
+			if (sockets[i].sock > max_fd) {
+				max_fd = sockets[i].sock;
+			}
+		}
+		struct timeval tv;
+		tv.tv_sec = (long)(wait_ns / 1000000000u);
+		tv.tv_usec = (long)((wait_ns % 1000000000u) / 1000u);
+		int ready = select(max_fd + 1, &read_fds, NULL, NULL, &tv);
+		if (ready <= 0) {
+			continue; // Scadenza o segnale
+		}
+
+		// RISPOSTE: abbinate alla richiesta più vecchia in volo sullo stesso socket
+		uint64_t received_ns = get_monotonic_ns();
+		for (int i = 0; i < socket_count; i++) {
+			replay_socket_t *s = &sockets[i];
+			if (!FD_ISSET(s->sock, &read_fds)) {
+				continue;
+			}
+			int n = recvfrom(s->sock, (char *)buffer, sizeof(buffer), 0, NULL, NULL);
+			if (n < 0) {
+				continue;
+			}
+			if (s->count == 0) {
+				mismatched++; // Risposta arrivata dopo il timeout
+				continue;
+			}
+
+			const replay_datagram_t *datagram = &trace.datagrams[s->pending[s->head]];
+			uint64_t sent_ns = s->sent_ns[s->head];
+			s->head = (s->head + 1) % REPLAY_WINDOW;
+			s->count--;
+			in_flight--;
+
+			uint32_t status = STATUS_SUCCESS;
+			if (!replay_response_matches(datagram, buffer, n, &status)) {
+				mismatched++;
+				continue;
+			}
+			if (status != STATUS_SUCCESS) {
+				error_status++;
+			}
+			sample_kinds[completed] = datagram->kind;
+			samples[completed++] = received_ns - sent_ns;
+		}
+	}
+
+	double elapsed_s = (double)(get_monotonic_ns() - start) / 1e9;
+	int sent = next - send_errors;
+
+	// DISTRIBUZIONI PER TIPO DI MESSAGGIO (prima di quella complessiva, che ordina i campioni)
+	static const char *kind_labels[] = { "replay meteo", "replay aggregate", "replay coordinate" };
+	uint64_t *subset = (uint64_t *)malloc((size_t)(completed > 0 ? completed : 1) * sizeof(uint64_t));
+	for (int kind = 0; subset && kind < 3; kind++) {
+		int subset_count = 0;
+		for (int i = 0; i < completed; i++) {
+			if (sample_kinds[i] == kind) {
+				subset[subset_count++] = samples[i];
+			}
+		}
+		if (subset_count > 0 && subset_count < completed) {
+			print_latency_stats(kind_labels[kind], subset, subset_count, 0);
+		}
+	}
+	free(subset);
+	print_latency_stats("replay", samples, completed, lost + mismatched);
+
+	printf("Throughput: %d richieste inviate in %.3f s (%.0f/s), %.0f risposte/s",
+	       sent, elapsed_s, elapsed_s > 0.0 ? sent / elapsed_s : 0.0,
+	       elapsed_s > 0.0 ? completed / elapsed_s : 0.0);
+	if (trace.duration_ns > 0) {
+		printf(", originale %.0f/s", trace.count / (trace.duration_ns / 1e9));
+	}
+	printf("\n");
+	printf("Risposte: %d valide (%d con status di errore), %d perse, %d non corrispondenti, %d errori di invio\n",
+	       completed, error_status, lost, mismatched, send_errors);
+	if (speed > 0.0 && sent > 0) {
+		printf("Ritardo degli invii rispetto ai tempi originali: medio %.1f us, massimo %.1f us\n",
+		       lag_total_ns / (double)sent / 1e3, lag_max_ns / 1e3);
+	}
+	if (stop_requested) {
+		printf("Replay interrotto dopo %d richieste su %d\n", next, trace.count);
+	}
+
+	for (int i = 0; i < socket_count; i++) {
+		closesocket(sockets[i].sock);
+	}
+	free(samples);
+	free(sample_kinds);
+	free(sockets);
+	capture_trace_free(&trace);
+	return completed > 0 ? 0 : 1;
+}
+
 int main(int argc, char *argv[]) {
 
 	const char *server_address = "localhost";
 	int server_port = SERVER_PORT;
 	const char *request_string = NULL;
+	long subscribe_interval_ms = -1; // -1: richiesta singola (nessuna sottoscrizione)
+	long aggregate_window_s = -1;    // >= 0: query aggregata sullo storico (0 = tutto)
+	int nearest_query = 0;           // 1: ricerca per coordinate (-g lat,lon)
+	float nearest_lat = 0.0f;
+	float nearest_lon = 0.0f;
+	char listen_group[32] = "";      // Vuoto: modalità listener disattivata
+	int listen_port = SNAPSHOT_PORT;
+	const char *listen_interface = NULL;
+	int use_shm = 0;                 // 1: trasporto in memoria condivisa (stesso host)
+	int bench_count = 0;             // > 0: benchmark di latenza con N richieste
+	int timeout_ms = 0;              // 0: REQUEST_TIMEOUT_MS, o BENCH_TIMEOUT_MS con -b
+	int max_suggestions = 0;        // Suggerimenti se la città non esiste (-k, 0 = richiesta da specifica)
+	const char *replay_path = NULL;  // Cattura da riprodurre (-R)
+	double replay_speed = 1.0;       // Moltiplicatore dei tempi originali (0 = massima velocità)
+	int replay_sockets = REPLAY_DEFAULT_SOCKETS;
+	long cache_ttl_s = 0;            // > 0: cache delle risposte condivisa tra invocazioni (-c)
 
 	// PARSING ARGOMENTI
 	for (int i = 1; i < argc; i++) {
@@ -283,15 +1166,206 @@ int main(int argc, char *argv[]) {
 			return 1;
 		}
 
+		if (strcmp(argv[i], "-A") == 0) {
+			if (i + 1 < argc) {
+				aggregate_window_s = atol(argv[++i]);
+				if (aggregate_window_s < 0 || aggregate_window_s > AGGREGATE_MAX_WINDOW_S) {
+					fprintf(stderr, "Errore: finestra non valida %ld (range 0-%d s)\n",
+					        aggregate_window_s, AGGREGATE_MAX_WINDOW_S);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -A\n");
+			return 1;
+		}
+
+		// -g lat,lon: meteo della città più vicina alle coordinate (gradi decimali)
+		if (strcmp(argv[i], "-g") == 0) {
+			if (i + 1 < argc) {
+				const char *value = argv[++i];
+				char *end;
+				nearest_lat = strtof(value, &end);
+				if (end == value || *end != ',') {
+					fprintf(stderr, "Errore: coordinate non valide '%s' (formato lat,lon)\n", value);
+					return 1;
+				}
+				const char *lon_start = end + 1;
+				nearest_lon = strtof(lon_start, &end);
+				if (end == lon_start || *end != '\0' ||
+				    nearest_lat < -90.0f || nearest_lat > 90.0f ||
+				    nearest_lon < -180.0f || nearest_lon > 180.0f) {
+					fprintf(stderr, "Errore: coordinate non valide '%s' (lat -90..90, lon -180..180)\n", value);
+					return 1;
+				}
+				nearest_query = 1;
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -g\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-S") == 0) {
+			if (i + 1 < argc) {
+				subscribe_interval_ms = atol(argv[++i]);
+				if (subscribe_interval_ms < SUBSCRIPTION_MIN_INTERVAL_MS ||
+				    subscribe_interval_ms > SUBSCRIPTION_MAX_INTERVAL_MS) {
+					fprintf(stderr, "Errore: intervallo non valido %ld (range %d-%d ms)\n",
+					        subscribe_interval_ms, SUBSCRIPTION_MIN_INTERVAL_MS, SUBSCRIPTION_MAX_INTERVAL_MS);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -S\n");
+			return 1;
+		}
+
+		// -L gruppo[:porta]: risposte dallo snapshot multicast
+		if (strcmp(argv[i], "-L") == 0) {
+			if (i + 1 < argc) {
+				strncpy(listen_group, argv[++i], sizeof(listen_group) - 1);
+				char *colon = strchr(listen_group, ':');
+				if (colon) {
+					*colon = '\0';
+					listen_port = atoi(colon + 1);
+					if (listen_port <= 0 || listen_port > 65535) {
+						fprintf(stderr, "Errore: porta non valida %d (range 1-65535)\n", listen_port);
+						return 1;
+					}
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -L\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-t") == 0) {
+			if (i + 1 < argc) {
+				timeout_ms = atoi(argv[++i]);
+				if (timeout_ms <= 0) {
+					fprintf(stderr, "Errore: timeout non valido %d\n", timeout_ms);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -t\n");
+			return 1;
+		}
+
+		// -k N: suggerimenti richiesti al server se la città non esiste
+		if (strcmp(argv[i], "-k") == 0) {
+			if (i + 1 < argc) {
+				max_suggestions = atoi(argv[++i]);
+				if (max_suggestions < 0 || max_suggestions > SUGGEST_MAX_COUNT) {
+					fprintf(stderr, "Errore: numero di suggerimenti non valido %d (range 0-%d)\n",
+					        max_suggestions, SUGGEST_MAX_COUNT);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -k\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-m") == 0) {
+			use_shm = 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-b") == 0) {
+			if (i + 1 < argc) {
+				bench_count = atoi(argv[++i]);
+				if (bench_count <= 0) {
+					fprintf(stderr, "Errore: numero di richieste non valido %d\n", bench_count);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -b\n");
+			return 1;
+		}
+
+		// -R file: replay di una cattura del server (-w) o di bench/capture_tap
+		if (strcmp(argv[i], "-R") == 0) {
+			if (i + 1 < argc) {
+				replay_path = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -R\n");
+			return 1;
+		}
+
+		// -X N: replay N volte più veloce dei tempi originali (0 = il più veloce possibile)
+		if (strcmp(argv[i], "-X") == 0) {
+			if (i + 1 < argc) {
+				replay_speed = atof(argv[++i]);
+				if (replay_speed < 0.0) {
+					fprintf(stderr, "Errore: velocità di replay non valida %s\n", argv[i]);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -X\n");
+			return 1;
+		}
+
+		// -n N: socket usati dal replay
+		if (strcmp(argv[i], "-n") == 0) {
+			if (i + 1 < argc) {
+				replay_sockets = atoi(argv[++i]);
+				if (replay_sockets < 1 || replay_sockets > REPLAY_MAX_SOCKETS) {
+					fprintf(stderr, "Errore: numero di socket non valido %d (range 1-%d)\n",
+					        replay_sockets, REPLAY_MAX_SOCKETS);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -n\n");
+			return 1;
+		}
+
+		// -c N: risposte riusate per N secondi da una cache condivisa in /tmp
+		if (strcmp(argv[i], "-c") == 0) {
+			if (i + 1 < argc) {
+				cache_ttl_s = atol(argv[++i]);
+				if (cache_ttl_s < 1 || cache_ttl_s > CACHE_MAX_TTL_S) {
+					fprintf(stderr, "Errore: durata della cache non valida %ld (range 1-%d s)\n",
+					        cache_ttl_s, CACHE_MAX_TTL_S);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -c\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-i") == 0) {
+			if (i + 1 < argc) {
+				listen_interface = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -i\n");
+			return 1;
+		}
+
 		if (argv[i][0] != '-' && request_string == NULL) {
 			request_string = argv[i];
 			continue;
 		}
 	}
 
-	if (!request_string) {
+	if (!request_string && listen_group[0] == '\0' && !replay_path) {
 		fprintf(stderr, "Errore: richiesta mancante.\n");
-		fprintf(stderr, "Uso: %s [-s server] [-p port] -r \"type city\"\n", argv[0]);
+		fprintf(stderr, "Uso: %s [-s server[:port][,server[:port]...]] [-p port] [-t timeout_ms] -r \"type city\"\n", argv[0]);
+		fprintf(stderr, "     %s [-s server] [-p port] -S intervallo_ms -r \"types city\"\n", argv[0]);
+		fprintf(stderr, "     %s [-s server] [-p port] -A finestra_s -r \"type city\"\n", argv[0]);
+		fprintf(stderr, "     %s [-s server] [-p port] -g lat,lon -r type\n", argv[0]);
+		fprintf(stderr, "     %s -L gruppo[:porta] [-i interfaccia] [-r \"type city\"]\n", argv[0]);
+		fprintf(stderr, "     %s [-s server] [-p port] -R cattura.wcap [-X velocità] [-n socket]\n", argv[0]);
+		fprintf(stderr, "Opzioni: -m memoria condivisa (server locale), -b N benchmark di latenza,\n");
+		fprintf(stderr, "         -c N risposte dalla cache condivisa se più recenti di N secondi,\n");
+		fprintf(stderr, "         -k N suggerimenti se la città non esiste (1-%d, default nessuno)\n",
+		        SUGGEST_MAX_COUNT);
 		return 1;
 	}
 
@@ -306,24 +1380,81 @@ int main(int argc, char *argv[]) {
 	}
 #endif
 
+	// MODALITÀ LISTENER: nessun socket verso il server
+	if (listen_group[0] != '\0') {
+		int exit_code = run_listener(listen_group, listen_port, listen_interface, request_string);
+		clearwinsock();
+		return exit_code;
+	}
+
 	// PARSING RICHIESTA
 	weather_request_t request;
 	memset(&request, 0, sizeof(request));
-
-	if (parse_weather_request(request_string, &request) == 0) {
+	subscribe_request_t subscription;
+	memset(&subscription, 0, sizeof(subscription));
+
+	if (replay_path) {
+		// Replay: le richieste sono nella cattura
+	} else if (nearest_query) {
+		// Solo il tipo: la città la sceglie il server
+		if (strlen(request_string) != 1) {
+			fprintf(stderr, "Errore: con -g la richiesta è solo il tipo (es. -r t)\n");
+			clearwinsock();
+			return 1;
+		}
+		request.type = request_string[0];
+	} else if (subscribe_interval_ms > 0) {
+		if (parse_subscribe_request(request_string, &subscription) == 0) {
+			clearwinsock();
+			return 1;
+		}
+		subscription.interval_ms = (uint32_t)subscribe_interval_ms;
+	} else if (parse_weather_request(request_string, &request) == 0) {
 		clearwinsock();
 		return 1;
 	}
 
-	// RISOLUZIONE DNS
-	char server_hostname[256];
-	char server_ip[16];
+	// CACHE DELLE RISPOSTE: solo per le richieste singole via UDP
+	// Una risposta abbastanza recente evita sia il DNS sia la rete
+	static response_cache_t cache;
+	int cacheable = cache_ttl_s > 0 && !replay_path && !nearest_query && subscribe_interval_ms < 0 &&
+	                aggregate_window_s < 0 && !use_shm && bench_count == 0;
+	if (cache_ttl_s > 0 && response_cache_open(&cache, (uint32_t)cache_ttl_s * 1000u) != 0) {
+		cacheable = 0; // Si prosegue senza cache
+	}
+	if (cacheable) {
+		weather_response_t cached;
+		char cached_hostname[64];
+		char cached_ip[16];
+		if (response_cache_lookup(&cache, server_address, server_port, &request, &cached,
+		                          cached_hostname, sizeof(cached_hostname), cached_ip, sizeof(cached_ip))) {
+			print_result(&cached, &request, cached_hostname, cached_ip);
+			response_cache_close(&cache);
+			printf("Client terminated.\n");
+			clearwinsock();
+			return 0;
+		}
+	}
 
-	if (resolve_host(server_address, server_hostname, sizeof(server_hostname), server_ip, sizeof(server_ip)) != 0) {
+	// RISOLUZIONE DNS: tutte le repliche, una sola volta all'avvio
+	static replica_set_t replicas;
+	if (replica_set_parse(&replicas, server_address, server_port, &cache) <= 0) {
 		clearwinsock();
 		return 1;
 	}
 
+	// Sottoscrizioni e memoria condivisa usano la prima replica
+	const char *server_hostname = replicas.replicas[0].hostname;
+	const char *server_ip = replicas.replicas[0].ip;
+
+	// MODALITÀ REPLAY: socket propri, verso la prima replica
+	if (replay_path) {
+		int exit_code = run_replay(replay_path, &replicas.replicas[0], replay_sockets, replay_speed,
+		                           timeout_ms > 0 ? timeout_ms : REPLAY_TIMEOUT_MS);
+		clearwinsock();
+		return exit_code;
+	}
+
 	// CREAZIONE SOCKET UDP
 	// DIFFERENZA: SOCK_DGRAM invece di SOCK_STREAM
 	int my_socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
@@ -333,61 +1464,106 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
-	// CONFIGURAZIONE INDIRIZZO SERVER
-	struct sockaddr_in server_addr;
-	memset(&server_addr, 0, sizeof(server_addr));
-	server_addr.sin_family = AF_INET;
-	server_addr.sin_port = htons((unsigned short)server_port);
-	server_addr.sin_addr.s_addr = inet_addr(server_ip);
-
-	// SERIALIZZAZIONE
-	uint8_t send_buffer[REQUEST_SIZE];
-	int serialized_len = serialize_request(&request, send_buffer);
-	if (serialized_len < 0) {
-		print_error("Errore: serializzazione fallita.\n");
+	// MODALITÀ SOTTOSCRIZIONE
+	if (subscribe_interval_ms > 0) {
+		int exit_code = run_subscription(my_socket, &replicas, &subscription, server_hostname, server_ip);
 		closesocket(my_socket);
+		printf("Client terminated.\n");
 		clearwinsock();
-		return 1;
+		return exit_code;
 	}
 
-	// INVIO DATAGRAM
-	// DIFFERENZA CHIAVE: sendto() invece di send()
-	// NO connect() in UDP (connectionless)
-	int bytes_sent = sendto(my_socket, (char *)send_buffer, serialized_len, 0,
-	                        (struct sockaddr *)&server_addr, sizeof(server_addr));
-	if (bytes_sent != serialized_len) {
-		print_error("Errore: sendto() fallita.\n");
+	// RICERCA PER COORDINATE
+	if (nearest_query) {
+		int exit_code = run_nearest(my_socket, &replicas, nearest_lat, nearest_lon, request.type,
+		                            timeout_ms > 0 ? timeout_ms : REQUEST_TIMEOUT_MS,
+		                            server_hostname, server_ip);
 		closesocket(my_socket);
+		printf("Client terminated.\n");
 		clearwinsock();
-		return 1;
+		return exit_code;
 	}
 
-	// RICEZIONE RISPOSTA
-	// DIFFERENZA CHIAVE: recvfrom() invece di recv()
-	uint8_t recv_buffer[RESPONSE_SIZE];
-	struct sockaddr_in from_addr;
-
-#if defined WIN32
-	int from_len = sizeof(from_addr);
-#else
-	socklen_t from_len = sizeof(from_addr);
-#endif
+	// QUERY AGGREGATA
+	if (aggregate_window_s >= 0) {
+		int exit_code = run_aggregate(my_socket, &replicas, &request, (uint32_t)aggregate_window_s,
+		                              timeout_ms > 0 ? timeout_ms : REQUEST_TIMEOUT_MS,
+		                              server_hostname, server_ip);
+		closesocket(my_socket);
+		printf("Client terminated.\n");
+		clearwinsock();
+		return exit_code;
+	}
 
-	int bytes_received = recvfrom(my_socket, (char *)recv_buffer, RESPONSE_SIZE, 0,
-	                              (struct sockaddr *)&from_addr, &from_len);
-	if (bytes_received <= 0) {
-		print_error("Errore: recvfrom() fallita.\n");
+	// SERIALIZZAZIONE
+	// Con suggerimenti la richiesta ha un byte in più: il numero massimo di nomi
+	uint8_t send_buffer[SUGGEST_REQUEST_SIZE];
+	int serialized_len = serialize_request(&request, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
 		closesocket(my_socket);
 		clearwinsock();
 		return 1;
 	}
 
-	// VALIDAZIONE SORGENTE: verifica che la risposta venga dal server corretto
-	if (from_addr.sin_addr.s_addr != server_addr.sin_addr.s_addr) {
-		fprintf(stderr, "Errore: ricevuto pacchetto da sorgente sconosciuta.\n");
+	// BENCHMARK DI LATENZA
+	// Via UDP la richiesta è quella della richiesta singola, suggerimenti compresi (-k)
+	if (bench_count > 0) {
+		size_t bench_len = REQUEST_SIZE;
+		if (!use_shm && max_suggestions > 0) {
+			send_buffer[REQUEST_SIZE] = (uint8_t)max_suggestions;
+			bench_len = SUGGEST_REQUEST_SIZE;
+		}
+		int exit_code = run_benchmark(my_socket, &replicas, use_shm, server_port, send_buffer, bench_len,
+		                              bench_count, timeout_ms > 0 ? timeout_ms : BENCH_TIMEOUT_MS);
 		closesocket(my_socket);
 		clearwinsock();
-		return 1;
+		return exit_code;
+	}
+
+	uint8_t recv_buffer[SUGGEST_RESPONSE_MAX_SIZE];
+	int response_len = RESPONSE_SIZE;
+	if (timeout_ms <= 0) {
+		timeout_ms = REQUEST_TIMEOUT_MS;
+	}
+
+	if (use_shm) {
+		// TRASPORTO IN MEMORIA CONDIVISA: stessa codifica, nessuno stack UDP
+		shm_client_t shm_client;
+		if (shm_client_open(&shm_client, server_port) != 0) {
+			closesocket(my_socket);
+			clearwinsock();
+			return 1;
+		}
+		int rc = shm_client_request(&shm_client, send_buffer, recv_buffer, SHM_REQUEST_TIMEOUT_MS);
+		shm_client_close(&shm_client);
+		if (rc != 0) {
+			print_error("Errore: nessuna risposta dalla memoria condivisa.\n");
+			closesocket(my_socket);
+			clearwinsock();
+			return 1;
+		}
+	} else {
+		// INVIO CON HEDGING
+		// DIFFERENZA CHIAVE: sendto() invece di send(), NO connect() in UDP (connectionless)
+		// La richiesta va alla replica più veloce; se tarda viene duplicata sulla successiva
+		size_t request_len = REQUEST_SIZE;
+		if (max_suggestions > 0) {
+			send_buffer[REQUEST_SIZE] = (uint8_t)max_suggestions;
+			request_len = SUGGEST_REQUEST_SIZE;
+		}
+		int winner = hedged_exchange(my_socket, &replicas, send_buffer, request_len, recv_buffer,
+		                             sizeof(recv_buffer), &response_len, timeout_ms);
+		if (winner < 0) {
+			fprintf(stderr, "Errore: nessuna risposta dal server entro %d ms.\n", timeout_ms);
+			closesocket(my_socket);
+			clearwinsock();
+			return 1;
+		}
+
+		// Il risultato riporta la replica che ha risposto
+		server_hostname = replicas.replicas[winner].hostname;
+		server_ip = replicas.replicas[winner].ip;
 	}
 
 	// DESERIALIZZAZIONE
@@ -399,11 +1575,28 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
+	if (cacheable) {
+		response_cache_store(&cache, server_address, server_port, &request, &response, server_hostname, server_ip);
+	}
+
 	// OUTPUT
 	print_result(&response, &request, server_hostname, server_ip);
 
+	// SUGGERIMENTI (solo via UDP e con città non trovata)
+	city_suggestions_t suggestions;
+	if (response.status == STATUS_CITY_NOT_FOUND && response_len > (int)RESPONSE_SIZE &&
+	    deserialize_suggestions(recv_buffer + RESPONSE_SIZE, response_len - (int)RESPONSE_SIZE,
+	                            &suggestions) == 0 && suggestions.count > 0) {
+		printf("Forse cercavi:");
+		for (int i = 0; i < suggestions.count; i++) {
+			printf("%s %s", i > 0 ? "," : "", suggestions.names[i]);
+		}
+		printf("\n");
+	}
+
 	// CHIUSURA
 	closesocket(my_socket);
+	response_cache_close(&cache);
 	printf("Client terminated.\n");
 	clearwinsock();
 
@@ -25,6 +25,7 @@
 #define STATUS_SUCCESS 0          // Richiesta elaborata con successo
 #define STATUS_CITY_NOT_FOUND 1   // Città richiesta non disponibile
 #define STATUS_INVALID_REQUEST 2  // Richiesta non valida
+#define STATUS_SERVER_BUSY 3      // Server senza risorse disponibili (es. tabella piena)
 
 /* Tipi di dati meteorologici supportati */
 #define TYPE_TEMPERATURE 't'      // Temperatura
@@ -32,6 +33,42 @@
 #define TYPE_WIND 'w'             // Velocità del vento
 #define TYPE_PRESSURE 'p'         // Pressione atmosferica
 
+/* Sottoscrizioni (modalità push) */
+#define TYPE_SUBSCRIBE 's'                  // Messaggio di sottoscrizione / conferma
+#define SUBSCRIPTION_LEASE_MS 30000         // Durata lease: va rinnovata prima della scadenza
+#define SUBSCRIPTION_MIN_INTERVAL_MS 100    // Intervallo minimo tra due push
+#define SUBSCRIPTION_MAX_INTERVAL_MS 30000  // Intervallo massimo tra due push
+#define SUBSCRIPTION_DEFAULT_CAPACITY 100000 // Numero massimo di sottoscrittori di default
+
+/* Query aggregate sullo storico */
+#define TYPE_AGGREGATE 'g'                  // Richiesta min/max/media su una finestra temporale
+#define AGGREGATE_MAX_WINDOW_S 604800       // Finestra massima: una settimana
+
+/* Ricerca per coordinate */
+#define TYPE_NEAREST 'n'                    // Meteo della città più vicina a latitudine/longitudine
+
+/* Suggerimenti per città non trovate */
+#define SUGGEST_MAX_COUNT 5                 // Suggerimenti al più per risposta
+
+/* Pubblicazione multicast dello snapshot completo */
+#define SNAPSHOT_GROUP "239.255.67.1"     // Gruppo multicast di default (administratively scoped)
+#define SNAPSHOT_PORT 56701               // Porta di default del flusso snapshot
+#define SNAPSHOT_MAGIC 0x57534E31u        // "WSN1"
+#define SNAPSHOT_HEADER_SIZE 18           // magic(4) + seq(4) + snapshot_id(4) + part(2) + part_count(2) + record_count(2)
+#define SNAPSHOT_MAX_DATAGRAM 1400        // Resta sotto la MTU Ethernet
+#define SNAPSHOT_METRICS 4                // Valori per città: t, h, w, p (in quest'ordine)
+
+/* File di cattura del traffico (server -w, bench/capture_tap.c) per il replay (client -R) */
+#define CAPTURE_MAGIC 0x57435031u         // "WCP1"
+#define CAPTURE_VERSION 1
+
+/* Maschera dei tipi sottoscritti (un bit per tipo) */
+#define SUB_MASK_TEMPERATURE 0x01
+#define SUB_MASK_HUMIDITY 0x02
+#define SUB_MASK_WIND 0x04
+#define SUB_MASK_PRESSURE 0x08
+#define SUB_MASK_ALL 0x0F
+
 /*
  * ============================================================================
  * PROTOCOL DATA STRUCTURES
@@ -51,6 +88,106 @@ typedef struct {
     float value;          // Valore dato meteo generato
 } weather_response_t;
 
+/*
+ * Struttura sottoscrizione (client -> server)
+ * interval_ms = 0 (oppure types = 0) annulla la sottoscrizione.
+ * Il server risponde con un weather_response_t con type = TYPE_SUBSCRIBE
+ * e value = durata del lease in secondi, poi invia periodicamente un
+ * weather_response_t per ogni tipo sottoscritto.
+ */
+typedef struct {
+    char city[64];         // Nome città (stringa null-terminated)
+    uint8_t types;         // Maschera SUB_MASK_* dei tipi richiesti
+    uint32_t interval_ms;  // Intervallo tra due push in millisecondi
+} subscribe_request_t;
+
+/*
+ * Query aggregata (client -> server)
+ * Min, max e media dei valori generati per la città negli ultimi
+ * window_s secondi (0 = tutto lo storico conservato dal server).
+ */
+typedef struct {
+    char city[64];         // Nome città (stringa null-terminated)
+    char type;             // Tipo di dato meteo: 't', 'h', 'w', 'p'
+    uint32_t window_s;     // Ampiezza della finestra in secondi
+} aggregate_request_t;
+
+/* Risposta a una query aggregata (server -> client) */
+typedef struct {
+    unsigned int status;   // Codici STATUS_* come in weather_response_t
+    char type;             // Echo del tipo richiesto
+    uint32_t count;        // Campioni nella finestra (0 = nessun dato)
+    float min;
+    float max;
+    float avg;
+} aggregate_response_t;
+
+/*
+ * Suggerimenti (server -> client)
+ * Una richiesta normale seguita da un byte max_suggestions (SUGGEST_REQUEST_SIZE)
+ * riceve la stessa risposta di 9 byte; solo con STATUS_CITY_NOT_FOUND la risposta
+ * continua con count (1 byte) e count nomi, ognuno lunghezza (1 byte) + nome.
+ */
+typedef struct {
+    uint8_t count;
+    char names[SUGGEST_MAX_COUNT][64];  // Nomi canonici (stringhe null-terminated)
+} city_suggestions_t;
+
+/*
+ * Ricerca per coordinate (client -> server)
+ * Il server risponde con il valore del tipo richiesto per la città
+ * del catalogo più vicina, con nome e distanza.
+ */
+typedef struct {
+    float latitude;        // Gradi, -90..90
+    float longitude;       // Gradi, -180..180
+    char type;             // Tipo di dato meteo: 't', 'h', 'w', 'p'
+} nearest_request_t;
+
+/* Risposta a una ricerca per coordinate (server -> client) */
+typedef struct {
+    unsigned int status;   // Codici STATUS_* come in weather_response_t
+    char type;             // Echo del tipo richiesto
+    float value;           // Valore dato meteo della città trovata
+    float distance_km;     // Distanza sul globo dalla posizione richiesta
+    char city[64];         // Nome della città trovata (stringa null-terminated)
+} nearest_response_t;
+
+/*
+ * Intestazione di un datagramma snapshot (server -> gruppo multicast)
+ * Lo snapshot completo di tutte le città è diviso in part_count datagrammi.
+ * seq cresce di 1 per ogni datagramma: un salto indica datagrammi persi.
+ * Ogni record segue l'intestazione: lunghezza nome (1) + nome (senza '\0')
+ * + SNAPSHOT_METRICS float in network byte order (come in serialize_response).
+ */
+typedef struct {
+    uint32_t seq;          // Numero di sequenza del datagramma
+    uint32_t snapshot_id;  // Identificativo dello snapshot (cresce a ogni pubblicazione)
+    uint16_t part;         // Indice del datagramma nello snapshot (da 0)
+    uint16_t part_count;   // Numero di datagrammi dello snapshot
+    uint16_t record_count; // Città contenute in questo datagramma
+} snapshot_header_t;
+
+/*
+ * File di cattura: capture_file_header_t, poi per ogni datagramma ricevuto
+ * un capture_record_t seguito da length byte del datagramma, così com'era.
+ * I campi sono nel byte order dell'host che ha catturato (il replay gira
+ * sulla stessa architettura); addr e port restano in network byte order.
+ */
+typedef struct {
+    uint32_t magic;        // CAPTURE_MAGIC
+    uint16_t version;      // CAPTURE_VERSION
+    uint16_t record_size;  // sizeof(capture_record_t)
+    uint64_t start_time;   // Secondi Unix all'inizio della cattura
+} capture_file_header_t;
+
+typedef struct {
+    uint64_t time_ns;      // Arrivo, dal primo datagramma catturato
+    uint32_t addr;         // Mittente IPv4, o 240.x.y.z = hash di un IPv6: un flusso per mittente nel replay
+    uint16_t port;
+    uint16_t length;       // Byte del datagramma che seguono
+} capture_record_t;
+
 /* DIMENSIONI MESSAGGI SULLA RETE */
 /* Dimensione messaggio richiesta: type (1) + city (64) = 65 byte */
 #define REQUEST_SIZE (sizeof(char) + 64)
@@ -58,6 +195,27 @@ typedef struct {
 /* Dimensione messaggio risposta: status (4) + type (1) + value (4) = 9 byte */
 #define RESPONSE_SIZE (sizeof(uint32_t) + sizeof(char) + sizeof(float))
 
+/* Dimensione messaggio sottoscrizione: type (1) + city (64) + types (1) + interval_ms (4) = 70 byte */
+#define SUBSCRIBE_SIZE (sizeof(char) + 64 + sizeof(uint8_t) + sizeof(uint32_t))
+
+/* Dimensione query aggregata: TYPE_AGGREGATE (1) + city (64) + type (1) + window_s (4) = 70 byte */
+#define AGGREGATE_REQUEST_SIZE (sizeof(char) + 64 + sizeof(char) + sizeof(uint32_t))
+
+/* Dimensione risposta aggregata: status (4) + type (1) + count (4) + min, max, avg (3 x 4) = 21 byte */
+#define AGGREGATE_RESPONSE_SIZE (sizeof(uint32_t) + sizeof(char) + sizeof(uint32_t) + 3 * sizeof(float))
+
+/* Dimensione richiesta con suggerimenti: richiesta (65) + max_suggestions (1) = 66 byte */
+#define SUGGEST_REQUEST_SIZE (REQUEST_SIZE + sizeof(uint8_t))
+
+/* Dimensione massima risposta estesa: risposta (9) + count (1) + SUGGEST_MAX_COUNT x (1 + 63) = 330 byte */
+#define SUGGEST_RESPONSE_MAX_SIZE (RESPONSE_SIZE + sizeof(uint8_t) + SUGGEST_MAX_COUNT * 64)
+
+/* Dimensione ricerca per coordinate: TYPE_NEAREST (1) + latitude (4) + longitude (4) + type (1) = 10 byte */
+#define NEAREST_REQUEST_SIZE (sizeof(char) + 2 * sizeof(float) + sizeof(char))
+
+/* Dimensione risposta per coordinate: status (4) + type (1) + value (4) + distance_km (4) + city (64) = 77 byte */
+#define NEAREST_RESPONSE_SIZE (sizeof(uint32_t) + sizeof(char) + 2 * sizeof(float) + 64)
+
 /*
  * ============================================================================
  * FUNCTION PROTOTYPES
@@ -90,6 +248,51 @@ int serialize_response(const weather_response_t *response, uint8_t *buffer);
  */
 int deserialize_response(const uint8_t *buffer, weather_response_t *response);
 
+/*
+ * Serializza / deserializza una sottoscrizione
+ * Il primo byte vale sempre TYPE_SUBSCRIBE, interval_ms viaggia in network byte order
+ */
+int serialize_subscribe(const subscribe_request_t *request, uint8_t *buffer);
+int deserialize_subscribe(const uint8_t *buffer, subscribe_request_t *request);
+
+/*
+ * Serializza / deserializza una query aggregata e la sua risposta
+ * Il primo byte della query vale sempre TYPE_AGGREGATE
+ */
+int serialize_aggregate_request(const aggregate_request_t *request, uint8_t *buffer);
+int deserialize_aggregate_request(const uint8_t *buffer, aggregate_request_t *request);
+int serialize_aggregate_response(const aggregate_response_t *response, uint8_t *buffer);
+int deserialize_aggregate_response(const uint8_t *buffer, aggregate_response_t *response);
+
+/*
+ * Serializza i suggerimenti dopo una risposta (ritorna i byte scritti)
+ * Deserializza i length byte che seguono la risposta; -1 se malformati
+ */
+int serialize_suggestions(const city_suggestions_t *suggestions, uint8_t *buffer);
+int deserialize_suggestions(const uint8_t *buffer, int length, city_suggestions_t *suggestions);
+
+/*
+ * Serializza / deserializza una ricerca per coordinate e la sua risposta
+ * Il primo byte della ricerca vale sempre TYPE_NEAREST
+ */
+int serialize_nearest_request(const nearest_request_t *request, uint8_t *buffer);
+int deserialize_nearest_request(const uint8_t *buffer, nearest_request_t *request);
+int serialize_nearest_response(const nearest_response_t *response, uint8_t *buffer);
+int deserialize_nearest_response(const uint8_t *buffer, nearest_response_t *response);
+
+/*
+ * Serializza / deserializza l'intestazione di un datagramma snapshot
+ * deserialize_snapshot_header ritorna -1 se il magic non corrisponde
+ */
+int serialize_snapshot_header(const snapshot_header_t *header, uint8_t *buffer);
+int deserialize_snapshot_header(const uint8_t *buffer, snapshot_header_t *header);
+
+/*
+ * Converte un tipo ('t', 'h', 'w', 'p') nel bit SUB_MASK_* corrispondente
+ * Ritorna 0 se il tipo non è valido
+ */
+uint8_t type_to_sub_mask(char type);
+
 /*
  * Effettua il parsing della stringa di richiesta utente (lato CLIENT)
  * Input: "type city" (es: "t roma")
@@ -97,6 +300,13 @@ int deserialize_response(const uint8_t *buffer, weather_response_t *response);
  */
 int parse_weather_request(const char *input, weather_request_t *request);
 
+/*
+ * Effettua il parsing della stringa di sottoscrizione (lato CLIENT)
+ * Input: "types city" (es: "th roma" = temperatura e umidità)
+ * Output: riempie city e types della struct subscribe_request_t
+ */
+int parse_subscribe_request(const char *input, subscribe_request_t *request);
+
 /*
  * Valida una richiesta lato SERVER
  * Verifica tipo valido e città supportata
@@ -104,13 +314,42 @@ int parse_weather_request(const char *input, weather_request_t *request);
  */
 int validate_request_server(const weather_request_t *request);
 
+/*
+ * Cerca una città del catalogo (confronto case-insensitive)
+ * Ritorna l'indice della città oppure -1 se non disponibile
+ */
+int find_city_index(const char *city_name);
+
+/*
+ * Nome canonico della città con indice city_index (NULL se fuori range)
+ */
+const char *get_city_name(int city_index);
+
+/*
+ * Numero di città del catalogo (supportate + caricate con -G)
+ */
+int get_city_count(void);
+
 /* Funzioni di generazione dati meteorologici */
 
 void initialize_random_generator(void);
-float get_temperature(void);
-float get_humidity(void);
-float get_wind(void);
-float get_pressure(void);
+
+/* Valori correnti della simulazione per la città city_index (indice di find_city_index) */
+float get_temperature(int city_index);
+float get_humidity(int city_index);
+float get_wind(int city_index);
+float get_pressure(int city_index);
+
+/*
+ * Valore corrente del tipo richiesto ('t', 'h', 'w', 'p') per la città
+ * Ritorna 0.0 per città o tipi non validi
+ */
+float get_weather_value(int city_index, char type);
+
+/*
+ * Costruisce la risposta completa per una richiesta (validazione + valore)
+ */
+void build_weather_response(const weather_request_t *request, weather_response_t *response);
 
 /* Funzioni di utilità DNS */
 
@@ -120,4 +359,14 @@ float get_pressure(void);
  */
 int resolve_host(const char *input, char *hostname_out, size_t hostname_size, char *ip_out, size_t ip_size);
 
+/*
+ * Orologio monotono in millisecondi (non influenzato da cambi di data/ora)
+ */
+uint64_t get_monotonic_ms(void);
+
+/*
+ * Orologio monotono in nanosecondi (misure di latenza)
+ */
+uint64_t get_monotonic_ns(void);
+
 #endif /* PROTOCOL_H_ */
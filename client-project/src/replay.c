@@ -0,0 +1,157 @@
+/*
+ * replay.c
+ *
+ * Caricamento di un file di cattura per il replay
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replay.h"
+
+static int compare_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Riconosce i messaggi con risposta, come il dispatch del server (dimensione + primo byte) */
+static int classify(const uint8_t *data, int length, uint8_t *kind, char *type) {
+	if ((length == (int)REQUEST_SIZE || length == (int)SUGGEST_REQUEST_SIZE) && data[0] != '\0') {
+		*kind = REPLAY_KIND_WEATHER;
+		*type = (char)data[0];
+		return 0;
+	}
+	if (length == (int)AGGREGATE_REQUEST_SIZE && data[0] == (uint8_t)TYPE_AGGREGATE) {
+		*kind = REPLAY_KIND_AGGREGATE;
+		*type = (char)data[65];
+		return 0;
+	}
+	if (length == (int)NEAREST_REQUEST_SIZE && data[0] == (uint8_t)TYPE_NEAREST) {
+		*kind = REPLAY_KIND_NEAREST;
+		*type = (char)data[NEAREST_REQUEST_SIZE - 1];
+		return 0;
+	}
+	return -1;
+}
+
+int capture_trace_load(capture_trace_t *trace, const char *path) {
+	if (!trace || !path) {
+		return -1;
+	}
+	memset(trace, 0, sizeof(*trace));
+
+	// LETTURA DEL FILE IN MEMORIA
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		fprintf(stderr, "Errore: impossibile aprire il file di cattura '%s'.\n", path);
+		return -1;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	if (size < (long)sizeof(capture_file_header_t)) {
+		fprintf(stderr, "Errore: '%s' non è un file di cattura.\n", path);
+		fclose(file);
+		return -1;
+	}
+	trace->buffer = (uint8_t *)malloc((size_t)size);
+	if (!trace->buffer || fread(trace->buffer, 1, (size_t)size, file) != (size_t)size) {
+		fprintf(stderr, "Errore: lettura del file di cattura '%s' fallita.\n", path);
+		fclose(file);
+		capture_trace_free(trace);
+		return -1;
+	}
+	fclose(file);
+
+	capture_file_header_t header;
+	memcpy(&header, trace->buffer, sizeof(header));
+	if (header.magic != CAPTURE_MAGIC || header.version != CAPTURE_VERSION ||
+	    header.record_size != sizeof(capture_record_t)) {
+		fprintf(stderr, "Errore: '%s' non è un file di cattura (versione %u).\n", path, header.version);
+		capture_trace_free(trace);
+		return -1;
+	}
+
+	// INDICE: al più un datagramma ogni sizeof(capture_record_t) byte
+	size_t max_records = ((size_t)size - sizeof(header)) / sizeof(capture_record_t);
+	trace->datagrams = (replay_datagram_t *)malloc((max_records + 1) * sizeof(replay_datagram_t));
+	if (!trace->datagrams) {
+		fprintf(stderr, "Errore: memoria insufficiente per la traccia.\n");
+		capture_trace_free(trace);
+		return -1;
+	}
+
+	size_t offset = sizeof(header);
+	int64_t previous_ns = 0;
+	while (offset + sizeof(capture_record_t) <= (size_t)size) {
+		capture_record_t record;
+		memcpy(&record, trace->buffer + offset, sizeof(record));
+		offset += sizeof(record);
+		if (offset + record.length > (size_t)size) {
+			break; // Cattura interrotta a metà di un record
+		}
+
+		replay_datagram_t *datagram = &trace->datagrams[trace->count];
+		datagram->data = trace->buffer + offset;
+		datagram->length = record.length;
+		offset += record.length;
+
+		if (classify(datagram->data, datagram->length, &datagram->kind, &datagram->type) != 0) {
+			trace->skipped++;
+			continue;
+		}
+		// Tempi non decrescenti nell'ordine del file: un arrivo precedente al
+		// record prima (o un tempo negativo di catture vecchie) parte subito dopo
+		int64_t time_ns = (int64_t)record.time_ns;
+		if (time_ns < previous_ns) {
+			time_ns = previous_ns;
+		}
+		previous_ns = time_ns;
+		datagram->time_ns = (uint64_t)time_ns;
+		// Mittente -> flusso (FNV-1a su indirizzo e porta)
+		uint32_t hash = 2166136261u;
+		const uint8_t *key = (const uint8_t *)&record.addr;
+		for (int i = 0; i < 6; i++) {
+			hash = (hash ^ (i < 4 ? key[i] : ((const uint8_t *)&record.port)[i - 4])) * 16777619u;
+		}
+		datagram->flow = hash;
+		trace->count++;
+	}
+
+	if (trace->count == 0) {
+		return 0;
+	}
+
+	// TEMPI RELATIVI AL PRIMO DATAGRAMMA RIPRODOTTO
+	uint64_t first_ns = trace->datagrams[0].time_ns;
+	for (int i = 0; i < trace->count; i++) {
+		trace->datagrams[i].time_ns -= first_ns;
+	}
+	trace->duration_ns = trace->datagrams[trace->count - 1].time_ns;
+
+	// MITTENTI DISTINTI (solo per il riepilogo)
+	uint32_t *flows = (uint32_t *)malloc((size_t)trace->count * sizeof(uint32_t));
+	if (flows) {
+		for (int i = 0; i < trace->count; i++) {
+			flows[i] = trace->datagrams[i].flow;
+		}
+		qsort(flows, (size_t)trace->count, sizeof(uint32_t), compare_u32);
+		for (int i = 0; i < trace->count; i++) {
+			if (i == 0 || flows[i] != flows[i - 1]) {
+				trace->flows++;
+			}
+		}
+		free(flows);
+	}
+	return 0;
+}
+
+void capture_trace_free(capture_trace_t *trace) {
+	if (!trace) {
+		return;
+	}
+	free(trace->buffer);
+	free(trace->datagrams);
+	memset(trace, 0, sizeof(*trace));
+}
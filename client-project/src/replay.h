@@ -0,0 +1,56 @@
+/*
+ * replay.h
+ *
+ * Caricamento di un file di cattura (server -w, bench/capture_tap.c) per il
+ * replay (opzione -R): il file è letto tutto in memoria e indicizzato, così
+ * durante il replay l'invio di un datagramma non tocca il disco.
+ * Sono riprodotti solo i messaggi con una risposta da confrontare:
+ * richieste meteo (anche con suggerimenti), query aggregate e ricerche per
+ * coordinate. Sottoscrizioni e datagrammi non validi sono saltati.
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+#include "protocol.h"
+
+#define REPLAY_MAX_SOCKETS 64
+#define REPLAY_DEFAULT_SOCKETS 4
+#define REPLAY_WINDOW 32                // Richieste in volo al più per socket (buffer del server)
+
+/* Tipo di messaggio riprodotto (decide come validare la risposta) */
+#define REPLAY_KIND_WEATHER 0
+#define REPLAY_KIND_AGGREGATE 1
+#define REPLAY_KIND_NEAREST 2
+
+typedef struct {
+	const uint8_t *data;            // Datagramma (nel buffer della traccia)
+	uint64_t time_ns;               // Arrivo originale, dal primo datagramma
+	uint32_t flow;                  // Hash del mittente originale
+	uint16_t length;
+	uint8_t kind;                   // REPLAY_KIND_*
+	char type;                      // Tipo atteso nella risposta
+} replay_datagram_t;
+
+typedef struct {
+	uint8_t *buffer;                // Contenuto del file
+	replay_datagram_t *datagrams;
+	int count;
+	int skipped;                    // Datagrammi senza risposta da confrontare
+	int flows;                      // Mittenti distinti (stima)
+	uint64_t duration_ns;           // Dal primo all'ultimo datagramma riprodotto
+} capture_trace_t;
+
+/*
+ * Legge e indicizza un file di cattura
+ * Ritorna 0 in caso di successo, -1 se il file non è valido
+ */
+int capture_trace_load(capture_trace_t *trace, const char *path);
+
+/*
+ * Libera la traccia
+ */
+void capture_trace_free(capture_trace_t *trace);
+
+#endif /* REPLAY_H_ */
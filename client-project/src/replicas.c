@@ -0,0 +1,275 @@
+/*
+ * replicas.c
+ *
+ * Selezione della replica e richieste hedged
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+typedef int socklen_t;
+#else
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "replicas.h"
+
+int replica_set_parse(replica_set_t *set, const char *list, int default_port, response_cache_t *cache) {
+	if (!set || !list) {
+		return -1;
+	}
+
+	char buffer[BUFFER_SIZE];
+	strncpy(buffer, list, sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	int added = 0;
+	char *item = buffer;
+	while (item) {
+		// Separazione manuale sulle virgole (strtok_r non è disponibile ovunque)
+		char *comma = strchr(item, ',');
+		if (comma) {
+			*comma = '\0';
+		}
+		char *next_item = comma ? comma + 1 : NULL;
+
+		if (*item == '\0') {
+			item = next_item;
+			continue;
+		}
+
+		if (set->count >= MAX_REPLICAS) {
+			fprintf(stderr, "Errore: troppe repliche (massimo %d).\n", MAX_REPLICAS);
+			return -1;
+		}
+
+		int port = default_port;
+		char *colon = strchr(item, ':');
+		if (colon) {
+			*colon = '\0';
+			port = atoi(colon + 1);
+			if (port <= 0 || port > 65535) {
+				fprintf(stderr, "Errore: porta non valida %d (range 1-65535)\n", port);
+				return -1;
+			}
+		}
+
+		// RISOLUZIONE DNS: una sola volta per replica, all'avvio (o dalla cache)
+		replica_t *replica = &set->replicas[set->count];
+		memset(replica, 0, sizeof(*replica));
+		if (response_cache_resolve(cache, item, replica->hostname, sizeof(replica->hostname),
+		                           replica->ip, sizeof(replica->ip)) != 0) {
+			return -1;
+		}
+
+		replica->addr.sin_family = AF_INET;
+		replica->addr.sin_port = htons((unsigned short)port);
+		replica->addr.sin_addr.s_addr = inet_addr(replica->ip);
+
+		set->count++;
+		added++;
+		item = next_item;
+	}
+
+	return added;
+}
+
+int replica_set_find(const replica_set_t *set, const struct sockaddr_in *addr) {
+	for (int i = 0; i < set->count; i++) {
+		if (set->replicas[i].addr.sin_addr.s_addr == addr->sin_addr.s_addr &&
+		    set->replicas[i].addr.sin_port == addr->sin_port) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int compare_u32(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+uint32_t replica_hedge_delay_us(const replica_set_t *set) {
+	if (set->recent_count < HEDGE_MIN_SAMPLES) {
+		return HEDGE_DEFAULT_DELAY_US;
+	}
+
+	uint32_t sorted[HEDGE_WINDOW];
+	memcpy(sorted, set->recent_us, (size_t)set->recent_count * sizeof(uint32_t));
+	qsort(sorted, (size_t)set->recent_count, sizeof(uint32_t), compare_u32);
+
+	uint32_t delay = sorted[(set->recent_count - 1) * HEDGE_PERCENTILE / 100];
+	return delay < HEDGE_MIN_DELAY_US ? HEDGE_MIN_DELAY_US : delay;
+}
+
+/* Stima usata per l'ordinamento: le repliche mai misurate valgono il ritardo di default */
+static double replica_estimate_us(const replica_t *replica) {
+	return replica->ewma_us > 0.0 ? replica->ewma_us : (double)HEDGE_DEFAULT_DELAY_US;
+}
+
+static void update_ewma(replica_t *replica, double sample_us) {
+	if (replica->ewma_us <= 0.0) {
+		replica->ewma_us = sample_us;
+	} else {
+		replica->ewma_us += REPLICA_EWMA_WEIGHT * (sample_us - replica->ewma_us);
+	}
+}
+
+/*
+ * Una replica che non ha ancora risposto ha latenza almeno pari al tempo trascorso:
+ * la stima viene alzata (mai abbassata) così una replica lenta o morta perde priorità
+ */
+static void penalize(replica_t *replica, double elapsed_us) {
+	if (elapsed_us > replica->ewma_us) {
+		update_ewma(replica, elapsed_us);
+	}
+}
+
+/* Scarta risposte tardive di richieste precedenti (es. hedge perdenti) */
+static void drain_stale(int sock) {
+	uint8_t discard[BUFFER_SIZE];
+	while (1) {
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+		struct timeval zero = { 0, 0 };
+		if (select(sock + 1, &read_set, NULL, NULL, &zero) <= 0) {
+			return;
+		}
+		if (recvfrom(sock, (char *)discard, sizeof(discard), 0, NULL, NULL) < 0) {
+			return;
+		}
+	}
+}
+
+int hedged_request(int sock, replica_set_t *set, const uint8_t *request, uint8_t *response, int timeout_ms) {
+	return hedged_exchange(sock, set, request, REQUEST_SIZE, response, RESPONSE_SIZE, NULL, timeout_ms);
+}
+
+int hedged_exchange(int sock, replica_set_t *set, const uint8_t *request, size_t request_len,
+                    uint8_t *response, size_t response_size, int *response_len, int timeout_ms) {
+	if (!set || set->count == 0 || !request || !response || response_size < RESPONSE_SIZE) {
+		return -1;
+	}
+
+	drain_stale(sock);
+
+	// ORDINE DI INVIO: dalla replica più veloce (insertion sort, al più MAX_REPLICAS)
+	int order[MAX_REPLICAS];
+	for (int i = 0; i < set->count; i++) {
+		int j = i;
+		while (j > 0 && replica_estimate_us(&set->replicas[order[j - 1]]) > replica_estimate_us(&set->replicas[i])) {
+			order[j] = order[j - 1];
+			j--;
+		}
+		order[j] = i;
+	}
+
+	uint64_t sent_at_ns[MAX_REPLICAS] = { 0 };
+	const uint64_t hedge_delay_ns = (uint64_t)replica_hedge_delay_us(set) * 1000u;
+	const uint64_t start_ns = get_monotonic_ns();
+	const uint64_t deadline_ns = start_ns + (uint64_t)timeout_ms * 1000000u;
+	uint64_t hedge_at_ns = start_ns;
+	int next = 0;
+
+	while (1) {
+		uint64_t now_ns = get_monotonic_ns();
+
+		// INVIO PRIMARIO O HEDGE
+		if (next < set->count && now_ns >= hedge_at_ns) {
+			replica_t *replica = &set->replicas[order[next]];
+			int bytes_sent = sendto(sock, (const char *)request, (int)request_len, 0,
+			                        (const struct sockaddr *)&replica->addr, sizeof(replica->addr));
+			if (bytes_sent == (int)request_len) {
+				sent_at_ns[order[next]] = now_ns;
+				replica->requests_sent++;
+				if (next > 0) {
+					set->hedges_sent++;
+				}
+			}
+			next++;
+			hedge_at_ns = now_ns + hedge_delay_ns;
+		}
+
+		if (now_ns >= deadline_ns) {
+			break;
+		}
+
+		uint64_t wake_ns = deadline_ns;
+		if (next < set->count && hedge_at_ns < wake_ns) {
+			wake_ns = hedge_at_ns;
+		}
+		uint64_t wait_us = wake_ns > now_ns ? (wake_ns - now_ns) / 1000u : 0;
+
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(sock, &read_set);
+		struct timeval timeout;
+		timeout.tv_sec = (long)(wait_us / 1000000u);
+		timeout.tv_usec = (long)(wait_us % 1000000u);
+
+		if (select(sock + 1, &read_set, NULL, NULL, &timeout) <= 0) {
+			continue; // Scadenza hedge o timeout
+		}
+
+		struct sockaddr_in from_addr;
+		socklen_t from_len = sizeof(from_addr);
+		int bytes_received = recvfrom(sock, (char *)response, (int)response_size, 0,
+		                              (struct sockaddr *)&from_addr, &from_len);
+		if (bytes_received < (int)RESPONSE_SIZE) {
+			continue;
+		}
+
+		// VALIDAZIONE SORGENTE: deve essere una replica contattata in questa richiesta
+		int winner = replica_set_find(set, &from_addr);
+		if (winner < 0) {
+			fprintf(stderr, "Errore: ricevuto pacchetto da sorgente sconosciuta.\n");
+			continue;
+		}
+		if (sent_at_ns[winner] == 0) {
+			continue; // Risposta tardiva a una richiesta precedente
+		}
+
+		// AGGIORNAMENTO STATISTICHE
+		now_ns = get_monotonic_ns();
+		double latency_us = (double)(now_ns - sent_at_ns[winner]) / 1000.0;
+		update_ewma(&set->replicas[winner], latency_us);
+		set->replicas[winner].responses_won++;
+
+		set->recent_us[set->recent_pos] = (uint32_t)latency_us;
+		set->recent_pos = (set->recent_pos + 1) % HEDGE_WINDOW;
+		if (set->recent_count < HEDGE_WINDOW) {
+			set->recent_count++;
+		}
+
+		for (int i = 0; i < set->count; i++) {
+			if (i != winner && sent_at_ns[i] != 0) {
+				penalize(&set->replicas[i], (double)(now_ns - sent_at_ns[i]) / 1000.0);
+			}
+		}
+		if (response_len) {
+			*response_len = bytes_received;
+		}
+		return winner;
+	}
+
+	// TIMEOUT: nessuna replica ha risposto
+	uint64_t end_ns = get_monotonic_ns();
+	for (int i = 0; i < set->count; i++) {
+		if (sent_at_ns[i] != 0) {
+			penalize(&set->replicas[i], (double)(end_ns - sent_at_ns[i]) / 1000.0);
+		}
+	}
+	set->timeouts++;
+	return -1;
+}
@@ -0,0 +1,105 @@
+/*
+ * replicas.h
+ *
+ * Richieste "hedged" verso più repliche del server
+ * Il client invia alla replica più veloce (EWMA della latenza); se la
+ * risposta non arriva entro un ritardo pari a un percentile delle latenze
+ * osservate, invia la stessa richiesta alla replica successiva e usa la
+ * prima risposta ricevuta.
+ */
+
+#ifndef REPLICAS_H_
+#define REPLICAS_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol.h"
+#include "response_cache.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define MAX_REPLICAS 8
+#define REPLICA_EWMA_WEIGHT 0.125       // Peso del nuovo campione (come SRTT di TCP)
+#define HEDGE_PERCENTILE 95             // Percentile delle latenze usato come ritardo di hedge
+#define HEDGE_WINDOW 64                 // Latenze recenti considerate per il percentile
+#define HEDGE_MIN_SAMPLES 8             // Sotto questa soglia si usa il ritardo di default
+#define HEDGE_DEFAULT_DELAY_US 20000    // Ritardo di hedge senza statistiche
+#define HEDGE_MIN_DELAY_US 100          // Evita hedge a raffica su latenze minime
+#define REQUEST_TIMEOUT_MS 2000         // Attesa massima complessiva di una richiesta
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	char hostname[256];             // Nome risolto (per l'output)
+	char ip[16];                    // Indirizzo IP (per l'output)
+	struct sockaddr_in addr;        // Indirizzo risolto una sola volta all'avvio
+	double ewma_us;                 // Latenza media esponenziale (0 = nessun campione)
+	uint64_t requests_sent;         // Richieste inviate (primarie + hedge)
+	uint64_t responses_won;         // Risposte usate
+} replica_t;
+
+typedef struct {
+	replica_t replicas[MAX_REPLICAS];
+	int count;
+
+	uint32_t recent_us[HEDGE_WINDOW]; // Latenze recenti delle risposte vincenti
+	int recent_count;
+	int recent_pos;
+
+	uint64_t hedges_sent;           // Richieste duplicate inviate
+	uint64_t timeouts;              // Richieste senza alcuna risposta
+} replica_set_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Aggiunge le repliche da una lista "host[:porta],host[:porta],..."
+ * risolvendo subito ogni indirizzo; default_port vale per le voci senza porta
+ * cache: indirizzi già risolti da altre invocazioni (NULL = sempre DNS)
+ * Ritorna il numero di repliche aggiunte oppure -1 in caso di errore
+ */
+int replica_set_parse(replica_set_t *set, const char *list, int default_port, response_cache_t *cache);
+
+/*
+ * Ritorna l'indice della replica con indirizzo e porta indicati, -1 se sconosciuta
+ */
+int replica_set_find(const replica_set_t *set, const struct sockaddr_in *addr);
+
+/*
+ * Ritardo di hedge corrente in microsecondi
+ */
+uint32_t replica_hedge_delay_us(const replica_set_t *set);
+
+/*
+ * Invia la richiesta serializzata con hedging e attende la prima risposta
+ * Ritorna l'indice della replica che ha risposto (response riempito con
+ * RESPONSE_SIZE byte) oppure -1 in caso di timeout o errore
+ */
+int hedged_request(int sock, replica_set_t *set, const uint8_t *request, uint8_t *response, int timeout_ms);
+
+/*
+ * Come hedged_request con richiesta di request_len byte e risposta di lunghezza
+ * variabile (da RESPONSE_SIZE a response_size byte, lunghezza in response_len)
+ */
+int hedged_exchange(int sock, replica_set_t *set, const uint8_t *request, size_t request_len,
+                    uint8_t *response, size_t response_size, int *response_len, int timeout_ms);
+
+#endif /* REPLICAS_H_ */
@@ -0,0 +1,373 @@
+/*
+ * response_cache.c
+ *
+ * Cache delle risposte in un file mappato, condiviso tra processi client
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include "response_cache.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Tempo reale: la cache sopravvive al processo, l'orologio monotono no */
+static uint64_t realtime_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000u + (uint64_t)(ts.tv_nsec / 1000000);
+}
+
+/* FNV-1a a 64 bit, concatenabile */
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t length) {
+	const uint8_t *bytes = (const uint8_t *)data;
+	for (size_t i = 0; i < length; i++) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+#define HASH_SEED 14695981039346656037ull
+
+/* Mai 0: la chiave 0 indica una voce libera */
+static uint64_t nonzero(uint64_t hash) {
+	return hash ? hash : 1;
+}
+
+/* Città in minuscolo: il server confronta i nomi senza distinguere maiuscole */
+static void normalize_city(const char *city, char *out) {
+	size_t i = 0;
+	for (; i < 63 && city[i]; i++) {
+		out[i] = (char)tolower((unsigned char)city[i]);
+	}
+	memset(out + i, 0, 64 - i);
+}
+
+static uint64_t server_hash(const char *server, int port) {
+	uint32_t port_value = (uint32_t)port;
+	uint64_t hash = hash_bytes(HASH_SEED, server, strlen(server));
+	return nonzero(hash_bytes(hash, &port_value, sizeof(port_value)));
+}
+
+/*
+ * ============================================================================
+ * SEQLOCK
+ * ============================================================================
+ * Lettura: seq pari, copia, seq invariato -> copia coerente.
+ * Scrittura: CAS da pari a dispari, campi, seq + 2 con release.
+ */
+
+static int seqlock_read(const uint32_t *seq, void *copy, const void *entry, size_t size) {
+	for (int attempt = 0; attempt < CACHE_READ_RETRIES; attempt++) {
+		uint32_t before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+		if (before & 1u) {
+			continue; // Scrittura in corso in un altro processo
+		}
+		memcpy(copy, entry, size);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(seq, __ATOMIC_RELAXED) == before) {
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static int seqlock_begin(uint32_t *seq, uint32_t *start) {
+	uint32_t current = __atomic_load_n(seq, __ATOMIC_RELAXED);
+	if (current & 1u) {
+		return -1;
+	}
+	if (!__atomic_compare_exchange_n(seq, &current, current + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+		return -1; // Un altro processo ha preso la voce: si rinuncia
+	}
+	*start = current;
+	return 0;
+}
+
+static void seqlock_end(uint32_t *seq, uint32_t start) {
+	__atomic_store_n(seq, start + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Voce in cui scrivere tra le CACHE_PROBES candidate: quella con la stessa
+ * chiave, altrimenti la più vecchia (le voci libere hanno stored_ms = 0).
+ * Le voci con una scrittura in corso non vengono scelte.
+ */
+static int pick_slot(const uint32_t *seq, const uint64_t *entry_key, const uint64_t *stored_ms, size_t stride,
+                     uint32_t mask, uint64_t key) {
+	int chosen = -1;
+	uint64_t oldest_ms = UINT64_MAX;
+	for (uint32_t probe = 0; probe < CACHE_PROBES; probe++) {
+		uint32_t index = ((uint32_t)key + probe) & mask;
+		const uint32_t *slot_seq = (const uint32_t *)((const uint8_t *)seq + index * stride);
+		const uint64_t *slot_key = (const uint64_t *)((const uint8_t *)entry_key + index * stride);
+		const uint64_t *slot_stored = (const uint64_t *)((const uint8_t *)stored_ms + index * stride);
+		if (__atomic_load_n(slot_seq, __ATOMIC_RELAXED) & 1u) {
+			continue;
+		}
+		if (__atomic_load_n(slot_key, __ATOMIC_RELAXED) == key) {
+			return (int)index;
+		}
+		uint64_t stored = __atomic_load_n(slot_stored, __ATOMIC_RELAXED);
+		if (stored < oldest_ms) {
+			oldest_ms = stored;
+			chosen = (int)index;
+		}
+	}
+	return chosen;
+}
+
+int response_cache_open(response_cache_t *cache, uint32_t ttl_ms) {
+	if (!cache) {
+		return -1;
+	}
+	memset(cache, 0, sizeof(*cache));
+
+	char path[64];
+	snprintf(path, sizeof(path), CACHE_PATH_FORMAT, (unsigned)getuid());
+
+	// APERTURA: niente link simbolici, solo file dell'utente corrente
+	int fd = open(path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: impossibile aprire la cache '%s' (%s).\n", path, strerror(errno));
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) < 0 || st.st_uid != getuid() || !S_ISREG(st.st_mode)) {
+		fprintf(stderr, "Errore: la cache '%s' non appartiene all'utente corrente.\n", path);
+		close(fd);
+		return -1;
+	}
+
+	// DIMENSIONE FISSA: il file appena creato viene esteso a zeri (cache vuota)
+	if (st.st_size == 0 && ftruncate(fd, (off_t)sizeof(cache_file_t)) < 0) {
+		fprintf(stderr, "Errore: impossibile dimensionare la cache '%s'.\n", path);
+		close(fd);
+		return -1;
+	}
+	if (st.st_size != 0 && st.st_size != (off_t)sizeof(cache_file_t)) {
+		fprintf(stderr, "Errore: la cache '%s' ha un formato diverso (eliminarla).\n", path);
+		close(fd);
+		return -1;
+	}
+
+	void *base = mmap(NULL, sizeof(cache_file_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		fprintf(stderr, "Errore: mmap() della cache fallita.\n");
+		return -1;
+	}
+	cache_file_t *file = (cache_file_t *)base;
+
+	// INTESTAZIONE: il primo processo la scrive, gli altri la verificano
+	uint32_t expected = 0;
+	if (__atomic_compare_exchange_n(&file->magic, &expected, CACHE_MAGIC, 0, __ATOMIC_ACQ_REL,
+	                                __ATOMIC_ACQUIRE)) {
+		file->version = CACHE_VERSION;
+		file->response_slots = CACHE_RESPONSE_SLOTS;
+		file->host_slots = CACHE_HOST_SLOTS;
+	} else if (expected != CACHE_MAGIC) {
+		fprintf(stderr, "Errore: '%s' non è un file di cache.\n", path);
+		munmap(base, sizeof(cache_file_t));
+		return -1;
+	}
+
+	cache->file = file;
+	cache->ttl_ms = ttl_ms;
+	return 0;
+}
+
+int response_cache_lookup(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          weather_response_t *response, char *hostname, size_t hostname_size,
+                          char *ip, size_t ip_size) {
+	if (!cache || !cache->file || !server || !request || !response) {
+		return 0;
+	}
+
+	char city[64];
+	normalize_city(request->city, city);
+	uint64_t server_key = server_hash(server, port);
+	uint64_t key = hash_bytes(server_key, &request->type, 1);
+	key = nonzero(hash_bytes(key, city, sizeof(city)));
+	uint64_t now_ms = realtime_ms();
+
+	for (uint32_t probe = 0; probe < CACHE_PROBES; probe++) {
+		cache_response_entry_t *entry =
+			&cache->file->responses[((uint32_t)key + probe) & (CACHE_RESPONSE_SLOTS - 1)];
+		if (__atomic_load_n(&entry->key, __ATOMIC_RELAXED) != key) {
+			continue;
+		}
+
+		cache_response_entry_t copy;
+		if (seqlock_read(&entry->seq, &copy, entry, sizeof(copy)) != 0) {
+			return 0;
+		}
+		// La chiave può essere cambiata tra il controllo e la copia
+		if (copy.key != key || copy.server_key != server_key || copy.port != (uint32_t)port ||
+		    copy.type != request->type || memcmp(copy.city, city, sizeof(city)) != 0) {
+			continue;
+		}
+		// Troppo vecchia per questa invocazione, o dal futuro (orologio spostato)
+		if (copy.stored_ms > now_ms || now_ms - copy.stored_ms >= cache->ttl_ms) {
+			return 0;
+		}
+
+		response->status = copy.status;
+		response->type = copy.type;
+		response->value = copy.value;
+		if (hostname && hostname_size > 0) {
+			copy.hostname[sizeof(copy.hostname) - 1] = '\0';
+			snprintf(hostname, hostname_size, "%s", copy.hostname);
+		}
+		if (ip && ip_size > 0) {
+			copy.ip[sizeof(copy.ip) - 1] = '\0';
+			snprintf(ip, ip_size, "%s", copy.ip);
+		}
+		return 1;
+	}
+	return 0;
+}
+
+void response_cache_store(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          const weather_response_t *response, const char *hostname, const char *ip) {
+	if (!cache || !cache->file || !server || !request || !response || response->status != STATUS_SUCCESS) {
+		return;
+	}
+
+	char city[64];
+	normalize_city(request->city, city);
+	uint64_t server_key = server_hash(server, port);
+	uint64_t key = hash_bytes(server_key, &request->type, 1);
+	key = nonzero(hash_bytes(key, city, sizeof(city)));
+
+	cache_response_entry_t *entries = cache->file->responses;
+	int index = pick_slot(&entries[0].seq, &entries[0].key, &entries[0].stored_ms, sizeof(entries[0]),
+	                      CACHE_RESPONSE_SLOTS - 1, key);
+	uint32_t start;
+	if (index < 0 || seqlock_begin(&entries[index].seq, &start) != 0) {
+		return;
+	}
+	cache_response_entry_t *entry = &entries[index];
+
+	entry->key = key;
+	entry->stored_ms = realtime_ms();
+	entry->server_key = server_key;
+	entry->port = (uint32_t)port;
+	memcpy(entry->city, city, sizeof(city));
+	entry->type = request->type;
+	entry->status = response->status;
+	entry->value = response->value;
+	snprintf(entry->hostname, sizeof(entry->hostname), "%s", hostname ? hostname : "");
+	snprintf(entry->ip, sizeof(entry->ip), "%s", ip ? ip : "");
+
+	seqlock_end(&entry->seq, start);
+}
+
+int response_cache_resolve(response_cache_t *cache, const char *input, char *hostname_out, size_t hostname_size,
+                           char *ip_out, size_t ip_size) {
+	if (!cache || !cache->file || !input || strlen(input) >= 64) {
+		return resolve_host(input, hostname_out, hostname_size, ip_out, ip_size);
+	}
+
+	uint64_t key = nonzero(hash_bytes(HASH_SEED, input, strlen(input)));
+	uint64_t now_ms = realtime_ms();
+
+	// RICERCA
+	for (uint32_t probe = 0; probe < CACHE_PROBES; probe++) {
+		cache_host_entry_t *entry = &cache->file->hosts[((uint32_t)key + probe) & (CACHE_HOST_SLOTS - 1)];
+		if (__atomic_load_n(&entry->key, __ATOMIC_RELAXED) != key) {
+			continue;
+		}
+		cache_host_entry_t copy;
+		if (seqlock_read(&entry->seq, &copy, entry, sizeof(copy)) != 0) {
+			break;
+		}
+		copy.name[sizeof(copy.name) - 1] = '\0';
+		if (copy.key != key || strcmp(copy.name, input) != 0) {
+			continue;
+		}
+		if (copy.stored_ms > now_ms || now_ms - copy.stored_ms >= CACHE_HOST_TTL_MS) {
+			break;
+		}
+		copy.hostname[sizeof(copy.hostname) - 1] = '\0';
+		copy.ip[sizeof(copy.ip) - 1] = '\0';
+		snprintf(hostname_out, hostname_size, "%s", copy.hostname);
+		snprintf(ip_out, ip_size, "%s", copy.ip);
+		return 0;
+	}
+
+	// RISOLUZIONE E MEMORIZZAZIONE
+	if (resolve_host(input, hostname_out, hostname_size, ip_out, ip_size) != 0) {
+		return -1;
+	}
+	if (strlen(hostname_out) >= 64) {
+		return 0; // Nome troppo lungo per la voce: non memorizzato
+	}
+
+	cache_host_entry_t *entries = cache->file->hosts;
+	int index = pick_slot(&entries[0].seq, &entries[0].key, &entries[0].stored_ms, sizeof(entries[0]),
+	                      CACHE_HOST_SLOTS - 1, key);
+	uint32_t start;
+	if (index < 0 || seqlock_begin(&entries[index].seq, &start) != 0) {
+		return 0;
+	}
+	cache_host_entry_t *entry = &entries[index];
+	entry->key = key;
+	entry->stored_ms = now_ms;
+	snprintf(entry->name, sizeof(entry->name), "%s", input);
+	snprintf(entry->hostname, sizeof(entry->hostname), "%s", hostname_out);
+	snprintf(entry->ip, sizeof(entry->ip), "%s", ip_out);
+	seqlock_end(&entry->seq, start);
+	return 0;
+}
+
+void response_cache_close(response_cache_t *cache) {
+	if (!cache || !cache->file) {
+		return;
+	}
+	munmap(cache->file, sizeof(cache_file_t));
+	cache->file = NULL;
+}
+
+#else /* !__linux__ */
+
+int response_cache_open(response_cache_t *cache, uint32_t ttl_ms) {
+	(void)ttl_ms;
+	if (cache) {
+		memset(cache, 0, sizeof(*cache));
+	}
+	fprintf(stderr, "Errore: cache delle risposte disponibile solo su Linux.\n");
+	return -1;
+}
+
+int response_cache_lookup(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          weather_response_t *response, char *hostname, size_t hostname_size,
+                          char *ip, size_t ip_size) {
+	(void)cache; (void)server; (void)port; (void)request; (void)response;
+	(void)hostname; (void)hostname_size; (void)ip; (void)ip_size;
+	return 0;
+}
+
+void response_cache_store(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          const weather_response_t *response, const char *hostname, const char *ip) {
+	(void)cache; (void)server; (void)port; (void)request; (void)response; (void)hostname; (void)ip;
+}
+
+int response_cache_resolve(response_cache_t *cache, const char *input, char *hostname_out, size_t hostname_size,
+                           char *ip_out, size_t ip_size) {
+	(void)cache;
+	return resolve_host(input, hostname_out, hostname_size, ip_out, ip_size);
+}
+
+void response_cache_close(response_cache_t *cache) {
+	(void)cache;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,137 @@
+/*
+ * response_cache.h
+ *
+ * Cache delle risposte condivisa tra invocazioni del client (opzione -c)
+ * Un file di dimensione fissa in /tmp, mappato con mmap() da ogni processo,
+ * contiene:
+ * - gli indirizzi risolti dei server (resolve_host), validi CACHE_HOST_TTL_MS
+ * - le risposte meteo riuscite, per (server, porta, tipo, città)
+ * Una risposta in cache evita sia la risoluzione DNS sia il round trip UDP.
+ *
+ * Ogni voce è protetta da un seqlock: i lettori non scrivono mai nel file e
+ * ripetono la copia se il numero di sequenza è dispari o è cambiato; chi
+ * scrive prende la voce con un CAS sul numero di sequenza e, se la trova
+ * occupata da un altro processo, rinuncia (la cache è solo un'ottimizzazione).
+ * L'età massima accettata la decide chi legge: ogni voce ricorda solo
+ * l'istante (CLOCK_REALTIME, comune a tutti i processi) in cui è stata scritta.
+ *
+ * Disponibile solo su Linux.
+ */
+
+#ifndef RESPONSE_CACHE_H_
+#define RESPONSE_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define CACHE_PATH_FORMAT "/tmp/weather_cache_%u.bin"  // Un file per utente (uid)
+#define CACHE_MAGIC 0x57434331u         // "WCC1"
+#define CACHE_VERSION 1
+#define CACHE_RESPONSE_SLOTS 512        // Voci di risposta (potenza di 2)
+#define CACHE_HOST_SLOTS 16             // Voci di indirizzo (potenza di 2)
+#define CACHE_PROBES 8                  // Voci candidate per chiave (sondaggio lineare)
+#define CACHE_READ_RETRIES 16           // Copie ripetute prima di considerare la voce assente
+#define CACHE_HOST_TTL_MS 60000         // Validità di un indirizzo risolto
+#define CACHE_MAX_TTL_S 3600
+
+/*
+ * ============================================================================
+ * LAYOUT DEL FILE
+ * ============================================================================
+ * Un file appena creato (tutto a zero) è una cache vuota valida.
+ */
+
+/* Indirizzo risolto di un server */
+typedef struct {
+	uint32_t seq;                    // Seqlock: dispari = scrittura in corso
+	uint32_t reserved;
+	uint64_t key;                    // Hash del nome richiesto (0 = voce libera)
+	uint64_t stored_ms;              // Istante di scrittura (CLOCK_REALTIME)
+	char name[64];                   // Nome richiesto (-s)
+	char hostname[64];               // Nome risolto
+	char ip[16];
+} cache_host_entry_t;
+
+/* Risposta meteo */
+typedef struct {
+	uint32_t seq;
+	uint32_t port;
+	uint64_t key;                    // Hash di server, porta, tipo e città (0 = voce libera)
+	uint64_t stored_ms;
+	uint64_t server_key;             // Hash della lista -s
+	char city[64];                   // Città in minuscolo
+	char type;
+	char reserved[3];
+	uint32_t status;
+	float value;
+	char hostname[64];               // Replica che ha risposto (per l'output)
+	char ip[16];
+} cache_response_entry_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t response_slots;
+	uint32_t host_slots;
+	cache_host_entry_t hosts[CACHE_HOST_SLOTS];
+	cache_response_entry_t responses[CACHE_RESPONSE_SLOTS];
+} cache_file_t;
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	cache_file_t *file;              // NULL = cache disattivata
+	uint32_t ttl_ms;                 // Età massima delle risposte accettate
+} response_cache_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Apre (o crea) il file di cache dell'utente
+ * Ritorna 0 in caso di successo, -1 se la cache non è utilizzabile
+ */
+int response_cache_open(response_cache_t *cache, uint32_t ttl_ms);
+
+/*
+ * Cerca una risposta non più vecchia di ttl_ms
+ * hostname/ip ricevono la replica che l'aveva fornita
+ * Ritorna 1 se trovata, 0 altrimenti
+ */
+int response_cache_lookup(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          weather_response_t *response, char *hostname, size_t hostname_size,
+                          char *ip, size_t ip_size);
+
+/*
+ * Memorizza una risposta (solo STATUS_SUCCESS)
+ */
+void response_cache_store(response_cache_t *cache, const char *server, int port, const weather_request_t *request,
+                          const weather_response_t *response, const char *hostname, const char *ip);
+
+/*
+ * resolve_host() passando dalla cache degli indirizzi
+ * Con cache NULL equivale a resolve_host()
+ */
+int response_cache_resolve(response_cache_t *cache, const char *input, char *hostname_out, size_t hostname_size,
+                           char *ip_out, size_t ip_size);
+
+/*
+ * Rilascia la mappatura
+ */
+void response_cache_close(response_cache_t *cache);
+
+#endif /* RESPONSE_CACHE_H_ */
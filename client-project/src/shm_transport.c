@@ -0,0 +1,235 @@
+/*
+ * shm_transport.c
+ *
+ * Trasporto in memoria condivisa - lato client
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "shm_transport.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static int futex_wait(uint32_t *word, uint32_t expected, int timeout_ms) {
+	struct timespec timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+	return (int)syscall(SYS_futex, word, FUTEX_WAIT, expected, &timeout, NULL, 0);
+}
+
+/* Occupa uno slot libero, oppure uno lasciato da un processo terminato */
+static int claim_slot(shm_segment_t *segment, uint32_t pid) {
+	for (uint32_t i = 0; i < SHM_MAX_CLIENTS; i++) {
+		uint32_t expected = 0;
+		if (__atomic_compare_exchange_n(&segment->clients[i].owner_pid, &expected, pid, 0,
+		                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return (int)i;
+		}
+	}
+
+	for (uint32_t i = 0; i < SHM_MAX_CLIENTS; i++) {
+		uint32_t owner = __atomic_load_n(&segment->clients[i].owner_pid, __ATOMIC_ACQUIRE);
+		if (owner != 0 && kill((pid_t)owner, 0) < 0 && errno == ESRCH &&
+		    __atomic_compare_exchange_n(&segment->clients[i].owner_pid, &owner, pid, 0,
+		                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			return (int)i;
+		}
+	}
+	return -1;
+}
+
+int shm_client_open(shm_client_t *client, int port) {
+	if (!client) {
+		return -1;
+	}
+
+	memset(client, 0, sizeof(*client));
+	client->doorbell_fd = -1;
+
+	char name[64];
+	snprintf(name, sizeof(name), SHM_NAME_FORMAT, port);
+
+	int fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: nessun server in memoria condivisa sulla porta %d.\n", port);
+		return -1;
+	}
+
+	void *mem = mmap(NULL, sizeof(shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		fprintf(stderr, "Errore: mmap del segmento condiviso fallita.\n");
+		return -1;
+	}
+
+	shm_segment_t *segment = (shm_segment_t *)mem;
+	if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || segment->version != SHM_VERSION) {
+		fprintf(stderr, "Errore: segmento condiviso non valido.\n");
+		munmap(mem, sizeof(shm_segment_t));
+		return -1;
+	}
+
+	int slot = claim_slot(segment, (uint32_t)getpid());
+	if (slot < 0) {
+		fprintf(stderr, "Errore: nessuno slot libero nel segmento condiviso.\n");
+		munmap(mem, sizeof(shm_segment_t));
+		return -1;
+	}
+
+	// Risposte rimaste da un proprietario precedente: scartate
+	shm_client_slot_t *own = &segment->clients[slot];
+	__atomic_store_n(&own->response_tail, __atomic_load_n(&own->response_head, __ATOMIC_ACQUIRE),
+	                 __ATOMIC_RELEASE);
+	__atomic_store_n(&own->waiting, 0, __ATOMIC_RELEASE);
+
+	char doorbell[96];
+	snprintf(doorbell, sizeof(doorbell), SHM_DOORBELL_FORMAT, port);
+	client->doorbell_fd = open(doorbell, O_WRONLY | O_NONBLOCK);
+	if (client->doorbell_fd < 0) {
+		fprintf(stderr, "Errore: apertura campanello %s fallita.\n", doorbell);
+		__atomic_store_n(&own->owner_pid, 0, __ATOMIC_RELEASE);
+		munmap(mem, sizeof(shm_segment_t));
+		return -1;
+	}
+
+	// Primo tag da pid e orologio: le richieste ancora in coda di un
+	// proprietario terminato non hanno tag che questo client attende
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	client->next_tag = (uint32_t)getpid() * 2654435761u ^ (uint32_t)now.tv_nsec ^ (uint32_t)now.tv_sec << 20;
+
+	client->segment = segment;
+	client->slot = (uint32_t)slot;
+	return 0;
+}
+
+void shm_client_close(shm_client_t *client) {
+	if (!client || !client->segment) {
+		return;
+	}
+	__atomic_store_n(&client->segment->clients[client->slot].owner_pid, 0, __ATOMIC_RELEASE);
+	munmap(client->segment, sizeof(shm_segment_t));
+	close(client->doorbell_fd);
+	client->segment = NULL;
+	client->doorbell_fd = -1;
+}
+
+/* Accoda la richiesta nel ring MPSC (protocollo di Vyukov) */
+static int enqueue_request(shm_client_t *client, const uint8_t *request, uint32_t tag) {
+	shm_segment_t *segment = client->segment;
+	uint32_t pos = __atomic_load_n(&segment->request_head, __ATOMIC_RELAXED);
+	shm_request_cell_t *cell;
+
+	while (1) {
+		cell = &segment->requests[pos & (SHM_REQUEST_RING - 1)];
+		uint32_t seq = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE);
+		int32_t diff = (int32_t)(seq - pos);
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&segment->request_head, &pos, pos + 1, 1,
+			                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			return -1; // Ring pieno
+		} else {
+			pos = __atomic_load_n(&segment->request_head, __ATOMIC_RELAXED);
+		}
+	}
+
+	cell->client_slot = client->slot;
+	cell->tag = tag;
+	memcpy(cell->payload, request, REQUEST_SIZE);
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+	// CAMPANELLO: solo se il server si è dichiarato addormentato
+	if (__atomic_load_n(&segment->server_sleeping, __ATOMIC_SEQ_CST)) {
+		char bell = 1;
+		if (write(client->doorbell_fd, &bell, 1) < 0 && errno != EAGAIN) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int shm_client_request(shm_client_t *client, const uint8_t *request, uint8_t *response, int timeout_ms) {
+	if (!client || !client->segment || !request || !response) {
+		return -1;
+	}
+
+	uint32_t tag = client->next_tag++;
+	if (enqueue_request(client, request, tag) != 0) {
+		fprintf(stderr, "Errore: ring richieste pieno.\n");
+		return -1;
+	}
+
+	shm_client_slot_t *slot = &client->segment->clients[client->slot];
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	while (1) {
+		uint32_t tail = slot->response_tail;
+		uint32_t head = __atomic_load_n(&slot->response_head, __ATOMIC_ACQUIRE);
+
+		// Consuma le risposte disponibili: quelle con tag diverso sono residui scaduti
+		while (tail != head) {
+			shm_response_cell_t *cell = &slot->ring[tail & (SHM_RESPONSE_RING - 1)];
+			int match = cell->tag == tag;
+			if (match) {
+				memcpy(response, cell->payload, RESPONSE_SIZE);
+			}
+			tail++;
+			__atomic_store_n(&slot->response_tail, tail, __ATOMIC_RELEASE);
+			if (match) {
+				return 0;
+			}
+		}
+
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L;
+		if (elapsed_ms >= timeout_ms) {
+			return -1;
+		}
+
+		// ATTESA SUL FUTEX: dichiarazione, ricontrollo, poi sonno
+		__atomic_store_n(&slot->waiting, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&slot->response_head, __ATOMIC_SEQ_CST) == head) {
+			futex_wait(&slot->response_head, head, (int)(timeout_ms - elapsed_ms));
+		}
+		__atomic_store_n(&slot->waiting, 0, __ATOMIC_SEQ_CST);
+	}
+}
+
+#else /* !__linux__ */
+
+int shm_client_open(shm_client_t *client, int port) {
+	(void)port;
+	if (client) {
+		memset(client, 0, sizeof(*client));
+		client->doorbell_fd = -1;
+	}
+	fprintf(stderr, "Errore: trasporto in memoria condivisa disponibile solo su Linux.\n");
+	return -1;
+}
+
+void shm_client_close(shm_client_t *client) {
+	(void)client;
+}
+
+int shm_client_request(shm_client_t *client, const uint8_t *request, uint8_t *response, int timeout_ms) {
+	(void)client; (void)request; (void)response; (void)timeout_ms;
+	return -1;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,207 @@
+/*
+ * impairment.c
+ *
+ * Modello di rete degradata per il proxy UDP
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "impairment.h"
+
+/*
+ * Generatore pseudocasuale xorshift64* (stato mai nullo)
+ */
+static uint64_t rng_next(impaired_link_t *link) {
+	uint64_t x = link->rng_state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	link->rng_state = x;
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+/* Valore uniforme in [0, 1) dai 53 bit alti */
+static double rng_uniform(impaired_link_t *link) {
+	return (double)(rng_next(link) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static int rng_chance(impaired_link_t *link, double percent) {
+	return percent > 0.0 && rng_uniform(link) * 100.0 < percent;
+}
+
+/*
+ * Min-heap per istante di consegna
+ */
+static int heap_before(const impaired_datagram_t *a, const impaired_datagram_t *b) {
+	if (a->release_us != b->release_us) {
+		return a->release_us < b->release_us;
+	}
+	return a->order < b->order;
+}
+
+static void heap_push(impaired_link_t *link, impaired_datagram_t *datagram) {
+	int i = link->heap_count++;
+	while (i > 0) {
+		int parent = (i - 1) / 2;
+		if (!heap_before(datagram, link->heap[parent])) {
+			break;
+		}
+		link->heap[i] = link->heap[parent];
+		i = parent;
+	}
+	link->heap[i] = datagram;
+}
+
+static impaired_datagram_t *heap_pop(impaired_link_t *link) {
+	impaired_datagram_t *top = link->heap[0];
+	impaired_datagram_t *last = link->heap[--link->heap_count];
+	int i = 0;
+
+	while (1) {
+		int child = 2 * i + 1;
+		if (child >= link->heap_count) {
+			break;
+		}
+		if (child + 1 < link->heap_count && heap_before(link->heap[child + 1], link->heap[child])) {
+			child++;
+		}
+		if (!heap_before(link->heap[child], last)) {
+			break;
+		}
+		link->heap[i] = link->heap[child];
+		i = child;
+	}
+	if (link->heap_count > 0) {
+		link->heap[i] = last;
+	}
+	return top;
+}
+
+int impaired_link_init(impaired_link_t *link, const impairment_config_t *config, uint64_t seed) {
+	if (!link || !config) {
+		return -1;
+	}
+
+	memset(link, 0, sizeof(*link));
+	link->config = *config;
+	link->rng_state = seed ? seed : 0x9E3779B97F4A7C15ULL;
+
+	link->pool = (impaired_datagram_t *)malloc(IMPAIR_QUEUE_CAPACITY * sizeof(impaired_datagram_t));
+	link->heap = (impaired_datagram_t **)malloc(IMPAIR_QUEUE_CAPACITY * sizeof(impaired_datagram_t *));
+	link->free_list = (impaired_datagram_t **)malloc(IMPAIR_QUEUE_CAPACITY * sizeof(impaired_datagram_t *));
+	if (!link->pool || !link->heap || !link->free_list) {
+		impaired_link_free(link);
+		return -1;
+	}
+
+	for (int i = 0; i < IMPAIR_QUEUE_CAPACITY; i++) {
+		link->free_list[i] = &link->pool[i];
+	}
+	link->free_count = IMPAIR_QUEUE_CAPACITY;
+	return 0;
+}
+
+void impaired_link_free(impaired_link_t *link) {
+	if (!link) {
+		return;
+	}
+	free(link->pool);
+	free(link->heap);
+	free(link->free_list);
+	link->pool = NULL;
+	link->heap = NULL;
+	link->free_list = NULL;
+	link->heap_count = 0;
+	link->free_count = 0;
+}
+
+/* Accoda una copia con istante di consegna calcolato da ritardo, jitter e riordino */
+static void schedule_copy(impaired_link_t *link, int session, const uint8_t *data, size_t length,
+                          uint64_t departure_us) {
+	if (link->free_count == 0) {
+		link->queue_drops++;
+		return;
+	}
+
+	const impairment_config_t *cfg = &link->config;
+	int64_t release = (int64_t)departure_us + cfg->delay_us;
+	if (cfg->jitter_us > 0) {
+		release += (int64_t)(rng_next(link) % (2u * (uint64_t)cfg->jitter_us + 1u)) - (int64_t)cfg->jitter_us;
+	}
+	if (rng_chance(link, cfg->reorder_percent)) {
+		release += cfg->reorder_us;
+		link->reordered++;
+	}
+	if (release < (int64_t)departure_us) {
+		release = (int64_t)departure_us;
+	}
+
+	impaired_datagram_t *datagram = link->free_list[--link->free_count];
+	datagram->release_us = (uint64_t)release;
+	datagram->order = link->next_order++;
+	datagram->session = session;
+	datagram->length = (uint16_t)length;
+	memcpy(datagram->data, data, length);
+	heap_push(link, datagram);
+}
+
+void impaired_link_submit(impaired_link_t *link, int session, const uint8_t *data, size_t length, uint64_t now_us) {
+	const impairment_config_t *cfg = &link->config;
+	link->received++;
+
+	if (length > IMPAIR_MAX_DATAGRAM) {
+		link->queue_drops++;
+		return;
+	}
+
+	// PERDITA CASUALE
+	if (rng_chance(link, cfg->loss_percent)) {
+		link->lost++;
+		return;
+	}
+
+	// COLLO DI BOTTIGLIA: trasmissione seriale, coda limitata in tempo
+	uint64_t departure_us = now_us;
+	if (cfg->rate_kbps > 0) {
+		uint64_t start_us = link->link_free_us > now_us ? link->link_free_us : now_us;
+		if (start_us - now_us > cfg->queue_us) {
+			link->queue_drops++; // Coda piena: scarto in coda (drop-tail)
+			return;
+		}
+		// kbit/s = bit/ms: tempo di trasmissione = bit * 1000 / kbps microsecondi
+		uint64_t transmit_us = (uint64_t)length * 8u * 1000u / cfg->rate_kbps;
+		departure_us = start_us + transmit_us;
+		link->link_free_us = departure_us;
+	}
+
+	schedule_copy(link, session, data, length, departure_us);
+
+	// DUPLICAZIONE: la copia ha ritardo e jitter indipendenti
+	if (rng_chance(link, cfg->duplicate_percent)) {
+		link->duplicated++;
+		schedule_copy(link, session, data, length, departure_us);
+	}
+}
+
+int64_t impaired_link_next_timeout_us(const impaired_link_t *link, uint64_t now_us) {
+	if (link->heap_count == 0) {
+		return -1;
+	}
+	uint64_t release_us = link->heap[0]->release_us;
+	return release_us > now_us ? (int64_t)(release_us - now_us) : 0;
+}
+
+impaired_datagram_t *impaired_link_pop_ready(impaired_link_t *link, uint64_t now_us) {
+	if (link->heap_count == 0 || link->heap[0]->release_us > now_us) {
+		return NULL;
+	}
+	link->delivered++;
+	return heap_pop(link);
+}
+
+void impaired_link_release(impaired_link_t *link, impaired_datagram_t *datagram) {
+	if (datagram) {
+		link->free_list[link->free_count++] = datagram;
+	}
+}
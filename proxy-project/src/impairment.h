@@ -0,0 +1,119 @@
+/*
+ * impairment.h
+ *
+ * Modello di rete degradata per il proxy UDP
+ * Ogni datagramma attraversa, nell'ordine: perdita casuale, collo di
+ * bottiglia a banda limitata (coda FIFO con limite), ritardo di
+ * propagazione con jitter, riordino e duplicazione. Tutte le scelte
+ * casuali vengono da un generatore con seme esplicito, così due
+ * esecuzioni con lo stesso seme e lo stesso traffico sono identiche.
+ */
+
+#ifndef IMPAIRMENT_H_
+#define IMPAIRMENT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define IMPAIR_MAX_DATAGRAM 2048        // Datagrammi più grandi vengono scartati
+#define IMPAIR_QUEUE_CAPACITY 8192      // Datagrammi in volo al massimo (per direzione)
+#define IMPAIR_DEFAULT_QUEUE_MS 100     // Coda massima davanti al collo di bottiglia
+#define IMPAIR_DEFAULT_REORDER_MS 5     // Ritardo extra di un datagramma riordinato
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/* Parametri di una direzione del collegamento */
+typedef struct {
+	double loss_percent;            // Probabilità di perdita
+	double duplicate_percent;       // Probabilità di duplicazione
+	double reorder_percent;         // Probabilità di ritardo extra (sorpassato dai successivi)
+	uint32_t delay_us;              // Ritardo di propagazione fisso
+	uint32_t jitter_us;             // Variazione uniforme in [-jitter, +jitter]
+	uint32_t reorder_us;            // Ritardo extra dei datagrammi riordinati
+	uint32_t rate_kbps;             // Banda del collo di bottiglia (0 = illimitata)
+	uint32_t queue_us;              // Attesa massima in coda prima dello scarto
+} impairment_config_t;
+
+/* Datagramma in attesa di consegna */
+typedef struct {
+	uint64_t release_us;            // Istante di consegna (orologio monotono)
+	uint64_t order;                 // Ordine di arrivo: spareggio a parità di istante
+	int session;                    // Sessione del proxy a cui appartiene
+	uint16_t length;
+	uint8_t data[IMPAIR_MAX_DATAGRAM];
+} impaired_datagram_t;
+
+/* Una direzione del collegamento: parametri, stato e statistiche */
+typedef struct {
+	impairment_config_t config;
+	uint64_t rng_state;             // xorshift64*
+
+	uint64_t link_free_us;          // Istante in cui il collo di bottiglia si libera
+	uint64_t next_order;
+
+	impaired_datagram_t **heap;     // Min-heap per istante di consegna
+	impaired_datagram_t *pool;      // Datagrammi preallocati
+	impaired_datagram_t **free_list;
+	int heap_count;
+	int free_count;
+
+	// Statistiche
+	uint64_t received;
+	uint64_t delivered;
+	uint64_t lost;
+	uint64_t queue_drops;
+	uint64_t duplicated;
+	uint64_t reordered;
+} impaired_link_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Inizializza una direzione con i parametri e il seme indicati
+ * Ritorna 0 in caso di successo, -1 se la memoria non basta
+ */
+int impaired_link_init(impaired_link_t *link, const impairment_config_t *config, uint64_t seed);
+
+/*
+ * Libera la memoria della direzione
+ */
+void impaired_link_free(impaired_link_t *link);
+
+/*
+ * Sottopone un datagramma ricevuto all'istante now_us al modello: viene
+ * scartato oppure accodato (eventualmente in due copie) per la consegna
+ */
+void impaired_link_submit(impaired_link_t *link, int session, const uint8_t *data, size_t length, uint64_t now_us);
+
+/*
+ * Microsecondi al prossimo datagramma da consegnare, -1 se la coda è vuota
+ */
+int64_t impaired_link_next_timeout_us(const impaired_link_t *link, uint64_t now_us);
+
+/*
+ * Estrae il prossimo datagramma con istante di consegna <= now_us
+ * Ritorna NULL se nessuno è pronto; il datagramma va restituito con
+ * impaired_link_release() dopo l'invio
+ */
+impaired_datagram_t *impaired_link_pop_ready(impaired_link_t *link, uint64_t now_us);
+
+/*
+ * Restituisce al pool un datagramma estratto con impaired_link_pop_ready()
+ */
+void impaired_link_release(impaired_link_t *link, impaired_datagram_t *datagram);
+
+#endif /* IMPAIRMENT_H_ */
@@ -0,0 +1,426 @@
+/*
+ * main.c
+ *
+ * UDP Proxy - rete degradata tra client e server
+ *
+ * Inoltra i datagrammi di ogni client al server (e le risposte al client)
+ * applicando perdita, ritardo, jitter, riordino, duplicazione e limite di
+ * banda in modo riproducibile (generatore con seme). Il contenuto dei
+ * datagrammi non viene interpretato: funziona con richieste, sottoscrizioni
+ * e qualsiasi altro messaggio del protocollo.
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+typedef int socklen_t;
+#else
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <sys/select.h>
+#define closesocket close
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include "impairment.h"
+
+#define PROXY_PORT 56800             // Porta default del proxy
+#define UPSTREAM_PORT 56700          // Porta default del server
+#define MAX_SESSIONS 256             // Client distinti serviti contemporaneamente
+#define SESSION_IDLE_MS 60000        // Sessione liberata dopo questo periodo di inattività
+
+/*
+ * Sessione: un client e il socket dedicato verso il server
+ * Il socket dedicato fa sì che il server veda client distinti (sottoscrizioni)
+ */
+typedef struct {
+	int in_use;
+	struct sockaddr_in client_addr;
+	int upstream_sock;
+	uint64_t last_active_us;
+} proxy_session_t;
+
+static proxy_session_t sessions[MAX_SESSIONS];
+
+/* Azzerato da Ctrl+C (SIGINT) o SIGTERM: il proxy stampa le statistiche ed esce */
+static volatile sig_atomic_t proxy_running = 1;
+
+static void handle_termination(int signum) {
+	(void)signum;
+	proxy_running = 0;
+}
+
+void clearwinsock() {
+#if defined WIN32
+	WSACleanup();
+#endif
+}
+
+static uint64_t get_monotonic_us(void) {
+#if defined WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e6 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+/*
+ * Risoluzione di "host[:porta]" in un indirizzo IPv4
+ */
+static int resolve_endpoint(const char *input, int default_port, struct sockaddr_in *addr) {
+	char host[256];
+	strncpy(host, input, sizeof(host) - 1);
+	host[sizeof(host) - 1] = '\0';
+
+	int port = default_port;
+	char *colon = strchr(host, ':');
+	if (colon) {
+		*colon = '\0';
+		port = atoi(colon + 1);
+		if (port <= 0 || port > 65535) {
+			fprintf(stderr, "Errore: porta non valida %d (range 1-65535)\n", port);
+			return -1;
+		}
+	}
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sin_family = AF_INET;
+	addr->sin_port = htons((unsigned short)port);
+	addr->sin_addr.s_addr = inet_addr(host);
+
+	if (addr->sin_addr.s_addr == INADDR_NONE) {
+		struct hostent *resolved = gethostbyname(host);
+		if (!resolved) {
+			fprintf(stderr, "Errore: impossibile risolvere l'hostname '%s'.\n", host);
+			return -1;
+		}
+		addr->sin_addr = *(struct in_addr *)resolved->h_addr_list[0];
+	}
+	return 0;
+}
+
+/*
+ * Sessione del client indicato: esistente, nuova, oppure -1 se la tabella è piena
+ */
+static int find_or_create_session(const struct sockaddr_in *client_addr, uint64_t now_us) {
+	int free_slot = -1;
+	for (int i = 0; i < MAX_SESSIONS; i++) {
+		if (!sessions[i].in_use) {
+			if (free_slot < 0) {
+				free_slot = i;
+			}
+			continue;
+		}
+		if (sessions[i].client_addr.sin_addr.s_addr == client_addr->sin_addr.s_addr &&
+		    sessions[i].client_addr.sin_port == client_addr->sin_port) {
+			sessions[i].last_active_us = now_us;
+			return i;
+		}
+	}
+
+	if (free_slot < 0) {
+		return -1;
+	}
+
+	int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		return -1;
+	}
+#if !defined WIN32
+	if (sock >= FD_SETSIZE) {
+		closesocket(sock);
+		return -1;
+	}
+#endif
+
+	proxy_session_t *session = &sessions[free_slot];
+	session->in_use = 1;
+	session->client_addr = *client_addr;
+	session->upstream_sock = sock;
+	session->last_active_us = now_us;
+	return free_slot;
+}
+
+static void expire_sessions(uint64_t now_us) {
+	for (int i = 0; i < MAX_SESSIONS; i++) {
+		if (sessions[i].in_use && now_us - sessions[i].last_active_us > (uint64_t)SESSION_IDLE_MS * 1000u) {
+			closesocket(sessions[i].upstream_sock);
+			sessions[i].in_use = 0;
+		}
+	}
+}
+
+static void print_link_stats(const char *label, const impaired_link_t *link) {
+	fprintf(stderr, "%s: ricevuti %llu, consegnati %llu, persi %llu, scartati in coda %llu, duplicati %llu, riordinati %llu\n",
+	        label,
+	        (unsigned long long)link->received,
+	        (unsigned long long)link->delivered,
+	        (unsigned long long)link->lost,
+	        (unsigned long long)link->queue_drops,
+	        (unsigned long long)link->duplicated,
+	        (unsigned long long)link->reordered);
+}
+
+/* Valore dell'opzione argv[*i], con messaggio di errore se manca */
+static const char *option_value(int argc, char *argv[], int *i) {
+	if (*i + 1 < argc) {
+		return argv[++(*i)];
+	}
+	fprintf(stderr, "Errore: manca il valore per %s\n", argv[*i]);
+	return NULL;
+}
+
+static void print_usage(const char *program) {
+	fprintf(stderr, "Uso: %s [-l porta] [-u server[:porta]] [-L perdita%%] [-d ritardo_ms] [-j jitter_ms]\n"
+	                "       [-o riordino%%] [-D duplicazione%%] [-r banda_kbps] [-Q coda_ms] [-S seme]\n",
+	        program);
+}
+
+int main(int argc, char *argv[]) {
+
+	int listen_port = PROXY_PORT;
+	const char *upstream = "localhost";
+	unsigned long long seed = 1;
+
+	impairment_config_t config;
+	memset(&config, 0, sizeof(config));
+	config.reorder_us = IMPAIR_DEFAULT_REORDER_MS * 1000u;
+	config.queue_us = IMPAIR_DEFAULT_QUEUE_MS * 1000u;
+
+	// PARSING ARGOMENTI
+	for (int i = 1; i < argc; i++) {
+		const char *option = argv[i];
+		if (strlen(option) != 2 || option[0] != '-' || !strchr("luLdjoDrQS", option[1])) {
+			print_usage(argv[0]);
+			return 1;
+		}
+
+		const char *value = option_value(argc, argv, &i);
+		if (!value) {
+			return 1;
+		}
+
+		switch (option[1]) {
+			case 'l':
+				listen_port = atoi(value);
+				if (listen_port <= 0 || listen_port > 65535) {
+					fprintf(stderr, "Errore: porta non valida %d (range 1-65535)\n", listen_port);
+					return 1;
+				}
+				break;
+			case 'u':
+				upstream = value;
+				break;
+			case 'L':
+				config.loss_percent = atof(value);
+				break;
+			case 'd':
+				config.delay_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'j':
+				config.jitter_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'o':
+				config.reorder_percent = atof(value);
+				break;
+			case 'D':
+				config.duplicate_percent = atof(value);
+				break;
+			case 'r':
+				config.rate_kbps = (uint32_t)atoi(value);
+				break;
+			case 'Q':
+				config.queue_us = (uint32_t)(atof(value) * 1000.0);
+				break;
+			case 'S':
+				seed = strtoull(value, NULL, 10);
+				break;
+		}
+	}
+
+	if (config.loss_percent < 0.0 || config.loss_percent > 100.0 ||
+	    config.reorder_percent < 0.0 || config.reorder_percent > 100.0 ||
+	    config.duplicate_percent < 0.0 || config.duplicate_percent > 100.0) {
+		fprintf(stderr, "Errore: le percentuali devono essere comprese tra 0 e 100\n");
+		return 1;
+	}
+
+#if defined WIN32
+	WSADATA wsa_data;
+	if (WSAStartup(MAKEWORD(2,2), &wsa_data) != 0) {
+		printf("Error at WSAStartup()\n");
+		return 0;
+	}
+#endif
+
+	struct sockaddr_in upstream_addr;
+	if (resolve_endpoint(upstream, UPSTREAM_PORT, &upstream_addr) != 0) {
+		clearwinsock();
+		return 1;
+	}
+
+	// Una direzione per verso, con semi distinti ma derivati dallo stesso
+	impaired_link_t to_server;
+	impaired_link_t to_client;
+	if (impaired_link_init(&to_server, &config, (uint64_t)seed * 2u + 1u) != 0 ||
+	    impaired_link_init(&to_client, &config, (uint64_t)seed * 2u + 2u) != 0) {
+		fprintf(stderr, "Errore: memoria insufficiente per le code del proxy.\n");
+		clearwinsock();
+		return 1;
+	}
+
+	// CREAZIONE SOCKET VERSO I CLIENT
+	int listen_sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (listen_sock < 0) {
+		fprintf(stderr, "Errore: creazione socket fallita.\n");
+		clearwinsock();
+		return 1;
+	}
+
+	struct sockaddr_in listen_addr;
+	memset(&listen_addr, 0, sizeof(listen_addr));
+	listen_addr.sin_family = AF_INET;
+	listen_addr.sin_port = htons((unsigned short)listen_port);
+	listen_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	if (bind(listen_sock, (struct sockaddr *)&listen_addr, sizeof(listen_addr)) < 0) {
+		fprintf(stderr, "Errore: bind() sulla porta %d fallito.\n", listen_port);
+		closesocket(listen_sock);
+		clearwinsock();
+		return 1;
+	}
+
+	signal(SIGINT, handle_termination);
+	signal(SIGTERM, handle_termination);
+
+	printf("Proxy UDP sulla porta %d verso %s:%d (perdita %.2f%%, ritardo %.1f ms, jitter %.1f ms, "
+	       "riordino %.2f%%, duplicazione %.2f%%, banda %u kbps, seme %llu)\n",
+	       listen_port, inet_ntoa(upstream_addr.sin_addr), ntohs(upstream_addr.sin_port),
+	       config.loss_percent, config.delay_us / 1000.0, config.jitter_us / 1000.0,
+	       config.reorder_percent, config.duplicate_percent, config.rate_kbps, seed);
+	fflush(stdout);
+
+	uint8_t buffer[IMPAIR_MAX_DATAGRAM];
+	uint64_t next_expiry_us = get_monotonic_us() + (uint64_t)SESSION_IDLE_MS * 1000u;
+
+	// LOOP PRINCIPALE
+	while (proxy_running) {
+		uint64_t now_us = get_monotonic_us();
+
+		// CONSEGNA DEI DATAGRAMMI SCADUTI
+		impaired_datagram_t *datagram;
+		while ((datagram = impaired_link_pop_ready(&to_server, now_us)) != NULL) {
+			proxy_session_t *session = &sessions[datagram->session];
+			if (session->in_use) {
+				sendto(session->upstream_sock, (const char *)datagram->data, datagram->length, 0,
+				       (struct sockaddr *)&upstream_addr, sizeof(upstream_addr));
+			}
+			impaired_link_release(&to_server, datagram);
+		}
+		while ((datagram = impaired_link_pop_ready(&to_client, now_us)) != NULL) {
+			proxy_session_t *session = &sessions[datagram->session];
+			if (session->in_use) {
+				sendto(listen_sock, (const char *)datagram->data, datagram->length, 0,
+				       (struct sockaddr *)&session->client_addr, sizeof(session->client_addr));
+			}
+			impaired_link_release(&to_client, datagram);
+		}
+
+		if (now_us >= next_expiry_us) {
+			expire_sessions(now_us);
+			next_expiry_us = now_us + (uint64_t)SESSION_IDLE_MS * 1000u;
+		}
+
+		// ATTESA: fino alla prossima consegna o al prossimo datagramma
+		int64_t wait_us = (int64_t)(next_expiry_us - now_us);
+		int64_t pending = impaired_link_next_timeout_us(&to_server, now_us);
+		if (pending >= 0 && pending < wait_us) {
+			wait_us = pending;
+		}
+		pending = impaired_link_next_timeout_us(&to_client, now_us);
+		if (pending >= 0 && pending < wait_us) {
+			wait_us = pending;
+		}
+
+		fd_set read_set;
+		FD_ZERO(&read_set);
+		FD_SET(listen_sock, &read_set);
+		int max_fd = listen_sock;
+		for (int i = 0; i < MAX_SESSIONS; i++) {
+			if (sessions[i].in_use) {
+				FD_SET(sessions[i].upstream_sock, &read_set);
+				if (sessions[i].upstream_sock > max_fd) {
+					max_fd = sessions[i].upstream_sock;
+				}
+			}
+		}
+
+		struct timeval timeout;
+		timeout.tv_sec = (long)(wait_us / 1000000);
+		timeout.tv_usec = (long)(wait_us % 1000000);
+
+		int ready = select(max_fd + 1, &read_set, NULL, NULL, &timeout);
+		if (ready <= 0) {
+			continue; // Scadenza, oppure interruzione da segnale
+		}
+		now_us = get_monotonic_us();
+
+		// DATAGRAMMI DAI CLIENT
+		if (FD_ISSET(listen_sock, &read_set)) {
+			struct sockaddr_in client_addr;
+			socklen_t client_len = sizeof(client_addr);
+			int bytes = recvfrom(listen_sock, (char *)buffer, sizeof(buffer), 0,
+			                     (struct sockaddr *)&client_addr, &client_len);
+			if (bytes > 0) {
+				int session = find_or_create_session(&client_addr, now_us);
+				if (session < 0) {
+					fprintf(stderr, "Errore: troppe sessioni, datagramma scartato.\n");
+				} else {
+					impaired_link_submit(&to_server, session, buffer, (size_t)bytes, now_us);
+				}
+			}
+		}
+
+		// RISPOSTE DEL SERVER
+		for (int i = 0; i < MAX_SESSIONS; i++) {
+			if (!sessions[i].in_use || !FD_ISSET(sessions[i].upstream_sock, &read_set)) {
+				continue;
+			}
+			int bytes = recvfrom(sessions[i].upstream_sock, (char *)buffer, sizeof(buffer), 0, NULL, NULL);
+			if (bytes > 0) {
+				sessions[i].last_active_us = now_us;
+				impaired_link_submit(&to_client, i, buffer, (size_t)bytes, now_us);
+			}
+		}
+	}
+
+	// STATISTICHE FINALI
+	print_link_stats("Client -> server", &to_server);
+	print_link_stats("Server -> client", &to_client);
+
+	for (int i = 0; i < MAX_SESSIONS; i++) {
+		if (sessions[i].in_use) {
+			closesocket(sessions[i].upstream_sock);
+		}
+	}
+	impaired_link_free(&to_server);
+	impaired_link_free(&to_client);
+	closesocket(listen_sock);
+	printf("Proxy terminated.\n");
+	clearwinsock();
+	return 0;
+}
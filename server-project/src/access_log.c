@@ -0,0 +1,238 @@
+/*
+ * access_log.c
+ *
+ * Log binario degli accessi su segmenti mappati in memoria
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "access_log.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+typedef char access_record_size_check[sizeof(access_record_t) == 96 ? 1 : -1];
+typedef char access_header_size_check[sizeof(access_log_header_t) == ACCESS_LOG_HEADER_SIZE ? 1 : -1];
+
+static uint64_t realtime_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Tocca le pagine di [from, to): i page fault avvengono qui e non sul percorso caldo
+ * Riscrive lo stesso byte, così la pagina diventa scrivibile senza perdere dati
+ */
+static size_t prefault(access_segment_t *segment, size_t from, size_t to) {
+	if (to > segment->size) {
+		to = segment->size;
+	}
+	long page = sysconf(_SC_PAGESIZE);
+	for (size_t offset = from - from % (size_t)page; offset < to; offset += (size_t)page) {
+		volatile uint8_t *byte = segment->base + offset;
+		*byte = *byte;
+	}
+	return to;
+}
+
+/*
+ * Crea un nuovo file segmento (O_EXCL: salta i numeri già usati),
+ * pre-alloca i blocchi su disco e lo mappa
+ */
+static int segment_create(access_log_t *log, access_segment_t *segment) {
+	memset(segment, 0, sizeof(*segment));
+	segment->fd = -1;
+	segment->size = ACCESS_LOG_HEADER_SIZE + (size_t)log->capacity * sizeof(access_record_t);
+
+	char path[ACCESS_LOG_PATH_SIZE + 16];
+	int fd = -1;
+	while (fd < 0) {
+		snprintf(path, sizeof(path), "%s.%06u.wlog", log->prefix, log->next_number);
+		fd = open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd < 0 && errno != EEXIST) {
+			fprintf(stderr, "Errore: impossibile creare il segmento di log '%s'.\n", path);
+			return -1;
+		}
+		if (fd < 0) {
+			log->next_number++;
+		}
+	}
+
+	// Blocchi riservati subito: niente SIGBUS per disco pieno durante le scritture
+	int rc = posix_fallocate(fd, 0, (off_t)segment->size);
+	if (rc != 0) {
+		fprintf(stderr, "Errore: pre-allocazione del segmento '%s' fallita (%s).\n", path, strerror(rc));
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	void *mem = mmap(NULL, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mem == MAP_FAILED) {
+		fprintf(stderr, "Errore: mmap del segmento '%s' fallita.\n", path);
+		close(fd);
+		unlink(path);
+		return -1;
+	}
+
+	segment->fd = fd;
+	segment->base = (uint8_t *)mem;
+	segment->number = log->next_number++;
+	segment->header = (access_log_header_t *)mem;
+	segment->records = (access_record_t *)(segment->base + ACCESS_LOG_HEADER_SIZE);
+
+	access_log_header_t *header = segment->header;
+	header->magic = ACCESS_LOG_MAGIC;
+	header->version = ACCESS_LOG_VERSION;
+	header->record_size = (uint16_t)sizeof(access_record_t);
+	header->capacity = log->capacity;
+	header->segment = segment->number;
+	header->created_ns = realtime_ns();
+	header->count = 0;
+
+	prefault(segment, 0, ACCESS_LOG_PREFAULT_BYTES);
+	log->segments_created++;
+	return 0;
+}
+
+/* Chiude un segmento; truncate > 0 riduce il file ai record scritti, < 0 lo rimuove */
+static void segment_close(access_log_t *log, access_segment_t *segment, int truncate) {
+	if (!segment->base) {
+		return;
+	}
+
+	size_t used = ACCESS_LOG_HEADER_SIZE + (size_t)segment->header->count * sizeof(access_record_t);
+	munmap(segment->base, segment->size);
+	if (truncate > 0 && used < segment->size) {
+		if (ftruncate(segment->fd, (off_t)used) < 0) {
+			fprintf(stderr, "Errore: troncamento del segmento %u fallito.\n", segment->number);
+		}
+	}
+	close(segment->fd);
+
+	if (truncate < 0) {
+		char path[ACCESS_LOG_PATH_SIZE + 16];
+		snprintf(path, sizeof(path), "%s.%06u.wlog", log->prefix, segment->number);
+		unlink(path);
+	}
+
+	memset(segment, 0, sizeof(*segment));
+	segment->fd = -1;
+}
+
+int access_log_open(access_log_t *log, const char *prefix, uint32_t records_per_segment) {
+	if (!log || !prefix) {
+		return -1;
+	}
+
+	memset(log, 0, sizeof(*log));
+	log->current.fd = -1;
+	log->next.fd = -1;
+	log->retired.fd = -1;
+	if (strlen(prefix) >= sizeof(log->prefix)) {
+		fprintf(stderr, "Errore: prefisso del log troppo lungo.\n");
+		return -1;
+	}
+	strcpy(log->prefix, prefix);
+	log->capacity = records_per_segment < ACCESS_LOG_MIN_RECORDS ? ACCESS_LOG_MIN_RECORDS : records_per_segment;
+
+	if (segment_create(log, &log->current) != 0) {
+		return -1;
+	}
+	log->prefaulted = ACCESS_LOG_PREFAULT_BYTES;
+	if (segment_create(log, &log->next) != 0) {
+		segment_close(log, &log->current, -1);
+		return -1;
+	}
+
+	log->enabled = 1;
+	return 0;
+}
+
+void access_log_append(access_log_t *log, const access_record_t *record) {
+	if (!log->enabled) {
+		return;
+	}
+
+	// ROTAZIONE: scambio di puntatori, il segmento pieno si chiude in access_log_maintain()
+	if (log->cursor == log->capacity) {
+		if (!log->next.base || log->retired.base) {
+			log->dropped++;
+			return;
+		}
+		log->retired = log->current;
+		log->current = log->next;
+		log->next.base = NULL;
+		log->cursor = 0;
+		log->prefaulted = ACCESS_LOG_PREFAULT_BYTES;
+	}
+
+	access_record_t *slot = &log->current.records[log->cursor];
+	memcpy(slot, record, sizeof(*slot));
+	slot->timestamp_ns = realtime_ns() - record->service_ns; // Istante di ricezione (vDSO, nessuna syscall)
+	slot->sequence = log->cursor;
+	log->cursor++;
+	log->current.header->count = log->cursor;
+	log->written++;
+}
+
+void access_log_maintain(access_log_t *log) {
+	if (!log || !log->enabled) {
+		return;
+	}
+
+	if (log->retired.base) {
+		segment_close(log, &log->retired, 0);
+	}
+	if (!log->next.base && segment_create(log, &log->next) != 0) {
+		log->next.base = NULL; // Nuovo tentativo al prossimo giro; intanto i record in eccesso sono scartati
+	}
+
+	// Pagine pronte per i prossimi ACCESS_LOG_PREFAULT_BYTES di record
+	size_t cursor_offset = ACCESS_LOG_HEADER_SIZE + (size_t)log->cursor * sizeof(access_record_t);
+	if (log->prefaulted < cursor_offset + ACCESS_LOG_PREFAULT_BYTES) {
+		log->prefaulted = prefault(&log->current, log->prefaulted, cursor_offset + ACCESS_LOG_PREFAULT_BYTES);
+	}
+}
+
+void access_log_close(access_log_t *log) {
+	if (!log || !log->enabled) {
+		return;
+	}
+	segment_close(log, &log->retired, 0);
+	segment_close(log, &log->current, 1);
+	segment_close(log, &log->next, -1);
+	log->enabled = 0;
+}
+
+#else /* !__linux__ */
+
+int access_log_open(access_log_t *log, const char *prefix, uint32_t records_per_segment) {
+	(void)prefix; (void)records_per_segment;
+	if (log) {
+		memset(log, 0, sizeof(*log));
+	}
+	fprintf(stderr, "Errore: log binario degli accessi disponibile solo su Linux.\n");
+	return -1;
+}
+
+void access_log_append(access_log_t *log, const access_record_t *record) {
+	(void)log; (void)record;
+}
+
+void access_log_maintain(access_log_t *log) {
+	(void)log;
+}
+
+void access_log_close(access_log_t *log) {
+	(void)log;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,143 @@
+/*
+ * access_log.h
+ *
+ * Log binario degli accessi per l'analisi offline
+ * Ogni richiesta servita produce un record a dimensione fissa, copiato in
+ * un file segmento mappato in memoria e pre-allocato: sul percorso delle
+ * richieste scrivere un record è una memcpy, senza syscall né formattazione.
+ * Il lavoro che richiede syscall (creare e mappare il segmento successivo,
+ * pre-caricare le pagine davanti al cursore, chiudere il segmento pieno)
+ * avviene in access_log_maintain(), chiamata dal loop principale.
+ *
+ * File: <prefisso>.<sequenza a 6 cifre>.wlog
+ *   intestazione (ACCESS_LOG_HEADER_SIZE byte) + capacity record
+ * I valori sono nel byte order dell'host (il lettore gira sulla stessa
+ * architettura); client_ip e client_port restano in network byte order.
+ * Lettura: bench/access_log_reader.c (CSV e statistiche).
+ *
+ * Disponibile solo su Linux.
+ */
+
+#ifndef ACCESS_LOG_H_
+#define ACCESS_LOG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define ACCESS_LOG_MAGIC 0x574C4731u              // "WLG1"
+#define ACCESS_LOG_VERSION 1
+#define ACCESS_LOG_HEADER_SIZE 64
+#define ACCESS_LOG_DEFAULT_RECORDS 1048576        // Record per segmento (96 MiB)
+#define ACCESS_LOG_MIN_RECORDS 1024
+#define ACCESS_LOG_PREFAULT_BYTES (1u << 20)      // Pagine già toccate davanti al cursore
+#define ACCESS_LOG_PATH_SIZE 256
+
+/* Tipo di accesso registrato */
+#define ACCESS_KIND_REQUEST 0       // Richiesta meteo via UDP
+#define ACCESS_KIND_SHM 1           // Richiesta meteo in memoria condivisa
+#define ACCESS_KIND_SUBSCRIBE 2     // Sottoscrizione (value = lease in secondi)
+#define ACCESS_KIND_AGGREGATE 3     // Query aggregata (value = media)
+#define ACCESS_KIND_NEAREST 4       // Ricerca per coordinate (city = città trovata)
+#define ACCESS_KIND_COUNT 5
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/* Record del log: 96 byte, allineati a 8 */
+typedef struct {
+	uint64_t timestamp_ns;          // CLOCK_REALTIME alla ricezione (scritto da access_log_append)
+	uint32_t service_ns;            // Dalla ricezione all'invio della risposta
+	uint32_t client_ip;             // IPv4 in network byte order (0 per la memoria condivisa)
+	uint16_t client_port;           // Network byte order
+	uint8_t kind;                   // ACCESS_KIND_*
+	uint8_t status;                 // STATUS_* della risposta
+	char type;                      // Tipo meteo richiesto
+	uint8_t reserved[3];
+	float value;                    // Valore inviato (0 se errore)
+	uint32_t sequence;              // Numero progressivo del record nel segmento
+	char city[64];                  // Città richiesta (null-terminated)
+} access_record_t;
+
+/* Intestazione di un segmento (ACCESS_LOG_HEADER_SIZE byte) */
+typedef struct {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t capacity;              // Record nel segmento
+	uint32_t segment;               // Numero di sequenza del segmento
+	uint64_t created_ns;            // CLOCK_REALTIME all'apertura
+	uint64_t count;                 // Record scritti (aggiornato a ogni record)
+	uint8_t reserved[32];
+} access_log_header_t;
+
+/* Segmento mappato */
+typedef struct {
+	int fd;
+	uint8_t *base;
+	size_t size;
+	uint32_t number;
+	access_log_header_t *header;
+	access_record_t *records;
+} access_segment_t;
+
+typedef struct {
+	int enabled;
+	char prefix[ACCESS_LOG_PATH_SIZE];
+	uint32_t capacity;              // Record per segmento
+	uint32_t next_number;           // Sequenza del prossimo file da creare
+
+	access_segment_t current;       // Segmento in scrittura
+	access_segment_t next;          // Pronto per la rotazione (base NULL se non ancora creato)
+	access_segment_t retired;       // Pieno, da chiudere in access_log_maintain()
+	uint32_t cursor;                // Prossimo record del segmento corrente
+	size_t prefaulted;              // Byte del segmento corrente già toccati
+
+	// Statistiche
+	uint64_t written;
+	uint64_t dropped;               // Segmento pieno e successivo non ancora pronto
+	uint32_t segments_created;
+} access_log_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Apre il log: crea il primo segmento e prepara il successivo
+ * I file esistenti con lo stesso prefisso non vengono sovrascritti
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int access_log_open(access_log_t *log, const char *prefix, uint32_t records_per_segment);
+
+/*
+ * Copia un record nel segmento corrente (percorso caldo: nessuna syscall)
+ * timestamp_ns e sequence sono calcolati qui, service_ns va già impostato
+ * Se il segmento è pieno passa al successivo già pronto; se non c'è, il
+ * record è scartato e contato in dropped
+ */
+void access_log_append(access_log_t *log, const access_record_t *record);
+
+/*
+ * Lavoro fuori dal percorso caldo: chiude il segmento pieno, crea il
+ * successivo e pre-carica le pagine davanti al cursore
+ */
+void access_log_maintain(access_log_t *log);
+
+/*
+ * Chiude il log: il segmento corrente è troncato ai record scritti e
+ * quello preparato in anticipo viene rimosso
+ */
+void access_log_close(access_log_t *log);
+
+#endif /* ACCESS_LOG_H_ */
@@ -0,0 +1,83 @@
+/*
+ * capture.c
+ *
+ * Cattura dei datagrammi ricevuti per il replay
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "capture.h"
+
+int capture_open(capture_writer_t *writer, const char *path) {
+	if (!writer || !path) {
+		return -1;
+	}
+
+	memset(writer, 0, sizeof(*writer));
+	writer->file = fopen(path, "wb");
+	if (!writer->file) {
+		fprintf(stderr, "Errore: impossibile creare il file di cattura '%s'.\n", path);
+		return -1;
+	}
+
+	// Buffer grande: le scritture vere avvengono ogni CAPTURE_BUFFER_SIZE byte
+	writer->buffer = (char *)malloc(CAPTURE_BUFFER_SIZE);
+	if (writer->buffer) {
+		setvbuf(writer->file, writer->buffer, _IOFBF, CAPTURE_BUFFER_SIZE);
+	}
+
+	capture_file_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CAPTURE_MAGIC;
+	header.version = CAPTURE_VERSION;
+	header.record_size = (uint16_t)sizeof(capture_record_t);
+	header.start_time = (uint64_t)time(NULL);
+	if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+		fprintf(stderr, "Errore: scrittura del file di cattura '%s' fallita.\n", path);
+		capture_close(writer);
+		return -1;
+	}
+	return 0;
+}
+
+void capture_write(capture_writer_t *writer, uint64_t receive_ns, uint32_t addr, uint16_t port,
+                   const uint8_t *data, int length) {
+	if (!writer->file || length < 0) {
+		return;
+	}
+
+	if (writer->datagrams == 0) {
+		writer->first_ns = receive_ns;
+	}
+
+	// Con le corsie o più socket un datagramma può essere servito dopo uno
+	// arrivato più tardi: mai prima dell'inizio della cattura
+	capture_record_t record;
+	record.time_ns = receive_ns > writer->first_ns ? receive_ns - writer->first_ns : 0;
+	record.addr = addr;
+	record.port = port;
+	record.length = (uint16_t)length;
+
+	if (fwrite(&record, sizeof(record), 1, writer->file) != 1 ||
+	    fwrite(data, 1, (size_t)length, writer->file) != (size_t)length) {
+		fprintf(stderr, "Errore: scrittura del file di cattura fallita, cattura interrotta.\n");
+		fclose(writer->file);
+		writer->file = NULL;
+		return;
+	}
+	writer->datagrams++;
+	writer->bytes += sizeof(record) + (uint64_t)length;
+}
+
+void capture_close(capture_writer_t *writer) {
+	if (!writer) {
+		return;
+	}
+	if (writer->file) {
+		fclose(writer->file);
+		writer->file = NULL;
+	}
+	free(writer->buffer);
+	writer->buffer = NULL;
+}
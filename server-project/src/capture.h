@@ -0,0 +1,48 @@
+/*
+ * capture.h
+ *
+ * Cattura dei datagrammi ricevuti per il replay (formato in protocol.h)
+ * Ogni datagramma è scritto con l'istante di arrivo e il mittente in un
+ * buffer di stdio grande: sul percorso delle richieste una scrittura è
+ * quasi sempre una copia in memoria.
+ * Usato dal loop del server (opzione -w) e dalla presa passiva
+ * bench/capture_tap.c.
+ */
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include "protocol.h"
+
+#define CAPTURE_BUFFER_SIZE (1 << 20)   // Buffer di scrittura del file
+
+typedef struct {
+	FILE *file;                     // NULL se la cattura non è attiva
+	char *buffer;
+	uint64_t first_ns;              // Arrivo del primo datagramma (0 = nessuno)
+	uint64_t datagrams;
+	uint64_t bytes;
+} capture_writer_t;
+
+/*
+ * Crea il file di cattura e scrive l'intestazione
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int capture_open(capture_writer_t *writer, const char *path);
+
+/*
+ * Accoda un datagramma; receive_ns è un istante monotono qualsiasi,
+ * nel file finisce la distanza dal primo datagramma
+ * In caso di errore di scrittura la cattura si interrompe (una sola stampa)
+ */
+void capture_write(capture_writer_t *writer, uint64_t receive_ns, uint32_t addr, uint16_t port,
+                   const uint8_t *data, int length);
+
+/*
+ * Svuota il buffer e chiude il file
+ */
+void capture_close(capture_writer_t *writer);
+
+#endif /* CAPTURE_H_ */
@@ -0,0 +1,221 @@
+/*
+ * catalogue.c
+ *
+ * Catalogo delle città: nome e coordinate
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "catalogue.h"
+
+/* FNV-1a sul nome in minuscolo */
+static uint32_t hash_name(const char *name) {
+	uint32_t hash = 2166136261u;
+	while (*name) {
+		hash ^= (uint8_t)tolower((unsigned char)*name);
+		hash *= 16777619u;
+		name++;
+	}
+	return hash;
+}
+
+static int names_equal(const char *a, const char *b) {
+	while (*a && *b) {
+		if (tolower((unsigned char)*a) != tolower((unsigned char)*b)) {
+			return 0;
+		}
+		a++;
+		b++;
+	}
+	return *a == '\0' && *b == '\0';
+}
+
+/* Stesse regole di validate_request_server: lettere, cifre e spazi */
+static int valid_name(const char *name) {
+	size_t length = strlen(name);
+	if (length == 0 || length >= CATALOGUE_NAME_SIZE) {
+		return 0;
+	}
+	for (size_t i = 0; i < length; i++) {
+		unsigned char c = (unsigned char)name[i];
+		if (!isalnum(c) && c != ' ') {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Ricostruisce la tabella hash con almeno il doppio degli slot delle città */
+static int rebuild_slots(city_catalogue_t *catalogue, int32_t min_cities) {
+	uint32_t size = 16;
+	while (size < (uint32_t)min_cities * 2u) {
+		size <<= 1;
+	}
+
+	int32_t *slots = (int32_t *)malloc(size * sizeof(int32_t));
+	if (!slots) {
+		return -1;
+	}
+	memset(slots, 0xFF, size * sizeof(int32_t)); // Tutti -1
+
+	for (int32_t i = 0; i < catalogue->count; i++) {
+		uint32_t pos = hash_name(catalogue->names[i]) & (size - 1);
+		while (slots[pos] >= 0) {
+			pos = (pos + 1) & (size - 1);
+		}
+		slots[pos] = i;
+	}
+
+	free(catalogue->slots);
+	catalogue->slots = slots;
+	catalogue->slot_mask = size - 1;
+	return 0;
+}
+
+static int grow(city_catalogue_t *catalogue) {
+	int32_t capacity = catalogue->capacity ? catalogue->capacity * 2 : 64;
+	if (capacity > CATALOGUE_MAX_CITIES) {
+		return -1;
+	}
+
+	void *names = realloc(catalogue->names, (size_t)capacity * CATALOGUE_NAME_SIZE);
+	if (!names) {
+		return -1;
+	}
+	catalogue->names = (char (*)[CATALOGUE_NAME_SIZE])names;
+
+	float *latitude = (float *)realloc(catalogue->latitude, (size_t)capacity * sizeof(float));
+	if (!latitude) {
+		return -1;
+	}
+	catalogue->latitude = latitude;
+
+	float *longitude = (float *)realloc(catalogue->longitude, (size_t)capacity * sizeof(float));
+	if (!longitude) {
+		return -1;
+	}
+	catalogue->longitude = longitude;
+
+	catalogue->capacity = capacity;
+	return rebuild_slots(catalogue, capacity);
+}
+
+int catalogue_init(city_catalogue_t *catalogue, const city_entry_t *entries, int count) {
+	if (!catalogue) {
+		return -1;
+	}
+
+	memset(catalogue, 0, sizeof(*catalogue));
+	for (int i = 0; i < count; i++) {
+		if (catalogue_add(catalogue, entries[i].name, entries[i].latitude, entries[i].longitude) < 0) {
+			catalogue_free(catalogue);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void catalogue_free(city_catalogue_t *catalogue) {
+	if (!catalogue) {
+		return;
+	}
+	free(catalogue->names);
+	free(catalogue->latitude);
+	free(catalogue->longitude);
+	free(catalogue->slots);
+	memset(catalogue, 0, sizeof(*catalogue));
+}
+
+int32_t catalogue_find(const city_catalogue_t *catalogue, const char *name) {
+	if (!catalogue || !catalogue->slots || !name) {
+		return -1;
+	}
+
+	uint32_t pos = hash_name(name) & catalogue->slot_mask;
+	while (catalogue->slots[pos] >= 0) {
+		int32_t index = catalogue->slots[pos];
+		if (names_equal(catalogue->names[index], name)) {
+			return index;
+		}
+		pos = (pos + 1) & catalogue->slot_mask;
+	}
+	return -1;
+}
+
+int32_t catalogue_add(city_catalogue_t *catalogue, const char *name, float latitude, float longitude) {
+	if (!catalogue || !name || !valid_name(name) ||
+	    latitude < -90.0f || latitude > 90.0f || longitude < -180.0f || longitude > 180.0f) {
+		return -1;
+	}
+
+	int32_t existing = catalogue_find(catalogue, name);
+	if (existing >= 0) {
+		return existing;
+	}
+
+	if (catalogue->count == catalogue->capacity && grow(catalogue) != 0) {
+		return -1;
+	}
+
+	int32_t index = catalogue->count++;
+	strncpy(catalogue->names[index], name, CATALOGUE_NAME_SIZE - 1);
+	catalogue->names[index][CATALOGUE_NAME_SIZE - 1] = '\0';
+	catalogue->latitude[index] = latitude;
+	catalogue->longitude[index] = longitude;
+
+	uint32_t pos = hash_name(name) & catalogue->slot_mask;
+	while (catalogue->slots[pos] >= 0) {
+		pos = (pos + 1) & catalogue->slot_mask;
+	}
+	catalogue->slots[pos] = index;
+	return index;
+}
+
+int catalogue_load_file(city_catalogue_t *catalogue, const char *path) {
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "Errore: impossibile aprire il catalogo '%s'.\n", path);
+		return -1;
+	}
+
+	char line[256];
+	int added = 0;
+	int skipped = 0;
+	int before = catalogue->count;
+
+	while (fgets(line, sizeof(line), file)) {
+		line[strcspn(line, "\r\n")] = '\0';
+		if (line[0] == '\0' || line[0] == '#') {
+			continue;
+		}
+
+		// nome,latitudine,longitudine (separazione manuale sulle virgole)
+		char *first = strchr(line, ',');
+		char *second = first ? strchr(first + 1, ',') : NULL;
+		if (!second) {
+			skipped++;
+			continue;
+		}
+		*first = '\0';
+		*second = '\0';
+
+		char *end_lat;
+		char *end_lon;
+		float latitude = strtof(first + 1, &end_lat);
+		float longitude = strtof(second + 1, &end_lon);
+		if (end_lat == first + 1 || end_lon == second + 1 ||
+		    catalogue_add(catalogue, line, latitude, longitude) < 0) {
+			skipped++;
+			continue;
+		}
+	}
+	fclose(file);
+
+	added = catalogue->count - before;
+	if (skipped > 0) {
+		fprintf(stderr, "Catalogo '%s': %d righe non valide ignorate\n", path, skipped);
+	}
+	return added;
+}
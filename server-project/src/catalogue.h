@@ -0,0 +1,68 @@
+/*
+ * catalogue.h
+ *
+ * Catalogo delle città: nome e coordinate
+ * Le città supportate sono sempre presenti (indici 0..N-1); un file CSV
+ * può aggiungerne altre. La ricerca per nome usa una tabella hash
+ * case-insensitive, così resta O(1) anche con centinaia di migliaia di città.
+ */
+
+#ifndef CATALOGUE_H_
+#define CATALOGUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define CATALOGUE_NAME_SIZE 64          // Come il campo city delle richieste
+#define CATALOGUE_MAX_CITIES 16777216
+
+/* Voce statica (città supportate compilate nel server) */
+typedef struct {
+	const char *name;
+	float latitude;
+	float longitude;
+} city_entry_t;
+
+typedef struct {
+	int32_t count;
+	int32_t capacity;
+
+	// Structure-of-arrays indicizzati per città
+	char (*names)[CATALOGUE_NAME_SIZE];
+	float *latitude;
+	float *longitude;
+
+	// Tabella hash a indirizzamento aperto: indice città oppure -1
+	int32_t *slots;
+	uint32_t slot_mask;
+} city_catalogue_t;
+
+/*
+ * Crea il catalogo con le città statiche indicate
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int catalogue_init(city_catalogue_t *catalogue, const city_entry_t *entries, int count);
+
+/*
+ * Libera la memoria del catalogo
+ */
+void catalogue_free(city_catalogue_t *catalogue);
+
+/*
+ * Aggiunge una città; i duplicati (stesso nome, case-insensitive) sono ignorati
+ * Ritorna l'indice della città (nuova o esistente), -1 se il nome non è valido
+ */
+int32_t catalogue_add(city_catalogue_t *catalogue, const char *name, float latitude, float longitude);
+
+/*
+ * Carica righe "nome,latitudine,longitudine" (righe vuote e '#' ignorate)
+ * Ritorna il numero di città aggiunte oppure -1 se il file non è leggibile
+ */
+int catalogue_load_file(city_catalogue_t *catalogue, const char *path);
+
+/*
+ * Indice della città con il nome indicato (case-insensitive), -1 se assente
+ */
+int32_t catalogue_find(const city_catalogue_t *catalogue, const char *name);
+
+#endif /* CATALOGUE_H_ */
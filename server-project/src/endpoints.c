@@ -0,0 +1,404 @@
+/*
+ * endpoints.c
+ *
+ * Socket in ascolto del server (IPv4 e IPv6) e lettura a lotti
+ */
+
+#if defined __linux__
+#define _GNU_SOURCE // recvmmsg()
+#endif
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+typedef int socklen_t;
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#define closesocket close
+#endif
+
+#if defined __linux__
+#include <sys/uio.h>
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "endpoints.h"
+
+int endpoint_parse(const char *spec, int default_port, const char *default_ip, endpoint_addr_t *addr,
+                   int *addr_len) {
+	if (!spec || !addr || !addr_len) {
+		return -1;
+	}
+	memset(addr, 0, sizeof(*addr));
+
+	char host[ENDPOINT_NAME_SIZE];
+	const char *port_text = NULL;
+	const char *colon = strrchr(spec, ':');
+
+	// FORMATI: "[ip6]:porta", "ip6", "ip4:porta", "ip4", "porta"
+	if (spec[0] == '[') {
+		const char *close_bracket = strchr(spec, ']');
+		if (!close_bracket || (size_t)(close_bracket - spec - 1) >= sizeof(host)) {
+			return -1;
+		}
+		memcpy(host, spec + 1, (size_t)(close_bracket - spec - 1));
+		host[close_bracket - spec - 1] = '\0';
+		if (close_bracket[1] == ':') {
+			port_text = close_bracket + 2;
+		} else if (close_bracket[1] != '\0') {
+			return -1;
+		}
+	} else if (colon && strchr(spec, ':') != colon) {
+		// Più di un ':' senza parentesi: IPv6 senza porta
+		if (strlen(spec) >= sizeof(host)) {
+			return -1;
+		}
+		strcpy(host, spec);
+	} else if (!strchr(spec, '.') && !colon) {
+		// Solo cifre: è la porta
+		port_text = spec;
+		strncpy(host, default_ip, sizeof(host) - 1);
+		host[sizeof(host) - 1] = '\0';
+	} else {
+		size_t host_len = colon ? (size_t)(colon - spec) : strlen(spec);
+		if (host_len >= sizeof(host)) {
+			return -1;
+		}
+		memcpy(host, spec, host_len);
+		host[host_len] = '\0';
+		port_text = colon ? colon + 1 : NULL;
+	}
+
+	int port = default_port;
+	if (port_text) {
+		char *end;
+		long value = strtol(port_text, &end, 10);
+		if (end == port_text || *end != '\0' || value <= 0 || value > 65535) {
+			return -1;
+		}
+		port = (int)value;
+	}
+
+	// INDIRIZZO NUMERICO
+	if (strchr(host, ':')) {
+#if defined WIN32
+		return -1; // IPv6 non disponibile con winsock.h
+#else
+		addr->v6.sin6_family = AF_INET6;
+		addr->v6.sin6_port = htons((uint16_t)port);
+		if (inet_pton(AF_INET6, host, &addr->v6.sin6_addr) != 1) {
+			return -1;
+		}
+		*addr_len = (int)sizeof(addr->v6);
+		return 0;
+#endif
+	}
+
+	addr->v4.sin_family = AF_INET;
+	addr->v4.sin_port = htons((uint16_t)port);
+	addr->v4.sin_addr.s_addr = inet_addr(host);
+	if (addr->v4.sin_addr.s_addr == INADDR_NONE && strcmp(host, "255.255.255.255") != 0) {
+		return -1;
+	}
+	*addr_len = (int)sizeof(addr->v4);
+	return 0;
+}
+
+void endpoint_format(const endpoint_addr_t *addr, char *out, size_t size) {
+	if (!addr || !out || size == 0) {
+		return;
+	}
+#if !defined WIN32
+	if (addr->sa.sa_family == AF_INET6) {
+		char ip[ENDPOINT_IP_SIZE];
+		inet_ntop(AF_INET6, &addr->v6.sin6_addr, ip, sizeof(ip));
+		snprintf(out, size, "[%s]:%u", ip, (unsigned)ntohs(addr->v6.sin6_port));
+		return;
+	}
+#endif
+	snprintf(out, size, "%s:%u", inet_ntoa(addr->v4.sin_addr), (unsigned)ntohs(addr->v4.sin_port));
+}
+
+int endpoint_open(endpoint_t *endpoint, const endpoint_addr_t *addr, int addr_len, int kind, int rcvbuf) {
+	if (!endpoint || !addr) {
+		return -1;
+	}
+	memset(endpoint, 0, sizeof(*endpoint));
+	endpoint->sock = -1;
+	endpoint->kind = kind;
+	endpoint->addr = *addr;
+	endpoint->addr_len = addr_len;
+	endpoint_format(addr, endpoint->name, sizeof(endpoint->name));
+
+	// CREAZIONE SOCKET: stessa famiglia dell'indirizzo
+	int sock = socket(addr->sa.sa_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		fprintf(stderr, "Errore: creazione socket UDP per %s fallita.\n", endpoint->name);
+		return -1;
+	}
+
+#if !defined WIN32
+	// IPv6 separato da IPv4: ogni famiglia ha il proprio -l
+	if (addr->sa.sa_family == AF_INET6) {
+		int v6only = 1;
+		setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+	}
+#endif
+
+	if (rcvbuf > 0) {
+		setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char *)&rcvbuf, sizeof(rcvbuf));
+	}
+
+	// BIND
+	if (bind(sock, &addr->sa, (socklen_t)addr_len) < 0) {
+		fprintf(stderr, "Errore: bind() su %s fallita.\n", endpoint->name);
+		closesocket(sock);
+		return -1;
+	}
+
+	endpoint->sock = sock;
+	return 0;
+}
+
+int endpoint_adopt(endpoint_t *endpoint, int sock, int kind) {
+	if (!endpoint || sock < 0) {
+		return -1;
+	}
+	memset(endpoint, 0, sizeof(*endpoint));
+	endpoint->sock = -1;
+	endpoint->kind = kind;
+
+	socklen_t addr_len = sizeof(endpoint->addr);
+	if (getsockname(sock, &endpoint->addr.sa, &addr_len) < 0 ||
+	    (endpoint->addr.sa.sa_family != AF_INET && endpoint->addr.sa.sa_family != AF_INET6)) {
+		fprintf(stderr, "Errore: il descrittore %d non è un socket UDP legato.\n", sock);
+		return -1;
+	}
+	endpoint->addr_len = (int)addr_len;
+	endpoint_format(&endpoint->addr, endpoint->name, sizeof(endpoint->name));
+	endpoint->sock = sock;
+	return 0;
+}
+
+#if defined __linux__
+/* Descrittori per recvmmsg(): il lotto è letto da un solo thread */
+static struct mmsghdr batch_msgs[ENDPOINT_BATCH];
+static struct iovec batch_iovs[ENDPOINT_BATCH];
+static union {
+	struct cmsghdr align;
+	uint8_t data[CMSG_SPACE(sizeof(struct timespec))];
+} batch_controls[ENDPOINT_BATCH];
+
+/* Istante SCM_TIMESTAMPNS del messaggio (CLOCK_REALTIME), 0 se assente */
+static uint64_t message_timestamp_ns(struct msghdr *msg) {
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+			struct timespec ts;
+			memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+			return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+		}
+	}
+	return 0;
+}
+#endif
+
+int endpoint_enable_timestamps(endpoint_t *endpoint) {
+	if (!endpoint || endpoint->sock < 0) {
+		return -1;
+	}
+#if defined __linux__
+	int on = 1;
+	if (setsockopt(endpoint->sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+		fprintf(stderr, "Errore: SO_TIMESTAMPNS su %s fallita.\n", endpoint->name);
+		return -1;
+	}
+#endif
+	endpoint->timestamps = 1;
+	return 0;
+}
+
+int endpoint_receive(endpoint_t *endpoint, endpoint_batch_t *batch) {
+	if (!endpoint || !batch || endpoint->sock < 0) {
+		return 0;
+	}
+	batch->count = 0;
+
+#if defined __linux__
+	// LOTTO: una recvmmsg() non bloccante per tutti i datagrammi già arrivati
+	for (int i = 0; i < ENDPOINT_BATCH; i++) {
+		batch_iovs[i].iov_base = batch->data[i];
+		batch_iovs[i].iov_len = BUFFER_SIZE;
+		memset(&batch_msgs[i].msg_hdr, 0, sizeof(batch_msgs[i].msg_hdr));
+		batch_msgs[i].msg_hdr.msg_name = &batch->addr[i];
+		batch_msgs[i].msg_hdr.msg_namelen = sizeof(batch->addr[i]);
+		batch_msgs[i].msg_hdr.msg_iov = &batch_iovs[i];
+		batch_msgs[i].msg_hdr.msg_iovlen = 1;
+		if (endpoint->timestamps) {
+			batch_msgs[i].msg_hdr.msg_control = batch_controls[i].data;
+			batch_msgs[i].msg_hdr.msg_controllen = sizeof(batch_controls[i].data);
+		}
+	}
+	int received = recvmmsg(endpoint->sock, batch_msgs, ENDPOINT_BATCH, MSG_DONTWAIT, NULL);
+	if (received < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			fprintf(stderr, "Errore: recvmmsg() su %s fallita.\n", endpoint->name);
+		}
+		return 0;
+	}
+	for (int i = 0; i < received; i++) {
+		batch->length[i] = (int)batch_msgs[i].msg_len;
+		batch->addr_len[i] = (int)batch_msgs[i].msg_hdr.msg_namelen;
+	}
+	batch->count = received;
+
+	// ISTANTI DI ARRIVO: dal kernel in CLOCK_REALTIME, riportati all'orologio monotono
+	if (endpoint->timestamps && received > 0) {
+		struct timespec realtime;
+		clock_gettime(CLOCK_REALTIME, &realtime);
+		uint64_t now_ns = get_monotonic_ns();
+		uint64_t realtime_ns = (uint64_t)realtime.tv_sec * 1000000000u + (uint64_t)realtime.tv_nsec;
+		for (int i = 0; i < received; i++) {
+			uint64_t arrival_ns = message_timestamp_ns(&batch_msgs[i].msg_hdr);
+			uint64_t age_ns = arrival_ns && arrival_ns < realtime_ns ? realtime_ns - arrival_ns : 0;
+			batch->receive_ns[i] = age_ns < now_ns ? now_ns - age_ns : now_ns;
+		}
+	}
+#else
+	// Un datagramma per risveglio: il socket è pronto, recvfrom() non si blocca
+	socklen_t addr_len = sizeof(batch->addr[0]);
+	int received = recvfrom(endpoint->sock, (char *)batch->data[0], BUFFER_SIZE, 0, &batch->addr[0].sa, &addr_len);
+	if (received < 0) {
+		fprintf(stderr, "Errore: recvfrom() su %s fallita.\n", endpoint->name);
+		return 0;
+	}
+	batch->length[0] = received;
+	batch->addr_len[0] = (int)addr_len;
+	batch->receive_ns[0] = endpoint->timestamps ? get_monotonic_ns() : 0;
+	batch->count = 1;
+#endif
+
+	if (batch->count > 0) {
+		endpoint->received += (uint64_t)batch->count;
+		endpoint->batches++;
+		if ((uint64_t)batch->count > endpoint->batch_max) {
+			endpoint->batch_max = (uint64_t)batch->count;
+		}
+	}
+	return batch->count;
+}
+
+void endpoint_close(endpoint_t *endpoint) {
+	if (!endpoint || endpoint->sock < 0) {
+		return;
+	}
+	closesocket(endpoint->sock);
+	endpoint->sock = -1;
+}
+
+/*
+ * Risoluzione indirizzo client (reverse lookup)
+ */
+static int resolve_client_address(struct in_addr *addr, char *hostname_out,
+                                  size_t hostname_size, char *ip_out, size_t ip_size) {
+	if (!addr || !hostname_out || !ip_out) {
+		return -1;
+	}
+
+	// IP come stringa
+	char *ip_str = inet_ntoa(*addr);
+	strncpy(ip_out, ip_str, ip_size - 1);
+	ip_out[ip_size - 1] = '\0';
+
+	// Reverse lookup: IP -> hostname
+	struct hostent *host = gethostbyaddr((char *)addr, sizeof(struct in_addr), AF_INET);
+
+	if (!host) {
+		// Fallback: usa IP come hostname
+		strncpy(hostname_out, ip_str, hostname_size - 1);
+		hostname_out[hostname_size - 1] = '\0';
+	} else {
+		strncpy(hostname_out, host->h_name, hostname_size - 1);
+		hostname_out[hostname_size - 1] = '\0';
+	}
+
+	return 0;
+}
+
+void endpoint_describe_client(const endpoint_addr_t *addr, char *hostname, size_t hostname_size,
+                              char *ip, size_t ip_size) {
+	if (!addr || !hostname || !ip) {
+		return;
+	}
+#if !defined WIN32
+	if (addr->sa.sa_family == AF_INET6) {
+		inet_ntop(AF_INET6, &addr->v6.sin6_addr, ip, (socklen_t)ip_size);
+		// Reverse lookup: con errore resta l'indirizzo numerico
+		if (getnameinfo(&addr->sa, sizeof(addr->v6), hostname, (socklen_t)hostname_size, NULL, 0, 0) != 0) {
+			strncpy(hostname, ip, hostname_size - 1);
+			hostname[hostname_size - 1] = '\0';
+		}
+		return;
+	}
+#endif
+	struct in_addr client_in = addr->v4.sin_addr;
+	resolve_client_address(&client_in, hostname, hostname_size, ip, ip_size);
+}
+
+uint32_t endpoint_addr_ipv4(const endpoint_addr_t *addr) {
+	if (!addr) {
+		return 0;
+	}
+#if !defined WIN32
+	if (addr->sa.sa_family == AF_INET6) {
+		const uint8_t *bytes = addr->v6.sin6_addr.s6_addr;
+		static const uint8_t mapped_prefix[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+		uint32_t ipv4 = 0;
+		if (memcmp(bytes, mapped_prefix, sizeof(mapped_prefix)) == 0) {
+			memcpy(&ipv4, bytes + 12, sizeof(ipv4));
+		}
+		return ipv4;
+	}
+#endif
+	return (uint32_t)addr->v4.sin_addr.s_addr;
+}
+
+uint32_t endpoint_addr_capture_key(const endpoint_addr_t *addr) {
+	uint32_t ipv4 = endpoint_addr_ipv4(addr);
+#if !defined WIN32
+	if (addr && addr->sa.sa_family == AF_INET6 && ipv4 == 0) {
+		// FNV-1a dei 16 byte, nei 28 bit bassi di 240.0.0.0/4
+		uint32_t hash = 2166136261u;
+		for (int i = 0; i < 16; i++) {
+			hash = (hash ^ addr->v6.sin6_addr.s6_addr[i]) * 16777619u;
+		}
+		return htonl(0xF0000000u | (hash & 0x0FFFFFFFu));
+	}
+#endif
+	return ipv4;
+}
+
+uint16_t endpoint_addr_port(const endpoint_addr_t *addr) {
+	if (!addr) {
+		return 0;
+	}
+	// sin_port e sin6_port sono nella stessa posizione
+	return addr->v4.sin_port;
+}
+
+int endpoint_addr_size(const endpoint_addr_t *addr) {
+#if !defined WIN32
+	if (addr && addr->sa.sa_family == AF_INET6) {
+		return (int)sizeof(addr->v6);
+	}
+#endif
+	return (int)sizeof(struct sockaddr_in);
+}
@@ -0,0 +1,167 @@
+/*
+ * endpoints.h
+ *
+ * Socket UDP in ascolto del server: uno per indirizzo e porta (-l), IPv4 o
+ * IPv6, più la porta di amministrazione (-A). Ogni socket è osservato dal
+ * reactor (reactor.h); quando è pronto viene svuotato a lotti: su Linux una
+ * sola recvmmsg() legge fino a ENDPOINT_BATCH datagrammi, altrove uno per
+ * risveglio.
+ *
+ * Gli indirizzi dei client viaggiano come endpoint_addr_t, abbastanza grande
+ * per entrambe le famiglie e senza il costo di una sockaddr_storage.
+ * IPv6 non è disponibile su Windows (winsock.h).
+ */
+
+#ifndef ENDPOINTS_H_
+#define ENDPOINTS_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define ENDPOINT_MAX 16                 // Socket in ascolto al più (-l ripetuta, più -A)
+#define ENDPOINT_BATCH 32               // Datagrammi letti per socket a ogni risveglio
+#define ENDPOINT_IP_SIZE 46             // INET6_ADDRSTRLEN
+#define ENDPOINT_NAME_SIZE 64           // "[indirizzo]:porta"
+#define ENDPOINT_ADMIN_IP "127.0.0.1"   // Indirizzo di default della porta di amministrazione
+
+#define ENDPOINT_KIND_SERVICE 0         // Protocollo meteo
+#define ENDPOINT_KIND_ADMIN 1           // Comandi testuali (stats, ping)
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/* Indirizzo IPv4 o IPv6 (sa.sa_family decide il membro valido) */
+typedef union {
+	struct sockaddr sa;
+	struct sockaddr_in v4;
+#if !defined WIN32
+	struct sockaddr_in6 v6;
+#endif
+} endpoint_addr_t;
+
+typedef struct {
+	int sock;
+	int kind;                       // ENDPOINT_KIND_*
+	endpoint_addr_t addr;           // Indirizzo locale
+	int addr_len;
+	char name[ENDPOINT_NAME_SIZE];  // Per i messaggi e le statistiche
+	int timestamps;                 // Istante di arrivo dal kernel (endpoint_enable_timestamps)
+
+	// Statistiche
+	uint64_t received;              // Datagrammi letti
+	uint64_t batches;               // Risvegli con almeno un datagramma
+	uint64_t batch_max;             // Lotto più grande letto in un risveglio
+} endpoint_t;
+
+/* Lotto di datagrammi letti da un socket */
+typedef struct {
+	uint8_t data[ENDPOINT_BATCH][BUFFER_SIZE];
+	endpoint_addr_t addr[ENDPOINT_BATCH];
+	int addr_len[ENDPOINT_BATCH];
+	int length[ENDPOINT_BATCH];
+	uint64_t receive_ns[ENDPOINT_BATCH]; // Arrivo (orologio monotono), solo con i timestamp attivi
+	int count;
+} endpoint_batch_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Interpreta "indirizzo[:porta]": IPv4 ("0.0.0.0:56700"), IPv6 tra parentesi
+ * quadre ("[::1]:56700") o senza porta ("::"), oppure solo la porta ("56700",
+ * con default_ip). Solo indirizzi numerici.
+ * Ritorna 0 in caso di successo, -1 se la specifica non è valida
+ */
+int endpoint_parse(const char *spec, int default_port, const char *default_ip, endpoint_addr_t *addr,
+                   int *addr_len);
+
+/*
+ * Crea il socket e lo lega all'indirizzo; rcvbuf in byte (0 = default del sistema)
+ * I socket IPv6 accettano solo IPv6 (IPV6_V6ONLY): per IPv4 serve un altro -l
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int endpoint_open(endpoint_t *endpoint, const endpoint_addr_t *addr, int addr_len, int kind, int rcvbuf);
+
+/*
+ * Adotta un socket già legato (ereditato con il passaggio di consegne, handoff.h):
+ * l'indirizzo è letto con getsockname()
+ * Ritorna 0 in caso di successo, -1 se il descrittore non è un socket legato
+ */
+int endpoint_adopt(endpoint_t *endpoint, int sock, int kind);
+
+/*
+ * Chiede al kernel l'istante di arrivo di ogni datagramma (SO_TIMESTAMPNS):
+ * endpoint_receive() lo riporta in batch->receive_ns, convertito
+ * all'orologio monotono. Senza Linux l'istante è quello della lettura.
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int endpoint_enable_timestamps(endpoint_t *endpoint);
+
+/*
+ * Legge i datagrammi già arrivati, al più ENDPOINT_BATCH, senza bloccarsi
+ * (da chiamare quando il reactor segnala il socket pronto)
+ * Ritorna il numero di datagrammi nel lotto
+ */
+int endpoint_receive(endpoint_t *endpoint, endpoint_batch_t *batch);
+
+/*
+ * Chiude il socket
+ */
+void endpoint_close(endpoint_t *endpoint);
+
+/*
+ * "indirizzo:porta" (IPv6 tra parentesi quadre)
+ */
+void endpoint_format(const endpoint_addr_t *addr, char *out, size_t size);
+
+/*
+ * Nome (reverse lookup) e indirizzo di un client, per i log
+ */
+void endpoint_describe_client(const endpoint_addr_t *addr, char *hostname, size_t hostname_size,
+                              char *ip, size_t ip_size);
+
+/*
+ * Indirizzo IPv4 del client in network byte order, anche se mappato in IPv6
+ * (::ffff:a.b.c.d); 0 per i client IPv6 nativi
+ * Usato dove il formato su disco prevede solo IPv4 (log degli accessi, cattura)
+ */
+uint32_t endpoint_addr_ipv4(const endpoint_addr_t *addr);
+
+/*
+ * Chiave del mittente per la cattura (capture_record_t.addr), network byte order:
+ * l'indirizzo IPv4, anche se mappato; per i client IPv6 nativi un hash
+ * dell'indirizzo in 240.0.0.0/4 (riservato), così ogni mittente resta un flusso
+ */
+uint32_t endpoint_addr_capture_key(const endpoint_addr_t *addr);
+
+/*
+ * Porta del client in network byte order
+ */
+uint16_t endpoint_addr_port(const endpoint_addr_t *addr);
+
+/*
+ * Dimensione dell'indirizzo per sendto() (dipende dalla famiglia)
+ */
+int endpoint_addr_size(const endpoint_addr_t *addr);
+
+#endif /* ENDPOINTS_H_ */
@@ -0,0 +1,625 @@
+/*
+ * handoff.c
+ *
+ * Passaggio di consegne tra server: socket con SCM_RIGHTS, stato caldo in un memfd
+ */
+
+#if defined __linux__
+#define _GNU_SOURCE // memfd_create(), struct ucred
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "handoff.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define STATE_MAGIC 0x31545348u             // "HST1"
+
+/* Sezioni del memfd: intestazione (tag, dimensione) seguita dai dati */
+#define STATE_SIM_CLOCK 1
+#define STATE_SIM_ARRAYS 2                  // + indice dell'array (6 array)
+#define STATE_HISTORY_INFO 10
+#define STATE_HISTORY_VALUES 11             // + metrica
+#define STATE_HISTORY_TIMES 15              // Istanti condivisi da tutti i ring
+#define STATE_SUBSCRIPTIONS 30
+
+#define SIM_ARRAY_COUNT 6
+
+typedef struct {
+	uint32_t magic;
+	uint32_t flags;
+} handoff_request_msg_t;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t count;
+	uint8_t kinds[HANDOFF_MAX_FDS];
+} handoff_reply_msg_t;
+
+typedef struct {
+	uint32_t tag;
+	uint32_t reserved;
+	uint64_t size;
+} state_section_t;
+
+typedef struct {
+	int32_t city_count;
+	int32_t padded_count;
+	double day_seconds;
+	uint64_t last_tick_ms;              // Istanti monotoni: CLOCK_MONOTONIC è lo stesso per tutti i processi
+	uint64_t next_tick_ms;
+} state_sim_clock_t;
+
+typedef struct {
+	int32_t city_count;
+	uint32_t capacity;
+	uint32_t next;
+	uint32_t count;
+} state_history_info_t;
+
+/* Sottoscrizione salvata: il socket è la posizione nel set dei descrittori */
+typedef struct {
+	endpoint_addr_t addr;
+	int32_t slot;
+	int32_t city_index;
+	uint8_t types;
+	uint8_t reserved[3];
+	uint32_t interval_ms;
+	uint64_t next_due_ms;
+	uint64_t lease_expiry_ms;
+} state_subscription_t;
+
+/*
+ * Timeout di invio e ricezione sulla connessione
+ */
+static void set_timeouts(int sock) {
+	struct timeval timeout = { HANDOFF_TIMEOUT_MS / 1000, (HANDOFF_TIMEOUT_MS % 1000) * 1000 };
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+static int fill_address(struct sockaddr_un *addr, const char *path) {
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (!path || strlen(path) >= sizeof(addr->sun_path)) {
+		fprintf(stderr, "Errore: percorso del passaggio di consegne troppo lungo.\n");
+		return -1;
+	}
+	strcpy(addr->sun_path, path);
+	return 0;
+}
+
+int handoff_connect(const char *path) {
+	struct sockaddr_un addr;
+	if (fill_address(&addr, path) != 0) {
+		return -1;
+	}
+	int conn = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (conn < 0) {
+		return -1;
+	}
+	// Percorso assente o lasciato da un server terminato: nessun predecessore
+	if (connect(conn, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		if (errno != ENOENT && errno != ECONNREFUSED) {
+			fprintf(stderr, "Errore: connessione a %s fallita.\n", path);
+		}
+		close(conn);
+		return -1;
+	}
+	set_timeouts(conn);
+	return conn;
+}
+
+int handoff_request(int conn, uint32_t flags, handoff_set_t *set) {
+	if (conn < 0 || !set) {
+		return -1;
+	}
+	memset(set, 0, sizeof(*set));
+
+	// RICHIESTA
+	handoff_request_msg_t request = { HANDOFF_MAGIC, flags };
+	if (send(conn, &request, sizeof(request), MSG_NOSIGNAL) != (ssize_t)sizeof(request)) {
+		fprintf(stderr, "Errore: invio della richiesta di passaggio di consegne fallito.\n");
+		close(conn);
+		return -1;
+	}
+
+	// RISPOSTA: elenco dei tipi nei dati, descrittori nei dati ausiliari
+	handoff_reply_msg_t reply;
+	union {
+		char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+		struct cmsghdr align;
+	} control;
+	struct iovec iov = { &reply, sizeof(reply) };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	ssize_t received = recvmsg(conn, &msg, MSG_CMSG_CLOEXEC);
+	close(conn);
+	if (received != (ssize_t)sizeof(reply)) {
+		fprintf(stderr, "Errore: nessuna risposta dal server precedente.\n");
+		return -1;
+	}
+
+	for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+		int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+		for (int i = 0; i < count && set->count < HANDOFF_MAX_FDS; i++) {
+			memcpy(&set->fds[set->count++], CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+		}
+	}
+
+	if (reply.magic != HANDOFF_MAGIC || reply.count != (uint32_t)set->count || (msg.msg_flags & MSG_CTRUNC)) {
+		fprintf(stderr, "Errore: risposta di passaggio di consegne non valida.\n");
+		handoff_set_close(set);
+		set->count = 0;
+		return -1;
+	}
+	memcpy(set->kinds, reply.kinds, sizeof(set->kinds));
+	return 0;
+}
+
+int handoff_listen(const char *path) {
+	struct sockaddr_un addr;
+	if (fill_address(&addr, path) != 0) {
+		return -1;
+	}
+	int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (listen_fd < 0) {
+		fprintf(stderr, "Errore: creazione del socket di passaggio di consegne fallita.\n");
+		return -1;
+	}
+
+	// Il percorso del predecessore (o di un server terminato) passa a questo processo
+	unlink(path);
+	mode_t previous_mask = umask(077);
+	int bound = bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+	umask(previous_mask);
+	if (bound < 0 || listen(listen_fd, 1) < 0) {
+		fprintf(stderr, "Errore: ascolto su %s fallito.\n", path);
+		close(listen_fd);
+		return -1;
+	}
+	return listen_fd;
+}
+
+void handoff_close_listener(int listen_fd, const char *path, int remove_path) {
+	if (listen_fd < 0) {
+		return;
+	}
+	close(listen_fd);
+	if (remove_path && path) {
+		unlink(path);
+	}
+}
+
+int handoff_accept(int listen_fd, uint32_t *flags, int *peer_pid) {
+	int conn = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+	if (conn < 0) {
+		return -1;
+	}
+
+	// Solo processi dello stesso utente ricevono i socket
+	struct ucred cred;
+	socklen_t cred_len = sizeof(cred);
+	if (getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0 || cred.uid != geteuid()) {
+		fprintf(stderr, "Errore: passaggio di consegne rifiutato (utente diverso).\n");
+		close(conn);
+		return -1;
+	}
+
+	set_timeouts(conn);
+	handoff_request_msg_t request;
+	if (recv(conn, &request, sizeof(request), MSG_WAITALL) != (ssize_t)sizeof(request) ||
+	    request.magic != HANDOFF_MAGIC) {
+		fprintf(stderr, "Errore: richiesta di passaggio di consegne non valida (pid %d).\n", (int)cred.pid);
+		close(conn);
+		return -1;
+	}
+	if (flags) {
+		*flags = request.flags;
+	}
+	if (peer_pid) {
+		*peer_pid = (int)cred.pid;
+	}
+	return conn;
+}
+
+int handoff_send(int conn, handoff_set_t *set) {
+	if (conn < 0 || !set || set->count <= 0 || set->count > HANDOFF_MAX_FDS) {
+		if (conn >= 0) {
+			close(conn);
+		}
+		return -1;
+	}
+
+	handoff_reply_msg_t reply;
+	memset(&reply, 0, sizeof(reply));
+	reply.magic = HANDOFF_MAGIC;
+	reply.count = (uint32_t)set->count;
+	memcpy(reply.kinds, set->kinds, sizeof(reply.kinds));
+
+	union {
+		char buf[CMSG_SPACE(sizeof(int) * HANDOFF_MAX_FDS)];
+		struct cmsghdr align;
+	} control;
+	memset(&control, 0, sizeof(control));
+	struct iovec iov = { &reply, sizeof(reply) };
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.buf;
+	msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)set->count);
+
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)set->count);
+	memcpy(CMSG_DATA(cmsg), set->fds, sizeof(int) * (size_t)set->count);
+
+	ssize_t sent = sendmsg(conn, &msg, MSG_NOSIGNAL);
+	close(conn);
+
+	// Il memfd dello stato appartiene al set: il successore ne ha ora una copia
+	for (int i = 0; i < set->count; i++) {
+		if (set->kinds[i] == HANDOFF_FD_STATE && set->fds[i] >= 0) {
+			close(set->fds[i]);
+			set->fds[i] = -1;
+		}
+	}
+	if (sent != (ssize_t)sizeof(reply)) {
+		fprintf(stderr, "Errore: invio dei socket al successore fallito.\n");
+		return -1;
+	}
+	return 0;
+}
+
+void handoff_set_close(handoff_set_t *set) {
+	if (!set) {
+		return;
+	}
+	for (int i = 0; i < set->count; i++) {
+		if (set->fds[i] >= 0) {
+			close(set->fds[i]);
+			set->fds[i] = -1;
+		}
+	}
+}
+
+/*
+ * ============================================================================
+ * STATO CALDO
+ * ============================================================================
+ */
+
+static int write_all(int fd, const void *data, size_t size) {
+	const uint8_t *bytes = (const uint8_t *)data;
+	while (size > 0) {
+		ssize_t written = write(fd, bytes, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return -1;
+		}
+		bytes += written;
+		size -= (size_t)written;
+	}
+	return 0;
+}
+
+/* Intestazione e dati, con i dati allineati a 8 byte per la lettura mappata */
+static int put_section(int fd, uint32_t tag, const void *data, size_t size) {
+	static const uint8_t padding[8] = { 0 };
+	state_section_t section = { tag, 0, size };
+	if (write_all(fd, &section, sizeof(section)) != 0 || write_all(fd, data, size) != 0) {
+		return -1;
+	}
+	return write_all(fd, padding, (8 - size % 8) % 8);
+}
+
+int handoff_add_state(handoff_set_t *set, const simulation_t *sim, const history_t *history,
+                      const subscription_table_t *subscriptions) {
+	if (!set || set->count >= HANDOFF_MAX_FDS) {
+		return -1;
+	}
+	int fd = memfd_create("weather_handoff", MFD_CLOEXEC);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: memfd_create() fallita.\n");
+		return -1;
+	}
+
+	uint32_t magic = STATE_MAGIC;
+	uint32_t version = 1;
+	int failed = write_all(fd, &magic, sizeof(magic)) != 0 || write_all(fd, &version, sizeof(version)) != 0;
+
+	// SIMULAZIONE: orologio e array per città (padding SIMD compreso)
+	if (!failed && sim && sim->city_count > 0) {
+		state_sim_clock_t clock = { sim->city_count, sim->padded_count, sim->day_seconds,
+		                            sim->last_tick_ms, sim->next_tick_ms };
+		const void *arrays[SIM_ARRAY_COUNT] = { sim->temperature, sim->humidity, sim->wind, sim->pressure,
+		                                        sim->base_temperature, sim->rng };
+		size_t array_bytes = (size_t)sim->padded_count * sizeof(float);
+		failed |= put_section(fd, STATE_SIM_CLOCK, &clock, sizeof(clock)) != 0;
+		for (int i = 0; i < SIM_ARRAY_COUNT && !failed; i++) {
+			failed |= put_section(fd, STATE_SIM_ARRAYS + (uint32_t)i, arrays[i], array_bytes) != 0;
+		}
+	}
+
+	// STORICO: ring per metrica e istanti condivisi
+	if (!failed && history && history->capacity > 0) {
+		state_history_info_t info = { history->city_count, history->capacity, history->next, history->count };
+		size_t slots = (size_t)history->city_count * history->capacity;
+		failed |= put_section(fd, STATE_HISTORY_INFO, &info, sizeof(info)) != 0;
+		failed |= put_section(fd, STATE_HISTORY_TIMES, history->times_ms,
+		                      (size_t)history->capacity * sizeof(uint64_t)) != 0;
+		for (uint32_t m = 0; m < SNAPSHOT_METRICS && !failed; m++) {
+			failed |= put_section(fd, STATE_HISTORY_VALUES + m, history->values[m], slots * sizeof(float)) != 0;
+		}
+	}
+
+	// SOTTOSCRIZIONI: il socket diventa la sua posizione nel set
+	if (!failed && subscriptions && subscriptions->count > 0) {
+		size_t bytes = (size_t)subscriptions->count * sizeof(state_subscription_t);
+		state_subscription_t *saved = (state_subscription_t *)mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+		                                                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (saved == MAP_FAILED) {
+			failed = 1;
+		} else {
+			int32_t used = 0;
+			for (int32_t i = 0; i < subscriptions->capacity && used < subscriptions->count; i++) {
+				const subscription_t *entry = &subscriptions->entries[i];
+				if (!entry->in_use) {
+					continue;
+				}
+				state_subscription_t *record = &saved[used++];
+				memset(record, 0, sizeof(*record));
+				record->addr = entry->addr;
+				record->slot = -1;
+				for (int s = 0; s < set->count; s++) {
+					if (set->fds[s] == entry->sock) {
+						record->slot = s;
+						break;
+					}
+				}
+				record->city_index = entry->city_index;
+				record->types = entry->types;
+				record->interval_ms = entry->interval_ms;
+				record->next_due_ms = entry->next_due_ms;
+				record->lease_expiry_ms = entry->lease_expiry_ms;
+			}
+			failed |= put_section(fd, STATE_SUBSCRIPTIONS, saved, (size_t)used * sizeof(*saved)) != 0;
+			munmap(saved, bytes);
+		}
+	}
+
+	if (failed) {
+		fprintf(stderr, "Errore: scrittura dello stato caldo fallita.\n");
+		close(fd);
+		return -1;
+	}
+	set->fds[set->count] = fd;
+	set->kinds[set->count] = HANDOFF_FD_STATE;
+	set->count++;
+	return 0;
+}
+
+/* Dati della sezione con il tag indicato (NULL se assente), *section_size riceve la dimensione */
+static const void *find_section(const uint8_t *base, size_t size, uint32_t tag, size_t *section_size) {
+	size_t offset = 2 * sizeof(uint32_t);
+	while (offset + sizeof(state_section_t) <= size) {
+		state_section_t section;
+		memcpy(&section, base + offset, sizeof(section));
+		offset += sizeof(section);
+		if (section.size > size - offset) {
+			return NULL;
+		}
+		if (section.tag == tag) {
+			*section_size = (size_t)section.size;
+			return base + offset;
+		}
+		offset += (size_t)section.size + (8 - section.size % 8) % 8;
+	}
+	return NULL;
+}
+
+/* Come find_section(), ma solo se la dimensione è quella attesa */
+static const void *find_exact(const uint8_t *base, size_t size, uint32_t tag, size_t expected) {
+	size_t section_size = 0;
+	const void *data = find_section(base, size, tag, &section_size);
+	return data && section_size == expected ? data : NULL;
+}
+
+int handoff_import_state(handoff_set_t *set, const int *new_socks, simulation_t *sim, history_t *history,
+                         subscription_table_t *subscriptions, handoff_summary_t *summary) {
+	if (summary) {
+		memset(summary, 0, sizeof(*summary));
+	}
+	if (!set) {
+		return -1;
+	}
+	int state_index = -1;
+	for (int i = 0; i < set->count; i++) {
+		if (set->kinds[i] == HANDOFF_FD_STATE && set->fds[i] >= 0) {
+			state_index = i;
+		}
+	}
+	if (state_index < 0) {
+		return 0; // Stato non richiesto o non disponibile: partenza a freddo
+	}
+
+	int fd = set->fds[state_index];
+	set->fds[state_index] = -1;
+	struct stat info;
+	uint8_t *base = MAP_FAILED;
+	if (fstat(fd, &info) == 0 && info.st_size >= (off_t)(2 * sizeof(uint32_t))) {
+		base = (uint8_t *)mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+	uint32_t magic = 0;
+	if (base != MAP_FAILED) {
+		memcpy(&magic, base, sizeof(magic));
+	}
+	if (base == MAP_FAILED || magic != STATE_MAGIC) {
+		fprintf(stderr, "Errore: stato caldo non leggibile.\n");
+		if (base != MAP_FAILED) {
+			munmap(base, (size_t)info.st_size);
+		}
+		return -1;
+	}
+	size_t size = (size_t)info.st_size;
+
+	// SIMULAZIONE: solo con lo stesso numero di città
+	const state_sim_clock_t *clock = (const state_sim_clock_t *)find_exact(base, size, STATE_SIM_CLOCK,
+	                                                                       sizeof(state_sim_clock_t));
+	if (sim && clock && clock->city_count == sim->city_count && clock->padded_count == sim->padded_count) {
+		void *targets[SIM_ARRAY_COUNT] = { sim->temperature, sim->humidity, sim->wind, sim->pressure,
+		                                   sim->base_temperature, sim->rng };
+		const void *sources[SIM_ARRAY_COUNT];
+		size_t array_bytes = (size_t)sim->padded_count * sizeof(float);
+		int complete = 1;
+		for (int i = 0; i < SIM_ARRAY_COUNT; i++) {
+			sources[i] = find_exact(base, size, STATE_SIM_ARRAYS + (uint32_t)i, array_bytes);
+			complete &= sources[i] != NULL;
+		}
+		for (int i = 0; complete && i < SIM_ARRAY_COUNT; i++) {
+			memcpy(targets[i], sources[i], array_bytes);
+		}
+		if (complete) {
+			sim->day_seconds = clock->day_seconds;
+			sim->last_tick_ms = clock->last_tick_ms;
+			sim->next_tick_ms = clock->next_tick_ms;
+			if (summary) {
+				summary->simulation = 1;
+			}
+		}
+	}
+
+	// STORICO: solo con stesse città e stessa capacità
+	const state_history_info_t *history_info = (const state_history_info_t *)find_exact(
+		base, size, STATE_HISTORY_INFO, sizeof(state_history_info_t));
+	if (history && history_info && history->capacity > 0 && history_info->city_count == history->city_count &&
+	    history_info->capacity == history->capacity && history_info->next < history->capacity &&
+	    history_info->count <= history->capacity) {
+		size_t slots = (size_t)history->city_count * history->capacity;
+		size_t times_bytes = (size_t)history->capacity * sizeof(uint64_t);
+		const void *times = find_exact(base, size, STATE_HISTORY_TIMES, times_bytes);
+		const void *sources[SNAPSHOT_METRICS];
+		int complete = times != NULL;
+		for (uint32_t m = 0; m < SNAPSHOT_METRICS; m++) {
+			sources[m] = find_exact(base, size, STATE_HISTORY_VALUES + m, slots * sizeof(float));
+			complete &= sources[m] != NULL;
+		}
+		if (complete) {
+			memcpy(history->times_ms, times, times_bytes);
+			for (uint32_t m = 0; m < SNAPSHOT_METRICS; m++) {
+				memcpy(history->values[m], sources[m], slots * sizeof(float));
+			}
+			history->next = history_info->next;
+			history->count = history_info->count;
+			if (summary) {
+				summary->history = 1;
+			}
+		}
+	}
+
+	// SOTTOSCRIZIONI: sul socket che ha preso il posto di quello originale
+	size_t saved_bytes = 0;
+	const state_subscription_t *saved = (const state_subscription_t *)find_section(base, size, STATE_SUBSCRIPTIONS,
+	                                                                               &saved_bytes);
+	size_t saved_count = saved && subscriptions && new_socks ? saved_bytes / sizeof(state_subscription_t) : 0;
+	for (size_t i = 0; i < saved_count; i++) {
+		subscription_t entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.addr = saved[i].addr;
+		entry.sock = saved[i].slot >= 0 && saved[i].slot < set->count ? new_socks[saved[i].slot] : -1;
+		entry.city_index = saved[i].city_index;
+		entry.types = saved[i].types;
+		entry.interval_ms = saved[i].interval_ms;
+		entry.next_due_ms = saved[i].next_due_ms;
+		entry.lease_expiry_ms = saved[i].lease_expiry_ms;
+		int valid = entry.sock >= 0 && entry.city_index >= 0 && (!sim || entry.city_index < sim->city_count);
+		if (valid && subscription_restore(subscriptions, &entry) == 0) {
+			if (summary) {
+				summary->subscriptions++;
+			}
+		} else if (summary) {
+			summary->subscriptions_dropped++;
+		}
+	}
+
+	munmap(base, size);
+	return 0;
+}
+
+#else /* !__linux__ */
+
+int handoff_connect(const char *path) {
+	(void)path;
+	fprintf(stderr, "Errore: passaggio di consegne disponibile solo su Linux.\n");
+	return -1;
+}
+
+int handoff_request(int conn, uint32_t flags, handoff_set_t *set) {
+	(void)conn; (void)flags;
+	if (set) {
+		memset(set, 0, sizeof(*set));
+	}
+	return -1;
+}
+
+int handoff_listen(const char *path) {
+	(void)path;
+	return -1;
+}
+
+void handoff_close_listener(int listen_fd, const char *path, int remove_path) {
+	(void)listen_fd; (void)path; (void)remove_path;
+}
+
+int handoff_accept(int listen_fd, uint32_t *flags, int *peer_pid) {
+	(void)listen_fd; (void)flags; (void)peer_pid;
+	return -1;
+}
+
+int handoff_add_state(handoff_set_t *set, const simulation_t *sim, const history_t *history,
+                      const subscription_table_t *subscriptions) {
+	(void)set; (void)sim; (void)history; (void)subscriptions;
+	return -1;
+}
+
+int handoff_send(int conn, handoff_set_t *set) {
+	(void)conn; (void)set;
+	return -1;
+}
+
+int handoff_import_state(handoff_set_t *set, const int *new_socks, simulation_t *sim, history_t *history,
+                         subscription_table_t *subscriptions, handoff_summary_t *summary) {
+	(void)set; (void)new_socks; (void)sim; (void)history; (void)subscriptions;
+	if (summary) {
+		memset(summary, 0, sizeof(*summary));
+	}
+	return 0;
+}
+
+void handoff_set_close(handoff_set_t *set) {
+	(void)set;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,141 @@
+/*
+ * handoff.h
+ *
+ * Passaggio di consegne tra due processi server per riavvii senza perdite
+ * Il server in esecuzione con -U percorso ascolta su un socket Unix. Un
+ * nuovo server avviato con lo stesso percorso, finita la propria
+ * inizializzazione, si collega e chiede i socket:
+ *  1. il vecchio server ferma le letture, serve i datagrammi già accodati
+ *     (corsie, ring shm) e con -K prepara lo stato caldo
+ *  2. invia i socket in ascolto con SCM_RIGHTS in un solo messaggio, più un
+ *     memfd con lo stato caldo: simulazione, storico e sottoscrizioni, e il
+ *     collegamento del filtro XDP (-X), che il successore aggiorna sul posto
+ *  3. il vecchio server termina, il nuovo serve dagli stessi socket
+ * I datagrammi arrivati nel frattempo restano nel buffer del kernel dei
+ * socket condivisi: nessuna richiesta viene persa.
+ *
+ * Il predecessore accetta solo processi dello stesso utente (SO_PEERCRED).
+ * Disponibile solo su Linux.
+ */
+
+#ifndef HANDOFF_H_
+#define HANDOFF_H_
+
+#include <stdint.h>
+#include "endpoints.h"
+#include "simulation.h"
+#include "history.h"
+#include "subscription.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define HANDOFF_MAGIC 0x31464F48u           // "HOF1"
+#define HANDOFF_MAX_FDS (ENDPOINT_MAX + 3)  // Socket in ascolto, porta prioritaria, stato caldo, XDP
+#define HANDOFF_TIMEOUT_MS 2000             // Attesa massima di ogni messaggio
+
+#define HANDOFF_WANT_STATE 0x1              // Richiesta: inviare anche lo stato caldo (-K)
+
+/* Tipo di ogni descrittore passato (i primi due coincidono con ENDPOINT_KIND_*) */
+#define HANDOFF_FD_SERVICE ENDPOINT_KIND_SERVICE
+#define HANDOFF_FD_ADMIN ENDPOINT_KIND_ADMIN
+#define HANDOFF_FD_PRIORITY 2
+#define HANDOFF_FD_STATE 3
+#define HANDOFF_FD_XDP_LINK 4              // Collegamento del filtro XDP (xdp_filter.h)
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/* Descrittori passati, nell'ordine del messaggio */
+typedef struct {
+	int count;
+	int fds[HANDOFF_MAX_FDS];
+	uint8_t kinds[HANDOFF_MAX_FDS];         // HANDOFF_FD_*
+} handoff_set_t;
+
+/* Esito dell'importazione dello stato caldo */
+typedef struct {
+	int simulation;                         // 1 se lo stato della simulazione è stato ripreso
+	int history;                            // 1 se lo storico è stato ripreso
+	int subscriptions;                      // Sottoscrizioni riprese
+	int subscriptions_dropped;              // Sottoscrizioni senza socket o senza posto in tabella
+} handoff_summary_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Lato successore: si collega al server in ascolto su path
+ * Ritorna il descrittore della connessione, -1 se nessun server è in ascolto
+ */
+int handoff_connect(const char *path);
+
+/*
+ * Lato successore: invia la richiesta (flags HANDOFF_*) e riceve i descrittori
+ * La connessione viene chiusa; i descrittori ricevuti passano al chiamante
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int handoff_request(int conn, uint32_t flags, handoff_set_t *set);
+
+/*
+ * Apre il socket Unix su cui il server attende un successore
+ * (un percorso lasciato da un server terminato viene sostituito)
+ * Ritorna il descrittore in ascolto, -1 in caso di errore
+ */
+int handoff_listen(const char *path);
+
+/*
+ * Chiude il socket in ascolto; il percorso viene rimosso solo con remove_path
+ * (dopo un passaggio di consegne appartiene già al successore)
+ */
+void handoff_close_listener(int listen_fd, const char *path, int remove_path);
+
+/*
+ * Lato predecessore: accetta un successore e ne legge la richiesta
+ * Ritorna la connessione, -1 se il processo non è dello stesso utente o la
+ * richiesta non è valida; *peer_pid riceve il pid del successore
+ */
+int handoff_accept(int listen_fd, uint32_t *flags, int *peer_pid);
+
+/*
+ * Lato predecessore: aggiunge al set un memfd con lo stato caldo
+ * Le sottoscrizioni ricordano il proprio socket come posizione nel set,
+ * quindi va chiamata dopo aver aggiunto tutti i socket
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int handoff_add_state(handoff_set_t *set, const simulation_t *sim, const history_t *history,
+                      const subscription_table_t *subscriptions);
+
+/*
+ * Lato predecessore: invia i descrittori del set e chiude la connessione
+ * Il memfd dello stato, creato da handoff_add_state(), viene chiuso qui;
+ * i socket restano aperti
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int handoff_send(int conn, handoff_set_t *set);
+
+/*
+ * Lato successore: riprende lo stato caldo dal memfd del set, se presente, e
+ * lo chiude. Simulazione e storico sono ripresi solo se le dimensioni
+ * coincidono; new_socks[i] è il socket che sostituisce il descrittore i del
+ * set (-1 se chiuso: le sue sottoscrizioni sono scartate)
+ * Ritorna 0 in caso di successo, -1 se lo stato non è leggibile
+ */
+int handoff_import_state(handoff_set_t *set, const int *new_socks, simulation_t *sim, history_t *history,
+                         subscription_table_t *subscriptions, handoff_summary_t *summary);
+
+/*
+ * Chiude i descrittori del set ancora aperti (quelli con valore >= 0)
+ */
+void handoff_set_close(handoff_set_t *set);
+
+#endif /* HANDOFF_H_ */
@@ -0,0 +1,209 @@
+/*
+ * history.c
+ *
+ * Storico dei valori per città e metrica
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "history.h"
+
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+int history_init(history_t *history, int city_count, uint32_t capacity) {
+	if (!history || city_count <= 0) {
+		return -1;
+	}
+
+	memset(history, 0, sizeof(*history));
+	history->city_count = city_count;
+	history->capacity = capacity;
+	if (capacity == 0) {
+		return 0;
+	}
+
+	size_t slots = (size_t)city_count * capacity;
+	history->times_ms = (uint64_t *)malloc((size_t)capacity * sizeof(uint64_t));
+	if (!history->times_ms) {
+		history_free(history);
+		return -1;
+	}
+	for (int m = 0; m < SNAPSHOT_METRICS; m++) {
+		history->values[m] = (float *)malloc(slots * sizeof(float));
+		if (!history->values[m]) {
+			history_free(history);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+void history_free(history_t *history) {
+	if (!history) {
+		return;
+	}
+	for (int m = 0; m < SNAPSHOT_METRICS; m++) {
+		free(history->values[m]);
+		history->values[m] = NULL;
+	}
+	free(history->times_ms);
+	history->times_ms = NULL;
+	history->next = 0;
+	history->count = 0;
+	history->capacity = 0;
+}
+
+size_t history_memory_bytes(const history_t *history) {
+	return (size_t)SNAPSHOT_METRICS * history->city_count * history->capacity * sizeof(float) +
+	       (size_t)history->capacity * sizeof(uint64_t);
+}
+
+int history_metric_index(char type) {
+	switch (type) {
+		case TYPE_TEMPERATURE:
+			return 0;
+		case TYPE_HUMIDITY:
+			return 1;
+		case TYPE_WIND:
+			return 2;
+		case TYPE_PRESSURE:
+			return 3;
+		default:
+			return -1;
+	}
+}
+
+void history_record_all(history_t *history, const float *const values[SNAPSHOT_METRICS], uint64_t now_ms) {
+	if (history->capacity == 0) {
+		return;
+	}
+
+	// Stessa posizione in tutti i ring: per ogni metrica un valore per città,
+	// ogni ring contiguo nel tempo (per le query), un solo istante per tick
+	uint32_t capacity = history->capacity;
+	uint32_t pos = history->next;
+	for (int m = 0; m < SNAPSHOT_METRICS; m++) {
+		float *ring_values = history->values[m] + pos;
+		for (int c = 0; c < history->city_count; c++) {
+			ring_values[(size_t)c * capacity] = values[m][c];
+		}
+	}
+	history->times_ms[pos] = now_ms;
+
+	history->next = pos + 1 == capacity ? 0 : pos + 1;
+	if (history->count < capacity) {
+		history->count++;
+	}
+}
+
+/*
+ * Riduzione min/max/somma di n float contigui
+ * Con SSE2: 4 corsie float per min/max, somma accumulata in double (2 x 2 corsie)
+ */
+static void reduce_range(const float *values, uint32_t n, float *min_out, float *max_out, double *sum_out) {
+	float min_value = *min_out;
+	float max_value = *max_out;
+	double sum = 0.0;
+	uint32_t i = 0;
+
+#if defined __SSE2__
+	if (n >= 4) {
+		__m128 vmin = _mm_set1_ps(min_value);
+		__m128 vmax = _mm_set1_ps(max_value);
+		__m128d vsum_lo = _mm_setzero_pd();
+		__m128d vsum_hi = _mm_setzero_pd();
+
+		for (; i + 4 <= n; i += 4) {
+			__m128 v = _mm_loadu_ps(values + i);
+			vmin = _mm_min_ps(vmin, v);
+			vmax = _mm_max_ps(vmax, v);
+			vsum_lo = _mm_add_pd(vsum_lo, _mm_cvtps_pd(v));
+			vsum_hi = _mm_add_pd(vsum_hi, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+		}
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, vmin);
+		for (int l = 0; l < 4; l++) {
+			min_value = lanes[l] < min_value ? lanes[l] : min_value;
+		}
+		_mm_storeu_ps(lanes, vmax);
+		for (int l = 0; l < 4; l++) {
+			max_value = lanes[l] > max_value ? lanes[l] : max_value;
+		}
+		double sums[2];
+		_mm_storeu_pd(sums, _mm_add_pd(vsum_lo, vsum_hi));
+		sum = sums[0] + sums[1];
+	}
+#endif
+
+	// Coda (o tutto l'intervallo senza SSE2)
+	for (; i < n; i++) {
+		float v = values[i];
+		min_value = v < min_value ? v : min_value;
+		max_value = v > max_value ? v : max_value;
+		sum += v;
+	}
+
+	*min_out = min_value;
+	*max_out = max_value;
+	*sum_out += sum;
+}
+
+void history_aggregate(const history_t *history, int city_index, int metric, uint64_t window_ms,
+                       uint64_t now_ms, history_aggregate_t *result) {
+	memset(result, 0, sizeof(*result));
+	if (history->capacity == 0 || city_index < 0 || city_index >= history->city_count ||
+	    metric < 0 || metric >= SNAPSHOT_METRICS) {
+		return;
+	}
+
+	uint32_t count = history->count;
+	if (count == 0) {
+		return;
+	}
+
+	const float *values = history->values[metric] + (size_t)city_index * history->capacity;
+	const uint64_t *times = history->times_ms;
+	uint32_t capacity = history->capacity;
+	uint32_t oldest = (history->next + capacity - count) % capacity;
+
+	// RICERCA BINARIA del primo campione nella finestra (istanti crescenti nel ring)
+	uint32_t first = 0;
+	if (window_ms > 0 && window_ms < now_ms) {
+		uint64_t since_ms = now_ms - window_ms;
+		uint32_t lo = 0;
+		uint32_t hi = count;
+		while (lo < hi) {
+			uint32_t mid = lo + (hi - lo) / 2;
+			if (times[(oldest + mid) % capacity] < since_ms) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		first = lo;
+	}
+	if (first == count) {
+		return;
+	}
+
+	// RIDUZIONE: al più due tratti contigui (prima e dopo il giro del ring)
+	uint32_t start = (oldest + first) % capacity;
+	uint32_t n = count - first;
+	uint32_t head_len = start + n <= capacity ? n : capacity - start;
+
+	float min_value = values[start];
+	float max_value = values[start];
+	double sum = 0.0;
+	reduce_range(values + start, head_len, &min_value, &max_value, &sum);
+	if (head_len < n) {
+		reduce_range(values, n - head_len, &min_value, &max_value, &sum);
+	}
+
+	result->count = n;
+	result->min = min_value;
+	result->max = max_value;
+	result->avg = (float)(sum / n);
+}
@@ -0,0 +1,99 @@
+/*
+ * history.h
+ *
+ * Storico dei valori per città e metrica
+ * Per ogni coppia (città, metrica) un ring di dimensione fissa conserva gli
+ * ultimi campioni, uno per tick della simulazione: la finestra coperta non
+ * dipende dal traffico. Layout structure-of-arrays: i valori di ogni
+ * (città, metrica) sono contigui nel tempo, così una query su una finestra
+ * temporale scorre solo float consecutivi (riduzione SIMD min/max/somma).
+ * Tutti i ring avanzano insieme: istanti e posizione sono uno per tick.
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "protocol.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define HISTORY_DEFAULT_CAPACITY 4096   // Campioni conservati per città e metrica
+#define HISTORY_MAX_CAPACITY 1048576    // Limite dell'opzione -H
+#define HISTORY_MAX_BYTES ((size_t)256 << 20) // Tetto di memoria dei ring (cataloghi grandi)
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	int city_count;
+	uint32_t capacity;                      // Campioni per ring (0 = storico disattivato)
+
+	// Indicizzati per metrica (ordine SNAPSHOT_METRICS: t, h, w, p), poi città * capacity
+	float *values[SNAPSHOT_METRICS];
+
+	// Tutti i ring avanzano insieme, un campione per tick: istanti e posizioni condivisi
+	uint64_t *times_ms;                     // capacity istanti monotoni, crescenti nel ring
+	uint32_t next;                          // Prossima posizione di scrittura
+	uint32_t count;                         // Campioni validi in ogni ring
+} history_t;
+
+/* Risultato di una query aggregata */
+typedef struct {
+	uint32_t count;
+	float min;
+	float max;
+	float avg;
+} history_aggregate_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Alloca i ring per city_count città (capacity = 0 disattiva lo storico)
+ * Ritorna 0 in caso di successo, -1 se la memoria non basta
+ */
+int history_init(history_t *history, int city_count, uint32_t capacity);
+
+/*
+ * Libera la memoria dello storico
+ */
+void history_free(history_t *history);
+
+/*
+ * Memoria occupata dai ring in byte
+ */
+size_t history_memory_bytes(const history_t *history);
+
+/*
+ * Indice della metrica (0..SNAPSHOT_METRICS-1) per il tipo indicato, -1 se sconosciuto
+ */
+int history_metric_index(char type);
+
+/*
+ * Registra un campione per ogni città e metrica, all'istante now_ms:
+ * values[m][i] è il valore della metrica m per la città i (almeno
+ * city_count elementi, es. gli array della simulazione)
+ * Sovrascrive il campione più vecchio quando i ring sono pieni
+ */
+void history_record_all(history_t *history, const float *const values[SNAPSHOT_METRICS], uint64_t now_ms);
+
+/*
+ * Min, max e media dei campioni con istante >= now_ms - window_ms
+ * (window_ms = 0: tutto lo storico); count = 0 se non ce ne sono
+ */
+void history_aggregate(const history_t *history, int city_index, int metric, uint64_t window_ms,
+                       uint64_t now_ms, history_aggregate_t *result);
+
+#endif /* HISTORY_H_ */
@@ -0,0 +1,39 @@
+/*
+ * lane_policy.c
+ *
+ * Politica di scelta tra le corsie di priorità
+ */
+
+#include "lane_policy.h"
+
+int lane_policy_next(int priority_ready, int bulk_ready, int weight, int *credit) {
+	if (!priority_ready && !bulk_ready) {
+		return -1;
+	}
+
+	// POLITICA: prioritaria prima; con peso N un normale in attesa passa ogni N prioritari
+	// Il credito conta solo i prioritari che hanno fatto attendere un normale:
+	// resta così entro weight, senza crescere con la corsia normale vuota
+	if (priority_ready && (!bulk_ready || weight == LANE_POLICY_STRICT || *credit < weight)) {
+		if (bulk_ready && *credit < weight) {
+			(*credit)++;
+		}
+		return LANE_PRIORITY;
+	}
+	*credit = 0;
+	return LANE_BULK;
+}
+
+int lane_policy_batch(const int pending[LANE_COUNT], int max, int weight, int *credit, int *order) {
+	int left[LANE_COUNT] = { pending[LANE_PRIORITY], pending[LANE_BULK] };
+	int count = 0;
+	while (count < max) {
+		int lane = lane_policy_next(left[LANE_PRIORITY] > 0, left[LANE_BULK] > 0, weight, credit);
+		if (lane < 0) {
+			break;
+		}
+		left[lane]--;
+		order[count++] = lane;
+	}
+	return count;
+}
@@ -0,0 +1,48 @@
+/*
+ * lane_policy.h
+ *
+ * Politica di scelta tra le corsie di priorità, senza stato proprio né
+ * thread: la usano il loop del server (lanes_take_batch) e la simulazione
+ * di rete (bench/netsim.c), così entrambi compongono i lotti allo stesso modo.
+ *  - stretta (weight = LANE_POLICY_STRICT): la prioritaria sempre per prima
+ *  - pesata (weight = N): un normale in attesa passa ogni N prioritari
+ */
+
+#ifndef LANE_POLICY_H_
+#define LANE_POLICY_H_
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define LANE_PRIORITY 0
+#define LANE_BULK 1
+#define LANE_COUNT 2
+
+#define LANE_POLICY_STRICT 0            // -W 0
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Corsia da servire dati i datagrammi in attesa su ciascuna
+ * credit conta i prioritari serviti, con un normale in attesa, dall'ultimo
+ * normale (0..weight) ed è aggiornato
+ * Ritorna LANE_PRIORITY o LANE_BULK, -1 se entrambe sono vuote
+ */
+int lane_policy_next(int priority_ready, int bulk_ready, int weight, int *credit);
+
+/*
+ * Composizione di un lotto: pending[] sono i datagrammi in coda per corsia
+ * all'inizio del lotto (quelli arrivati dopo attendono il lotto seguente)
+ * order riceve al più max corsie, una per datagramma nell'ordine di servizio
+ * Ritorna il numero di datagrammi del lotto
+ */
+int lane_policy_batch(const int pending[LANE_COUNT], int max, int weight, int *credit, int *order);
+
+#endif /* LANE_POLICY_H_ */
@@ -0,0 +1,368 @@
+/*
+ * lanes.c
+ *
+ * Corsie di priorità con socket e thread dedicati
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lanes.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+
+#define LANE_POLL_MS 100                // Il thread di una corsia controlla running a questo intervallo
+
+static int latency_bucket(uint64_t ns) {
+	int bucket = 0;
+	while (ns > 1 && bucket < LANE_LATENCY_BUCKETS - 1) {
+		ns >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+static void set_rcvbuf(int sock, int bytes, const char *name) {
+	if (bytes <= 0) {
+		bytes = LANE_DEFAULT_RCVBUF;
+	}
+	if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bytes, sizeof(bytes)) < 0) {
+		fprintf(stderr, "Errore: SO_RCVBUF non impostato per la corsia %s.\n", name);
+	}
+}
+
+/*
+ * Thread di una corsia: riceve direttamente nella cella libera del ring
+ * Con la coda piena il datagramma è letto e scartato (contato in dropped),
+ * così il buffer del kernel non si riempie di richieste vecchie
+ */
+static void *lane_thread(void *arg) {
+	lane_t *lane = (lane_t *)arg;
+
+	lane_datagram_t overflow;
+	while (__atomic_load_n(lane->running, __ATOMIC_RELAXED)) {
+		uint32_t tail = lane->tail;
+		uint32_t head = __atomic_load_n(&lane->head, __ATOMIC_ACQUIRE);
+		int full = tail - head == LANE_QUEUE_SIZE;
+		lane_datagram_t *cell = full ? &overflow : &lane->queue[tail & (LANE_QUEUE_SIZE - 1)];
+
+		socklen_t addr_len = sizeof(cell->addr);
+		ssize_t n = recvfrom(lane->sock, cell->data, sizeof(cell->data), 0, &cell->addr.sa, &addr_len);
+		if (n < 0) {
+			continue; // Timeout del poll o segnale
+		}
+		cell->addr_len = (uint16_t)addr_len;
+		cell->receive_ns = get_monotonic_ns();
+		cell->length = (uint16_t)n;
+		__atomic_fetch_add(&lane->received, 1, __ATOMIC_RELAXED);
+
+		if (full) {
+			__atomic_fetch_add(&lane->dropped, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+
+		// Pubblica la cella, poi controlla se il thread principale aveva già svuotato la coda:
+		// in quel caso potrebbe dormire e va svegliato (entrambe le operazioni seq_cst)
+		__atomic_store_n(&lane->tail, tail + 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&lane->head, __ATOMIC_SEQ_CST) == tail) {
+			uint64_t one = 1;
+			if (write(lane->wake_fd, &one, sizeof(one)) < 0) {
+				// eventfd saturo: il thread principale è comunque già sveglio
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Stessa famiglia e stesso indirizzo della porta normale, cambia solo la porta */
+static int open_priority_socket(const endpoint_addr_t *bulk_addr, int port) {
+	int sock = socket(bulk_addr->sa.sa_family, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		fprintf(stderr, "Errore: creazione del socket prioritario fallita.\n");
+		return -1;
+	}
+	endpoint_addr_t addr = *bulk_addr;
+	addr.v4.sin_port = htons((uint16_t)port); // sin_port e sin6_port coincidono
+	if (addr.sa.sa_family == AF_INET6) {
+		int v6only = 1;
+		setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &v6only, sizeof(v6only));
+	}
+	if (bind(sock, &addr.sa, (socklen_t)endpoint_addr_size(&addr)) < 0) {
+		fprintf(stderr, "Errore: bind() della porta prioritaria %d fallita.\n", port);
+		close(sock);
+		return -1;
+	}
+	return sock;
+}
+
+int lanes_start(lane_set_t *set, int bulk_sock, int priority_sock, int priority_port, int bulk_rcvbuf,
+                int priority_rcvbuf, int weight) {
+	if (!set) {
+		return -1;
+	}
+	memset(set, 0, sizeof(*set));
+	set->wake_fd = -1;
+	set->weight = weight;
+
+	lane_t *priority = &set->lanes[LANE_PRIORITY];
+	lane_t *bulk = &set->lanes[LANE_BULK];
+	priority->name = "prioritaria";
+	bulk->name = "normale";
+	priority->port = priority_port;
+	bulk->sock = bulk_sock;
+
+	endpoint_addr_t bulk_addr;
+	socklen_t bulk_len = sizeof(bulk_addr);
+	if (getsockname(bulk_sock, &bulk_addr.sa, &bulk_len) < 0) {
+		fprintf(stderr, "Errore: indirizzo della porta normale non disponibile.\n");
+		priority->sock = -1;
+		return -1;
+	}
+	bulk->port = ntohs(bulk_addr.v4.sin_port);
+	priority->sock = priority_sock >= 0 ? priority_sock : open_priority_socket(&bulk_addr, priority_port);
+	if (priority->sock < 0) {
+		return -1;
+	}
+
+	set_rcvbuf(priority->sock, priority_rcvbuf, priority->name);
+	set_rcvbuf(bulk->sock, bulk_rcvbuf, bulk->name);
+
+	set->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (set->wake_fd < 0) {
+		fprintf(stderr, "Errore: eventfd() fallita.\n");
+		lanes_stop(set);
+		return -1;
+	}
+
+	set->running = 1;
+	for (int i = 0; i < LANE_COUNT; i++) {
+		lane_t *lane = &set->lanes[i];
+		lane->wake_fd = set->wake_fd;
+		lane->running = &set->running;
+		lane->queue = (lane_datagram_t *)malloc(LANE_QUEUE_SIZE * sizeof(lane_datagram_t));
+		if (!lane->queue) {
+			fprintf(stderr, "Errore: memoria insufficiente per la coda della corsia %s.\n", lane->name);
+			lanes_stop(set);
+			return -1;
+		}
+
+		// Timeout di ricezione: i thread si accorgono di lanes_stop() entro LANE_POLL_MS
+		struct timeval poll_timeout = { 0, LANE_POLL_MS * 1000 };
+		setsockopt(lane->sock, SOL_SOCKET, SO_RCVTIMEO, &poll_timeout, sizeof(poll_timeout));
+	}
+	if (lanes_resume(set) != 0) {
+		lanes_stop(set);
+		return -1;
+	}
+
+	set->enabled = 1;
+	return 0;
+}
+
+void lanes_pause(lane_set_t *set) {
+	if (!set) {
+		return;
+	}
+	__atomic_store_n(&set->running, 0, __ATOMIC_RELAXED);
+	for (int i = 0; i < LANE_COUNT; i++) {
+		lane_t *lane = &set->lanes[i];
+		if (lane->thread_started) {
+			pthread_join(lane->thread, NULL);
+			lane->thread_started = 0;
+		}
+	}
+}
+
+int lanes_resume(lane_set_t *set) {
+	if (!set) {
+		return -1;
+	}
+	__atomic_store_n(&set->running, 1, __ATOMIC_RELAXED);
+	for (int i = 0; i < LANE_COUNT; i++) {
+		if (set->lanes[i].thread_started) {
+			continue;
+		}
+		if (pthread_create(&set->lanes[i].thread, NULL, lane_thread, &set->lanes[i]) != 0) {
+			fprintf(stderr, "Errore: avvio del thread della corsia %s fallito.\n", set->lanes[i].name);
+			return -1;
+		}
+		set->lanes[i].thread_started = 1;
+	}
+	return 0;
+}
+
+static int lane_ready(lane_t *lane) {
+	return __atomic_load_n(&lane->tail, __ATOMIC_SEQ_CST) != lane->head;
+}
+
+int lanes_pending(lane_set_t *set) {
+	return set->enabled && (lane_ready(&set->lanes[LANE_PRIORITY]) || lane_ready(&set->lanes[LANE_BULK]));
+}
+
+int lanes_take_batch(lane_set_t *set, int *order, int max) {
+	if (!set->enabled) {
+		return 0;
+	}
+
+	// Datagrammi in coda adesso: il thread della corsia può solo aggiungerne
+	int pending[LANE_COUNT];
+	for (int i = 0; i < LANE_COUNT; i++) {
+		pending[i] = (int)(__atomic_load_n(&set->lanes[i].tail, __ATOMIC_SEQ_CST) - set->lanes[i].head);
+	}
+	return lane_policy_batch(pending, max, set->weight, &set->credit, order);
+}
+
+lane_datagram_t *lanes_peek(lane_set_t *set, int lane) {
+	lane_t *chosen = &set->lanes[lane];
+	return &chosen->queue[chosen->head & (LANE_QUEUE_SIZE - 1)];
+}
+
+void lanes_release(lane_set_t *set, int lane_index, uint64_t dequeue_ns, uint64_t done_ns) {
+	lane_t *lane = &set->lanes[lane_index];
+	const lane_datagram_t *datagram = &lane->queue[lane->head & (LANE_QUEUE_SIZE - 1)];
+
+	uint64_t wait_ns = dequeue_ns - datagram->receive_ns;
+	uint64_t latency_ns = done_ns - datagram->receive_ns;
+	lane->served++;
+	lane->wait_ns_total += wait_ns;
+	if (wait_ns > lane->wait_ns_max) {
+		lane->wait_ns_max = wait_ns;
+	}
+	lane->latency[latency_bucket(latency_ns)]++;
+	if (latency_ns > lane->latency_ns_max) {
+		lane->latency_ns_max = latency_ns;
+	}
+
+	__atomic_store_n(&lane->head, lane->head + 1, __ATOMIC_SEQ_CST);
+}
+
+void lanes_clear_wake(lane_set_t *set) {
+	uint64_t value;
+	if (set->enabled && read(set->wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+		fprintf(stderr, "Errore: lettura dell'eventfd delle corsie fallita.\n");
+	}
+}
+
+/* Limite superiore del bucket che contiene il percentile */
+static double latency_percentile_us(const lane_t *lane, double percentile) {
+	uint64_t target = (uint64_t)(lane->served * percentile);
+	uint64_t seen = 0;
+	for (int i = 0; i < LANE_LATENCY_BUCKETS; i++) {
+		seen += lane->latency[i];
+		if (seen > target) {
+			double bound = (double)(1ull << (i + 1)) / 1e3;
+			return bound < lane->latency_ns_max / 1e3 ? bound : lane->latency_ns_max / 1e3;
+		}
+	}
+	return lane->latency_ns_max / 1e3;
+}
+
+void lanes_print_stats(const lane_set_t *set) {
+	if (!set->enabled) {
+		return;
+	}
+	printf("Corsie (%s", set->weight == LANE_POLICY_STRICT ? "priorità stretta" : "priorità pesata");
+	if (set->weight != LANE_POLICY_STRICT) {
+		printf(", %d:1", set->weight);
+	}
+	printf("):\n");
+	for (int i = 0; i < LANE_COUNT; i++) {
+		const lane_t *lane = &set->lanes[i];
+		printf("  %-11s porta %5d: ricevuti %llu, scartati %llu, serviti %llu",
+		       lane->name, lane->port,
+		       (unsigned long long)__atomic_load_n(&lane->received, __ATOMIC_RELAXED),
+		       (unsigned long long)__atomic_load_n(&lane->dropped, __ATOMIC_RELAXED),
+		       (unsigned long long)lane->served);
+		if (lane->served > 0) {
+			printf(", attesa in coda media %.1f us (max %.1f us), latenza p50 <%.1f us, p99 <%.1f us, max %.1f us",
+			       lane->wait_ns_total / (double)lane->served / 1e3, lane->wait_ns_max / 1e3,
+			       latency_percentile_us(lane, 0.50), latency_percentile_us(lane, 0.99),
+			       lane->latency_ns_max / 1e3);
+		}
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+void lanes_stop(lane_set_t *set) {
+	if (!set) {
+		return;
+	}
+	lanes_pause(set);
+	for (int i = 0; i < LANE_COUNT; i++) {
+		lane_t *lane = &set->lanes[i];
+		free(lane->queue);
+		lane->queue = NULL;
+	}
+	if (set->lanes[LANE_PRIORITY].sock >= 0) {
+		close(set->lanes[LANE_PRIORITY].sock);
+		set->lanes[LANE_PRIORITY].sock = -1;
+	}
+	if (set->wake_fd >= 0) {
+		close(set->wake_fd);
+		set->wake_fd = -1;
+	}
+	set->enabled = 0;
+}
+
+#else /* !__linux__ */
+
+int lanes_start(lane_set_t *set, int bulk_sock, int priority_sock, int priority_port, int bulk_rcvbuf,
+                int priority_rcvbuf, int weight) {
+	(void)bulk_sock; (void)priority_sock; (void)priority_port; (void)bulk_rcvbuf; (void)priority_rcvbuf;
+	(void)weight;
+	if (set) {
+		memset(set, 0, sizeof(*set));
+		set->wake_fd = -1;
+	}
+	fprintf(stderr, "Errore: corsie di priorità disponibili solo su Linux.\n");
+	return -1;
+}
+
+int lanes_pending(lane_set_t *set) {
+	(void)set;
+	return 0;
+}
+
+int lanes_take_batch(lane_set_t *set, int *order, int max) {
+	(void)set; (void)order; (void)max;
+	return 0;
+}
+
+lane_datagram_t *lanes_peek(lane_set_t *set, int lane) {
+	(void)set; (void)lane;
+	return NULL;
+}
+
+void lanes_release(lane_set_t *set, int lane, uint64_t dequeue_ns, uint64_t done_ns) {
+	(void)set; (void)lane; (void)dequeue_ns; (void)done_ns;
+}
+
+void lanes_clear_wake(lane_set_t *set) {
+	(void)set;
+}
+
+void lanes_print_stats(const lane_set_t *set) {
+	(void)set;
+}
+
+void lanes_pause(lane_set_t *set) {
+	(void)set;
+}
+
+int lanes_resume(lane_set_t *set) {
+	(void)set;
+	return -1;
+}
+
+void lanes_stop(lane_set_t *set) {
+	(void)set;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,169 @@
+/*
+ * lanes.h
+ *
+ * Corsie di priorità: una porta prioritaria (-P) accanto a quella normale
+ * Ogni corsia ha il proprio socket, con buffer di ricezione dimensionato a
+ * parte, e un thread dedicato che riceve i datagrammi e li accoda in un
+ * ring SPSC con l'istante di arrivo. Il thread principale resta l'unico
+ * proprietario dello stato del server: preleva i datagrammi dalle corsie
+ * secondo la politica scelta e li serve come prima.
+ *  - stretta: la corsia prioritaria è sempre servita per prima
+ *  - pesata (-W N): fino a N datagrammi prioritari per ogni datagramma
+ *    normale, così il traffico normale non resta mai fermo
+ * Con il traffico normale in sovraccarico si riempiono (e scartano) solo il
+ * suo buffer e la sua coda: la latenza della corsia prioritaria non cambia.
+ *
+ * Risveglio del thread principale: un eventfd scritto dal thread di una
+ * corsia quando accoda in un ring vuoto, sorgente del reactor epoll del loop.
+ *
+ * Disponibile solo su Linux.
+ */
+
+#ifndef LANES_H_
+#define LANES_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#if defined __linux__
+#include <pthread.h>
+#endif
+
+#include <stdint.h>
+#include "protocol.h"
+#include "endpoints.h"
+#include "lane_policy.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define LANE_QUEUE_SIZE 4096            // Datagrammi in coda per corsia (potenza di 2)
+#define LANE_BATCH 64                   // Datagrammi serviti per giro del loop principale
+#define LANE_DEFAULT_RCVBUF (1 << 20)   // SO_RCVBUF di default per corsia
+#define LANE_LATENCY_BUCKETS 48         // Istogramma delle latenze: potenze di due di ns
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	uint64_t receive_ns;            // Istante di arrivo (get_monotonic_ns, nel thread della corsia)
+	endpoint_addr_t addr;
+	uint16_t addr_len;
+	uint16_t length;
+	uint8_t data[BUFFER_SIZE];
+} lane_datagram_t;
+
+typedef struct {
+	int sock;
+	int port;
+	const char *name;
+#if defined __linux__
+	pthread_t thread;
+#endif
+	int thread_started;
+	int wake_fd;                    // Copie da lane_set_t per il thread della corsia
+	const int *running;
+
+	// Ring SPSC: tail scritto dal thread della corsia, head dal thread principale
+	lane_datagram_t *queue;
+	uint32_t head;
+	uint32_t tail;
+
+	// Statistiche del thread della corsia (lette con __atomic_load_n)
+	uint64_t received;
+	uint64_t dropped;               // Coda piena: scartati senza essere serviti
+
+	// Statistiche del thread principale
+	uint64_t served;
+	uint64_t wait_ns_total;         // Arrivo -> prelievo dalla coda
+	uint64_t wait_ns_max;
+	uint64_t latency[LANE_LATENCY_BUCKETS]; // Arrivo -> risposta inviata
+	uint64_t latency_ns_max;
+} lane_t;
+
+typedef struct {
+	int enabled;
+	lane_t lanes[LANE_COUNT];
+	int wake_fd;                    // eventfd: le corsie svegliano il thread principale
+	int weight;                     // 0 = stretta, N = pesata
+	int credit;                     // Prioritari serviti con un normale in attesa (0..weight)
+	int running;
+} lane_set_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Avvia le corsie: bulk_sock è il socket già aperto della porta normale,
+ * priority_sock quello della porta prioritaria se ereditato (handoff.h),
+ * altrimenti -1 e la porta prioritaria viene aperta qui, sullo stesso
+ * indirizzo; rcvbuf in byte (0 = default)
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int lanes_start(lane_set_t *set, int bulk_sock, int priority_sock, int priority_port, int bulk_rcvbuf,
+                int priority_rcvbuf, int weight);
+
+/*
+ * 1 se almeno una corsia ha datagrammi in coda
+ */
+int lanes_pending(lane_set_t *set);
+
+/*
+ * Prossimo lotto secondo la politica (lane_policy_batch), al più max
+ * datagrammi tra quelli già in coda: order riceve la corsia di ciascuno
+ * Ritorna quanti; ognuno si legge con lanes_peek() e si libera con lanes_release()
+ */
+int lanes_take_batch(lane_set_t *set, int *order, int max);
+
+/*
+ * Primo datagramma in coda sulla corsia lane, valido fino a lanes_release()
+ */
+lane_datagram_t *lanes_peek(lane_set_t *set, int lane);
+
+/*
+ * Libera il datagramma prelevato e aggiorna le statistiche della corsia
+ * (done_ns: istante in cui la risposta è stata inviata)
+ */
+void lanes_release(lane_set_t *set, int lane, uint64_t dequeue_ns, uint64_t done_ns);
+
+/*
+ * Azzera l'eventfd dopo il risveglio
+ */
+void lanes_clear_wake(lane_set_t *set);
+
+/*
+ * Stampa le statistiche per corsia
+ */
+void lanes_print_stats(const lane_set_t *set);
+
+/*
+ * Ferma i thread delle corsie senza toccare code e socket: i datagrammi già
+ * accodati restano da servire, i nuovi restano nel buffer del kernel
+ */
+void lanes_pause(lane_set_t *set);
+
+/*
+ * Riavvia i thread fermati con lanes_pause()
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int lanes_resume(lane_set_t *set);
+
+/*
+ * Ferma i thread, chiude il socket prioritario e libera le code
+ * (il socket normale resta al chiamante)
+ */
+void lanes_stop(lane_set_t *set);
+
+#endif /* LANES_H_ */
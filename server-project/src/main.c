@@ -16,6 +16,7 @@ typedef int socklen_t;
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <sys/select.h>
 #define closesocket close
 #endif
 
@@ -24,7 +25,24 @@ typedef int socklen_t;
 #include <ctype.h>
 #include <time.h>
 #include <string.h>
+#include <signal.h>
 #include "protocol.h"
+#include "subscription.h"
+#include "publisher.h"
+#include "shm_transport.h"
+#include "history.h"
+#include "simulation.h"
+#include "catalogue.h"
+#include "spatial.h"
+#include "suggest.h"
+#include "access_log.h"
+#include "capture.h"
+#include "lanes.h"
+#include "endpoints.h"
+#include "reactor.h"
+#include "handoff.h"
+#include "xdp_filter.h"
+#include "service.h"
 
 
 void clearwinsock() {
@@ -33,207 +51,500 @@ void clearwinsock() {
 #endif
 }
 
-// Stampa un messaggio di errore su stream per errori
-void print_error(const char* Messaggio_di_errore){
-	fprintf(stderr, "%s", Messaggio_di_errore);
-}
 /*
- * Generazione numeri casuali e dati meteo
+ * Generazione numeri casuali (seme della simulazione)
  */
 void initialize_random_generator(void) {
 	srand((unsigned int)time(NULL));
 }
 
-static float generate_random_float(float min_val, float max_val) {
-	float random_fraction = (float)rand() / (float)RAND_MAX;
-	return min_val + random_fraction * (max_val - min_val);
-}
+/* Stato della simulazione, letto dal servizio a ogni richiesta */
+static simulation_t simulation;
+
+/* Storico dei valori generati (query aggregate); capacità 0 = disattivato */
+static history_t history;
 
-float get_temperature(void) {
-	return generate_random_float(-10.0f, 40.0f);
+/*
+ * Orologio monotono
+ */
+uint64_t get_monotonic_ms(void) {
+#if defined WIN32
+	return (uint64_t)GetTickCount64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000u + (uint64_t)(ts.tv_nsec / 1000000);
+#endif
 }
 
-float get_humidity(void) {
-	return generate_random_float(20.0f, 100.0f);
+uint64_t get_monotonic_ns(void) {
+#if defined WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
 }
 
-float get_wind(void) {
-	return generate_random_float(0.0f, 100.0f);
+/* Catalogo delle città e indici (le città supportate sono in service.c) */
+static city_catalogue_t catalogue;
+static spatial_index_t spatial_index;
+static suggest_index_t suggest_index;
+
+/* Azzerato da Ctrl+C (SIGINT) o SIGTERM: il server esce dal loop e libera le risorse */
+static volatile sig_atomic_t server_running = 1;
+
+static void handle_termination(int signum) {
+	(void)signum;
+	server_running = 0;
 }
 
-float get_pressure(void) {
-	return generate_random_float(950.0f, 1050.0f);
+/* Statistiche delle corsie richieste con SIGUSR1 (stampate dal loop principale) */
+static volatile sig_atomic_t stats_requested = 0;
+
+static void handle_stats_request(int signum) {
+	(void)signum;
+	stats_requested = 1;
 }
 
+/* Corsie di priorità (-P); disattivate se non avviate */
+static lane_set_t lanes;
+
+/* Modalità silenziosa (-q): nessun log per richiesta e nessun reverse lookup */
+static int quiet_mode = 0;
+
+/* Log binario degli accessi (-a); disattivato se non aperto */
+static access_log_t access_log;
+
+/* Elaborazione delle richieste (service.c) sui socket del server */
+static service_t service;
+static transport_socket_t socket_transport; // Stato GSO del trasporto sui socket, condiviso da push e snapshot
+
 /*
- * Validazione città
+ * Serve le richieste accodate in memoria condivisa (al più un ring per chiamata)
+ * Ritorna 1 se ne restano altre da servire
  */
-static int compare_case_insensitive(const char *str1, const char *str2) {
-	while (*str1 && *str2) {
-		if (tolower((unsigned char)*str1) != tolower((unsigned char)*str2)) {
+static int serve_shm_requests(shm_server_t *shm_server) {
+	if (!shm_server->segment) {
+		return 0;
+	}
+
+	uint8_t payload[REQUEST_SIZE];
+	uint8_t send_buffer[RESPONSE_SIZE];
+	uint32_t client_slot;
+	uint32_t tag;
+
+	for (int served = 0; served < SHM_REQUEST_RING; served++) {
+		if (!shm_server_poll(shm_server, payload, &client_slot, &tag)) {
 			return 0;
 		}
-		str1++;
-		str2++;
+		uint64_t receive_ns = access_log.enabled ? get_monotonic_ns() : 0;
+		access_record_t record;
+		memset(&record, 0, sizeof(record));
+		record.kind = ACCESS_KIND_SHM;
+
+		// Client locale: nessuna risoluzione DNS
+		if (service_handle_payload(&service, payload, 0, "localhost", "shm", send_buffer, &record) ==
+		    (int)RESPONSE_SIZE) {
+			shm_server_respond(shm_server, client_slot, tag, send_buffer);
+			service_log_access(&service, &record, NULL, receive_ns);
+		}
 	}
-	return *str1 == '\0' && *str2 == '\0';
+	return 1;
 }
 
-static int check_city_availability(const char *city_name) {
-	const char *supported_cities[] = {
-		"Bari", "Roma", "Milano", "Napoli", "Torino",
-		"Palermo", "Genova", "Bologna", "Firenze", "Venezia"
-	};
+/*
+ * ============================================================================
+ * LOOP DEGLI EVENTI
+ * ============================================================================
+ * Stato condiviso con le callback del reactor (un solo thread)
+ */
 
-	const int total_cities = (int)(sizeof(supported_cities) / sizeof(supported_cities[0]));
+static reactor_t reactor;
+static endpoint_t endpoints[ENDPOINT_MAX];
+static int endpoint_count = 0;
+static endpoint_batch_t endpoint_batch;     // Lotto riusato da tutti i socket
+static subscription_table_t subscriptions;
+static capture_writer_t capture;
+static shm_server_t shm_server;
+static int shm_pending = 0;                 // Ring shm non svuotato nell'ultimo giro
+static xdp_filter_t xdp_filter;
+static publisher_t publisher;
+static uint64_t server_start_ms;
+
+static void print_xdp_stats(void) {
+	xdp_counters_t counters;
+	if (xdp_filter_read(&xdp_filter, &counters) == 0) {
+		printf("XDP su %s: passati %llu, scartati per dimensione %llu, scartati per frequenza %llu\n",
+		       xdp_filter.ifname, (unsigned long long)counters.passed, (unsigned long long)counters.dropped_size,
+		       (unsigned long long)counters.dropped_rate);
+	}
+}
 
-	for (int i = 0; i < total_cities; i++) {
-		if (compare_case_insensitive(city_name, supported_cities[i])) {
-			return 1;
-		}
+static void close_endpoints(void) {
+	for (int i = 0; i < endpoint_count; i++) {
+		endpoint_close(&endpoints[i]);
 	}
-	return 0;
+	endpoint_count = 0;
 }
 
 /*
- * Validazione richiesta lato server
+ * Socket di servizio pronto: un lotto di datagrammi, serviti in ordine
  */
-int validate_request_server(const weather_request_t *request) {
-	if (!request) {
-		return STATUS_INVALID_REQUEST;
-	}
+static int handed_off = 0;                  // Socket ceduti a un successore: nessuna nuova lettura
 
-	// Validazione tipo
-	if (request->type != TYPE_TEMPERATURE &&
-	    request->type != TYPE_HUMIDITY &&
-	    request->type != TYPE_WIND &&
-	    request->type != TYPE_PRESSURE) {
-		return STATUS_INVALID_REQUEST;
+static void on_endpoint_ready(void *context) {
+	endpoint_t *endpoint = (endpoint_t *)context;
+	if (handed_off) {
+		return;
 	}
+	int count = endpoint_receive(endpoint, &endpoint_batch);
+
+	// Arrivati tutti prima della lettura: un solo istante di ricezione per il lotto,
+	// tranne con la cattura, che ha l'istante di arrivo di ogni datagramma dal kernel
+	uint64_t batch_ns = count > 0 && access_log.enabled && !endpoint->timestamps ? get_monotonic_ns() : 0;
+	for (int i = 0; i < count; i++) {
+		const endpoint_addr_t *client_addr = &endpoint_batch.addr[i];
+		uint64_t receive_ns = endpoint->timestamps ? endpoint_batch.receive_ns[i] : batch_ns;
+
+		// CATTURA: ogni datagramma ricevuto, anche se non valido, così com'è arrivato
+		if (capture.file) {
+			capture_write(&capture, receive_ns, endpoint_addr_capture_key(client_addr),
+			              endpoint_addr_port(client_addr), endpoint_batch.data[i], endpoint_batch.length[i]);
+		}
+		service_handle_datagram(&service, endpoint->sock, endpoint_batch.data[i], endpoint_batch.length[i],
+		                        client_addr, endpoint_batch.addr_len[i], receive_ns);
+	}
+}
 
-	// Validazione città: verifica assenza caratteri tab e speciali
-	const char *city_ptr = request->city;
-
-	while (*city_ptr) {
-		// TAB → errore
-		if (*city_ptr == '\t') {
-			return STATUS_INVALID_REQUEST;
+/*
+ * Comando testuale sulla porta di amministrazione, risposta sullo stesso socket
+ */
+static void handle_admin_command(int sock, const uint8_t *data, int length, const endpoint_addr_t *client_addr,
+                                 int client_addr_len) {
+	char command[32];
+	int command_len = length < (int)sizeof(command) - 1 ? length : (int)sizeof(command) - 1;
+	memcpy(command, data, (size_t)command_len);
+	while (command_len > 0 && isspace((unsigned char)command[command_len - 1])) {
+		command_len--;
+	}
+	command[command_len] = '\0';
+
+	char reply[BUFFER_SIZE * 2];
+	int used = 0;
+	if (strcmp(command, "ping") == 0) {
+		used = snprintf(reply, sizeof(reply), "pong\n");
+	} else if (strcmp(command, "stats") == 0) {
+		used += snprintf(reply + used, sizeof(reply) - (size_t)used, "attivo_s %llu\n",
+		                 (unsigned long long)((get_monotonic_ms() - server_start_ms) / 1000));
+		for (int i = 0; i < endpoint_count && used < (int)sizeof(reply); i++) {
+			used += snprintf(reply + used, sizeof(reply) - (size_t)used,
+			                 "socket %s %s ricevuti %llu lotti %llu lotto_max %llu\n", endpoints[i].name,
+			                 endpoints[i].kind == ENDPOINT_KIND_ADMIN ? "admin" : "servizio",
+			                 (unsigned long long)endpoints[i].received, (unsigned long long)endpoints[i].batches,
+			                 (unsigned long long)endpoints[i].batch_max);
 		}
-		// Numeri → AMMESSI
-		if (isdigit((unsigned char)*city_ptr)) {
-			city_ptr++;
-			continue;
+		for (int i = 0; lanes.enabled && i < LANE_COUNT && used < (int)sizeof(reply); i++) {
+			const lane_t *lane = &lanes.lanes[i];
+			used += snprintf(reply + used, sizeof(reply) - (size_t)used,
+			                 "corsia %s ricevuti %llu scartati %llu serviti %llu\n", lane->name,
+			                 (unsigned long long)__atomic_load_n(&lane->received, __ATOMIC_RELAXED),
+			                 (unsigned long long)__atomic_load_n(&lane->dropped, __ATOMIC_RELAXED),
+			                 (unsigned long long)lane->served);
 		}
-		// Lettere → ammesse
-		if (isalpha((unsigned char)*city_ptr)) {
-			city_ptr++;
-		    continue;
+		xdp_counters_t counters;
+		if (used < (int)sizeof(reply) && xdp_filter_read(&xdp_filter, &counters) == 0) {
+			used += snprintf(reply + used, sizeof(reply) - (size_t)used,
+			                 "xdp %s passati %llu scartati_dimensione %llu scartati_frequenza %llu\n",
+			                 xdp_filter.ifname, (unsigned long long)counters.passed,
+			                 (unsigned long long)counters.dropped_size, (unsigned long long)counters.dropped_rate);
 		}
-
-		// Spazi → ammessi (anche multipli)
-		if (*city_ptr == ' ') {
-		city_ptr++;
-		continue;
+		if (used < (int)sizeof(reply)) {
+			used += snprintf(reply + used, sizeof(reply) - (size_t)used,
+			                 "loop attese %llu pronti %llu\n"
+			                 "sottoscrizioni %d push %llu lease_scaduti %llu\n",
+			                 (unsigned long long)reactor.waits, (unsigned long long)reactor.ready_events,
+			                 subscriptions.count, (unsigned long long)subscriptions.pushes_sent,
+			                 (unsigned long long)subscriptions.leases_expired);
 		}
-
-		// Se arriva qui → carattere speciale → ERRORE
-		return STATUS_INVALID_REQUEST;
-
+		if (used < (int)sizeof(reply) && publisher.sock >= 0) {
+			used += snprintf(reply + used, sizeof(reply) - (size_t)used,
+			                 "snapshot pubblicati %llu datagrammi %llu rifiutati %llu\n",
+			                 (unsigned long long)publisher.snapshots_sent,
+			                 (unsigned long long)publisher.datagrams_sent,
+			                 (unsigned long long)publisher.snapshots_rejected);
+		}
+	} else {
+		used = snprintf(reply, sizeof(reply), "errore: comando sconosciuto '%s' (stats, ping)\n", command);
+	}
+	if (used > (int)sizeof(reply) - 1) {
+		used = (int)sizeof(reply) - 1; // Risposta troncata
 	}
 
-	// Verifica disponibilità città
-	if (!check_city_availability(request->city)) {
-		return STATUS_CITY_NOT_FOUND;
+	if (sendto(sock, reply, used, 0, &client_addr->sa, client_addr_len) != used) {
+		print_error("Errore: sendto() fallita.\n");
 	}
+}
 
-	return STATUS_SUCCESS;
+static void on_admin_ready(void *context) {
+	endpoint_t *endpoint = (endpoint_t *)context;
+	int count = endpoint_receive(endpoint, &endpoint_batch);
+	for (int i = 0; i < count; i++) {
+		handle_admin_command(endpoint->sock, endpoint_batch.data[i], endpoint_batch.length[i],
+		                     &endpoint_batch.addr[i], endpoint_batch.addr_len[i]);
+	}
 }
 
 /*
- * Deserializzazione richiesta
+ * Timer del reactor: adattatori verso i moduli esistenti
  */
-int deserialize_request(const uint8_t *buffer, weather_request_t *request) {
-	if (!buffer || !request) {
-		return -1;
+static int simulation_timeout_hook(void *context, uint64_t now_ms) {
+	return simulation_next_timeout_ms(((service_t *)context)->simulation, now_ms);
+}
+
+static void simulation_advance_hook(void *context, uint64_t now_ms) {
+	service_advance((service_t *)context, now_ms);
+}
+
+static int subscription_timeout_hook(void *context, uint64_t now_ms) {
+	return subscription_next_timeout_ms((const subscription_table_t *)context, now_ms);
+}
+
+static void subscription_advance_hook(void *context, uint64_t now_ms) {
+	subscription_advance((subscription_table_t *)context, now_ms);
+}
+
+static int publisher_timeout_hook(void *context, uint64_t now_ms) {
+	return publisher_next_timeout_ms((publisher_t *)context, now_ms);
+}
+
+static void publisher_advance_hook(void *context, uint64_t now_ms) {
+	publisher_advance((publisher_t *)context, now_ms);
+}
+
+static void access_log_hook(void *context, uint64_t now_ms) {
+	(void)now_ms;
+	access_log_maintain((access_log_t *)context);
+}
+
+static void stats_hook(void *context, uint64_t now_ms) {
+	(void)context;
+	(void)now_ms;
+	if (stats_requested) {
+		stats_requested = 0;
+		lanes_print_stats(&lanes);
+		print_xdp_stats();
 	}
+}
 
-	int offset = 0;
+/* Memoria condivisa: con richieste in coda nessuna attesa, altrimenti si dorme sul campanello */
+static int shm_timeout_hook(void *context, uint64_t now_ms) {
+	(void)context;
+	(void)now_ms;
+	return shm_pending || shm_server_prepare_sleep(&shm_server) ? 0 : -1;
+}
 
-	// Campo type: 1 byte
-	request->type = (char)buffer[offset];
-	offset += 1;
+static void shm_advance_hook(void *context, uint64_t now_ms) {
+	(void)context;
+	(void)now_ms;
+	shm_server_wake(&shm_server);
+	shm_pending = serve_shm_requests(&shm_server);
+}
 
-	// Campo city: 64 byte
-	memcpy(request->city, buffer + offset, 64);
-	request->city[63] = '\0'; // Assicura null-termination
-	offset += 64;
+/* Corsie: un lotto per giro, così i timer restano puntuali */
+static int lanes_timeout_hook(void *context, uint64_t now_ms) {
+	(void)context;
+	(void)now_ms;
+	return lanes_pending(&lanes) ? 0 : -1;
+}
+
+static void lanes_advance_hook(void *context, uint64_t now_ms) {
+	(void)context;
+	(void)now_ms;
+	int order[LANE_BATCH];
+	int count = lanes_take_batch(&lanes, order, LANE_BATCH);
+	for (int served = 0; served < count; served++) {
+		int lane = order[served];
+		lane_datagram_t *datagram = lanes_peek(&lanes, lane);
+		uint64_t dequeue_ns = get_monotonic_ns();
+		if (capture.file) {
+			capture_write(&capture, datagram->receive_ns, endpoint_addr_capture_key(&datagram->addr),
+			              endpoint_addr_port(&datagram->addr), datagram->data, datagram->length);
+		}
+		service_handle_datagram(&service, lanes.lanes[lane].sock, datagram->data, datagram->length,
+		                        &datagram->addr, datagram->addr_len, datagram->receive_ns);
+		lanes_release(&lanes, lane, dequeue_ns, get_monotonic_ns());
+	}
+}
 
-	return 0;
+/* Dopo i timer: un accodamento arrivato nel frattempo resta visibile a lanes_timeout_hook */
+static void on_lanes_wake(void *context) {
+	(void)context;
+	lanes_clear_wake(&lanes);
 }
 
 /*
- * Serializzazione risposta
+ * ============================================================================
+ * PASSAGGIO DI CONSEGNE (riavvio senza perdite)
+ * ============================================================================
  */
-int serialize_response(const weather_response_t *response, uint8_t *buffer) {
-	if (!response || !buffer) {
-		return -1;
-	}
 
-	int offset = 0;
+static int handoff_listen_fd = -1;
+static int xdp_inherited_link = -1;         // Collegamento XDP del predecessore, aggiornato da -X
 
-	// Campo status: 4 byte uint32_t - CONVERSIONE in network byte order
-	uint32_t net_status = htonl(response->status);
-	memcpy(buffer + offset, &net_status, sizeof(uint32_t));
-	offset += sizeof(uint32_t);
+/*
+ * Un successore chiede i socket: si finisce il lavoro in corso, si cedono
+ * socket e stato caldo e il loop termina
+ */
+static void on_handoff_ready(void *context) {
+	(void)context;
+	uint32_t flags = 0;
+	int peer_pid = 0;
+	int conn = handoff_accept(handoff_listen_fd, &flags, &peer_pid);
+	if (conn < 0) {
+		return;
+	}
 
-	// Campo type: 1 byte - nessuna conversione
-	buffer[offset] = (uint8_t)response->type;
-	offset += 1;
+	// LAVORO IN CORSO: le corsie smettono di leggere, poi si servono le code e il ring shm
+	// (i datagrammi nuovi restano nel buffer del kernel, per il successore)
+	if (lanes.enabled) {
+		lanes_pause(&lanes);
+		while (lanes_pending(&lanes)) {
+			lanes_advance_hook(NULL, 0);
+		}
+	}
+	while (serve_shm_requests(&shm_server)) {
+	}
 
-	// Campo value: 4 byte float - CONVERSIONE in network byte order
-	// Tecnica: float -> uint32_t -> htonl() -> buffer
-	uint32_t bits;
-	memcpy(&bits, &response->value, sizeof(float));
-	uint32_t net_bits = htonl(bits);
-	memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
-	offset += sizeof(uint32_t);
+	// DESCRITTORI: socket in ascolto nell'ordine attuale, porta prioritaria, stato caldo
+	handoff_set_t set;
+	memset(&set, 0, sizeof(set));
+	for (int i = 0; i < endpoint_count; i++) {
+		set.fds[set.count] = endpoints[i].sock;
+		set.kinds[set.count++] = (uint8_t)endpoints[i].kind;
+	}
+	if (lanes.enabled) {
+		set.fds[set.count] = lanes.lanes[LANE_PRIORITY].sock;
+		set.kinds[set.count++] = HANDOFF_FD_PRIORITY;
+	}
+	if (xdp_filter.enabled) {
+		set.fds[set.count] = xdp_filter.link_fd;
+		set.kinds[set.count++] = HANDOFF_FD_XDP_LINK;
+	}
+	if ((flags & HANDOFF_WANT_STATE) && handoff_add_state(&set, &simulation, &history, &subscriptions) != 0) {
+		fprintf(stderr, "Attenzione: stato caldo non disponibile, il successore parte a freddo.\n");
+	}
 
-	return offset; // Ritorna 9 byte
+	if (handoff_send(conn, &set) != 0) {
+		fprintf(stderr, "Errore: passaggio di consegne al processo %d fallito, il server resta attivo.\n", peer_pid);
+		if (lanes.enabled && lanes_resume(&lanes) != 0) {
+			server_running = 0;
+		}
+		return;
+	}
+	printf("Passaggio di consegne: socket ceduti al processo %d%s\n", peer_pid,
+	       (flags & HANDOFF_WANT_STATE) ? " con lo stato caldo" : "");
+	handed_off = 1;
+	server_running = 0;
 }
 
 /*
- * Risoluzione indirizzo client (reverse lookup)
+ * Socket in ascolto ereditati dal server in esecuzione su handoff_path
+ * *priority_sock riceve la porta prioritaria se coincide con priority_port
+ * Con want_xdp_link si tiene il collegamento XDP, altrimenti il filtro si stacca
+ * all'uscita del predecessore
+ * Ritorna 1 se i socket sono stati ereditati, 0 se non c'è un predecessore
  */
-int resolve_client_address(struct in_addr *addr, char *hostname_out,
-                           size_t hostname_size, char *ip_out, size_t ip_size) {
-	if (!addr || !hostname_out || !ip_out) {
-		return -1;
+static int inherit_endpoints(const char *handoff_path, int want_state, int want_xdp_link, int priority_port,
+                             int *priority_sock) {
+	*priority_sock = -1;
+	int conn = handoff_connect(handoff_path);
+	if (conn < 0) {
+		return 0;
 	}
 
-	// IP come stringa
-	char *ip_str = inet_ntoa(*addr);
-	strncpy(ip_out, ip_str, ip_size - 1);
-	ip_out[ip_size - 1] = '\0';
-
-	// Reverse lookup: IP -> hostname
-	struct hostent *host = gethostbyaddr((char *)addr, sizeof(struct in_addr), AF_INET);
+	handoff_set_t set;
+	if (handoff_request(conn, want_state ? HANDOFF_WANT_STATE : 0, &set) != 0) {
+		return 0; // Il predecessore ha tenuto i socket (bind fallirà) oppure è già terminato
+	}
 
-	if (!host) {
-		// Fallback: usa IP come hostname
-		strncpy(hostname_out, ip_str, hostname_size - 1);
-		hostname_out[hostname_size - 1] = '\0';
-	} else {
-		strncpy(hostname_out, host->h_name, hostname_size - 1);
-		hostname_out[hostname_size - 1] = '\0';
+	// ADOZIONE: socket di servizio e di amministrazione, porta prioritaria se richiesta
+	int new_socks[HANDOFF_MAX_FDS];
+	int unused_priority_port = 0;
+	for (int i = 0; i < set.count; i++) {
+		new_socks[i] = -1;
+		int kind = set.kinds[i];
+		if ((kind == HANDOFF_FD_SERVICE || kind == HANDOFF_FD_ADMIN) && endpoint_count < ENDPOINT_MAX &&
+		    endpoint_adopt(&endpoints[endpoint_count], set.fds[i], kind) == 0) {
+			new_socks[i] = set.fds[i];
+			set.fds[i] = -1;
+			endpoint_count++;
+		} else if (kind == HANDOFF_FD_PRIORITY) {
+			endpoint_t priority;
+			int port = endpoint_adopt(&priority, set.fds[i], kind) == 0 ? ntohs(endpoint_addr_port(&priority.addr)) : 0;
+			if (port == priority_port) {
+				new_socks[i] = set.fds[i];
+				*priority_sock = set.fds[i];
+				set.fds[i] = -1;
+			} else {
+				unused_priority_port = port;
+			}
+		} else if (kind == HANDOFF_FD_XDP_LINK && want_xdp_link && xdp_inherited_link < 0) {
+			xdp_inherited_link = set.fds[i];
+			set.fds[i] = -1;
+		}
 	}
 
-	return 0;
+	handoff_summary_t summary;
+	if (handoff_import_state(&set, new_socks, &simulation, &history, &subscriptions, &summary) == 0 && want_state) {
+		printf("Stato caldo: simulazione %s, storico %s, %d sottoscrizioni riprese (%d scartate)\n",
+		       summary.simulation ? "ripresa" : "nuova", summary.history ? "ripreso" : "vuoto",
+		       summary.subscriptions, summary.subscriptions_dropped);
+	}
+	handoff_set_close(&set); // Descrittori non adottati
+	if (unused_priority_port > 0) {
+		fprintf(stderr, "Attenzione: porta prioritaria %d del server precedente chiusa (manca -P %d)\n",
+		        unused_priority_port, unused_priority_port);
+	}
+	printf("Passaggio di consegne: %d socket ereditati da %s\n", endpoint_count, handoff_path);
+	return 1;
 }
 
 int main(int argc, char *argv[]) {
 
 	// Porta di default
 	int listen_port = SERVER_PORT;
+	int max_subscribers = SUBSCRIPTION_DEFAULT_CAPACITY;
+
+	// Pubblicazione multicast (disattivata di default)
+	char snapshot_group[32] = "";
+	int snapshot_port = SNAPSHOT_PORT;
+	int snapshot_rate = 1;
+	const char *snapshot_interface = NULL;
+
+	int shm_enabled = 0;
+	int history_capacity = HISTORY_DEFAULT_CAPACITY;
+	int simulated_cities = 0;        // 0: solo le città supportate
+	double time_scale = SIM_DEFAULT_TIME_SCALE;
+	const char *catalogue_path = NULL;
+	const char *access_log_prefix = NULL;
+	const char *capture_path = NULL;
+	int priority_port = 0;           // > 0: corsia prioritaria su questa porta (-P)
+	int bulk_rcvbuf = 0;             // SO_RCVBUF della porta normale (0 = default del sistema)
+	int priority_rcvbuf = 0;         // SO_RCVBUF della porta prioritaria (0 = LANE_DEFAULT_RCVBUF)
+	int lane_weight = LANE_POLICY_STRICT;
+	int access_log_records = ACCESS_LOG_DEFAULT_RECORDS;
+	const char *listen_specs[ENDPOINT_MAX]; // Indirizzi in ascolto (-l), default SERVER_IP:porta
+	int listen_spec_count = 0;
+	const char *admin_spec = NULL;   // Porta di amministrazione (-A)
+	const char *handoff_path = NULL; // Socket Unix del passaggio di consegne (-U)
+	int want_state = 0;              // Riprende lo stato caldo dal predecessore (-K)
+	char xdp_ifname[XDP_IFNAME_SIZE] = ""; // Filtro XDP su questa interfaccia (-X)
+	long xdp_rate = XDP_DEFAULT_RATE;
 
 	// PARSING ARGOMENTI
 	for (int i = 1; i < argc; i++) {
@@ -249,6 +560,268 @@ int main(int argc, char *argv[]) {
 			fprintf(stderr, "Errore: manca il valore per -p\n");
 			return 1;
 		}
+
+		if (strcmp(argv[i], "-n") == 0) {
+			if (i + 1 < argc) {
+				max_subscribers = atoi(argv[++i]);
+				if (max_subscribers <= 0) {
+					fprintf(stderr, "Errore: numero massimo di sottoscrittori non valido %d\n", max_subscribers);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -n\n");
+			return 1;
+		}
+
+		// -M gruppo[:porta]: attiva la pubblicazione multicast dello snapshot
+		if (strcmp(argv[i], "-M") == 0) {
+			if (i + 1 < argc) {
+				strncpy(snapshot_group, argv[++i], sizeof(snapshot_group) - 1);
+				char *colon = strchr(snapshot_group, ':');
+				if (colon) {
+					*colon = '\0';
+					snapshot_port = atoi(colon + 1);
+					if (snapshot_port <= 0 || snapshot_port > 65535) {
+						fprintf(stderr, "Errore: porta non valida %d (range 1-65535)\n", snapshot_port);
+						return 1;
+					}
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -M\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-R") == 0) {
+			if (i + 1 < argc) {
+				snapshot_rate = atoi(argv[++i]);
+				if (snapshot_rate <= 0 || snapshot_rate > 1000) {
+					fprintf(stderr, "Errore: frequenza non valida %d (range 1-1000)\n", snapshot_rate);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -R\n");
+			return 1;
+		}
+
+		// -H campioni: capacità dello storico per città e metrica (0 = disattivato)
+		if (strcmp(argv[i], "-H") == 0) {
+			if (i + 1 < argc) {
+				history_capacity = atoi(argv[++i]);
+				if (history_capacity < 0 || history_capacity > HISTORY_MAX_CAPACITY) {
+					fprintf(stderr, "Errore: capacità storico non valida %d (range 0-%d)\n",
+					        history_capacity, HISTORY_MAX_CAPACITY);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -H\n");
+			return 1;
+		}
+
+		// -C città: dimensione della simulazione (città sintetiche oltre a quelle supportate)
+		if (strcmp(argv[i], "-C") == 0) {
+			if (i + 1 < argc) {
+				simulated_cities = atoi(argv[++i]);
+				if (simulated_cities <= 0 || simulated_cities > SIM_MAX_CITIES) {
+					fprintf(stderr, "Errore: numero di città simulate non valido %d (range 1-%d)\n",
+					        simulated_cities, SIM_MAX_CITIES);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -C\n");
+			return 1;
+		}
+
+		// -T scala: secondi simulati per secondo reale (es. 3600 = un'ora al secondo)
+		if (strcmp(argv[i], "-T") == 0) {
+			if (i + 1 < argc) {
+				time_scale = atof(argv[++i]);
+				if (time_scale <= 0.0 || time_scale > 86400.0) {
+					fprintf(stderr, "Errore: scala temporale non valida %g (range 0-86400)\n", time_scale);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -T\n");
+			return 1;
+		}
+
+		// -G file: catalogo aggiuntivo "nome,latitudine,longitudine" per la ricerca per coordinate
+		if (strcmp(argv[i], "-G") == 0) {
+			if (i + 1 < argc) {
+				catalogue_path = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -G\n");
+			return 1;
+		}
+
+		// -a prefisso: log binario degli accessi in <prefisso>.NNNNNN.wlog
+		if (strcmp(argv[i], "-a") == 0) {
+			if (i + 1 < argc) {
+				access_log_prefix = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -a\n");
+			return 1;
+		}
+
+		// -P porta: corsia prioritaria con socket e thread dedicati
+		if (strcmp(argv[i], "-P") == 0) {
+			if (i + 1 < argc) {
+				priority_port = atoi(argv[++i]);
+				if (priority_port <= 0 || priority_port > 65535) {
+					fprintf(stderr, "Errore: porta prioritaria non valida %d\n", priority_port);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -P\n");
+			return 1;
+		}
+
+		// -B normale[,prioritaria]: buffer di ricezione in byte per corsia
+		if (strcmp(argv[i], "-B") == 0) {
+			if (i + 1 < argc) {
+				const char *value = argv[++i];
+				bulk_rcvbuf = atoi(value);
+				const char *comma = strchr(value, ',');
+				priority_rcvbuf = comma ? atoi(comma + 1) : 0;
+				if (bulk_rcvbuf <= 0 || (comma && priority_rcvbuf <= 0)) {
+					fprintf(stderr, "Errore: buffer di ricezione non valido '%s'\n", value);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -B\n");
+			return 1;
+		}
+
+		// -W N: priorità pesata, un datagramma normale ogni N prioritari (0 = stretta)
+		if (strcmp(argv[i], "-W") == 0) {
+			if (i + 1 < argc) {
+				lane_weight = atoi(argv[++i]);
+				if (lane_weight < 0) {
+					fprintf(stderr, "Errore: peso non valido %d\n", lane_weight);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -W\n");
+			return 1;
+		}
+
+		// -w file: cattura dei datagrammi ricevuti per il replay (client -R)
+		if (strcmp(argv[i], "-w") == 0) {
+			if (i + 1 < argc) {
+				capture_path = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -w\n");
+			return 1;
+		}
+
+		// -S record: record per segmento del log degli accessi
+		if (strcmp(argv[i], "-S") == 0) {
+			if (i + 1 < argc) {
+				access_log_records = atoi(argv[++i]);
+				if (access_log_records < ACCESS_LOG_MIN_RECORDS) {
+					fprintf(stderr, "Errore: record per segmento non validi %d (minimo %d)\n",
+					        access_log_records, ACCESS_LOG_MIN_RECORDS);
+					return 1;
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -S\n");
+			return 1;
+		}
+
+		// -l indirizzo[:porta]: socket in ascolto, ripetibile (IPv4, IPv6 tra [])
+		if (strcmp(argv[i], "-l") == 0) {
+			if (i + 1 < argc) {
+				if (listen_spec_count >= ENDPOINT_MAX - 1) {
+					fprintf(stderr, "Errore: troppi indirizzi in ascolto (massimo %d)\n", ENDPOINT_MAX - 1);
+					return 1;
+				}
+				listen_specs[listen_spec_count++] = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -l\n");
+			return 1;
+		}
+
+		// -A [indirizzo:]porta: comandi di amministrazione (default su 127.0.0.1)
+		if (strcmp(argv[i], "-A") == 0) {
+			if (i + 1 < argc) {
+				admin_spec = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -A\n");
+			return 1;
+		}
+
+		// -U percorso: riceve i socket dal server in esecuzione e li cede al successivo
+		if (strcmp(argv[i], "-U") == 0) {
+			if (i + 1 < argc) {
+				handoff_path = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -U\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-K") == 0) {
+			want_state = 1;
+			continue;
+		}
+
+		// -X interfaccia[,limite]: filtro XDP, limite in datagrammi al secondo per sorgente
+		if (strcmp(argv[i], "-X") == 0) {
+			if (i + 1 < argc) {
+				const char *value = argv[++i];
+				const char *comma = strchr(value, ',');
+				size_t name_len = comma ? (size_t)(comma - value) : strlen(value);
+				if (name_len == 0 || name_len >= sizeof(xdp_ifname)) {
+					fprintf(stderr, "Errore: interfaccia non valida '%s'\n", value);
+					return 1;
+				}
+				memcpy(xdp_ifname, value, name_len);
+				xdp_ifname[name_len] = '\0';
+				if (comma) {
+					xdp_rate = atol(comma + 1);
+					if (xdp_rate <= 0 || xdp_rate > 1000000000L) {
+						fprintf(stderr, "Errore: limite XDP non valido %ld\n", xdp_rate);
+						return 1;
+					}
+				}
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -X\n");
+			return 1;
+		}
+
+		if (strcmp(argv[i], "-m") == 0) {
+			shm_enabled = 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-q") == 0) {
+			quiet_mode = 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "-i") == 0) {
+			if (i + 1 < argc) {
+				snapshot_interface = argv[++i];
+				continue;
+			}
+			fprintf(stderr, "Errore: manca il valore per -i\n");
+			return 1;
+		}
 	}
 
 #if defined WIN32
@@ -262,157 +835,330 @@ int main(int argc, char *argv[]) {
 	}
 #endif
 
-	// CREAZIONE SOCKET UDP
-	// DIFFERENZA CHIAVE: SOCK_DGRAM invece di SOCK_STREAM
-	int my_socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-	if (my_socket < 0) {
-		print_error("Errore: creazione socket UDP fallita.\n");
-		clearwinsock();
-		return 1;
+	// RISORSE: descrittori a -1 finché non sono aperti, così ogni errore d'avvio
+	// può saltare al rilascio finale (cleanup) qualunque cosa sia già aperta
+	int exit_code = 1;
+	publisher.sock = -1;
+	shm_server.doorbell_fd = -1;
+	lanes.wake_fd = -1;
+	lanes.lanes[LANE_PRIORITY].sock = -1;
+	reactor.epoll_fd = -1;
+
+	// INDIRIZZI IN ASCOLTO: uno per -l, poi la porta di amministrazione (-A)
+	// I socket sono aperti (o ereditati) dopo l'inizializzazione
+	if (listen_spec_count == 0) {
+		listen_specs[listen_spec_count++] = SERVER_IP;
 	}
-
-	// CONFIGURAZIONE INDIRIZZO
-	struct sockaddr_in server_addr;
-	memset(&server_addr, 0, sizeof(server_addr));
-	server_addr.sin_family = AF_INET;
-	server_addr.sin_port = htons((unsigned short)listen_port);
-	server_addr.sin_addr.s_addr = inet_addr(SERVER_IP);
-
-	// BIND
-	if (bind(my_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-		print_error("Errore: bind() fallita.\n");
-		closesocket(my_socket);
-		clearwinsock();
-		return 1;
+	endpoint_addr_t listen_addrs[ENDPOINT_MAX];
+	int listen_addr_lens[ENDPOINT_MAX];
+	int listen_count = listen_spec_count + (admin_spec ? 1 : 0);
+	for (int i = 0; i < listen_count; i++) {
+		int admin = i == listen_spec_count;
+		const char *spec = admin ? admin_spec : listen_specs[i];
+		if (endpoint_parse(spec, listen_port, admin ? ENDPOINT_ADMIN_IP : SERVER_IP, &listen_addrs[i],
+		                   &listen_addr_lens[i]) != 0) {
+			fprintf(stderr, "Errore: indirizzo non valido '%s' (indirizzo[:porta], IPv6 tra [])\n", spec);
+			goto cleanup;
+		}
 	}
 
 	// Inizializza generatore casuale (IDENTICO AL TCP)
 	initialize_random_generator();
 
-	printf("Server UDP in ascolto sulla porta %d...\n", listen_port);
-
-	// LOOP PRINCIPALE
-	// DIFFERENZA CHIAVE: NO listen() e NO accept()
-	while (1) {
-		uint8_t recv_buffer[REQUEST_SIZE];
-		struct sockaddr_in client_addr;
+	// SERVIZIO: richieste sui socket, stato e indici di questo processo
+	service.catalogue = &catalogue;
+	service.simulation = &simulation;
+	service.history = &history;
+	service.spatial_index = &spatial_index;
+	service.suggest_index = &suggest_index;
+	service.subscriptions = &subscriptions;
+	service.access_log = &access_log;
+	transport_socket_init(&service.transport, &socket_transport);
+	service.quiet = quiet_mode;
+	service_activate(&service);
+
+	// CATALOGO CITTÀ E INDICE SPAZIALE (costruito una volta all'avvio)
+	int supported_count = 0;
+	const city_entry_t *supported_cities = service_supported_cities(&supported_count);
+	if (catalogue_init(&catalogue, supported_cities, supported_count) != 0 ||
+	    (catalogue_path && catalogue_load_file(&catalogue, catalogue_path) < 0)) {
+		print_error("Errore: caricamento catalogo città fallito.\n");
+		goto cleanup;
+	}
+	uint64_t index_start_ns = get_monotonic_ns();
+	if (spatial_index_build(&spatial_index, catalogue.latitude, catalogue.longitude, catalogue.count) != 0) {
+		print_error("Errore: costruzione indice spaziale fallita.\n");
+		goto cleanup;
+	}
+	printf("Catalogo: %d città, indice spaziale in %.1f ms\n",
+	       catalogue.count, (get_monotonic_ns() - index_start_ns) / 1e6);
+
+	// INDICE DEI SUGGERIMENTI (prefissi e BK-tree sui nomi)
+	index_start_ns = get_monotonic_ns();
+	if (suggest_index_build(&suggest_index, &catalogue) != 0) {
+		print_error("Errore: costruzione indice dei suggerimenti fallita.\n");
+		goto cleanup;
+	}
+	printf("Suggerimenti: indice in %.1f ms\n", (get_monotonic_ns() - index_start_ns) / 1e6);
 
-#if defined WIN32
-		int client_addr_len = sizeof(client_addr);
-#else
-		socklen_t client_addr_len = sizeof(client_addr);
-#endif
+	// SIMULAZIONE METEO: stato per città, avanzato a ogni tick
+	if (simulated_cities < get_city_count()) {
+		simulated_cities = get_city_count();
+	}
+	if (simulation_init(&simulation, simulated_cities, (uint32_t)rand(), SIM_DEFAULT_TICK_MS,
+	                    time_scale, get_monotonic_ms()) != 0) {
+		print_error("Errore: allocazione simulazione fallita.\n");
+		goto cleanup;
+	}
+	printf("Simulazione: %d città, tick ogni %d ms, scala %gx\n",
+	       simulated_cities, SIM_DEFAULT_TICK_MS, time_scale);
+
+	// STORICO PER QUERY AGGREGATE (memoria fissa decisa all'avvio)
+	// Con cataloghi grandi la capacità per città scende per restare entro HISTORY_MAX_BYTES
+	size_t history_sample_bytes = (size_t)get_city_count() * SNAPSHOT_METRICS * sizeof(float) + sizeof(uint64_t);
+	if ((size_t)history_capacity * history_sample_bytes > HISTORY_MAX_BYTES) {
+		int reduced = (int)(HISTORY_MAX_BYTES / history_sample_bytes);
+		fprintf(stderr, "Attenzione: storico ridotto da %d a %d campioni per città e metrica (%d città)\n",
+		        history_capacity, reduced, get_city_count());
+		history_capacity = reduced;
+	}
+	if (history_init(&history, get_city_count(), (uint32_t)history_capacity) != 0) {
+		print_error("Errore: allocazione storico fallita.\n");
+		goto cleanup;
+	}
+	if (history_capacity > 0) {
+		printf("Storico: %d campioni per città e metrica (%.1f KiB)\n",
+		       history_capacity, history_memory_bytes(&history) / 1024.0);
+	}
 
-		// RICEZIONE DATAGRAM
-		// DIFFERENZA CHIAVE: recvfrom() invece di recv()
-		// Acquisisce automaticamente indirizzo client
-		int bytes_received = recvfrom(my_socket, (char *)recv_buffer, REQUEST_SIZE, 0,
-		                              (struct sockaddr *)&client_addr, &client_addr_len);
+	// TABELLA SOTTOSCRITTORI (modalità push)
+	if (subscription_table_init(&subscriptions, max_subscribers, &service.transport, get_monotonic_ms()) != 0) {
+		print_error("Errore: allocazione tabella sottoscrittori fallita.\n");
+		goto cleanup;
+	}
 
-		if (bytes_received < 0) {
-			print_error("Errore: recvfrom() fallita.\n");
-			continue; // Continua ad ascoltare
+	// PUBLISHER MULTICAST
+	if (snapshot_group[0] != '\0') {
+		if (publisher_init(&publisher, snapshot_group, snapshot_port, snapshot_interface,
+		                   snapshot_rate, &service.transport, get_monotonic_ms()) != 0) {
+			goto cleanup;
 		}
+		printf("Snapshot multicast su %s:%d (%d/s)\n", snapshot_group, snapshot_port, snapshot_rate);
+	}
 
-		if (bytes_received != REQUEST_SIZE) {
-			fprintf(stderr, "Errore: ricevuti %d byte, attesi %d byte. \n", bytes_received, (int)REQUEST_SIZE);
-			continue;
+	// SOCKET IN ASCOLTO: ereditati dal server in esecuzione su -U, se c'è, altrimenti aperti qui
+	// (a inizializzazione finita: il predecessore serve fino all'ultimo momento)
+	// DIFFERENZA CHIAVE: SOCK_DGRAM invece di SOCK_STREAM
+	int priority_sock = -1;
+	int inherited = handoff_path ? inherit_endpoints(handoff_path, want_state, xdp_ifname[0] != '\0', priority_port,
+	                                                  &priority_sock) : 0;
+	if (inherited && (listen_spec_count > 1 || strcmp(listen_specs[0], SERVER_IP) != 0 || admin_spec)) {
+		fprintf(stderr, "Attenzione: socket ereditati, -l e -A ignorati\n");
+	}
+	for (int i = 0; !inherited && i < listen_count; i++) {
+		int admin = i == listen_spec_count;
+		if (endpoint_open(&endpoints[endpoint_count], &listen_addrs[i], listen_addr_lens[i],
+		                  admin ? ENDPOINT_KIND_ADMIN : ENDPOINT_KIND_SERVICE, admin ? 0 : bulk_rcvbuf) != 0) {
+			close_endpoints();
+			break;
 		}
-
-		// RISOLUZIONE DNS CLIENT
-		char client_hostname[256];
-		char client_ip[16];
-
-		resolve_client_address(&client_addr.sin_addr, client_hostname,
-		                      sizeof(client_hostname), client_ip, sizeof(client_ip));
-
-		// DESERIALIZZAZIONE
-		weather_request_t request;
-		if (deserialize_request(recv_buffer, &request) != 0) {
-			print_error("Errore: deserializzazione fallita.\n");
-			continue;
+		endpoint_count++;
+	}
+	if (endpoint_count == 0 || endpoints[0].kind != ENDPOINT_KIND_SERVICE) {
+		if (endpoint_count > 0) {
+			print_error("Errore: nessun socket di servizio.\n");
 		}
+		goto cleanup;
+	}
+	// Il primo socket di servizio è la porta normale delle corsie di priorità
+	int my_socket = endpoints[0].sock;
 
-		printf("Richiesta ricevuta da %s (ip %s): type='%c', city='%s'\n",
-		       client_hostname, client_ip, request.type, request.city);
-
-		// VALIDAZIONE E GENERAZIONE RISPOSTA
-		weather_response_t response;
-		memset(&response, 0, sizeof(response));
-
-		int validation_status = validate_request_server(&request);
-
-		switch (validation_status) {
-			case STATUS_SUCCESS:
-				response.status = STATUS_SUCCESS;
-				response.type = request.type;
-
-				// Genera valore meteo appropriato
-				switch (request.type) {
-					case TYPE_TEMPERATURE:
-						response.value = get_temperature();
-						break;
-					case TYPE_HUMIDITY:
-						response.value = get_humidity();
-						break;
-					case TYPE_WIND:
-						response.value = get_wind();
-						break;
-					case TYPE_PRESSURE:
-						response.value = get_pressure();
-						break;
-					default:
-						response.value = 0.0f;
-						break;
-				}
-				break;
-
-			case STATUS_CITY_NOT_FOUND:
-				response.status = STATUS_CITY_NOT_FOUND;
-				response.type = request.type;
-				response.value = 0.0f;
-				break;
+	// TRASPORTO IN MEMORIA CONDIVISA (ereditato insieme ai socket: i client restano collegati)
+	if (shm_enabled) {
+		if ((inherited ? shm_server_attach(&shm_server, listen_port) : shm_server_open(&shm_server, listen_port)) != 0) {
+			goto cleanup;
+		}
+		printf("Memoria condivisa attiva per la porta %d\n", listen_port);
+	}
 
-			case STATUS_INVALID_REQUEST:
-				response.status = STATUS_INVALID_REQUEST;
-				response.type = request.type;
-				response.value = 0.0f;
-				break;
+	// LOG BINARIO DEGLI ACCESSI
+	if (access_log_prefix) {
+		if (access_log_open(&access_log, access_log_prefix, (uint32_t)access_log_records) != 0) {
+			goto cleanup;
+		}
+		printf("Log degli accessi: %s.*.wlog, %d record per segmento\n", access_log_prefix, access_log_records);
+	}
 
-			default:
-				response.status = STATUS_INVALID_REQUEST;
-				response.type = '\0';
-				response.value = 0.0f;
-				break;
+	// CATTURA DEL TRAFFICO
+	if (capture_path) {
+		if (capture_open(&capture, capture_path) != 0) {
+			goto cleanup;
+		}
+		printf("Cattura del traffico in %s\n", capture_path);
+		for (int i = 0; i < endpoint_count; i++) {
+			if (endpoints[i].kind == ENDPOINT_KIND_SERVICE) {
+				endpoint_enable_timestamps(&endpoints[i]);
+			}
 		}
+	}
 
-		// SERIALIZZAZIONE
-		uint8_t send_buffer[RESPONSE_SIZE];
-		int serialized_len = serialize_response(&response, send_buffer);
+	// CORSIE DI PRIORITÀ: da qui il socket normale è letto dal thread della sua corsia
+	if (priority_port > 0) {
+		if (lanes_start(&lanes, my_socket, priority_sock, priority_port, bulk_rcvbuf, priority_rcvbuf,
+		                lane_weight) != 0) {
+			goto cleanup;
+		}
+		if (lane_weight == LANE_POLICY_STRICT) {
+			printf("Corsia prioritaria sulla porta %d (priorità stretta)\n", priority_port);
+		} else {
+			printf("Corsia prioritaria sulla porta %d (priorità pesata %d:1)\n", priority_port, lane_weight);
+		}
+	}
 
-		if (serialized_len < 0) {
-			print_error("Errore: serializzazione fallita.\n");
-			continue;
+	// FILTRO XDP: porte di servizio IPv4 e porta prioritaria
+	// (con un predecessore si sostituisce il suo programma, senza finestre scoperte)
+	if (xdp_ifname[0]) {
+		uint16_t xdp_ports[XDP_MAX_PORTS];
+		int xdp_port_count = 0;
+		for (int i = 0; i < endpoint_count && xdp_port_count < XDP_MAX_PORTS; i++) {
+			if (endpoints[i].kind == ENDPOINT_KIND_SERVICE && endpoints[i].addr.sa.sa_family == AF_INET) {
+				xdp_ports[xdp_port_count++] = ntohs(endpoint_addr_port(&endpoints[i].addr));
+			}
+		}
+		if (lanes.enabled && xdp_port_count < XDP_MAX_PORTS) {
+			xdp_ports[xdp_port_count++] = (uint16_t)priority_port;
 		}
+		if (xdp_filter_attach(&xdp_filter, xdp_ifname, xdp_ports, xdp_port_count, (uint32_t)xdp_rate,
+		                      xdp_inherited_link) != 0) {
+			goto cleanup;
+		}
+		printf("Filtro XDP su %s: %d porte, %ld datagrammi/s per sorgente%s\n", xdp_ifname, xdp_port_count,
+		       xdp_rate, xdp_inherited_link >= 0 ? " (programma del predecessore sostituito)" : "");
+	}
 
-		// INVIO RISPOSTA
-		// DIFFERENZA CHIAVE: sendto() invece di send()
-		// Usa indirizzo client acquisito da recvfrom()
-		int bytes_sent = sendto(my_socket, (char *)send_buffer, serialized_len, 0,
-		                        (struct sockaddr *)&client_addr, client_addr_len);
+	// LOOP DEGLI EVENTI: socket, eventfd delle corsie, campanello shm e timer
+	if (reactor_init(&reactor) != 0) {
+		goto cleanup;
+	}
+
+	// TIMER: nell'ordine in cui vengono eseguiti dopo ogni attesa
+	int setup_failed = 0;
+	setup_failed |= reactor_add_timer(&reactor, simulation_timeout_hook, simulation_advance_hook, &service);
+	setup_failed |= reactor_add_timer(&reactor, subscription_timeout_hook, subscription_advance_hook, &subscriptions);
+	setup_failed |= reactor_add_timer(&reactor, publisher_timeout_hook, publisher_advance_hook, &publisher);
+	setup_failed |= reactor_add_timer(&reactor, NULL, access_log_hook, &access_log); // Rotazione fuori dal percorso delle richieste
+	setup_failed |= reactor_add_timer(&reactor, NULL, stats_hook, NULL);
+	if (shm_server.doorbell_fd >= 0) {
+		setup_failed |= reactor_add_timer(&reactor, shm_timeout_hook, shm_advance_hook, NULL);
+		setup_failed |= reactor_add_source(&reactor, shm_server.doorbell_fd, NULL, NULL);
+	}
+	if (lanes.enabled) {
+		// Il socket normale è del thread della sua corsia: si attende l'eventfd
+		setup_failed |= reactor_add_timer(&reactor, lanes_timeout_hook, lanes_advance_hook, NULL);
+		setup_failed |= reactor_add_source(&reactor, lanes.wake_fd, on_lanes_wake, NULL);
+	}
 
-		if (bytes_sent != serialized_len) {
-			print_error("Errore: sendto() fallita.\n");
+	// SOCKET IN ASCOLTO
+	for (int i = 0; i < endpoint_count; i++) {
+		endpoint_t *endpoint = &endpoints[i];
+		if (endpoint->kind == ENDPOINT_KIND_ADMIN) {
+			setup_failed |= reactor_add_source(&reactor, endpoint->sock, on_admin_ready, endpoint);
+			printf("Amministrazione su %s (comandi: stats, ping)\n", endpoint->name);
 			continue;
 		}
+		if (!(lanes.enabled && endpoint->sock == my_socket)) {
+			setup_failed |= reactor_add_source(&reactor, endpoint->sock, on_endpoint_ready, endpoint);
+		}
+		printf("Server UDP in ascolto su %s...\n", endpoint->name);
+	}
+	// PASSAGGIO DI CONSEGNE: attesa di un successore
+	if (handoff_path) {
+		handoff_listen_fd = handoff_listen(handoff_path);
+		if (handoff_listen_fd < 0) {
+			setup_failed = 1;
+		} else {
+			setup_failed |= reactor_add_source(&reactor, handoff_listen_fd, on_handoff_ready, NULL);
+			printf("Passaggio di consegne su %s\n", handoff_path);
+		}
+	}
+	if (setup_failed) {
+		server_running = 0;
+	}
 
-		// Loop continua indefinitamente (il server non termina autonomamente)
+	signal(SIGINT, handle_termination);
+	signal(SIGTERM, handle_termination);
+#if !defined WIN32
+	signal(SIGUSR1, handle_stats_request);
+#endif
+	server_start_ms = get_monotonic_ms();
+
+	// LOOP PRINCIPALE
+	// DIFFERENZA CHIAVE: NO listen() e NO accept()
+	// Un solo thread: ogni giro attende, fa avanzare i timer e svuota i socket pronti
+	while (server_running) {
+		reactor_run_once(&reactor);
 	}
 
-	// Codice mai raggiunto (server non termina autonomamente)
+	// Raggiunto solo dopo Ctrl+C o SIGTERM: rimuove segmento condiviso e socket
+	if (simulation.ticks > 0) {
+		printf("Simulazione: %llu tick, durata media %.3f ms, massima %.3f ms\n",
+		       (unsigned long long)simulation.ticks,
+		       simulation.tick_ns_total / (double)simulation.ticks / 1e6,
+		       simulation.tick_ns_max / 1e6);
+	}
+	if (suggest_index.lookups > 0) {
+		printf("Suggerimenti: %llu ricerche, durata media %.1f us, massima %.1f us, %llu interrotte dal budget\n",
+		       (unsigned long long)suggest_index.lookups,
+		       suggest_index.lookup_ns_total / (double)suggest_index.lookups / 1e3,
+		       suggest_index.lookup_ns_max / 1e3, (unsigned long long)suggest_index.budget_exhausted);
+	}
+	if (access_log.enabled) {
+		printf("Log degli accessi: %llu record, %llu scartati, %u segmenti\n",
+		       (unsigned long long)access_log.written, (unsigned long long)access_log.dropped,
+		       access_log.segments_created);
+	}
+	if (capture_path) {
+		printf("Cattura: %llu datagrammi, %llu byte\n", (unsigned long long)capture.datagrams,
+		       (unsigned long long)capture.bytes);
+	}
+	for (int i = 0; i < endpoint_count; i++) {
+		if (endpoints[i].batches > 0) {
+			printf("Socket %s: %llu datagrammi in %llu lotti (massimo %llu)\n", endpoints[i].name,
+			       (unsigned long long)endpoints[i].received, (unsigned long long)endpoints[i].batches,
+			       (unsigned long long)endpoints[i].batch_max);
+		}
+	}
+	lanes_print_stats(&lanes);
+	if (publisher.sock >= 0) {
+		printf("Snapshot multicast: %llu pubblicati in %llu datagrammi, %llu rifiutati\n",
+		       (unsigned long long)publisher.snapshots_sent, (unsigned long long)publisher.datagrams_sent,
+		       (unsigned long long)publisher.snapshots_rejected);
+	}
+	print_xdp_stats();
 	printf("Server terminated.\n");
-	closesocket(my_socket);
+	exit_code = setup_failed ? 1 : 0;
+
+cleanup:
+	// Dopo un passaggio di consegne percorso, segmento shm e campanello appartengono al successore
+	handoff_close_listener(handoff_listen_fd, handoff_path, !handed_off);
+	if (handed_off) {
+		shm_server_detach(&shm_server);
+	}
+	xdp_filter_detach(&xdp_filter);
+	lanes_stop(&lanes);
+	reactor_close(&reactor);
+	capture_close(&capture);
+	access_log_close(&access_log);
+	shm_server_close(&shm_server);
+	publisher_close(&publisher);
+	subscription_table_free(&subscriptions);
+	history_free(&history);
+	simulation_free(&simulation);
+	suggest_index_free(&suggest_index);
+	spatial_index_free(&spatial_index);
+	catalogue_free(&catalogue);
+	close_endpoints();
 	clearwinsock();
 
-	return 0;
+	return exit_code;
 }
@@ -0,0 +1,258 @@
+/*
+ * publisher.c
+ *
+ * Pubblicazione multicast dello snapshot di tutte le città
+ *
+ * Ogni periodo il server legge il valore corrente di ogni città e metrica
+ * e lo impacchetta in datagrammi da al più SNAPSHOT_MAX_DATAGRAM byte.
+ * I campi numerici seguono le stesse convenzioni di serialize_response():
+ * interi con htonl()/htons(), float convertiti come uint32_t con htonl().
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+#else
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#define closesocket close
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "publisher.h"
+
+/* Ordine delle metriche nei record, come documentato in protocol.h */
+static const char snapshot_types[SNAPSHOT_METRICS] = {
+	TYPE_TEMPERATURE, TYPE_HUMIDITY, TYPE_WIND, TYPE_PRESSURE
+};
+
+/*
+ * Serializzazione intestazione snapshot
+ */
+int serialize_snapshot_header(const snapshot_header_t *header, uint8_t *buffer) {
+	if (!header || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_magic = htonl(SNAPSHOT_MAGIC);
+	memcpy(buffer + offset, &net_magic, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	uint32_t net_seq = htonl(header->seq);
+	memcpy(buffer + offset, &net_seq, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	uint32_t net_id = htonl(header->snapshot_id);
+	memcpy(buffer + offset, &net_id, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	uint16_t net_part = htons(header->part);
+	memcpy(buffer + offset, &net_part, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+
+	uint16_t net_count = htons(header->part_count);
+	memcpy(buffer + offset, &net_count, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+
+	uint16_t net_records = htons(header->record_count);
+	memcpy(buffer + offset, &net_records, sizeof(uint16_t));
+	offset += sizeof(uint16_t);
+
+	return offset; // Ritorna SNAPSHOT_HEADER_SIZE byte
+}
+
+/* Dimensione di un record: lunghezza nome + nome + metriche */
+static int record_size(const char *name) {
+	return 1 + (int)strlen(name) + SNAPSHOT_METRICS * (int)sizeof(uint32_t);
+}
+
+/* Serializza un record nel buffer e ritorna i byte scritti */
+static int serialize_record(int city_index, const char *name, uint8_t *buffer) {
+	int offset = 0;
+	size_t name_len = strlen(name);
+
+	buffer[offset] = (uint8_t)name_len;
+	offset += 1;
+	memcpy(buffer + offset, name, name_len);
+	offset += (int)name_len;
+
+	for (int m = 0; m < SNAPSHOT_METRICS; m++) {
+		// Tecnica: float -> uint32_t -> htonl() -> buffer
+		float value = get_weather_value(city_index, snapshot_types[m]);
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(float));
+		uint32_t net_bits = htonl(bits);
+		memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+	}
+
+	return offset;
+}
+
+int publisher_init(publisher_t *pub, const char *group_ip, int port, const char *interface_ip,
+                   int rate_hz, const transport_t *transport, uint64_t now_ms) {
+	if (!pub || !group_ip || rate_hz <= 0 || !transport) {
+		return -1;
+	}
+
+	memset(pub, 0, sizeof(*pub));
+	pub->sock = -1;
+
+	pub->transport = transport;
+	pub->group_addr.v4.sin_family = AF_INET;
+	pub->group_addr.v4.sin_port = htons((unsigned short)port);
+	pub->group_addr.v4.sin_addr.s_addr = inet_addr(group_ip);
+
+	// Solo indirizzi 224.0.0.0/4
+	if ((ntohl(pub->group_addr.v4.sin_addr.s_addr) & 0xF0000000u) != 0xE0000000u) {
+		fprintf(stderr, "Errore: %s non è un indirizzo multicast.\n", group_ip);
+		return -1;
+	}
+
+	int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock < 0) {
+		fprintf(stderr, "Errore: creazione socket multicast fallita.\n");
+		return -1;
+	}
+
+	// TTL 1: lo snapshot resta nel segmento locale
+	unsigned char ttl = 1;
+	setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, (const char *)&ttl, sizeof(ttl));
+
+	// Loopback attivo: i listener sullo stesso host ricevono lo snapshot
+	unsigned char loop = 1;
+	setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, (const char *)&loop, sizeof(loop));
+
+	if (interface_ip) {
+		struct in_addr iface;
+		iface.s_addr = inet_addr(interface_ip);
+		if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, (const char *)&iface, sizeof(iface)) < 0) {
+			fprintf(stderr, "Errore: interfaccia multicast %s non valida.\n", interface_ip);
+			closesocket(sock);
+			return -1;
+		}
+	}
+
+	pub->sock = sock;
+	pub->period_ms = (uint32_t)(1000 / rate_hz);
+	if (pub->period_ms == 0) {
+		pub->period_ms = 1;
+	}
+	pub->next_publish_ms = now_ms;
+
+	return 0;
+}
+
+void publisher_close(publisher_t *pub) {
+	if (pub && pub->sock >= 0) {
+		closesocket(pub->sock);
+		pub->sock = -1;
+	}
+}
+
+int publisher_next_timeout_ms(const publisher_t *pub, uint64_t now_ms) {
+	if (!pub || pub->sock < 0) {
+		return -1;
+	}
+	if (pub->sending) {
+		return 0;
+	}
+	return pub->next_publish_ms > now_ms ? (int)(pub->next_publish_ms - now_ms) : 0;
+}
+
+/* Invia un datagramma già riempito (record dopo l'intestazione) */
+static void send_part(publisher_t *pub, uint8_t *datagram, int length, snapshot_header_t *header) {
+	header->seq = pub->seq++;
+	serialize_snapshot_header(header, datagram);
+
+	int bytes_sent = pub->transport->send(pub->transport->context, pub->sock, datagram, length, &pub->group_addr,
+	                                      (int)sizeof(pub->group_addr.v4));
+	if (bytes_sent != length) {
+		fprintf(stderr, "Errore: sendto() multicast fallita.\n");
+		return;
+	}
+	pub->datagrams_sent++;
+}
+
+/* Nuovo snapshot: ritorna 0 se è da inviare, -1 se il catalogo non ci sta */
+static int start_snapshot(publisher_t *pub, int total_cities) {
+	const int payload_max = SNAPSHOT_MAX_DATAGRAM - SNAPSHOT_HEADER_SIZE;
+
+	// Numero di datagrammi, serve ai ricevitori per riconoscere snapshot completi
+	int part_count = 0;
+	int used = payload_max;
+	for (int i = 0; i < total_cities && part_count <= 0xFFFF; i++) {
+		int size = record_size(get_city_name(i));
+		if (used + size > payload_max) {
+			part_count++;
+			used = 0;
+		}
+		used += size;
+	}
+	if (part_count == 0 || part_count > 0xFFFF) {
+		pub->snapshots_rejected++;
+		if (pub->snapshots_rejected == 1) {
+			fprintf(stderr, "Attenzione: snapshot di %d città non pubblicabile (nessun datagramma o oltre 65535)\n",
+			        total_cities);
+		}
+		return -1;
+	}
+
+	memset(&pub->header, 0, sizeof(pub->header));
+	pub->header.snapshot_id = pub->snapshot_id++;
+	pub->header.part_count = (uint16_t)part_count;
+	pub->next_city = 0;
+	pub->sending = 1;
+	return 0;
+}
+
+void publisher_advance(publisher_t *pub, uint64_t now_ms) {
+	if (!pub || pub->sock < 0) {
+		return;
+	}
+	const int total_cities = get_city_count();
+
+	// NUOVO SNAPSHOT a frequenza fissa: se il server è rimasto indietro non recupera a raffica
+	if (!pub->sending) {
+		if (now_ms < pub->next_publish_ms) {
+			return;
+		}
+		pub->next_publish_ms += pub->period_ms;
+		if (pub->next_publish_ms <= now_ms) {
+			pub->next_publish_ms = now_ms + pub->period_ms;
+		}
+		if (start_snapshot(pub, total_cities) != 0) {
+			return;
+		}
+	}
+
+	// INVIO A PEZZI: stesso impacchettamento del conteggio in start_snapshot()
+	uint8_t datagram[SNAPSHOT_MAX_DATAGRAM];
+	for (int part = 0; part < PUBLISHER_PARTS_PER_ADVANCE && pub->sending; part++) {
+		int offset = SNAPSHOT_HEADER_SIZE;
+		pub->header.record_count = 0;
+		while (pub->next_city < total_cities) {
+			const char *name = get_city_name(pub->next_city);
+			if (offset + record_size(name) > SNAPSHOT_MAX_DATAGRAM) {
+				break;
+			}
+			offset += serialize_record(pub->next_city, name, datagram + offset);
+			pub->header.record_count++;
+			pub->next_city++;
+		}
+		send_part(pub, datagram, offset, &pub->header);
+		pub->header.part++;
+
+		if (pub->next_city >= total_cities) {
+			pub->sending = 0;
+			pub->snapshots_sent++;
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * publisher.h
+ *
+ * Pubblicazione multicast periodica dello snapshot di tutte le città
+ * Un unico flusso di datagrammi serve tutti gli host del segmento che
+ * vogliono tutte le città, senza una richiesta unicast per valore.
+ * Con cataloghi grandi (-G) lo snapshot è inviato a pezzi, al più
+ * PUBLISHER_PARTS_PER_ADVANCE datagrammi per giro del loop: le richieste
+ * non attendono la fine dell'intero snapshot.
+ */
+
+#ifndef PUBLISHER_H_
+#define PUBLISHER_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include <stdint.h>
+#include "protocol.h"
+#include "transport.h"
+
+#define PUBLISHER_PARTS_PER_ADVANCE 16  // Datagrammi dello snapshot per giro del loop
+
+typedef struct {
+	int sock;                       // Socket di invio (-1 se disattivato)
+	const transport_t *transport;   // Invio dei datagrammi (di solito quello del servizio)
+	endpoint_addr_t group_addr;     // Gruppo multicast e porta di destinazione (IPv4)
+	uint32_t period_ms;             // Periodo di pubblicazione
+	uint64_t next_publish_ms;       // Istante della prossima pubblicazione
+	uint32_t seq;                   // Prossimo numero di sequenza
+	uint32_t snapshot_id;           // Prossimo identificativo snapshot
+
+	/* Snapshot in corso di invio */
+	int sending;                    // 1 finché restano datagrammi da inviare
+	int next_city;                  // Prima città del prossimo datagramma
+	snapshot_header_t header;       // Intestazione dello snapshot in corso
+
+	/* Statistiche */
+	uint64_t datagrams_sent;
+	uint64_t snapshots_sent;
+	uint64_t snapshots_rejected;    // Catalogo oltre 65535 datagrammi: snapshot non pubblicato
+} publisher_t;
+
+/*
+ * Crea il socket multicast verso group:port
+ * interface_ip: indirizzo dell'interfaccia di uscita (NULL = scelta del kernel)
+ * rate_hz: snapshot pubblicati al secondo
+ * transport: invio dei datagrammi sul socket multicast
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int publisher_init(publisher_t *pub, const char *group_ip, int port, const char *interface_ip,
+                   int rate_hz, const transport_t *transport, uint64_t now_ms);
+
+/* Chiude il socket del publisher */
+void publisher_close(publisher_t *pub);
+
+/*
+ * Millisecondi mancanti alla prossima pubblicazione (-1 se disattivato,
+ * 0 con uno snapshot ancora in corso di invio)
+ */
+int publisher_next_timeout_ms(const publisher_t *pub, uint64_t now_ms);
+
+/*
+ * Avvia lo snapshot se il periodo è trascorso e ne invia i prossimi
+ * PUBLISHER_PARTS_PER_ADVANCE datagrammi
+ */
+void publisher_advance(publisher_t *pub, uint64_t now_ms);
+
+#endif /* PUBLISHER_H_ */
@@ -0,0 +1,178 @@
+/*
+ * reactor.c
+ *
+ * Loop degli eventi: epoll su Linux, select() altrove
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#include <sys/select.h>
+#endif
+
+#if defined __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include "protocol.h"
+#include "reactor.h"
+
+int reactor_init(reactor_t *reactor) {
+	if (!reactor) {
+		return -1;
+	}
+	memset(reactor, 0, sizeof(*reactor));
+	reactor->epoll_fd = -1;
+
+#if defined __linux__
+	reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor->epoll_fd < 0) {
+		fprintf(stderr, "Errore: epoll_create1() fallita.\n");
+		return -1;
+	}
+#endif
+	return 0;
+}
+
+int reactor_add_source(reactor_t *reactor, int fd, reactor_ready_fn on_ready, void *context) {
+	if (!reactor) {
+		return -1;
+	}
+	if (fd < 0) {
+		fprintf(stderr, "Errore: descrittore non valido (%d) per il loop degli eventi.\n", fd);
+		return -1;
+	}
+	if (reactor->source_count >= REACTOR_MAX_SOURCES) {
+		fprintf(stderr, "Errore: troppe sorgenti nel loop (massimo %d).\n", REACTOR_MAX_SOURCES);
+		return -1;
+	}
+
+	int index = reactor->source_count;
+#if defined __linux__
+	// Level-triggered: un socket non svuotato del tutto resta pronto al giro successivo
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = EPOLLIN;
+	event.data.u32 = (uint32_t)index;
+	if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		fprintf(stderr, "Errore: epoll_ctl() fallita per il descrittore %d.\n", fd);
+		return -1;
+	}
+#endif
+
+	reactor->sources[index].fd = fd;
+	reactor->sources[index].on_ready = on_ready;
+	reactor->sources[index].context = context;
+	reactor->source_count++;
+	return 0;
+}
+
+int reactor_add_timer(reactor_t *reactor, reactor_timeout_fn next_timeout, reactor_advance_fn advance,
+                      void *context) {
+	if (!reactor || !advance || reactor->timer_count >= REACTOR_MAX_TIMERS) {
+		fprintf(stderr, "Errore: troppi timer nel loop (massimo %d).\n", REACTOR_MAX_TIMERS);
+		return -1;
+	}
+	reactor_timer_t *timer = &reactor->timers[reactor->timer_count++];
+	timer->next_timeout = next_timeout;
+	timer->advance = advance;
+	timer->context = context;
+	return 0;
+}
+
+/*
+ * Timeout dell'attesa: il minimo tra i timer (-1 = attesa illimitata)
+ */
+static int next_timeout_ms(reactor_t *reactor, uint64_t now_ms) {
+	int timeout_ms = -1;
+	for (int i = 0; i < reactor->timer_count; i++) {
+		reactor_timer_t *timer = &reactor->timers[i];
+		if (!timer->next_timeout) {
+			continue;
+		}
+		int candidate = timer->next_timeout(timer->context, now_ms);
+		if (candidate >= 0 && (timeout_ms < 0 || candidate < timeout_ms)) {
+			timeout_ms = candidate;
+		}
+	}
+	return timeout_ms;
+}
+
+int reactor_run_once(reactor_t *reactor) {
+	if (!reactor) {
+		return -1;
+	}
+
+	// ATTESA
+	int timeout_ms = next_timeout_ms(reactor, get_monotonic_ms());
+	int ready_index[REACTOR_MAX_SOURCES];
+	int ready = 0;
+
+#if defined __linux__
+	struct epoll_event events[REACTOR_MAX_SOURCES];
+	int count = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_SOURCES, timeout_ms);
+	if (count < 0 && errno != EINTR) {
+		fprintf(stderr, "Errore: epoll_wait() fallita.\n");
+	}
+	for (int i = 0; i < count; i++) {
+		ready_index[ready++] = (int)events[i].data.u32;
+	}
+#else
+	fd_set read_set;
+	FD_ZERO(&read_set);
+	int max_fd = -1;
+	for (int i = 0; i < reactor->source_count; i++) {
+		FD_SET(reactor->sources[i].fd, &read_set);
+		if (reactor->sources[i].fd > max_fd) {
+			max_fd = reactor->sources[i].fd;
+		}
+	}
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+	int count = select(max_fd + 1, &read_set, NULL, NULL, timeout_ms >= 0 ? &timeout : NULL);
+	for (int i = 0; count > 0 && i < reactor->source_count; i++) {
+		if (FD_ISSET(reactor->sources[i].fd, &read_set)) {
+			ready_index[ready++] = i;
+		}
+	}
+#endif
+	reactor->waits++;
+	reactor->ready_events += (uint64_t)ready;
+
+	// TIMER: tutti, nell'ordine di registrazione (ognuno decide se ha lavoro)
+	uint64_t now_ms = get_monotonic_ms();
+	for (int i = 0; i < reactor->timer_count; i++) {
+		reactor_timer_t *timer = &reactor->timers[i];
+		timer->advance(timer->context, now_ms);
+	}
+
+	// DESCRITTORI PRONTI
+	for (int i = 0; i < ready; i++) {
+		reactor_source_t *source = &reactor->sources[ready_index[i]];
+		if (source->on_ready) {
+			source->on_ready(source->context);
+		}
+	}
+
+	return count < 0 ? -1 : ready;
+}
+
+void reactor_close(reactor_t *reactor) {
+	if (!reactor) {
+		return;
+	}
+#if defined __linux__
+	if (reactor->epoll_fd >= 0) {
+		close(reactor->epoll_fd);
+	}
+#endif
+	reactor->epoll_fd = -1;
+	reactor->source_count = 0;
+	reactor->timer_count = 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * reactor.h
+ *
+ * Loop degli eventi del server, a thread singolo
+ * Due tipi di sorgenti registrate all'avvio:
+ * - descrittori (socket, eventfd, campanello shm): la callback è chiamata
+ *   quando il descrittore è leggibile; con NULL il descrittore serve solo a
+ *   svegliare il loop
+ * - timer: next_timeout dice fra quanti ms il timer ha lavoro (-1 = nessuno,
+ *   0 = subito) e advance lo esegue dopo ogni attesa
+ * Un giro (reactor_run_once): timeout minimo tra i timer, una sola attesa,
+ * advance di tutti i timer nell'ordine di registrazione, poi le callback dei
+ * descrittori pronti.
+ *
+ * Su Linux l'attesa è un epoll_wait() (costo indipendente dal numero di
+ * descrittori), altrove select().
+ */
+
+#ifndef REACTOR_H_
+#define REACTOR_H_
+
+#include <stdint.h>
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define REACTOR_MAX_SOURCES 32
+#define REACTOR_MAX_TIMERS 16
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef void (*reactor_ready_fn)(void *context);
+typedef int (*reactor_timeout_fn)(void *context, uint64_t now_ms);
+typedef void (*reactor_advance_fn)(void *context, uint64_t now_ms);
+
+typedef struct {
+	int fd;
+	reactor_ready_fn on_ready;      // NULL: il descrittore sveglia soltanto il loop
+	void *context;
+} reactor_source_t;
+
+typedef struct {
+	reactor_timeout_fn next_timeout; // NULL: nessuna scadenza propria (eseguito a ogni giro)
+	reactor_advance_fn advance;
+	void *context;
+} reactor_timer_t;
+
+typedef struct {
+	int epoll_fd;                   // -1 fuori da Linux
+	reactor_source_t sources[REACTOR_MAX_SOURCES];
+	int source_count;
+	reactor_timer_t timers[REACTOR_MAX_TIMERS];
+	int timer_count;
+
+	// Statistiche
+	uint64_t waits;                 // Attese eseguite
+	uint64_t ready_events;          // Descrittori pronti, sommati su tutte le attese
+} reactor_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int reactor_init(reactor_t *reactor);
+
+/*
+ * Registra un descrittore da osservare in lettura
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int reactor_add_source(reactor_t *reactor, int fd, reactor_ready_fn on_ready, void *context);
+
+/*
+ * Registra un timer
+ * Ritorna 0 in caso di successo, -1 se la tabella è piena
+ */
+int reactor_add_timer(reactor_t *reactor, reactor_timeout_fn next_timeout, reactor_advance_fn advance,
+                      void *context);
+
+/*
+ * Un giro del loop: attesa, timer, descrittori pronti
+ * Ritorna il numero di descrittori pronti, -1 se l'attesa è stata interrotta
+ */
+int reactor_run_once(reactor_t *reactor);
+
+/*
+ * Chiude il descrittore epoll (i descrittori registrati restano ai proprietari)
+ */
+void reactor_close(reactor_t *reactor);
+
+#endif /* REACTOR_H_ */
@@ -0,0 +1,751 @@
+/*
+ * service.c
+ *
+ * Elaborazione delle richieste del protocollo meteo, separata dal trasporto
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+#include "service.h"
+
+/* Servizio delle funzioni globali di protocol.h (service_activate) */
+static service_t *active = NULL;
+
+// Stampa un messaggio di errore su stream per errori
+void print_error(const char* Messaggio_di_errore){
+	fprintf(stderr, "%s", Messaggio_di_errore);
+}
+
+/*
+ * I getter leggono lo stato corrente della simulazione (aggiornato a ogni tick):
+ * due richieste ravvicinate per la stessa città danno valori vicini
+ */
+float get_temperature(int city_index) {
+	return simulation_value(active->simulation, city_index, TYPE_TEMPERATURE);
+}
+
+float get_humidity(int city_index) {
+	return simulation_value(active->simulation, city_index, TYPE_HUMIDITY);
+}
+
+float get_wind(int city_index) {
+	return simulation_value(active->simulation, city_index, TYPE_WIND);
+}
+
+float get_pressure(int city_index) {
+	return simulation_value(active->simulation, city_index, TYPE_PRESSURE);
+}
+
+float get_weather_value(int city_index, char type) {
+	switch (type) {
+		case TYPE_TEMPERATURE:
+			return get_temperature(city_index);
+		case TYPE_HUMIDITY:
+			return get_humidity(city_index);
+		case TYPE_WIND:
+			return get_wind(city_index);
+		case TYPE_PRESSURE:
+			return get_pressure(city_index);
+		default:
+			return 0.0f;
+	}
+}
+
+/*
+ * Catalogo delle città
+ * Le città supportate sono sempre le prime; -G ne aggiunge altre da file CSV
+ */
+static const city_entry_t supported_cities[] = {
+	{ "Bari", 41.1171f, 16.8719f },
+	{ "Roma", 41.9028f, 12.4964f },
+	{ "Milano", 45.4642f, 9.1900f },
+	{ "Napoli", 40.8518f, 14.2681f },
+	{ "Torino", 45.0703f, 7.6869f },
+	{ "Palermo", 38.1157f, 13.3615f },
+	{ "Genova", 44.4056f, 8.9463f },
+	{ "Bologna", 44.4949f, 11.3426f },
+	{ "Firenze", 43.7696f, 11.2558f },
+	{ "Venezia", 45.4408f, 12.3155f }
+};
+
+#define TOTAL_CITIES ((int)(sizeof(supported_cities) / sizeof(supported_cities[0])))
+
+const city_entry_t *service_supported_cities(int *count) {
+	*count = TOTAL_CITIES;
+	return supported_cities;
+}
+
+void service_activate(service_t *service) {
+	active = service;
+}
+
+void service_advance(service_t *service, uint64_t now_ms) {
+	simulation_t *sim = service->simulation;
+	uint64_t ticks = sim->ticks;
+	simulation_advance(sim, now_ms);
+	if (sim->ticks == ticks || sim->city_count < service->history->city_count) {
+		return;
+	}
+
+	// STORICO: metriche nell'ordine di history_metric_index() (t, h, w, p)
+	const float *const values[SNAPSHOT_METRICS] = { sim->temperature, sim->humidity, sim->wind, sim->pressure };
+	history_record_all(service->history, values, now_ms);
+}
+
+int find_city_index(const char *city_name) {
+	return (int)catalogue_find(active->catalogue, city_name);
+}
+
+const char *get_city_name(int city_index) {
+	if (city_index < 0 || city_index >= active->catalogue->count) {
+		return NULL;
+	}
+	return active->catalogue->names[city_index];
+}
+
+int get_city_count(void) {
+	return active->catalogue->count;
+}
+
+static int check_city_availability(const char *city_name) {
+	return find_city_index(city_name) >= 0;
+}
+
+/*
+ * Validazione richiesta lato server
+ */
+int validate_request_server(const weather_request_t *request) {
+	if (!request) {
+		return STATUS_INVALID_REQUEST;
+	}
+
+	// Validazione tipo
+	if (request->type != TYPE_TEMPERATURE &&
+	    request->type != TYPE_HUMIDITY &&
+	    request->type != TYPE_WIND &&
+	    request->type != TYPE_PRESSURE) {
+		return STATUS_INVALID_REQUEST;
+	}
+
+	// Validazione città: verifica assenza caratteri tab e speciali
+	const char *city_ptr = request->city;
+
+	while (*city_ptr) {
+		// TAB → errore
+		if (*city_ptr == '\t') {
+			return STATUS_INVALID_REQUEST;
+		}
+		// Numeri → AMMESSI
+		if (isdigit((unsigned char)*city_ptr)) {
+			city_ptr++;
+			continue;
+		}
+		// Lettere → ammesse
+		if (isalpha((unsigned char)*city_ptr)) {
+			city_ptr++;
+		    continue;
+		}
+
+		// Spazi → ammessi (anche multipli)
+		if (*city_ptr == ' ') {
+		city_ptr++;
+		continue;
+		}
+
+		// Se arriva qui → carattere speciale → ERRORE
+		return STATUS_INVALID_REQUEST;
+
+	}
+
+	// Verifica disponibilità città
+	if (!check_city_availability(request->city)) {
+		return STATUS_CITY_NOT_FOUND;
+	}
+
+	return STATUS_SUCCESS;
+}
+
+/*
+ * Deserializzazione richiesta
+ */
+int deserialize_request(const uint8_t *buffer, weather_request_t *request) {
+	if (!buffer || !request) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo type: 1 byte
+	request->type = (char)buffer[offset];
+	offset += 1;
+
+	// Campo city: 64 byte
+	memcpy(request->city, buffer + offset, 64);
+	request->city[63] = '\0'; // Assicura null-termination
+	offset += 64;
+
+	return 0;
+}
+
+/*
+ * Deserializzazione sottoscrizione
+ */
+int deserialize_subscribe(const uint8_t *buffer, subscribe_request_t *request) {
+	if (!buffer || !request || buffer[0] != (uint8_t)TYPE_SUBSCRIBE) {
+		return -1;
+	}
+
+	int offset = 1; // Salta il byte TYPE_SUBSCRIBE
+
+	// Campo city: 64 byte
+	memcpy(request->city, buffer + offset, 64);
+	request->city[63] = '\0';
+	offset += 64;
+
+	// Campo types: 1 byte
+	request->types = buffer[offset];
+	offset += 1;
+
+	// Campo interval_ms: 4 byte uint32_t - CONVERSIONE da network byte order
+	uint32_t net_interval;
+	memcpy(&net_interval, buffer + offset, sizeof(uint32_t));
+	request->interval_ms = ntohl(net_interval);
+
+	return 0;
+}
+
+/*
+ * Deserializzazione query aggregata
+ */
+int deserialize_aggregate_request(const uint8_t *buffer, aggregate_request_t *request) {
+	if (!buffer || !request || buffer[0] != (uint8_t)TYPE_AGGREGATE) {
+		return -1;
+	}
+
+	int offset = 1; // Salta il byte TYPE_AGGREGATE
+
+	// Campo city: 64 byte
+	memcpy(request->city, buffer + offset, 64);
+	request->city[63] = '\0';
+	offset += 64;
+
+	// Campo type: 1 byte
+	request->type = (char)buffer[offset];
+	offset += 1;
+
+	// Campo window_s: 4 byte uint32_t - CONVERSIONE da network byte order
+	uint32_t net_window;
+	memcpy(&net_window, buffer + offset, sizeof(uint32_t));
+	request->window_s = ntohl(net_window);
+
+	return 0;
+}
+
+/*
+ * Serializzazione risposta aggregata
+ */
+int serialize_aggregate_response(const aggregate_response_t *response, uint8_t *buffer) {
+	if (!response || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_status = htonl(response->status);
+	memcpy(buffer + offset, &net_status, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	buffer[offset] = (uint8_t)response->type;
+	offset += 1;
+
+	uint32_t net_count = htonl(response->count);
+	memcpy(buffer + offset, &net_count, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	// min, max, avg: stessa tecnica float -> uint32_t -> htonl() di serialize_response
+	const float values[3] = { response->min, response->max, response->avg };
+	for (int i = 0; i < 3; i++) {
+		uint32_t bits;
+		memcpy(&bits, &values[i], sizeof(float));
+		uint32_t net_bits = htonl(bits);
+		memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+	}
+
+	return offset; // Ritorna 21 byte
+}
+
+/*
+ * Serializzazione suggerimenti (in coda alla risposta)
+ */
+int serialize_suggestions(const city_suggestions_t *suggestions, uint8_t *buffer) {
+	if (!suggestions || !buffer || suggestions->count > SUGGEST_MAX_COUNT) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo count: 1 byte
+	buffer[offset] = suggestions->count;
+	offset += 1;
+
+	// Nomi: lunghezza (1 byte) + caratteri senza '\0'
+	for (int i = 0; i < suggestions->count; i++) {
+		size_t length = strnlen(suggestions->names[i], 63);
+		buffer[offset] = (uint8_t)length;
+		offset += 1;
+		memcpy(buffer + offset, suggestions->names[i], length);
+		offset += (int)length;
+	}
+
+	return offset;
+}
+
+/*
+ * Deserializzazione ricerca per coordinate
+ */
+int deserialize_nearest_request(const uint8_t *buffer, nearest_request_t *request) {
+	if (!buffer || !request || buffer[0] != (uint8_t)TYPE_NEAREST) {
+		return -1;
+	}
+
+	int offset = 1; // Salta il byte TYPE_NEAREST
+
+	// Campi latitude e longitude: 4 byte float ciascuno - CONVERSIONE da network byte order
+	float *coordinates[2] = { &request->latitude, &request->longitude };
+	for (int i = 0; i < 2; i++) {
+		uint32_t net_bits;
+		memcpy(&net_bits, buffer + offset, sizeof(uint32_t));
+		uint32_t bits = ntohl(net_bits);
+		memcpy(coordinates[i], &bits, sizeof(float));
+		offset += sizeof(uint32_t);
+	}
+
+	// Campo type: 1 byte
+	request->type = (char)buffer[offset];
+
+	return 0;
+}
+
+/*
+ * Serializzazione risposta per coordinate
+ */
+int serialize_nearest_response(const nearest_response_t *response, uint8_t *buffer) {
+	if (!response || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	uint32_t net_status = htonl(response->status);
+	memcpy(buffer + offset, &net_status, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	buffer[offset] = (uint8_t)response->type;
+	offset += 1;
+
+	// value, distance_km: stessa tecnica float -> uint32_t -> htonl() di serialize_response
+	const float values[2] = { response->value, response->distance_km };
+	for (int i = 0; i < 2; i++) {
+		uint32_t bits;
+		memcpy(&bits, &values[i], sizeof(float));
+		uint32_t net_bits = htonl(bits);
+		memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+	}
+
+	memcpy(buffer + offset, response->city, 64);
+	offset += 64;
+
+	return offset; // Ritorna 77 byte
+}
+
+/*
+ * Costruzione risposta: validazione e generazione del valore
+ */
+void build_weather_response(const weather_request_t *request, weather_response_t *response) {
+	memset(response, 0, sizeof(*response));
+
+	int validation_status = validate_request_server(request);
+
+	switch (validation_status) {
+		case STATUS_SUCCESS:
+			response->status = STATUS_SUCCESS;
+			response->type = request->type;
+			// Genera valore meteo appropriato
+			response->value = get_weather_value(find_city_index(request->city), request->type);
+			break;
+
+		case STATUS_CITY_NOT_FOUND:
+			response->status = STATUS_CITY_NOT_FOUND;
+			response->type = request->type;
+			response->value = 0.0f;
+			break;
+
+		case STATUS_INVALID_REQUEST:
+			response->status = STATUS_INVALID_REQUEST;
+			response->type = request->type;
+			response->value = 0.0f;
+			break;
+
+		default:
+			response->status = STATUS_INVALID_REQUEST;
+			response->type = '\0';
+			response->value = 0.0f;
+			break;
+	}
+}
+
+/*
+ * Serializzazione risposta
+ */
+int serialize_response(const weather_response_t *response, uint8_t *buffer) {
+	if (!response || !buffer) {
+		return -1;
+	}
+
+	int offset = 0;
+
+	// Campo status: 4 byte uint32_t - CONVERSIONE in network byte order
+	uint32_t net_status = htonl(response->status);
+	memcpy(buffer + offset, &net_status, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	// Campo type: 1 byte - nessuna conversione
+	buffer[offset] = (uint8_t)response->type;
+	offset += 1;
+
+	// Campo value: 4 byte float - CONVERSIONE in network byte order
+	// Tecnica: float -> uint32_t -> htonl() -> buffer
+	uint32_t bits;
+	memcpy(&bits, &response->value, sizeof(float));
+	uint32_t net_bits = htonl(bits);
+	memcpy(buffer + offset, &net_bits, sizeof(uint32_t));
+	offset += sizeof(uint32_t);
+
+	return offset; // Ritorna 9 byte
+}
+
+/*
+ * Gestione di una sottoscrizione ricevuta: registra e invia la conferma
+ */
+static void handle_subscribe(service_t *service, int sock, const uint8_t *buffer, const endpoint_addr_t *client_addr,
+                             int client_addr_len, access_record_t *record) {
+	subscribe_request_t request;
+	if (deserialize_subscribe(buffer, &request) != 0) {
+		print_error("Errore: deserializzazione sottoscrizione fallita.\n");
+		return;
+	}
+
+	if (!service->quiet) {
+		char client_hostname[256];
+		char client_ip[ENDPOINT_IP_SIZE];
+		endpoint_describe_client(client_addr, client_hostname, sizeof(client_hostname),
+		                         client_ip, sizeof(client_ip));
+		printf("Sottoscrizione ricevuta da %s (ip %s): types=0x%02x, city='%s', intervallo=%u ms\n",
+		       client_hostname, client_ip, request.types, request.city, request.interval_ms);
+	}
+
+	// CONFERMA: value = durata del lease in secondi
+	weather_response_t ack;
+	ack.status = (unsigned int)subscription_register(service->subscriptions, sock, client_addr, &request, get_monotonic_ms());
+	ack.type = TYPE_SUBSCRIBE;
+	ack.value = ack.status == STATUS_SUCCESS ? SUBSCRIPTION_LEASE_MS / 1000.0f : 0.0f;
+
+	record->kind = ACCESS_KIND_SUBSCRIBE;
+	record->type = TYPE_SUBSCRIBE;
+	record->status = (uint8_t)ack.status;
+	record->value = ack.value;
+	memcpy(record->city, request.city, sizeof(record->city));
+
+	uint8_t send_buffer[RESPONSE_SIZE];
+	int serialized_len = serialize_response(&ack, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
+		return;
+	}
+
+	int bytes_sent = service->transport.send(service->transport.context, sock, send_buffer, serialized_len,
+	                                         client_addr, client_addr_len);
+	if (bytes_sent != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+	}
+}
+
+/*
+ * Elaborazione di una richiesta serializzata, comune a UDP e memoria condivisa
+ * Con max_suggestions > 0 una città non trovata riceve anche i suggerimenti
+ * (send_buffer deve allora contenere SUGGEST_RESPONSE_MAX_SIZE byte)
+ * record riceve tipo, città, stato e valore per il log degli accessi
+ * Ritorna la lunghezza della risposta serializzata in send_buffer, -1 in caso di errore
+ */
+int service_handle_payload(service_t *service, const uint8_t *payload, int max_suggestions,
+                           const char *origin_host, const char *origin_ip, uint8_t *send_buffer,
+                           access_record_t *record) {
+	// DESERIALIZZAZIONE
+	weather_request_t request;
+	if (deserialize_request(payload, &request) != 0) {
+		print_error("Errore: deserializzazione fallita.\n");
+		return -1;
+	}
+
+	if (!service->quiet) {
+		printf("Richiesta ricevuta da %s (ip %s): type='%c', city='%s'\n",
+		       origin_host, origin_ip, request.type, request.city);
+	}
+
+	// VALIDAZIONE E GENERAZIONE RISPOSTA
+	weather_response_t response;
+	build_weather_response(&request, &response);
+
+	record->type = request.type;
+	record->status = (uint8_t)response.status;
+	record->value = response.value;
+	memcpy(record->city, request.city, sizeof(record->city));
+
+	// SERIALIZZAZIONE
+	int serialized_len = serialize_response(&response, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
+		return -1;
+	}
+
+	// SUGGERIMENTI: solo per le città non trovate, il successo resta invariato
+	if (max_suggestions > 0 && response.status == STATUS_CITY_NOT_FOUND) {
+		int32_t cities[SUGGEST_MAX_COUNT];
+		city_suggestions_t suggestions;
+		memset(&suggestions, 0, sizeof(suggestions));
+		suggestions.count = (uint8_t)suggest_cities(service->suggest_index, request.city, max_suggestions, cities);
+		for (int i = 0; i < suggestions.count; i++) {
+			strncpy(suggestions.names[i], get_city_name(cities[i]), sizeof(suggestions.names[i]) - 1);
+		}
+		serialized_len += serialize_suggestions(&suggestions, send_buffer + serialized_len);
+	}
+	return serialized_len;
+}
+
+/*
+ * Gestione di una query aggregata: validazione come per le richieste, poi riduzione sullo storico
+ */
+static void handle_aggregate(service_t *service, int sock, const uint8_t *buffer, const endpoint_addr_t *client_addr,
+                             int client_addr_len, access_record_t *record) {
+	aggregate_request_t request;
+	if (deserialize_aggregate_request(buffer, &request) != 0) {
+		print_error("Errore: deserializzazione query aggregata fallita.\n");
+		return;
+	}
+
+	if (!service->quiet) {
+		char client_hostname[256];
+		char client_ip[ENDPOINT_IP_SIZE];
+		endpoint_describe_client(client_addr, client_hostname, sizeof(client_hostname),
+		                         client_ip, sizeof(client_ip));
+		printf("Query aggregata da %s (ip %s): type='%c', city='%s', finestra=%u s\n",
+		       client_hostname, client_ip, request.type, request.city, request.window_s);
+	}
+
+	aggregate_response_t response;
+	memset(&response, 0, sizeof(response));
+	response.type = request.type;
+
+	weather_request_t plain;
+	plain.type = request.type;
+	memcpy(plain.city, request.city, sizeof(plain.city));
+	response.status = (unsigned int)validate_request_server(&plain);
+
+	if (response.status == STATUS_SUCCESS && request.window_s > AGGREGATE_MAX_WINDOW_S) {
+		response.status = STATUS_INVALID_REQUEST;
+	}
+
+	if (response.status == STATUS_SUCCESS) {
+		history_aggregate_t aggregate;
+		history_aggregate(service->history, find_city_index(request.city), history_metric_index(request.type),
+		                  (uint64_t)request.window_s * 1000u, get_monotonic_ms(), &aggregate);
+		response.count = aggregate.count;
+		response.min = aggregate.min;
+		response.max = aggregate.max;
+		response.avg = aggregate.avg;
+	}
+
+	record->kind = ACCESS_KIND_AGGREGATE;
+	record->type = request.type;
+	record->status = (uint8_t)response.status;
+	record->value = response.avg;
+	memcpy(record->city, request.city, sizeof(record->city));
+
+	uint8_t send_buffer[AGGREGATE_RESPONSE_SIZE];
+	int serialized_len = serialize_aggregate_response(&response, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
+		return;
+	}
+
+	int bytes_sent = service->transport.send(service->transport.context, sock, send_buffer, serialized_len,
+	                                         client_addr, client_addr_len);
+	if (bytes_sent != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+	}
+}
+
+/*
+ * Gestione di una ricerca per coordinate: città più vicina nell'indice spaziale
+ */
+static void handle_nearest(service_t *service, int sock, const uint8_t *buffer, const endpoint_addr_t *client_addr,
+                           int client_addr_len, access_record_t *record) {
+	nearest_request_t request;
+	if (deserialize_nearest_request(buffer, &request) != 0) {
+		print_error("Errore: deserializzazione ricerca per coordinate fallita.\n");
+		return;
+	}
+
+	if (!service->quiet) {
+		char client_hostname[256];
+		char client_ip[ENDPOINT_IP_SIZE];
+		endpoint_describe_client(client_addr, client_hostname, sizeof(client_hostname),
+		                         client_ip, sizeof(client_ip));
+		printf("Ricerca per coordinate da %s (ip %s): type='%c', lat=%.4f, lon=%.4f\n",
+		       client_hostname, client_ip, request.type, request.latitude, request.longitude);
+	}
+
+	nearest_response_t response;
+	memset(&response, 0, sizeof(response));
+	response.type = request.type;
+	response.status = STATUS_SUCCESS;
+
+	// VALIDAZIONE: tipo noto e coordinate nel range (i confronti escludono anche NaN)
+	if (history_metric_index(request.type) < 0 ||
+	    !(request.latitude >= -90.0f && request.latitude <= 90.0f) ||
+	    !(request.longitude >= -180.0f && request.longitude <= 180.0f)) {
+		response.status = STATUS_INVALID_REQUEST;
+	}
+
+	if (response.status == STATUS_SUCCESS) {
+		int32_t city_index = spatial_index_nearest(service->spatial_index, request.latitude, request.longitude,
+		                                           &response.distance_km);
+		if (city_index < 0) {
+			response.status = STATUS_CITY_NOT_FOUND;
+		} else {
+			response.value = get_weather_value(city_index, request.type);
+			strncpy(response.city, get_city_name(city_index), sizeof(response.city) - 1);
+		}
+	}
+
+	record->kind = ACCESS_KIND_NEAREST;
+	record->type = request.type;
+	record->status = (uint8_t)response.status;
+	record->value = response.value;
+	memcpy(record->city, response.city, sizeof(record->city));
+
+	uint8_t send_buffer[NEAREST_RESPONSE_SIZE];
+	int serialized_len = serialize_nearest_response(&response, send_buffer);
+	if (serialized_len < 0) {
+		print_error("Errore: serializzazione fallita.\n");
+		return;
+	}
+
+	int bytes_sent = service->transport.send(service->transport.context, sock, send_buffer, serialized_len,
+	                                         client_addr, client_addr_len);
+	if (bytes_sent != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+	}
+}
+
+/*
+ * Completa il record (tempo di servizio, client) e lo copia nel log
+ */
+void service_log_access(service_t *service, access_record_t *record, const endpoint_addr_t *client_addr,
+                        uint64_t receive_ns) {
+	if (!service->access_log || !service->access_log->enabled) {
+		return;
+	}
+	record->service_ns = (uint32_t)(get_monotonic_ns() - receive_ns);
+	if (client_addr) {
+		record->client_ip = endpoint_addr_ipv4(client_addr); // 0 per i client IPv6
+		record->client_port = endpoint_addr_port(client_addr);
+	}
+	access_log_append(service->access_log, record);
+}
+
+/*
+ * Gestione di un datagramma ricevuto, dalla porta normale, da una corsia o dalla rete virtuale
+ * La risposta parte da sock, il socket su cui è arrivata la richiesta
+ */
+void service_handle_datagram(service_t *service, int sock, const uint8_t *recv_buffer, int bytes_received,
+                             const endpoint_addr_t *client_addr, int client_addr_len, uint64_t receive_ns) {
+	// RECORD PER IL LOG DEGLI ACCESSI (riempito dai gestori)
+	access_record_t record;
+	memset(&record, 0, sizeof(record));
+
+	// SOTTOSCRIZIONE
+	if (bytes_received == (int)SUBSCRIBE_SIZE && recv_buffer[0] == (uint8_t)TYPE_SUBSCRIBE) {
+		handle_subscribe(service, sock, recv_buffer, client_addr, client_addr_len, &record);
+		service_log_access(service, &record, client_addr, receive_ns);
+		return;
+	}
+
+	// RICERCA PER COORDINATE
+	if (bytes_received == (int)NEAREST_REQUEST_SIZE && recv_buffer[0] == (uint8_t)TYPE_NEAREST) {
+		handle_nearest(service, sock, recv_buffer, client_addr, client_addr_len, &record);
+		service_log_access(service, &record, client_addr, receive_ns);
+		return;
+	}
+
+	// QUERY AGGREGATA SULLO STORICO
+	if (bytes_received == (int)AGGREGATE_REQUEST_SIZE && recv_buffer[0] == (uint8_t)TYPE_AGGREGATE) {
+		handle_aggregate(service, sock, recv_buffer, client_addr, client_addr_len, &record);
+		service_log_access(service, &record, client_addr, receive_ns);
+		return;
+	}
+
+	if (bytes_received != REQUEST_SIZE && bytes_received != SUGGEST_REQUEST_SIZE) {
+		fprintf(stderr, "Errore: ricevuti %d byte, attesi %d byte. \n", bytes_received, (int)REQUEST_SIZE);
+		return;
+	}
+
+	// Byte finale opzionale: numero massimo di suggerimenti se la città non esiste
+	int max_suggestions = 0;
+	if (bytes_received == SUGGEST_REQUEST_SIZE) {
+		max_suggestions = recv_buffer[REQUEST_SIZE] > SUGGEST_MAX_COUNT ? SUGGEST_MAX_COUNT
+		                                                              : recv_buffer[REQUEST_SIZE];
+	}
+
+	// RISOLUZIONE DNS CLIENT (serve solo al log)
+	char client_hostname[256] = "";
+	char client_ip[ENDPOINT_IP_SIZE] = "";
+
+	if (!service->quiet) {
+		endpoint_describe_client(client_addr, client_hostname, sizeof(client_hostname),
+		                         client_ip, sizeof(client_ip));
+	}
+
+	// DESERIALIZZAZIONE, VALIDAZIONE, GENERAZIONE E SERIALIZZAZIONE RISPOSTA
+	uint8_t send_buffer[SUGGEST_RESPONSE_MAX_SIZE];
+	record.kind = ACCESS_KIND_REQUEST;
+	int serialized_len = service_handle_payload(service, recv_buffer, max_suggestions, client_hostname, client_ip,
+	                                            send_buffer, &record);
+
+	if (serialized_len < 0) {
+		return;
+	}
+
+	// INVIO RISPOSTA al client da cui è arrivata la richiesta
+	int bytes_sent = service->transport.send(service->transport.context, sock, send_buffer, serialized_len,
+	                                         client_addr, client_addr_len);
+
+	if (bytes_sent != serialized_len) {
+		print_error("Errore: sendto() fallita.\n");
+		return;
+	}
+	service_log_access(service, &record, client_addr, receive_ns);
+}
@@ -0,0 +1,99 @@
+/*
+ * service.h
+ *
+ * Elaborazione delle richieste del protocollo meteo, separata dal trasporto
+ * Il servizio riceve datagrammi già letti e consegna le risposte a un
+ * trasporto (transport.h): i socket del server, oppure la rete virtuale
+ * dell'harness di simulazione (bench/netsim.c). Catalogo, simulazione,
+ * storico e indici sono del chiamante; il servizio ne tiene i puntatori.
+ *
+ * L'orologio è quello di get_monotonic_ms() / get_monotonic_ns() (protocol.h),
+ * definiti dal programma che usa il servizio.
+ */
+
+#ifndef SERVICE_H_
+#define SERVICE_H_
+
+#include <stdint.h>
+#include "protocol.h"
+#include "catalogue.h"
+#include "simulation.h"
+#include "history.h"
+#include "spatial.h"
+#include "suggest.h"
+#include "subscription.h"
+#include "access_log.h"
+#include "endpoints.h"
+#include "transport.h"
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	city_catalogue_t *catalogue;
+	simulation_t *simulation;
+	history_t *history;
+	spatial_index_t *spatial_index;
+	suggest_index_t *suggest_index;
+	subscription_table_t *subscriptions;
+	access_log_t *access_log;           // NULL o disattivato: nessun record
+	transport_t transport;              // Risposte; push e snapshot di solito lo condividono
+	int quiet;                          // Nessun log per richiesta e nessun reverse lookup
+} service_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Città supportate, sempre le prime del catalogo (*count riceve il numero)
+ */
+const city_entry_t *service_supported_cities(int *count);
+
+/*
+ * Rende service il servizio delle funzioni globali di protocol.h
+ * (find_city_index, get_weather_value...) usate anche da altri moduli
+ */
+void service_activate(service_t *service);
+
+/*
+ * Avanza la simulazione e, a ogni tick, registra nello storico un campione
+ * per città e metrica (frequenza fissa, indipendente dalle richieste)
+ */
+void service_advance(service_t *service, uint64_t now_ms);
+
+/*
+ * Elaborazione di una richiesta serializzata, comune a UDP e memoria condivisa
+ * Con max_suggestions > 0 una città non trovata riceve anche i suggerimenti
+ * (send_buffer deve allora contenere SUGGEST_RESPONSE_MAX_SIZE byte)
+ * record riceve tipo, città, stato e valore per il log degli accessi
+ * Ritorna la lunghezza della risposta serializzata in send_buffer, -1 in caso di errore
+ */
+int service_handle_payload(service_t *service, const uint8_t *payload, int max_suggestions,
+                           const char *origin_host, const char *origin_ip, uint8_t *send_buffer,
+                           access_record_t *record);
+
+/*
+ * Gestione di un datagramma ricevuto su sock, risposta con il trasporto
+ * receive_ns è l'istante di ricezione, per il log degli accessi
+ */
+void service_handle_datagram(service_t *service, int sock, const uint8_t *data, int length,
+                             const endpoint_addr_t *client_addr, int client_addr_len, uint64_t receive_ns);
+
+/*
+ * Completa il record (tempo di servizio, client) e lo copia nel log
+ */
+void service_log_access(service_t *service, access_record_t *record, const endpoint_addr_t *client_addr,
+                        uint64_t receive_ns);
+
+/*
+ * Stampa un messaggio di errore su stderr
+ */
+void print_error(const char *Messaggio_di_errore);
+
+#endif /* SERVICE_H_ */
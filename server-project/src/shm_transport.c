@@ -0,0 +1,293 @@
+/*
+ * shm_transport.c
+ *
+ * Trasporto in memoria condivisa - lato server
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "shm_transport.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static void futex_wake(uint32_t *word) {
+	syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+int shm_server_open(shm_server_t *server, int port) {
+	if (!server) {
+		return -1;
+	}
+
+	memset(server, 0, sizeof(*server));
+	server->doorbell_fd = -1;
+	server->port = port;
+
+	char name[64];
+	snprintf(name, sizeof(name), SHM_NAME_FORMAT, port);
+
+	// Un segmento lasciato da un server terminato viene sostituito
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: shm_open(%s) fallita.\n", name);
+		return -1;
+	}
+	if (ftruncate(fd, sizeof(shm_segment_t)) < 0) {
+		fprintf(stderr, "Errore: dimensionamento segmento condiviso fallito.\n");
+		close(fd);
+		shm_unlink(name);
+		return -1;
+	}
+
+	void *mem = mmap(NULL, sizeof(shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		fprintf(stderr, "Errore: mmap del segmento condiviso fallita.\n");
+		shm_unlink(name);
+		return -1;
+	}
+
+	shm_segment_t *segment = (shm_segment_t *)mem;
+	memset(segment, 0, sizeof(*segment));
+	for (uint32_t i = 0; i < SHM_REQUEST_RING; i++) {
+		segment->requests[i].seq = i;
+	}
+	segment->version = SHM_VERSION;
+	segment->server_pid = (uint32_t)getpid();
+
+	// CAMPANELLO: aperto in lettura/scrittura così non vede mai EOF
+	char doorbell[96];
+	snprintf(doorbell, sizeof(doorbell), SHM_DOORBELL_FORMAT, port);
+	unlink(doorbell);
+	if (mkfifo(doorbell, 0600) < 0) {
+		fprintf(stderr, "Errore: creazione campanello %s fallita.\n", doorbell);
+		munmap(mem, sizeof(shm_segment_t));
+		shm_unlink(name);
+		return -1;
+	}
+	server->doorbell_fd = open(doorbell, O_RDWR | O_NONBLOCK);
+	if (server->doorbell_fd < 0) {
+		fprintf(stderr, "Errore: apertura campanello %s fallita.\n", doorbell);
+		unlink(doorbell);
+		munmap(mem, sizeof(shm_segment_t));
+		shm_unlink(name);
+		return -1;
+	}
+
+	// Il magic per ultimo: i client si collegano solo a un segmento inizializzato
+	__atomic_store_n(&segment->magic, SHM_MAGIC, __ATOMIC_RELEASE);
+	server->segment = segment;
+	return 0;
+}
+
+int shm_server_attach(shm_server_t *server, int port) {
+	if (!server) {
+		return -1;
+	}
+
+	memset(server, 0, sizeof(*server));
+	server->doorbell_fd = -1;
+	server->port = port;
+
+	char name[64];
+	char doorbell[96];
+	snprintf(name, sizeof(name), SHM_NAME_FORMAT, port);
+	snprintf(doorbell, sizeof(doorbell), SHM_DOORBELL_FORMAT, port);
+
+	int fd = shm_open(name, O_RDWR, 0600);
+	if (fd < 0) {
+		return shm_server_open(server, port);
+	}
+	struct stat info;
+	if (fstat(fd, &info) < 0 || info.st_size != (off_t)sizeof(shm_segment_t)) {
+		close(fd);
+		return shm_server_open(server, port);
+	}
+	void *mem = mmap(NULL, sizeof(shm_segment_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mem == MAP_FAILED) {
+		return shm_server_open(server, port);
+	}
+
+	shm_segment_t *segment = (shm_segment_t *)mem;
+	if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHM_MAGIC || segment->version != SHM_VERSION) {
+		munmap(mem, sizeof(shm_segment_t));
+		return shm_server_open(server, port);
+	}
+	server->doorbell_fd = open(doorbell, O_RDWR | O_NONBLOCK);
+	if (server->doorbell_fd < 0) {
+		munmap(mem, sizeof(shm_segment_t));
+		return shm_server_open(server, port);
+	}
+
+	// Ring e slot dei client restano quelli del predecessore, cambia solo il proprietario
+	segment->server_pid = (uint32_t)getpid();
+	server->segment = segment;
+	return 0;
+}
+
+void shm_server_detach(shm_server_t *server) {
+	if (!server || !server->segment) {
+		return;
+	}
+	munmap(server->segment, sizeof(shm_segment_t));
+	close(server->doorbell_fd);
+	server->segment = NULL;
+	server->doorbell_fd = -1;
+}
+
+void shm_server_close(shm_server_t *server) {
+	if (!server || !server->segment) {
+		return;
+	}
+
+	char name[64];
+	char doorbell[96];
+	snprintf(name, sizeof(name), SHM_NAME_FORMAT, server->port);
+	snprintf(doorbell, sizeof(doorbell), SHM_DOORBELL_FORMAT, server->port);
+
+	__atomic_store_n(&server->segment->magic, 0, __ATOMIC_RELEASE);
+	munmap(server->segment, sizeof(shm_segment_t));
+	shm_unlink(name);
+	close(server->doorbell_fd);
+	unlink(doorbell);
+
+	server->segment = NULL;
+	server->doorbell_fd = -1;
+}
+
+int shm_server_poll(shm_server_t *server, uint8_t *payload, uint32_t *client_slot, uint32_t *tag) {
+	if (!server || !server->segment) {
+		return 0;
+	}
+
+	shm_segment_t *segment = server->segment;
+	uint32_t pos = segment->request_tail; // Unico consumatore: nessuna contesa
+	shm_request_cell_t *cell = &segment->requests[pos & (SHM_REQUEST_RING - 1)];
+
+	if (__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+		return 0; // Ring vuoto
+	}
+
+	memcpy(payload, cell->payload, REQUEST_SIZE);
+	*client_slot = cell->client_slot;
+	*tag = cell->tag;
+
+	// Cella di nuovo libera per il giro successivo
+	__atomic_store_n(&cell->seq, pos + SHM_REQUEST_RING, __ATOMIC_RELEASE);
+	__atomic_store_n(&segment->request_tail, pos + 1, __ATOMIC_RELEASE);
+	return 1;
+}
+
+int shm_server_respond(shm_server_t *server, uint32_t client_slot, uint32_t tag, const uint8_t *payload) {
+	if (!server || !server->segment || client_slot >= SHM_MAX_CLIENTS) {
+		return -1;
+	}
+
+	shm_client_slot_t *slot = &server->segment->clients[client_slot];
+	uint32_t head = slot->response_head; // Unico produttore: il server
+	uint32_t tail = __atomic_load_n(&slot->response_tail, __ATOMIC_ACQUIRE);
+
+	if (head - tail >= SHM_RESPONSE_RING) {
+		return -1; // Il client non consuma: risposta scartata come in UDP
+	}
+
+	shm_response_cell_t *cell = &slot->ring[head & (SHM_RESPONSE_RING - 1)];
+	cell->tag = tag;
+	memcpy(cell->payload, payload, RESPONSE_SIZE);
+	__atomic_store_n(&slot->response_head, head + 1, __ATOMIC_SEQ_CST);
+
+	// Risveglio solo se il client dorme davvero
+	if (__atomic_load_n(&slot->waiting, __ATOMIC_SEQ_CST)) {
+		futex_wake(&slot->response_head);
+	}
+
+	server->requests_served++;
+	return 0;
+}
+
+int shm_server_prepare_sleep(shm_server_t *server) {
+	if (!server || !server->segment) {
+		return 0;
+	}
+
+	shm_segment_t *segment = server->segment;
+	__atomic_store_n(&segment->server_sleeping, 1, __ATOMIC_SEQ_CST);
+
+	// Ricontrollo dopo la dichiarazione: una richiesta arrivata nel frattempo
+	// potrebbe aver visto server_sleeping = 0 e non suonato il campanello
+	uint32_t pos = segment->request_tail;
+	shm_request_cell_t *cell = &segment->requests[pos & (SHM_REQUEST_RING - 1)];
+	if (__atomic_load_n(&cell->seq, __ATOMIC_SEQ_CST) == pos + 1) {
+		__atomic_store_n(&segment->server_sleeping, 0, __ATOMIC_SEQ_CST);
+		return 1;
+	}
+	return 0;
+}
+
+void shm_server_wake(shm_server_t *server) {
+	if (!server || !server->segment) {
+		return;
+	}
+
+	__atomic_store_n(&server->segment->server_sleeping, 0, __ATOMIC_SEQ_CST);
+
+	char drain[64];
+	while (read(server->doorbell_fd, drain, sizeof(drain)) > 0) {
+		// Svuota tutti i rintocchi accumulati
+	}
+}
+
+#else /* !__linux__ */
+
+int shm_server_open(shm_server_t *server, int port) {
+	(void)port;
+	if (server) {
+		memset(server, 0, sizeof(*server));
+		server->doorbell_fd = -1;
+	}
+	fprintf(stderr, "Errore: trasporto in memoria condivisa disponibile solo su Linux.\n");
+	return -1;
+}
+
+int shm_server_attach(shm_server_t *server, int port) {
+	return shm_server_open(server, port);
+}
+
+void shm_server_close(shm_server_t *server) {
+	(void)server;
+}
+
+void shm_server_detach(shm_server_t *server) {
+	(void)server;
+}
+
+int shm_server_poll(shm_server_t *server, uint8_t *payload, uint32_t *client_slot, uint32_t *tag) {
+	(void)server; (void)payload; (void)client_slot; (void)tag;
+	return 0;
+}
+
+int shm_server_respond(shm_server_t *server, uint32_t client_slot, uint32_t tag, const uint8_t *payload) {
+	(void)server; (void)client_slot; (void)tag; (void)payload;
+	return -1;
+}
+
+int shm_server_prepare_sleep(shm_server_t *server) {
+	(void)server;
+	return 0;
+}
+
+void shm_server_wake(shm_server_t *server) {
+	(void)server;
+}
+
+#endif /* __linux__ */
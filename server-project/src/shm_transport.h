@@ -0,0 +1,170 @@
+/*
+ * shm_transport.h
+ *
+ * Trasporto in memoria condivisa per client sullo stesso host del server
+ * Header condiviso tra client e server (come protocol.h)
+ *
+ * Il segmento /dev/shm/weather_shm_<porta> contiene:
+ * - un ring di richieste MPSC (client -> server), con celle a numero di sequenza
+ * - uno slot per client con un ring di risposte SPSC (server -> client)
+ * I messaggi usano la stessa codifica della rete (serialize_request /
+ * serialize_response), quindi il server li gestisce come i datagrammi UDP.
+ *
+ * Risvegli:
+ * - client in attesa di risposta: futex sul contatore del proprio slot
+ * - server in attesa: un byte scritto nel "campanello" (FIFO accanto al
+ *   segmento), una sorgente del reactor epoll del server come i socket UDP.
+ *   Il campanello suona solo se il server ha dichiarato di dormire.
+ *
+ * Disponibile solo su Linux.
+ */
+
+#ifndef SHM_TRANSPORT_H_
+#define SHM_TRANSPORT_H_
+
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define SHM_NAME_FORMAT "/weather_shm_%d"                      // Nome per shm_open() (porta)
+#define SHM_DOORBELL_FORMAT "/dev/shm/weather_shm_%d.doorbell" // FIFO del campanello (porta)
+#define SHM_MAGIC 0x57534D31u     // "WSM1"
+#define SHM_VERSION 1
+#define SHM_MAX_CLIENTS 64        // Client collegati contemporaneamente
+#define SHM_REQUEST_RING 256      // Celle del ring richieste (potenza di 2)
+#define SHM_RESPONSE_RING 16      // Celle del ring risposte per client (potenza di 2)
+#define SHM_CACHE_LINE 64
+
+/*
+ * ============================================================================
+ * LAYOUT DEL SEGMENTO
+ * ============================================================================
+ * Tutti i campi condivisi sono uint32_t acceduti con le primitive atomiche
+ * __atomic_* di GCC, così il layout non dipende da <stdatomic.h>.
+ */
+
+/* Cella del ring richieste */
+typedef struct {
+	uint32_t seq;                    // Protocollo di Vyukov: pos = libera, pos + 1 = piena
+	uint32_t client_slot;            // Slot del client a cui rispondere
+	uint32_t tag;                    // Identificativo scelto dal client, ripetuto nella risposta
+	uint8_t payload[REQUEST_SIZE];   // Richiesta serializzata (serialize_request)
+} shm_request_cell_t;
+
+/* Cella del ring risposte */
+typedef struct {
+	uint32_t tag;
+	uint8_t payload[RESPONSE_SIZE];  // Risposta serializzata (serialize_response)
+} shm_response_cell_t;
+
+/* Slot di un client */
+typedef struct {
+	uint32_t owner_pid;              // 0 = slot libero
+	uint32_t waiting;                // 1 se il client dorme sul futex
+	uint32_t response_head;          // Risposte scritte dal server (parola futex)
+	uint32_t response_tail;          // Risposte consumate dal client
+	shm_response_cell_t ring[SHM_RESPONSE_RING];
+} __attribute__((aligned(SHM_CACHE_LINE))) shm_client_slot_t;
+
+/* Segmento completo */
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t server_pid;
+
+	uint32_t request_head __attribute__((aligned(SHM_CACHE_LINE)));  // Prossima cella da riempire
+	uint32_t request_tail __attribute__((aligned(SHM_CACHE_LINE)));  // Prossima cella da servire
+	uint32_t server_sleeping __attribute__((aligned(SHM_CACHE_LINE))); // 1 = suonare il campanello
+
+	shm_request_cell_t requests[SHM_REQUEST_RING];
+	shm_client_slot_t clients[SHM_MAX_CLIENTS];
+} shm_segment_t;
+
+/*
+ * ============================================================================
+ * LATO SERVER
+ * ============================================================================
+ */
+
+typedef struct {
+	shm_segment_t *segment;
+	int doorbell_fd;                 // FIFO registrata nel reactor (-1 se disattivo)
+	int port;
+	uint64_t requests_served;
+} shm_server_t;
+
+/*
+ * Crea segmento e campanello per la porta indicata
+ * Ritorna 0 in caso di successo, -1 in caso di errore (o piattaforma non supportata)
+ */
+int shm_server_open(shm_server_t *server, int port);
+
+/*
+ * Riprende segmento e campanello lasciati da un server che ha ceduto i
+ * socket (handoff): i client già collegati continuano senza riconnettersi.
+ * Se il segmento non esiste o non è valido ne crea uno nuovo (shm_server_open)
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int shm_server_attach(shm_server_t *server, int port);
+
+/* Rimuove segmento e campanello */
+void shm_server_close(shm_server_t *server);
+
+/* Stacca il server da segmento e campanello senza rimuoverli (ripresi dal successore) */
+void shm_server_detach(shm_server_t *server);
+
+/*
+ * Estrae una richiesta dal ring
+ * Ritorna 1 se una richiesta è stata copiata in payload (REQUEST_SIZE byte), 0 se il ring è vuoto
+ */
+int shm_server_poll(shm_server_t *server, uint8_t *payload, uint32_t *client_slot, uint32_t *tag);
+
+/*
+ * Consegna una risposta serializzata al client dello slot indicato
+ * Ritorna 0 in caso di successo, -1 se il ring del client è pieno
+ */
+int shm_server_respond(shm_server_t *server, uint32_t client_slot, uint32_t tag, const uint8_t *payload);
+
+/*
+ * Da chiamare prima di bloccarsi in epoll_wait(): dichiara che il server dorme
+ * Ritorna 0 se il server può dormire, 1 se nel frattempo sono arrivate richieste
+ */
+int shm_server_prepare_sleep(shm_server_t *server);
+
+/* Da chiamare dopo il risveglio: svuota il campanello */
+void shm_server_wake(shm_server_t *server);
+
+/*
+ * ============================================================================
+ * LATO CLIENT
+ * ============================================================================
+ */
+
+typedef struct {
+	shm_segment_t *segment;
+	int doorbell_fd;
+	uint32_t slot;                   // Slot occupato nel segmento
+	uint32_t next_tag;               // Parte da pid e orologio, non da 0: slot ereditati
+} shm_client_t;
+
+/*
+ * Si collega al segmento del server sulla porta indicata e occupa uno slot
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int shm_client_open(shm_client_t *client, int port);
+
+/* Libera lo slot e scollega il segmento */
+void shm_client_close(shm_client_t *client);
+
+/*
+ * Invia una richiesta serializzata e attende la risposta serializzata
+ * Ritorna 0 in caso di successo, -1 in caso di errore o timeout
+ */
+int shm_client_request(shm_client_t *client, const uint8_t *request, uint8_t *response, int timeout_ms);
+
+#endif /* SHM_TRANSPORT_H_ */
@@ -0,0 +1,359 @@
+/*
+ * simulation.c
+ *
+ * Simulazione meteo coerente nel tempo
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "simulation.h"
+
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Parametri del modello
+ * Le anomalie sono processi di Ornstein-Uhlenbeck: a' = a * decay + sigma * rumore,
+ * con decay = exp(-dt / tau) e sigma scelto perché la deviazione standard
+ * stazionaria valga *_STDDEV qualunque sia il passo dt.
+ */
+#define SIM_PI 3.14159265358979323846
+
+#define TEMPERATURE_BASE_MIN 8.0f       // Media giornaliera delle città in [min, max]
+#define TEMPERATURE_BASE_MAX 20.0f
+#define DIURNAL_AMPLITUDE 6.0f          // Escursione diurna (picco alle 15, minimo alle 3)
+#define TEMPERATURE_TAU_S 21600.0       // 6 ore
+#define TEMPERATURE_STDDEV 3.0
+
+#define HUMIDITY_BASE 65.0f
+#define HUMIDITY_PER_DEGREE 2.0f        // -2% per ogni grado sopra la media
+#define HUMIDITY_TAU_S 10800.0          // 3 ore
+#define HUMIDITY_STDDEV 10.0
+
+#define PRESSURE_BASE 1013.0f
+#define PRESSURE_TAU_S 86400.0          // 1 giorno
+#define PRESSURE_STDDEV 8.0
+
+#define WIND_BASE 20.0f
+#define WIND_PER_HPA 1.0f               // +1 km/h per ogni hPa sotto la media
+#define WIND_TAU_S 3600.0               // 1 ora
+#define WIND_STDDEV 8.0
+
+/* Correlazioni tra i rumori: umidità anticorrelata alla temperatura, vento alla pressione */
+#define HUMIDITY_TEMPERATURE_CORRELATION -0.6f
+#define WIND_PRESSURE_CORRELATION -0.5f
+
+/* Rumore uniforme in [-1, 1) ha varianza 1/3: il fattore lo porta a varianza 1 */
+#define UNIFORM_TO_UNIT 1.7320508f
+
+/* Coefficienti di un passo, calcolati una volta per tick e uguali per tutte le città */
+typedef struct {
+	float diurnal_prev;             // Termine diurno all'istante precedente
+	float diurnal_now;
+	float decay_t, sigma_t;
+	float decay_h, sigma_h;
+	float decay_p, sigma_p;
+	float decay_w, sigma_w;
+} step_coefficients_t;
+
+static float clampf(float v, float lo, float hi) {
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+/* Ciclo diurno in [-1, 1]: massimo alle 15, minimo alle 3 */
+static float diurnal(double day_seconds) {
+	return (float)sin(2.0 * SIM_PI * (day_seconds / 86400.0 - 0.375));
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/* Rumore in [-1, 1) dai bit del generatore (interpretati con segno) */
+static float noise_from_bits(uint32_t bits) {
+	return (float)(int32_t)bits * (1.0f / 2147483648.0f);
+}
+
+static void ou_coefficients(double dt, double tau, double stddev, float *decay, float *sigma) {
+	double d = exp(-dt / tau);
+	*decay = (float)d;
+	*sigma = (float)(stddev * sqrt(1.0 - d * d)) * UNIFORM_TO_UNIT;
+}
+
+int simulation_init(simulation_t *sim, int32_t city_count, uint32_t seed, uint32_t tick_ms,
+                    double time_scale, uint64_t now_ms) {
+	// OROLOGIO: l'ora del giorno simulata parte da quella locale
+	time_t wall = time(NULL);
+	struct tm *local = localtime(&wall);
+	double day_seconds = local ? local->tm_hour * 3600.0 + local->tm_min * 60.0 + local->tm_sec : 0.0;
+	return simulation_init_at(sim, city_count, seed, tick_ms, time_scale, now_ms, day_seconds);
+}
+
+int simulation_init_at(simulation_t *sim, int32_t city_count, uint32_t seed, uint32_t tick_ms,
+                       double time_scale, uint64_t now_ms, double day_seconds) {
+	if (!sim || city_count <= 0 || tick_ms == 0) {
+		return -1;
+	}
+
+	memset(sim, 0, sizeof(*sim));
+	sim->city_count = city_count;
+	sim->padded_count = (city_count + 3) & ~3;
+	sim->tick_ms = tick_ms;
+	sim->time_scale = time_scale;
+
+	size_t n = (size_t)sim->padded_count;
+	sim->temperature = (float *)malloc(n * sizeof(float));
+	sim->humidity = (float *)malloc(n * sizeof(float));
+	sim->wind = (float *)malloc(n * sizeof(float));
+	sim->pressure = (float *)malloc(n * sizeof(float));
+	sim->base_temperature = (float *)malloc(n * sizeof(float));
+	sim->rng = (uint32_t *)malloc(n * sizeof(uint32_t));
+	if (!sim->temperature || !sim->humidity || !sim->wind || !sim->pressure ||
+	    !sim->base_temperature || !sim->rng) {
+		simulation_free(sim);
+		return -1;
+	}
+
+	sim->day_seconds = day_seconds;
+	sim->last_tick_ms = now_ms;
+	sim->next_tick_ms = now_ms + tick_ms;
+
+	// STATO INIZIALE: anomalie estratte dalla distribuzione stazionaria
+	float d0 = diurnal(sim->day_seconds);
+	for (size_t i = 0; i < n; i++) {
+		// Seme per città mai nullo (xorshift32 resterebbe a zero)
+		uint32_t state = (uint32_t)(seed ^ ((uint32_t)i * 0x9E3779B9u)) | 1u;
+		xorshift32(&state);
+
+		float unit = (noise_from_bits(xorshift32(&state)) + 1.0f) * 0.5f;
+		float base = TEMPERATURE_BASE_MIN + unit * (TEMPERATURE_BASE_MAX - TEMPERATURE_BASE_MIN);
+		float a_t = (float)TEMPERATURE_STDDEV * UNIFORM_TO_UNIT * noise_from_bits(xorshift32(&state));
+		float a_h = (float)HUMIDITY_STDDEV * UNIFORM_TO_UNIT * noise_from_bits(xorshift32(&state));
+		float a_p = (float)PRESSURE_STDDEV * UNIFORM_TO_UNIT * noise_from_bits(xorshift32(&state));
+		float a_w = (float)WIND_STDDEV * UNIFORM_TO_UNIT * noise_from_bits(xorshift32(&state));
+
+		sim->base_temperature[i] = base;
+		sim->rng[i] = state;
+		sim->temperature[i] = clampf(base + DIURNAL_AMPLITUDE * d0 + a_t, SIM_TEMPERATURE_MIN, SIM_TEMPERATURE_MAX);
+		sim->humidity[i] = clampf(HUMIDITY_BASE - HUMIDITY_PER_DEGREE * DIURNAL_AMPLITUDE * d0 + a_h,
+		                          SIM_HUMIDITY_MIN, SIM_HUMIDITY_MAX);
+		sim->pressure[i] = clampf(PRESSURE_BASE + a_p, SIM_PRESSURE_MIN, SIM_PRESSURE_MAX);
+		sim->wind[i] = clampf(WIND_BASE - WIND_PER_HPA * a_p + a_w, SIM_WIND_MIN, SIM_WIND_MAX);
+	}
+	return 0;
+}
+
+void simulation_free(simulation_t *sim) {
+	if (!sim) {
+		return;
+	}
+	free(sim->temperature);
+	free(sim->humidity);
+	free(sim->wind);
+	free(sim->pressure);
+	free(sim->base_temperature);
+	free(sim->rng);
+	sim->temperature = NULL;
+	sim->humidity = NULL;
+	sim->wind = NULL;
+	sim->pressure = NULL;
+	sim->base_temperature = NULL;
+	sim->rng = NULL;
+	sim->city_count = 0;
+	sim->padded_count = 0;
+}
+
+#if !defined __SSE2__
+
+/*
+ * Passo scalare per le città [from, to)
+ * Le anomalie non sono memorizzate: si ricavano dal valore corrente meno la
+ * parte deterministica dell'istante precedente (meno memoria da scorrere)
+ */
+static void step_scalar(simulation_t *sim, const step_coefficients_t *c, int32_t from, int32_t to) {
+	const float rho_h = HUMIDITY_TEMPERATURE_CORRELATION;
+	const float rho_w = WIND_PRESSURE_CORRELATION;
+	const float mix_h = sqrtf(1.0f - rho_h * rho_h);
+	const float mix_w = sqrtf(1.0f - rho_w * rho_w);
+
+	for (int32_t i = from; i < to; i++) {
+		float n1 = noise_from_bits(xorshift32(&sim->rng[i]));
+		float n2 = noise_from_bits(xorshift32(&sim->rng[i]));
+		float n3 = noise_from_bits(xorshift32(&sim->rng[i]));
+
+		float base = sim->base_temperature[i];
+
+		float a_t = sim->temperature[i] - (base + DIURNAL_AMPLITUDE * c->diurnal_prev);
+		a_t = a_t * c->decay_t + c->sigma_t * n1;
+		sim->temperature[i] = clampf(base + DIURNAL_AMPLITUDE * c->diurnal_now + a_t,
+		                             SIM_TEMPERATURE_MIN, SIM_TEMPERATURE_MAX);
+
+		float h_prev = HUMIDITY_BASE - HUMIDITY_PER_DEGREE * DIURNAL_AMPLITUDE * c->diurnal_prev;
+		float h_now = HUMIDITY_BASE - HUMIDITY_PER_DEGREE * DIURNAL_AMPLITUDE * c->diurnal_now;
+		float a_h = (sim->humidity[i] - h_prev) * c->decay_h + c->sigma_h * (rho_h * n1 + mix_h * n3);
+		sim->humidity[i] = clampf(h_now + a_h, SIM_HUMIDITY_MIN, SIM_HUMIDITY_MAX);
+
+		float a_p_prev = sim->pressure[i] - PRESSURE_BASE;
+		float a_p = a_p_prev * c->decay_p + c->sigma_p * n2;
+		sim->pressure[i] = clampf(PRESSURE_BASE + a_p, SIM_PRESSURE_MIN, SIM_PRESSURE_MAX);
+
+		float a_w = sim->wind[i] - (WIND_BASE - WIND_PER_HPA * a_p_prev);
+		a_w = a_w * c->decay_w + c->sigma_w * (rho_w * n2 + mix_w * n3);
+		sim->wind[i] = clampf(WIND_BASE - WIND_PER_HPA * a_p + a_w, SIM_WIND_MIN, SIM_WIND_MAX);
+	}
+}
+
+#else /* __SSE2__ */
+
+/* xorshift32 su 4 corsie indipendenti */
+static inline __m128i xorshift32x4(__m128i x) {
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+	x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+	return x;
+}
+
+static inline __m128 noise_x4(__m128i bits) {
+	return _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.0f / 2147483648.0f));
+}
+
+static inline __m128 clamp_x4(__m128 v, float lo, float hi) {
+	return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(lo)), _mm_set1_ps(hi));
+}
+
+/* Stesso calcolo del passo scalare, 4 città per iterazione (padded_count è multiplo di 4) */
+static void step_sse2(simulation_t *sim, const step_coefficients_t *c) {
+	const float rho_h = HUMIDITY_TEMPERATURE_CORRELATION;
+	const float rho_w = WIND_PRESSURE_CORRELATION;
+
+	const __m128 diurnal_prev = _mm_set1_ps(DIURNAL_AMPLITUDE * c->diurnal_prev);
+	const __m128 diurnal_now = _mm_set1_ps(DIURNAL_AMPLITUDE * c->diurnal_now);
+	const __m128 h_prev = _mm_set1_ps(HUMIDITY_BASE - HUMIDITY_PER_DEGREE * DIURNAL_AMPLITUDE * c->diurnal_prev);
+	const __m128 h_now = _mm_set1_ps(HUMIDITY_BASE - HUMIDITY_PER_DEGREE * DIURNAL_AMPLITUDE * c->diurnal_now);
+	const __m128 p_base = _mm_set1_ps(PRESSURE_BASE);
+	const __m128 w_base = _mm_set1_ps(WIND_BASE);
+	const __m128 w_per_hpa = _mm_set1_ps(WIND_PER_HPA);
+	const __m128 decay_t = _mm_set1_ps(c->decay_t), sigma_t = _mm_set1_ps(c->sigma_t);
+	const __m128 decay_h = _mm_set1_ps(c->decay_h), sigma_h = _mm_set1_ps(c->sigma_h);
+	const __m128 decay_p = _mm_set1_ps(c->decay_p), sigma_p = _mm_set1_ps(c->sigma_p);
+	const __m128 decay_w = _mm_set1_ps(c->decay_w), sigma_w = _mm_set1_ps(c->sigma_w);
+	const __m128 rho_h_v = _mm_set1_ps(rho_h), mix_h_v = _mm_set1_ps(sqrtf(1.0f - rho_h * rho_h));
+	const __m128 rho_w_v = _mm_set1_ps(rho_w), mix_w_v = _mm_set1_ps(sqrtf(1.0f - rho_w * rho_w));
+
+	for (int32_t i = 0; i < sim->padded_count; i += 4) {
+		__m128i state = _mm_loadu_si128((const __m128i *)(sim->rng + i));
+		state = xorshift32x4(state);
+		__m128 n1 = noise_x4(state);
+		state = xorshift32x4(state);
+		__m128 n2 = noise_x4(state);
+		state = xorshift32x4(state);
+		__m128 n3 = noise_x4(state);
+		_mm_storeu_si128((__m128i *)(sim->rng + i), state);
+
+		__m128 base = _mm_loadu_ps(sim->base_temperature + i);
+
+		// Temperatura
+		__m128 t = _mm_loadu_ps(sim->temperature + i);
+		__m128 a_t = _mm_sub_ps(t, _mm_add_ps(base, diurnal_prev));
+		a_t = _mm_add_ps(_mm_mul_ps(a_t, decay_t), _mm_mul_ps(sigma_t, n1));
+		t = clamp_x4(_mm_add_ps(_mm_add_ps(base, diurnal_now), a_t), SIM_TEMPERATURE_MIN, SIM_TEMPERATURE_MAX);
+		_mm_storeu_ps(sim->temperature + i, t);
+
+		// Umidità
+		__m128 h = _mm_loadu_ps(sim->humidity + i);
+		__m128 noise_h = _mm_add_ps(_mm_mul_ps(rho_h_v, n1), _mm_mul_ps(mix_h_v, n3));
+		__m128 a_h = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(h, h_prev), decay_h), _mm_mul_ps(sigma_h, noise_h));
+		h = clamp_x4(_mm_add_ps(h_now, a_h), SIM_HUMIDITY_MIN, SIM_HUMIDITY_MAX);
+		_mm_storeu_ps(sim->humidity + i, h);
+
+		// Pressione
+		__m128 a_p_prev = _mm_sub_ps(_mm_loadu_ps(sim->pressure + i), p_base);
+		__m128 a_p = _mm_add_ps(_mm_mul_ps(a_p_prev, decay_p), _mm_mul_ps(sigma_p, n2));
+		_mm_storeu_ps(sim->pressure + i, clamp_x4(_mm_add_ps(p_base, a_p), SIM_PRESSURE_MIN, SIM_PRESSURE_MAX));
+
+		// Vento
+		__m128 w = _mm_loadu_ps(sim->wind + i);
+		__m128 a_w = _mm_sub_ps(w, _mm_sub_ps(w_base, _mm_mul_ps(w_per_hpa, a_p_prev)));
+		__m128 noise_w = _mm_add_ps(_mm_mul_ps(rho_w_v, n2), _mm_mul_ps(mix_w_v, n3));
+		a_w = _mm_add_ps(_mm_mul_ps(a_w, decay_w), _mm_mul_ps(sigma_w, noise_w));
+		w = _mm_add_ps(_mm_sub_ps(w_base, _mm_mul_ps(w_per_hpa, a_p)), a_w);
+		_mm_storeu_ps(sim->wind + i, clamp_x4(w, SIM_WIND_MIN, SIM_WIND_MAX));
+	}
+}
+
+#endif /* __SSE2__ */
+
+void simulation_step(simulation_t *sim, double dt_seconds) {
+	if (!sim || sim->city_count == 0 || dt_seconds <= 0.0) {
+		return;
+	}
+
+	step_coefficients_t c;
+	c.diurnal_prev = diurnal(sim->day_seconds);
+	sim->day_seconds = fmod(sim->day_seconds + dt_seconds, 86400.0);
+	c.diurnal_now = diurnal(sim->day_seconds);
+	ou_coefficients(dt_seconds, TEMPERATURE_TAU_S, TEMPERATURE_STDDEV, &c.decay_t, &c.sigma_t);
+	ou_coefficients(dt_seconds, HUMIDITY_TAU_S, HUMIDITY_STDDEV, &c.decay_h, &c.sigma_h);
+	ou_coefficients(dt_seconds, PRESSURE_TAU_S, PRESSURE_STDDEV, &c.decay_p, &c.sigma_p);
+	ou_coefficients(dt_seconds, WIND_TAU_S, WIND_STDDEV, &c.decay_w, &c.sigma_w);
+
+#if defined __SSE2__
+	step_sse2(sim, &c);
+#else
+	step_scalar(sim, &c, 0, sim->padded_count);
+#endif
+}
+
+int simulation_next_timeout_ms(const simulation_t *sim, uint64_t now_ms) {
+	if (!sim || sim->city_count == 0) {
+		return -1;
+	}
+	return sim->next_tick_ms > now_ms ? (int)(sim->next_tick_ms - now_ms) : 0;
+}
+
+void simulation_advance(simulation_t *sim, uint64_t now_ms) {
+	if (!sim || sim->city_count == 0 || now_ms < sim->next_tick_ms) {
+		return;
+	}
+
+	// Un solo passo anche dopo un ritardo: dt copre tutto il tempo trascorso
+	double dt = (double)(now_ms - sim->last_tick_ms) / 1000.0 * sim->time_scale;
+	uint64_t start_ns = get_monotonic_ns();
+	simulation_step(sim, dt);
+	uint64_t elapsed_ns = get_monotonic_ns() - start_ns;
+
+	sim->ticks++;
+	sim->tick_ns_total += elapsed_ns;
+	if (elapsed_ns > sim->tick_ns_max) {
+		sim->tick_ns_max = elapsed_ns;
+	}
+
+	sim->last_tick_ms = now_ms;
+	sim->next_tick_ms = now_ms + sim->tick_ms;
+}
+
+float simulation_value(const simulation_t *sim, int city_index, char type) {
+	if (!sim || city_index < 0 || city_index >= sim->city_count) {
+		return 0.0f;
+	}
+	switch (type) {
+		case TYPE_TEMPERATURE:
+			return sim->temperature[city_index];
+		case TYPE_HUMIDITY:
+			return sim->humidity[city_index];
+		case TYPE_WIND:
+			return sim->wind[city_index];
+		case TYPE_PRESSURE:
+			return sim->pressure[city_index];
+		default:
+			return 0.0f;
+	}
+}
@@ -0,0 +1,119 @@
+/*
+ * simulation.h
+ *
+ * Simulazione meteo coerente nel tempo
+ * Ogni città ha uno stato che evolve a ogni tick: temperatura con ciclo
+ * diurno più un'anomalia che torna verso la media (processo di
+ * Ornstein-Uhlenbeck), umidità anticorrelata alla temperatura, pressione
+ * lenta e vento legato alle basse pressioni. I valori restano nei range
+ * dei generatori originali. Lo stato è structure-of-arrays e il tick
+ * aggiorna 4 città per istruzione (SSE2, con fallback scalare).
+ */
+
+#ifndef SIMULATION_H_
+#define SIMULATION_H_
+
+#include <stdint.h>
+#include "protocol.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define SIM_DEFAULT_TICK_MS 1000        // Periodo del tick
+#define SIM_DEFAULT_TIME_SCALE 1.0      // Secondi simulati per secondo reale
+#define SIM_MAX_CITIES 16777216         // Limite dell'opzione -C
+
+/* Range dei valori (gli stessi dei generatori casuali originali) */
+#define SIM_TEMPERATURE_MIN -10.0f
+#define SIM_TEMPERATURE_MAX 40.0f
+#define SIM_HUMIDITY_MIN 20.0f
+#define SIM_HUMIDITY_MAX 100.0f
+#define SIM_WIND_MIN 0.0f
+#define SIM_WIND_MAX 100.0f
+#define SIM_PRESSURE_MIN 950.0f
+#define SIM_PRESSURE_MAX 1050.0f
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	int32_t city_count;
+	int32_t padded_count;           // city_count arrotondato a multiplo di 4
+
+	// Stato osservabile (letto dai getter)
+	float *temperature;
+	float *humidity;
+	float *wind;
+	float *pressure;
+
+	// Parametri per città
+	float *base_temperature;        // Media giornaliera
+	uint32_t *rng;                  // xorshift32, uno per città (corsie SIMD indipendenti)
+
+	// Orologio simulato
+	uint32_t tick_ms;
+	double time_scale;
+	double day_seconds;             // Ora del giorno simulata in secondi
+	uint64_t last_tick_ms;
+	uint64_t next_tick_ms;
+
+	// Statistiche
+	uint64_t ticks;
+	uint64_t tick_ns_total;
+	uint64_t tick_ns_max;
+} simulation_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Alloca e inizializza lo stato di city_count città con il seme indicato
+ * L'ora del giorno simulata parte dall'ora locale
+ * Ritorna 0 in caso di successo, -1 se la memoria non basta
+ */
+int simulation_init(simulation_t *sim, int32_t city_count, uint32_t seed, uint32_t tick_ms,
+                    double time_scale, uint64_t now_ms);
+
+/*
+ * Come simulation_init(), con l'ora del giorno di partenza in secondi
+ * dalla mezzanotte: stesso seme e stessa ora danno la stessa evoluzione
+ */
+int simulation_init_at(simulation_t *sim, int32_t city_count, uint32_t seed, uint32_t tick_ms,
+                       double time_scale, uint64_t now_ms, double day_seconds);
+
+/*
+ * Libera lo stato della simulazione
+ */
+void simulation_free(simulation_t *sim);
+
+/*
+ * Avanza tutte le città di dt_seconds secondi simulati
+ */
+void simulation_step(simulation_t *sim, double dt_seconds);
+
+/*
+ * Millisecondi al prossimo tick
+ */
+int simulation_next_timeout_ms(const simulation_t *sim, uint64_t now_ms);
+
+/*
+ * Esegue il tick se è scaduto (dt = tempo reale trascorso per time_scale)
+ */
+void simulation_advance(simulation_t *sim, uint64_t now_ms);
+
+/*
+ * Valore corrente del tipo indicato per la città city_index
+ * Ritorna 0.0 per città o tipi non validi
+ */
+float simulation_value(const simulation_t *sim, int city_index, char type);
+
+#endif /* SIMULATION_H_ */
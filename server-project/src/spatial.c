@@ -0,0 +1,228 @@
+/*
+ * spatial.c
+ *
+ * Indice spaziale per la ricerca della città più vicina
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "spatial.h"
+
+#define DEGREES_TO_RADIANS (3.14159265358979323846f / 180.0f)
+#define LEAF_SIZE 16                    // Intervalli più piccoli: scansione lineare (contigua)
+
+/* Trigonometria in float: la precisione (~1 m) basta e costa molto meno */
+static void to_unit_vector(float latitude, float longitude, float *x, float *y, float *z) {
+	float lat = latitude * DEGREES_TO_RADIANS;
+	float lon = longitude * DEGREES_TO_RADIANS;
+	float cos_lat = cosf(lat);
+	*x = cos_lat * cosf(lon);
+	*y = cos_lat * sinf(lon);
+	*z = sinf(lat);
+}
+
+/* Corda al quadrato sulla sfera unitaria -> distanza sul globo */
+static float chord2_to_km(float chord2) {
+	double chord = sqrt(chord2);
+	if (chord > 2.0) {
+		chord = 2.0;
+	}
+	return (float)(2.0 * asin(chord / 2.0) * EARTH_RADIUS_KM);
+}
+
+static float axis_value(const spatial_point_t *p, int axis) {
+	return axis == 0 ? p->x : (axis == 1 ? p->y : p->z);
+}
+
+static void swap_points(spatial_point_t *a, spatial_point_t *b) {
+	spatial_point_t tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+/* Quickselect: mette in posizione k l'elemento k-esimo lungo l'asse, minori a sinistra */
+static void select_kth(spatial_point_t *points, int32_t lo, int32_t hi, int32_t k, int axis) {
+	while (hi > lo) {
+		// Pivot: mediana di tre
+		int32_t mid = lo + (hi - lo) / 2;
+		if (axis_value(&points[mid], axis) < axis_value(&points[lo], axis)) swap_points(&points[mid], &points[lo]);
+		if (axis_value(&points[hi], axis) < axis_value(&points[lo], axis)) swap_points(&points[hi], &points[lo]);
+		if (axis_value(&points[hi], axis) < axis_value(&points[mid], axis)) swap_points(&points[hi], &points[mid]);
+		float pivot = axis_value(&points[mid], axis);
+
+		int32_t i = lo;
+		int32_t j = hi;
+		while (i <= j) {
+			while (axis_value(&points[i], axis) < pivot) i++;
+			while (axis_value(&points[j], axis) > pivot) j--;
+			if (i <= j) {
+				swap_points(&points[i], &points[j]);
+				i++;
+				j--;
+			}
+		}
+		if (k <= j) {
+			hi = j;
+		} else if (k >= i) {
+			lo = i;
+		} else {
+			return;
+		}
+	}
+}
+
+/*
+ * Costruzione ricorsiva: l'intervallo [lo, hi) del nodo node (numerazione BFS,
+ * radice 1) è diviso alla mediana; la mediana apre il figlio destro
+ */
+static void build(spatial_point_t *points, float *splits, uint32_t node, int32_t lo, int32_t hi, int depth) {
+	if (hi - lo <= LEAF_SIZE) {
+		return; // Foglia: nessun ordine interno
+	}
+	int axis = depth % 3;
+	int32_t mid = lo + (hi - lo) / 2;
+	select_kth(points, lo, hi - 1, mid, axis);
+	splits[node] = axis_value(&points[mid], axis);
+	build(points, splits, 2 * node, lo, mid, depth + 1);
+	build(points, splits, 2 * node + 1, mid, hi, depth + 1);
+}
+
+int spatial_index_build(spatial_index_t *index, const float *latitude, const float *longitude, int32_t count) {
+	if (!index || count < 0) {
+		return -1;
+	}
+
+	memset(index, 0, sizeof(*index));
+	if (count == 0) {
+		return 0;
+	}
+
+	index->nodes = (spatial_point_t *)malloc((size_t)count * sizeof(spatial_point_t));
+	if (!index->nodes) {
+		return -1;
+	}
+	for (int32_t i = 0; i < count; i++) {
+		spatial_point_t *p = &index->nodes[i];
+		to_unit_vector(latitude[i], longitude[i], &p->x, &p->y, &p->z);
+		p->city = i;
+	}
+	index->count = count;
+
+	// Profondità dell'albero: gli intervalli si dimezzano fino a LEAF_SIZE punti
+	int depth = 0;
+	for (int32_t n = count; n > LEAF_SIZE; n = n - n / 2) {
+		depth++;
+	}
+	index->splits = (float *)calloc((size_t)1 << (depth + 1), sizeof(float));
+	if (!index->splits) {
+		spatial_index_free(index);
+		return -1;
+	}
+
+	build(index->nodes, index->splits, 1, 0, count, 0);
+	return 0;
+}
+
+void spatial_index_free(spatial_index_t *index) {
+	if (!index) {
+		return;
+	}
+	free(index->nodes);
+	free(index->splits);
+	index->nodes = NULL;
+	index->splits = NULL;
+	index->count = 0;
+}
+
+typedef struct {
+	float x, y, z;
+	float best_d2;
+	int32_t best;
+} nearest_query_t;
+
+static void scan_leaf(const spatial_point_t *nodes, int32_t lo, int32_t hi, nearest_query_t *q) {
+	for (int32_t i = lo; i < hi; i++) {
+		float dx = nodes[i].x - q->x;
+		float dy = nodes[i].y - q->y;
+		float dz = nodes[i].z - q->z;
+		float d2 = dx * dx + dy * dy + dz * dz;
+		if (d2 < q->best_d2) {
+			q->best_d2 = d2;
+			q->best = nodes[i].city;
+		}
+	}
+}
+
+static void search(const spatial_index_t *index, uint32_t node, int32_t lo, int32_t hi, int depth,
+                   nearest_query_t *q) {
+	while (hi - lo > LEAF_SIZE) {
+		int axis = depth % 3;
+		int32_t mid = lo + (hi - lo) / 2;
+		float q_axis = axis == 0 ? q->x : (axis == 1 ? q->y : q->z);
+		float diff = q_axis - index->splits[node];
+
+		// Prima il lato della query; l'altro solo se il piano è più vicino del migliore
+		if (diff < 0.0f) {
+			search(index, 2 * node, lo, mid, depth + 1, q);
+			if (diff * diff >= q->best_d2) {
+				return;
+			}
+			node = 2 * node + 1; // Lato lontano in coda (iterazione invece di ricorsione)
+			lo = mid;
+		} else {
+			search(index, 2 * node + 1, mid, hi, depth + 1, q);
+			if (diff * diff >= q->best_d2) {
+				return;
+			}
+			node = 2 * node;
+			hi = mid;
+		}
+		depth++;
+	}
+	scan_leaf(index->nodes, lo, hi, q);
+}
+
+int32_t spatial_index_nearest(const spatial_index_t *index, float latitude, float longitude, float *distance_km) {
+	if (!index || index->count == 0) {
+		return -1;
+	}
+
+	nearest_query_t q;
+	to_unit_vector(latitude, longitude, &q.x, &q.y, &q.z);
+	q.best_d2 = INFINITY;
+	q.best = -1;
+
+	search(index, 1, 0, index->count, 0, &q);
+
+	if (distance_km) {
+		*distance_km = chord2_to_km(q.best_d2);
+	}
+	return q.best;
+}
+
+int32_t spatial_nearest_brute_force(const spatial_index_t *index, float latitude, float longitude,
+                                    float *distance_km) {
+	if (!index || index->count == 0) {
+		return -1;
+	}
+
+	float qx, qy, qz;
+	to_unit_vector(latitude, longitude, &qx, &qy, &qz);
+
+	float best_d2 = INFINITY;
+	int32_t best = -1;
+	for (int32_t i = 0; i < index->count; i++) {
+		const spatial_point_t *p = &index->nodes[i];
+		float d2 = (p->x - qx) * (p->x - qx) + (p->y - qy) * (p->y - qy) + (p->z - qz) * (p->z - qz);
+		if (d2 < best_d2) {
+			best_d2 = d2;
+			best = p->city;
+		}
+	}
+
+	if (distance_km) {
+		*distance_km = chord2_to_km(best_d2);
+	}
+	return best;
+}
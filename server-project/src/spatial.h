@@ -0,0 +1,56 @@
+/*
+ * spatial.h
+ *
+ * Indice spaziale per la ricerca della città più vicina
+ * Le coordinate sono convertite in punti sulla sfera unitaria (x, y, z):
+ * la distanza euclidea tra due punti cresce con la distanza sul globo,
+ * quindi un k-d tree 3D trova il vicino esatto senza casi speciali ai
+ * poli o sull'antimeridiano. L'albero è implicito (mediana al centro di
+ * ogni intervallo dell'array), senza puntatori: i piani di taglio stanno
+ * in un array compatto in ordine BFS, così i livelli alti restano in cache,
+ * e i punti delle foglie sono contigui.
+ */
+
+#ifndef SPATIAL_H_
+#define SPATIAL_H_
+
+#include <stdint.h>
+
+#define EARTH_RADIUS_KM 6371.0
+
+typedef struct {
+	float x, y, z;
+	int32_t city;                   // Indice della città nel catalogo
+} spatial_point_t;
+
+typedef struct {
+	spatial_point_t *nodes;         // Punti in ordine di k-d tree implicito
+	float *splits;                  // Piani di taglio per nodo (radice 1, figli 2n e 2n+1)
+	int32_t count;
+} spatial_index_t;
+
+/*
+ * Costruisce l'indice sulle coordinate (gradi) di count città
+ * Ritorna 0 in caso di successo, -1 se la memoria non basta
+ */
+int spatial_index_build(spatial_index_t *index, const float *latitude, const float *longitude, int32_t count);
+
+/*
+ * Libera l'indice
+ */
+void spatial_index_free(spatial_index_t *index);
+
+/*
+ * Città più vicina alle coordinate indicate (gradi); distance_km può essere NULL
+ * Ritorna l'indice della città, -1 se l'indice è vuoto
+ */
+int32_t spatial_index_nearest(const spatial_index_t *index, float latitude, float longitude, float *distance_km);
+
+/*
+ * Scansione lineare degli stessi punti, stessa semantica di spatial_index_nearest
+ * (verifica e benchmark)
+ */
+int32_t spatial_nearest_brute_force(const spatial_index_t *index, float latitude, float longitude,
+                                    float *distance_km);
+
+#endif /* SPATIAL_H_ */
@@ -0,0 +1,425 @@
+/*
+ * subscription.c
+ *
+ * Modalità push: tabella dei sottoscrittori, timer wheel e invio batch
+ *
+ * - Le sottoscrizioni vivono in un array preallocato (nessuna malloc a regime)
+ * - Un indice hash su (ip, porta, città) permette rinnovo/annullamento in O(1)
+ * - Un timer wheel a slot fissi raccoglie le sottoscrizioni per istante di push
+ * - I push partono a lotti dal trasporto della tabella (transport.h): i tipi
+ *   multipli destinati allo stesso client sono un solo messaggio a segmenti
+ *   da RESPONSE_SIZE byte, che sui socket viaggia con UDP GSO
+ */
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "subscription.h"
+
+/* Tipi nell'ordine di invio, allineati ai bit SUB_MASK_* */
+static const char push_types[4] = { TYPE_TEMPERATURE, TYPE_HUMIDITY, TYPE_WIND, TYPE_PRESSURE };
+
+#define MAX_SEGMENTS 4
+
+/*
+ * Batch di messaggi in uscita
+ * Ogni elemento raccoglie i push di una sottoscrizione, uno per tipo, come
+ * segmenti da RESPONSE_SIZE byte dello stesso messaggio
+ */
+typedef struct {
+	uint8_t payload[PUSH_BATCH_SIZE][MAX_SEGMENTS * RESPONSE_SIZE];
+	endpoint_addr_t addr[PUSH_BATCH_SIZE];
+	transport_message_t messages[PUSH_BATCH_SIZE];
+	int count;
+	int sock;                   // Socket comune a tutto il batch
+} push_batch_t;
+
+static push_batch_t push_batch;
+
+/*
+ * Hash di (ip, porta, città)
+ */
+static uint32_t subscription_hash(const endpoint_addr_t *addr, int32_t city_index) {
+	uint32_t h = (uint32_t)addr->v4.sin_addr.s_addr;
+#if !defined WIN32
+	if (addr->sa.sa_family == AF_INET6) {
+		uint32_t words[4];
+		memcpy(words, &addr->v6.sin6_addr, sizeof(words));
+		h = words[0] ^ words[1] ^ words[2] ^ words[3];
+	}
+#endif
+	h ^= ((uint32_t)addr->v4.sin_port << 16) | (uint32_t)addr->v4.sin_port;
+	h ^= (uint32_t)city_index * 0x9E3779B1u;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 16;
+	return h;
+}
+
+static int same_client(const endpoint_addr_t *a, const endpoint_addr_t *b) {
+	if (a->sa.sa_family != b->sa.sa_family || a->v4.sin_port != b->v4.sin_port) {
+		return 0;
+	}
+#if !defined WIN32
+	if (a->sa.sa_family == AF_INET6) {
+		return memcmp(&a->v6.sin6_addr, &b->v6.sin6_addr, sizeof(a->v6.sin6_addr)) == 0;
+	}
+#endif
+	return a->v4.sin_addr.s_addr == b->v4.sin_addr.s_addr;
+}
+
+/*
+ * Gestione liste del timer wheel
+ */
+static void wheel_insert(subscription_table_t *table, int32_t index) {
+	subscription_t *entry = &table->entries[index];
+
+	// Mai in uno slot già elaborato: altrimenti il push slitterebbe di un giro intero
+	uint64_t tick = entry->next_due_ms / WHEEL_TICK_MS;
+	if (tick <= table->wheel_tick) {
+		tick = table->wheel_tick + 1;
+	}
+
+	int32_t slot = (int32_t)(tick & (WHEEL_SLOTS - 1));
+	entry->wheel_prev = -slot - 2; // Valore negativo: l'elemento è testa dello slot
+	entry->wheel_next = table->wheel[slot];
+	if (entry->wheel_next >= 0) {
+		table->entries[entry->wheel_next].wheel_prev = index;
+	}
+	table->wheel[slot] = index;
+}
+
+static void wheel_remove(subscription_table_t *table, int32_t index) {
+	subscription_t *entry = &table->entries[index];
+
+	if (entry->wheel_prev >= 0) {
+		table->entries[entry->wheel_prev].wheel_next = entry->wheel_next;
+	} else {
+		table->wheel[-entry->wheel_prev - 2] = entry->wheel_next;
+	}
+	if (entry->wheel_next >= 0) {
+		table->entries[entry->wheel_next].wheel_prev = entry->wheel_prev;
+	}
+	entry->wheel_next = -1;
+	entry->wheel_prev = -1;
+}
+
+/*
+ * Gestione indice hash
+ */
+static int32_t hash_lookup(const subscription_table_t *table, const endpoint_addr_t *addr,
+                           int32_t city_index) {
+	int32_t index = table->buckets[subscription_hash(addr, city_index) & table->bucket_mask];
+
+	while (index >= 0) {
+		const subscription_t *entry = &table->entries[index];
+		if (entry->city_index == city_index && same_client(&entry->addr, addr)) {
+			return index;
+		}
+		index = entry->hash_next;
+	}
+	return -1;
+}
+
+static void hash_remove(subscription_table_t *table, int32_t index) {
+	subscription_t *entry = &table->entries[index];
+	int32_t *link = &table->buckets[subscription_hash(&entry->addr, entry->city_index) & table->bucket_mask];
+
+	while (*link >= 0) {
+		if (*link == index) {
+			*link = entry->hash_next;
+			break;
+		}
+		link = &table->entries[*link].hash_next;
+	}
+	entry->hash_next = -1;
+}
+
+/* Rimuove una sottoscrizione già staccata dal wheel e la rimette nella free list */
+static void release_entry(subscription_table_t *table, int32_t index) {
+	subscription_t *entry = &table->entries[index];
+
+	hash_remove(table, index);
+	entry->in_use = 0;
+	entry->wheel_next = table->free_head;
+	table->free_head = index;
+	table->count--;
+}
+
+/* Occupa un elemento della free list con i campi di source e lo collega a hash e wheel */
+static int insert_entry(subscription_table_t *table, const subscription_t *source) {
+	if (table->free_head < 0) {
+		return -1;
+	}
+
+	int32_t index = table->free_head;
+	subscription_t *entry = &table->entries[index];
+	table->free_head = entry->wheel_next;
+
+	memset(entry, 0, sizeof(*entry));
+	entry->addr = source->addr;
+	entry->sock = source->sock;
+	entry->city_index = source->city_index;
+	entry->types = source->types;
+	entry->interval_ms = source->interval_ms;
+	entry->next_due_ms = source->next_due_ms;
+	entry->lease_expiry_ms = source->lease_expiry_ms;
+	entry->in_use = 1;
+
+	uint32_t bucket = subscription_hash(&entry->addr, entry->city_index) & table->bucket_mask;
+	entry->hash_next = table->buckets[bucket];
+	table->buckets[bucket] = index;
+
+	wheel_insert(table, index);
+	table->count++;
+	return 0;
+}
+
+int subscription_table_init(subscription_table_t *table, int32_t capacity, const transport_t *transport,
+                            uint64_t now_ms) {
+	if (!table || capacity <= 0 || !transport) {
+		return -1;
+	}
+
+	memset(table, 0, sizeof(*table));
+
+	uint32_t buckets = 1;
+	while (buckets < (uint32_t)capacity) {
+		buckets <<= 1;
+	}
+
+	table->entries = (subscription_t *)calloc((size_t)capacity, sizeof(subscription_t));
+	table->buckets = (int32_t *)malloc(buckets * sizeof(int32_t));
+	if (!table->entries || !table->buckets) {
+		subscription_table_free(table);
+		return -1;
+	}
+
+	table->capacity = capacity;
+	table->bucket_mask = buckets - 1;
+	memset(table->buckets, 0xFF, buckets * sizeof(int32_t)); // Tutti -1
+	for (int i = 0; i < WHEEL_SLOTS; i++) {
+		table->wheel[i] = -1;
+	}
+
+	// Free list: tutti gli elementi concatenati tramite wheel_next
+	for (int32_t i = 0; i < capacity; i++) {
+		table->entries[i].wheel_next = (i + 1 < capacity) ? i + 1 : -1;
+		table->entries[i].wheel_prev = -1;
+		table->entries[i].hash_next = -1;
+	}
+	table->free_head = 0;
+	table->wheel_tick = now_ms / WHEEL_TICK_MS;
+	table->transport = transport;
+
+	return 0;
+}
+
+void subscription_table_free(subscription_table_t *table) {
+	if (!table) {
+		return;
+	}
+	free(table->entries);
+	free(table->buckets);
+	table->entries = NULL;
+	table->buckets = NULL;
+	table->capacity = 0;
+	table->count = 0;
+}
+
+int subscription_register(subscription_table_t *table, int sock, const endpoint_addr_t *client_addr,
+                          const subscribe_request_t *request, uint64_t now_ms) {
+	if (!table || !client_addr || !request) {
+		return STATUS_INVALID_REQUEST;
+	}
+
+	// Stessa validazione del nome città usata per le richieste singole
+	weather_request_t check;
+	memset(&check, 0, sizeof(check));
+	check.type = TYPE_TEMPERATURE;
+	memcpy(check.city, request->city, sizeof(check.city));
+
+	int status = validate_request_server(&check);
+	if (status != STATUS_SUCCESS) {
+		return status;
+	}
+	if (request->types & ~SUB_MASK_ALL) {
+		return STATUS_INVALID_REQUEST;
+	}
+
+	int32_t city_index = find_city_index(request->city);
+	int32_t index = hash_lookup(table, client_addr, city_index);
+
+	// ANNULLAMENTO
+	if (request->interval_ms == 0 || request->types == 0) {
+		if (index >= 0) {
+			wheel_remove(table, index);
+			release_entry(table, index);
+		}
+		return STATUS_SUCCESS;
+	}
+
+	uint32_t interval = request->interval_ms;
+	if (interval < SUBSCRIPTION_MIN_INTERVAL_MS) {
+		interval = SUBSCRIPTION_MIN_INTERVAL_MS;
+	}
+	if (interval > SUBSCRIPTION_MAX_INTERVAL_MS) {
+		interval = SUBSCRIPTION_MAX_INTERVAL_MS;
+	}
+
+	// RINNOVO
+	if (index >= 0) {
+		subscription_t *entry = &table->entries[index];
+		entry->types = request->types;
+		entry->interval_ms = interval;
+		entry->lease_expiry_ms = now_ms + SUBSCRIPTION_LEASE_MS;
+		entry->sock = sock; // Il rinnovo può arrivare da un altro socket
+
+		// Intervallo ridotto: anticipa il prossimo push
+		if (entry->next_due_ms > now_ms + interval) {
+			wheel_remove(table, index);
+			entry->next_due_ms = now_ms + interval;
+			wheel_insert(table, index);
+		}
+		return STATUS_SUCCESS;
+	}
+
+	// NUOVA SOTTOSCRIZIONE: primo push al prossimo tick
+	subscription_t fresh;
+	memset(&fresh, 0, sizeof(fresh));
+	fresh.addr = *client_addr;
+	fresh.sock = sock;
+	fresh.city_index = city_index;
+	fresh.types = request->types;
+	fresh.interval_ms = interval;
+	fresh.next_due_ms = now_ms;
+	fresh.lease_expiry_ms = now_ms + SUBSCRIPTION_LEASE_MS;
+	return insert_entry(table, &fresh) == 0 ? STATUS_SUCCESS : STATUS_SERVER_BUSY;
+}
+
+int subscription_restore(subscription_table_t *table, const subscription_t *saved) {
+	if (!table || !table->entries || !saved || hash_lookup(table, &saved->addr, saved->city_index) >= 0) {
+		return -1;
+	}
+	return insert_entry(table, saved);
+}
+
+int subscription_next_timeout_ms(const subscription_table_t *table, uint64_t now_ms) {
+	if (!table || table->count == 0) {
+		return -1;
+	}
+
+	// Primo slot non vuoto dopo l'ultimo tick elaborato
+	for (uint64_t tick = table->wheel_tick + 1; tick <= table->wheel_tick + WHEEL_SLOTS; tick++) {
+		if (table->wheel[tick & (WHEEL_SLOTS - 1)] >= 0) {
+			uint64_t due_ms = tick * WHEEL_TICK_MS;
+			return due_ms > now_ms ? (int)(due_ms - now_ms) : 0;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Invio del batch
+ */
+static void flush_batch(subscription_table_t *table) {
+	if (push_batch.count == 0) {
+		return;
+	}
+	transport_send_batch(table->transport, push_batch.sock, push_batch.messages, push_batch.count);
+	push_batch.count = 0;
+}
+
+/* Accoda i valori di una sottoscrizione (uno per tipo) */
+static void queue_push(subscription_table_t *table, const subscription_t *entry) {
+	if (!(entry->types & SUB_MASK_ALL)) {
+		return;
+	}
+
+	// Un batch parte da un solo socket: cambio di socket = invio del batch corrente
+	if ((push_batch.count > 0 && push_batch.sock != entry->sock) || push_batch.count == PUSH_BATCH_SIZE) {
+		flush_batch(table);
+	}
+	push_batch.sock = entry->sock;
+
+	// Un segmento per tipo sottoscritto, serializzato direttamente nel batch
+	int slot = push_batch.count++;
+	uint8_t *payload = push_batch.payload[slot];
+	int segments = 0;
+	for (int i = 0; i < MAX_SEGMENTS; i++) {
+		if (!(entry->types & (1u << i))) {
+			continue;
+		}
+		weather_response_t response;
+		response.status = STATUS_SUCCESS;
+		response.type = push_types[i];
+		response.value = get_weather_value(entry->city_index, push_types[i]);
+		serialize_response(&response, payload + segments * RESPONSE_SIZE);
+		segments++;
+	}
+
+	push_batch.addr[slot] = entry->addr;
+	push_batch.messages[slot].data = payload;
+	push_batch.messages[slot].length = segments * (int)RESPONSE_SIZE;
+	push_batch.messages[slot].segment_size = (int)RESPONSE_SIZE;
+	push_batch.messages[slot].addr = &push_batch.addr[slot];
+
+	table->pushes_sent += (uint64_t)segments;
+}
+
+void subscription_advance(subscription_table_t *table, uint64_t now_ms) {
+	if (!table || !table->entries) {
+		return;
+	}
+
+	uint64_t target_tick = now_ms / WHEEL_TICK_MS;
+	if (target_tick <= table->wheel_tick) {
+		return;
+	}
+
+	// Dopo un blocco lungo basta un giro completo: ogni slot viene visitato una volta
+	uint64_t first_tick = table->wheel_tick + 1;
+	if (target_tick - first_tick >= WHEEL_SLOTS) {
+		first_tick = target_tick - WHEEL_SLOTS + 1;
+	}
+
+	for (uint64_t tick = first_tick; tick <= target_tick; tick++) {
+		int32_t slot = (int32_t)(tick & (WHEEL_SLOTS - 1));
+		int32_t index = table->wheel[slot];
+		table->wheel[slot] = -1;
+		table->wheel_tick = tick;
+
+		while (index >= 0) {
+			subscription_t *entry = &table->entries[index];
+			int32_t next = entry->wheel_next;
+
+			if (entry->lease_expiry_ms <= now_ms) {
+				// Lease scaduto: il sottoscrittore non ha rinnovato
+				release_entry(table, index);
+				table->leases_expired++;
+			} else {
+				if (entry->next_due_ms <= now_ms) {
+					queue_push(table, entry);
+					entry->next_due_ms += entry->interval_ms;
+					if (entry->next_due_ms <= now_ms) {
+						entry->next_due_ms = now_ms + entry->interval_ms;
+					}
+				}
+				wheel_insert(table, index);
+			}
+			index = next;
+		}
+	}
+
+	table->wheel_tick = target_tick;
+	flush_batch(table);
+}
@@ -0,0 +1,120 @@
+/*
+ * subscription.h
+ *
+ * Tabella dei sottoscrittori e timer wheel per la modalità push
+ * Ogni sottoscrizione è identificata da (indirizzo client, città):
+ * il server invia periodicamente un weather_response_t per ogni tipo
+ * sottoscritto finché il lease non scade. I push partono dal socket su cui
+ * è arrivata la sottoscrizione (IPv4 o IPv6), con il trasporto della tabella.
+ */
+
+#ifndef SUBSCRIPTION_H_
+#define SUBSCRIPTION_H_
+
+#if defined WIN32
+#include <winsock.h>
+#else
+#include <netinet/in.h>
+#endif
+
+#include <stdint.h>
+#include "protocol.h"
+#include "endpoints.h"
+#include "transport.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define WHEEL_TICK_MS 10          // Granularità del timer wheel
+#define WHEEL_SLOTS 4096          // 4096 * 10 ms = 40.96 s > SUBSCRIPTION_MAX_INTERVAL_MS
+#define PUSH_BATCH_SIZE 64        // Sottoscrizioni accodate prima di un invio a lotti
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/* Singola sottoscrizione: le liste (wheel e hash) sono indici nell'array */
+typedef struct {
+	endpoint_addr_t addr;       // Indirizzo del sottoscrittore
+	int sock;                   // Socket su cui è arrivata la sottoscrizione
+	int32_t city_index;         // Indice città (find_city_index)
+	uint8_t types;              // Maschera SUB_MASK_*
+	uint8_t in_use;             // 1 se l'elemento è occupato
+	uint32_t interval_ms;       // Intervallo tra due push
+	uint64_t next_due_ms;       // Istante del prossimo push
+	uint64_t lease_expiry_ms;   // Istante di scadenza del lease
+	int32_t wheel_next;         // Successivo nello slot del wheel (o nella free list)
+	int32_t wheel_prev;         // Precedente nello slot del wheel
+	int32_t hash_next;          // Successivo nella catena hash
+} subscription_t;
+
+/* Tabella dei sottoscrittori con indice hash e timer wheel */
+typedef struct {
+	subscription_t *entries;    // Array preallocato di capacity elementi
+	int32_t capacity;
+	int32_t count;              // Sottoscrizioni attive
+	int32_t free_head;          // Testa della free list
+
+	int32_t *buckets;           // Teste delle catene hash
+	uint32_t bucket_mask;       // Numero bucket - 1 (potenza di 2)
+
+	int32_t wheel[WHEEL_SLOTS]; // Teste delle liste per slot
+	uint64_t wheel_tick;        // Ultimo tick elaborato (in unità WHEEL_TICK_MS)
+
+	const transport_t *transport; // Invio dei push (di solito quello del servizio)
+
+	/* Statistiche */
+	uint64_t pushes_sent;       // weather_response_t inviati
+	uint64_t leases_expired;    // Sottoscrizioni rimosse per lease scaduto
+} subscription_table_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Alloca la tabella con la capacità richiesta; i push partiranno da transport
+ * Ritorna 0 in caso di successo, -1 se l'allocazione fallisce
+ */
+int subscription_table_init(subscription_table_t *table, int32_t capacity, const transport_t *transport,
+                            uint64_t now_ms);
+
+/* Libera la memoria della tabella */
+void subscription_table_free(subscription_table_t *table);
+
+/*
+ * Registra, rinnova o annulla (interval_ms = 0 o types = 0) una sottoscrizione
+ * Ritorna STATUS_SUCCESS, STATUS_CITY_NOT_FOUND, STATUS_INVALID_REQUEST
+ * oppure STATUS_SERVER_BUSY se la tabella è piena
+ */
+int subscription_register(subscription_table_t *table, int sock, const endpoint_addr_t *client_addr,
+                          const subscribe_request_t *request, uint64_t now_ms);
+
+/*
+ * Reinserisce una sottoscrizione ereditata (handoff.h) con scadenze e socket
+ * già decisi: solo addr, sock, city_index, types, interval_ms, next_due_ms e
+ * lease_expiry_ms di saved sono usati
+ * Ritorna 0 in caso di successo, -1 se la tabella è piena o è già presente
+ */
+int subscription_restore(subscription_table_t *table, const subscription_t *saved);
+
+/*
+ * Millisecondi mancanti al prossimo tick utile (-1 se non ci sono sottoscrizioni)
+ * Da usare come timeout del ciclo principale
+ */
+int subscription_next_timeout_ms(const subscription_table_t *table, uint64_t now_ms);
+
+/*
+ * Fa avanzare il timer wheel fino a now_ms: invia i push scaduti, ognuno dal
+ * socket della propria sottoscrizione, e rimuove quelle con lease scaduto
+ */
+void subscription_advance(subscription_table_t *table, uint64_t now_ms);
+
+#endif /* SUBSCRIPTION_H_ */
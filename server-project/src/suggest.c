@@ -0,0 +1,377 @@
+/*
+ * suggest.c
+ *
+ * Suggerimenti per le città non trovate
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "suggest.h"
+#include "protocol.h"
+
+#define SUGGEST_STACK 512               // Nodi in attesa di visita (oltre: ricerca parziale)
+#define SUGGEST_MIN_PREFIX 3            // Prefissi più corti danno suggerimenti casuali
+
+static uint8_t lower_table[256];
+
+static void init_lower_table(void) {
+	for (int c = 0; c < 256; c++) {
+		lower_table[c] = (uint8_t)tolower(c);
+	}
+}
+
+/*
+ * Distanza di Levenshtein case-insensitive, algoritmo bit-parallelo di Myers
+ * (variante di Hyyrö per la distanza globale): il nome cercato (< 64 caratteri)
+ * sta in una parola da 64 bit, un carattere dell'altro nome costa ~10 operazioni
+ */
+typedef struct {
+	uint64_t peq[256];              // Bit i del carattere c: pattern[i] == c
+	uint64_t high;                  // Bit dell'ultimo carattere del pattern
+	int length;
+} pattern_t;
+
+/* peq deve essere azzerato (pattern_clear lo riporta a zero) */
+static void pattern_set(pattern_t *pattern, const char *text) {
+	pattern->length = 0;
+	for (const char *c = text; *c; c++) {
+		pattern->peq[lower_table[(uint8_t)*c]] |= 1ULL << pattern->length;
+		pattern->length++;
+	}
+	pattern->high = pattern->length > 0 ? 1ULL << (pattern->length - 1) : 0;
+}
+
+static void pattern_clear(pattern_t *pattern, const char *text) {
+	for (const char *c = text; *c; c++) {
+		pattern->peq[lower_table[(uint8_t)*c]] = 0;
+	}
+}
+
+static int edit_distance(const pattern_t *pattern, const char *text) {
+	if (pattern->length == 0) {
+		return (int)strlen(text);
+	}
+
+	uint64_t pv = ~0ULL;
+	uint64_t mv = 0;
+	int score = pattern->length;
+	for (; *text; text++) {
+		uint64_t eq = pattern->peq[lower_table[(uint8_t)*text]];
+		uint64_t xv = eq | mv;
+		uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+		uint64_t ph = mv | ~(xh | pv);
+		uint64_t mh = pv & xh;
+		if (ph & pattern->high) {
+			score++;
+		} else if (mh & pattern->high) {
+			score--;
+		}
+		ph = (ph << 1) | 1; // Riga 0: distanza dal prefisso vuoto, +1 per colonna
+		mh <<= 1;
+		pv = mh | ~(xv | ph);
+		mv = ph & xv;
+	}
+	return score;
+}
+
+/* Confronto dei primi strlen(prefix) caratteri: 0 se name inizia con prefix */
+static int compare_prefix(const char *name, const char *prefix) {
+	while (*prefix) {
+		int diff = (int)lower_table[(uint8_t)*name] - (int)lower_table[(uint8_t)*prefix];
+		if (diff != 0) {
+			return diff;
+		}
+		name++;
+		prefix++;
+	}
+	return 0;
+}
+
+/* qsort non ha contesto: il catalogo da ordinare è in una variabile di file (solo all'avvio) */
+static const city_catalogue_t *sort_catalogue;
+
+static int compare_cities(const void *a, const void *b) {
+	const char *name_a = sort_catalogue->names[*(const int32_t *)a];
+	const char *name_b = sort_catalogue->names[*(const int32_t *)b];
+	while (*name_a && lower_table[(uint8_t)*name_a] == lower_table[(uint8_t)*name_b]) {
+		name_a++;
+		name_b++;
+	}
+	return (int)lower_table[(uint8_t)*name_a] - (int)lower_table[(uint8_t)*name_b];
+}
+
+int suggest_index_build(suggest_index_t *index, const city_catalogue_t *catalogue) {
+	if (!index || !catalogue) {
+		return -1;
+	}
+
+	memset(index, 0, sizeof(*index));
+	init_lower_table();
+	if (catalogue->count == 0) {
+		return 0;
+	}
+
+	index->nodes = (bk_node_t *)malloc((size_t)catalogue->count * sizeof(bk_node_t));
+	index->sorted = (int32_t *)malloc((size_t)catalogue->count * sizeof(int32_t));
+	// Albero provvisorio a liste di figli, indicizzato per città
+	int32_t *first_child = (int32_t *)malloc((size_t)catalogue->count * sizeof(int32_t));
+	int32_t *next_sibling = (int32_t *)malloc((size_t)catalogue->count * sizeof(int32_t));
+	uint8_t *distances = (uint8_t *)malloc((size_t)catalogue->count);
+	if (!index->nodes || !index->sorted || !first_child || !next_sibling || !distances) {
+		free(first_child);
+		free(next_sibling);
+		free(distances);
+		suggest_index_free(index);
+		return -1;
+	}
+	index->catalogue = catalogue;
+	index->count = catalogue->count;
+
+	// BK-TREE: radice = prima città, ogni altra scende lungo il figlio con la stessa distanza
+	for (int32_t i = 0; i < index->count; i++) {
+		first_child[i] = -1;
+		next_sibling[i] = -1;
+		distances[i] = 0;
+	}
+	static pattern_t pattern; // 2 KiB azzerati, riusati per ogni inserimento
+	for (int32_t i = 1; i < index->count; i++) {
+		int32_t node = 0;
+		pattern_set(&pattern, catalogue->names[i]);
+		while (1) {
+			int distance = edit_distance(&pattern, catalogue->names[node]);
+			if (distance == 0) {
+				break; // Impossibile con il catalogo (nomi unici), ma non va inserito due volte
+			}
+			int32_t child = first_child[node];
+			while (child >= 0 && distances[child] != distance) {
+				child = next_sibling[child];
+			}
+			if (child >= 0) {
+				node = child;
+				continue;
+			}
+			distances[i] = (uint8_t)distance;
+			next_sibling[i] = first_child[node];
+			first_child[node] = i;
+			break;
+		}
+		pattern_clear(&pattern, catalogue->names[i]);
+	}
+
+	// LAYOUT BFS: i figli di ogni nodo diventano contigui e ordinati per distanza
+	index->nodes[0].city = 0;
+	index->nodes[0].distance = 0;
+	int32_t next_free = 1;
+	for (int32_t position = 0; position < next_free; position++) {
+		bk_node_t *node = &index->nodes[position];
+		node->first_child = next_free;
+		node->child_count = 0;
+		for (int32_t child = first_child[node->city]; child >= 0; child = next_sibling[child]) {
+			// Inserimento ordinato tra i figli già copiati (al più CATALOGUE_NAME_SIZE)
+			int32_t j = next_free + node->child_count;
+			while (j > next_free && index->nodes[j - 1].distance > distances[child]) {
+				index->nodes[j] = index->nodes[j - 1];
+				j--;
+			}
+			index->nodes[j].city = child;
+			index->nodes[j].distance = distances[child];
+			node->child_count++;
+		}
+		next_free += node->child_count;
+	}
+	index->count = next_free; // Tutte le città, salvo duplicati
+
+	free(first_child);
+	free(next_sibling);
+	free(distances);
+
+	// POOL DEI NOMI: fratelli adiacenti anche in memoria, niente accessi sparsi al catalogo
+	size_t pool_size = 0;
+	for (int32_t i = 0; i < index->count; i++) {
+		pool_size += strlen(catalogue->names[index->nodes[i].city]) + 1;
+	}
+	index->names = (char *)malloc(pool_size);
+	if (!index->names) {
+		suggest_index_free(index);
+		return -1;
+	}
+	size_t offset = 0;
+	for (int32_t i = 0; i < index->count; i++) {
+		const char *name = catalogue->names[index->nodes[i].city];
+		size_t length = strlen(name) + 1;
+		memcpy(index->names + offset, name, length);
+		index->nodes[i].name_offset = (uint32_t)offset;
+		offset += length;
+	}
+
+	// NOMI ORDINATI PER I PREFISSI
+	for (int32_t i = 0; i < catalogue->count; i++) {
+		index->sorted[i] = i;
+	}
+	sort_catalogue = catalogue;
+	qsort(index->sorted, (size_t)catalogue->count, sizeof(int32_t), compare_cities);
+	sort_catalogue = NULL;
+	return 0;
+}
+
+void suggest_index_free(suggest_index_t *index) {
+	if (!index) {
+		return;
+	}
+	free(index->nodes);
+	free(index->names);
+	free(index->sorted);
+	memset(index, 0, sizeof(*index));
+}
+
+typedef struct {
+	int32_t city;
+	int score;
+} candidate_t;
+
+/* Inserimento ordinato per punteggio (al più max_results elementi, senza duplicati) */
+static void add_candidate(candidate_t *candidates, int *found, int max_results, int32_t city, int score) {
+	for (int i = 0; i < *found; i++) {
+		if (candidates[i].city == city) {
+			if (candidates[i].score <= score) {
+				return;
+			}
+			// Punteggio migliore: rimuove e reinserisce
+			memmove(&candidates[i], &candidates[i + 1], (size_t)(*found - i - 1) * sizeof(candidate_t));
+			(*found)--;
+			break;
+		}
+	}
+
+	int position = *found;
+	while (position > 0 && candidates[position - 1].score > score) {
+		position--;
+	}
+	if (position >= max_results) {
+		return;
+	}
+	int moved = *found < max_results ? *found - position : max_results - 1 - position;
+	memmove(&candidates[position + 1], &candidates[position], (size_t)moved * sizeof(candidate_t));
+	candidates[position].city = city;
+	candidates[position].score = score;
+	if (*found < max_results) {
+		(*found)++;
+	}
+}
+
+/* Distanza massima da accettare: le richieste corte tollerano meno errori */
+static int tolerance_for(size_t length) {
+	if (length < 3) {
+		return 0;
+	}
+	return length < 6 ? 1 : SUGGEST_MAX_DISTANCE;
+}
+
+int suggest_cities(suggest_index_t *index, const char *query, int max_results, int32_t *results) {
+	if (!index || index->count == 0 || !query || !results || max_results <= 0) {
+		return 0;
+	}
+	if (max_results > SUGGEST_MAX_COUNT) {
+		max_results = SUGGEST_MAX_COUNT;
+	}
+
+	uint64_t start_ns = get_monotonic_ns();
+	const uint64_t deadline_ns = start_ns + SUGGEST_BUDGET_NS;
+	const city_catalogue_t *catalogue = index->catalogue;
+	size_t length = strlen(query);
+
+	candidate_t candidates[SUGGEST_MAX_COUNT];
+	int found = 0;
+	int exhausted = 0;
+
+	// PREFISSO: ricerca binaria del primo nome >= query, poi scansione dell'intervallo
+	if (length >= SUGGEST_MIN_PREFIX) {
+		int32_t lo = 0;
+		int32_t hi = catalogue->count;
+		while (lo < hi) {
+			int32_t mid = lo + (hi - lo) / 2;
+			if (compare_prefix(catalogue->names[index->sorted[mid]], query) < 0) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		for (int32_t i = lo; i < catalogue->count && found < max_results; i++) {
+			int32_t city = index->sorted[i];
+			if (compare_prefix(catalogue->names[city], query) != 0) {
+				break;
+			}
+			add_candidate(candidates, &found, max_results, city, 1); // Come un carattere mancante
+		}
+	}
+
+	// BK-TREE: visita in profondità con pila esplicita e budget di nodi e tempo
+	int tolerance = tolerance_for(length);
+	if (tolerance > 0) {
+		pattern_t pattern;
+		memset(pattern.peq, 0, sizeof(pattern.peq));
+		pattern_set(&pattern, query);
+
+		int32_t stack[SUGGEST_STACK];
+		int top = 0;
+		int visits = 0;
+		stack[top++] = 0;
+
+		while (top > 0) {
+			if (visits >= SUGGEST_MAX_VISITS || ((visits & 15) == 15 && get_monotonic_ns() > deadline_ns)) {
+				exhausted = 1;
+				break;
+			}
+			const bk_node_t *node = &index->nodes[stack[--top]];
+			visits++;
+
+			int distance = edit_distance(&pattern, index->names + node->name_offset);
+			// Con la lista piena servono candidati strettamente migliori del peggiore
+			int limit = found == max_results ? candidates[found - 1].score - 1 : tolerance;
+			if (distance <= limit) {
+				add_candidate(candidates, &found, max_results, node->city, distance);
+				limit = found == max_results ? candidates[found - 1].score - 1 : tolerance;
+			}
+
+			// Figli ordinati per distanza: si visita solo l'intervallo [d - limit, d + limit]
+			int32_t lo = node->first_child;
+			int32_t hi = node->first_child + node->child_count;
+			while (lo < hi && (int)index->nodes[lo].distance < distance - limit) {
+				lo++;
+			}
+			while (hi > lo && (int)index->nodes[hi - 1].distance > distance + limit) {
+				hi--;
+			}
+			// Prima in pila i figli più lontani da d: i più promettenti sono visitati per primi
+			for (int gap = limit; gap >= 0; gap--) {
+				for (int32_t child = lo; child < hi; child++) {
+					int child_gap = (int)index->nodes[child].distance - distance;
+					if (child_gap != gap && child_gap != -gap) {
+						continue;
+					}
+					if (top == SUGGEST_STACK) {
+						exhausted = 1;
+						break;
+					}
+					stack[top++] = child;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < found; i++) {
+		results[i] = candidates[i].city;
+	}
+
+	uint64_t elapsed_ns = get_monotonic_ns() - start_ns;
+	index->lookups++;
+	index->lookup_ns_total += elapsed_ns;
+	if (elapsed_ns > index->lookup_ns_max) {
+		index->lookup_ns_max = elapsed_ns;
+	}
+	if (exhausted) {
+		index->budget_exhausted++;
+	}
+	return found;
+}
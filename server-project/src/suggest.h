@@ -0,0 +1,69 @@
+/*
+ * suggest.h
+ *
+ * Suggerimenti per le città non trovate
+ * Due strutture compatte costruite all'avvio sul catalogo:
+ *  - indici delle città ordinati per nome (minuscolo): i nomi che iniziano
+ *    con la richiesta sono un intervallo contiguo, trovato con una ricerca
+ *    binaria ("Mil" -> "Milano")
+ *  - BK-tree sulla distanza di edit: la disuguaglianza triangolare limita la
+ *    visita ai figli con distanza dal padre in [d - k, d + k] ("Milan",
+ *    "Mlano" -> "Milano")
+ * Ogni ricerca ha un budget fisso di nodi visitati e di tempo: con cataloghi
+ * molto grandi il risultato del BK-tree può essere parziale, mai lento.
+ */
+
+#ifndef SUGGEST_H_
+#define SUGGEST_H_
+
+#include <stdint.h>
+#include "catalogue.h"
+
+#define SUGGEST_MAX_DISTANCE 2          // Distanza di edit massima accettata
+#define SUGGEST_MAX_VISITS 4096         // Nodi del BK-tree visitati al più per ricerca
+#define SUGGEST_BUDGET_NS 100000        // Tempo massimo per ricerca (100 µs)
+
+/*
+ * Nodo del BK-tree in ordine BFS: i figli di un nodo sono contigui e
+ * ordinati per distanza, così la visita legge un solo intervallo dell'array
+ */
+typedef struct {
+	int32_t city;                   // Indice della città nel catalogo
+	int32_t first_child;            // Posizione del primo figlio nell'array
+	uint32_t name_offset;           // Nome nel pool (stesso ordine dei nodi)
+	uint8_t child_count;
+	uint8_t distance;               // Distanza di edit dal padre
+} bk_node_t;
+
+typedef struct {
+	const city_catalogue_t *catalogue;
+	int32_t count;
+	bk_node_t *nodes;
+	char *names;                    // Pool dei nomi null-terminated, in ordine BFS
+	int32_t *sorted;                // Indici delle città in ordine di nome
+
+	// Statistiche (stampate all'uscita del server)
+	uint64_t lookups;
+	uint64_t lookup_ns_total;
+	uint64_t lookup_ns_max;
+	uint64_t budget_exhausted;      // Ricerche interrotte dal budget
+} suggest_index_t;
+
+/*
+ * Costruisce l'indice sulle città del catalogo (che non deve cambiare dopo)
+ * Ritorna 0 in caso di successo, -1 se la memoria non basta
+ */
+int suggest_index_build(suggest_index_t *index, const city_catalogue_t *catalogue);
+
+/*
+ * Libera l'indice
+ */
+void suggest_index_free(suggest_index_t *index);
+
+/*
+ * Fino a max_results città con nome simile a query, dalla più vicina
+ * Ritorna il numero di indici scritti in results
+ */
+int suggest_cities(suggest_index_t *index, const char *query, int max_results, int32_t *results);
+
+#endif /* SUGGEST_H_ */
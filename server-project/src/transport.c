@@ -0,0 +1,193 @@
+/*
+ * transport.c
+ *
+ * Trasporto sui socket del server
+ *
+ * - Un datagramma: sendto() verso l'indirizzo del client
+ * - Un lotto (Linux): sendmmsg(); un messaggio a più segmenti viaggia in un
+ *   unico "super datagramma" con UDP GSO (UDP_SEGMENT) e il kernel lo divide
+ *   in segmenti da segment_size byte. Se il kernel o la scheda rifiutano GSO
+ *   il trasporto lo spegne e da lì invia un datagramma per segmento
+ * - Altrove un sendto() per segmento
+ */
+
+#if defined __linux__
+#define _GNU_SOURCE // sendmmsg()
+#endif
+
+#if defined WIN32
+#include <winsock.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+
+#if defined __linux__
+#include <sys/uio.h>
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#endif
+
+#include <string.h>
+#include "transport.h"
+
+#if defined __linux__
+/*
+ * Descrittori per sendmmsg(): un elemento è un messaggio intero con GSO
+ * oppure un suo segmento; segment_size > 0 solo per gli elementi con GSO
+ */
+static struct mmsghdr batch_msgs[TRANSPORT_BATCH_MAX];
+static struct iovec batch_iovs[TRANSPORT_BATCH_MAX];
+static int batch_segment_size[TRANSPORT_BATCH_MAX];
+static union {
+	struct cmsghdr align;
+	char buf[CMSG_SPACE(sizeof(uint16_t))];
+} batch_controls[TRANSPORT_BATCH_MAX];
+#endif
+
+void transport_socket_init(transport_t *transport, transport_socket_t *state) {
+	memset(state, 0, sizeof(*state));
+#if defined __linux__
+	state->gso_enabled = 1; // Verificato al primo invio: disattivato se il kernel lo rifiuta
+#endif
+	transport->send = transport_socket_send;
+	transport->send_batch = transport_socket_send_batch;
+	transport->context = state;
+}
+
+int transport_socket_send(void *context, int sock, const uint8_t *data, int length,
+                          const endpoint_addr_t *addr, int addr_len) {
+	(void)context;
+	// DIFFERENZA CHIAVE: sendto() invece di send()
+	// Usa indirizzo client acquisito da recvfrom()
+	return sendto(sock, (const char *)data, length, 0, (const struct sockaddr *)addr, addr_len);
+}
+
+/* Un datagramma per segmento (tutto data se segment_size è 0) */
+static void send_segmented(const transport_t *transport, int sock, const uint8_t *data, int length,
+                           int segment_size, const endpoint_addr_t *addr) {
+	int step = segment_size > 0 ? segment_size : length;
+	for (int offset = 0; offset < length; offset += step) {
+		int part = length - offset < step ? length - offset : step;
+		transport->send(transport->context, sock, data + offset, part, addr, endpoint_addr_size(addr));
+	}
+}
+
+int transport_send_batch(const transport_t *transport, int sock, const transport_message_t *messages, int count) {
+	if (!transport || !messages || count <= 0) {
+		return 0;
+	}
+	if (transport->send_batch) {
+		return transport->send_batch(transport->context, sock, messages, count);
+	}
+	for (int i = 0; i < count; i++) {
+		send_segmented(transport, sock, messages[i].data, messages[i].length, messages[i].segment_size,
+		               messages[i].addr);
+	}
+	return count;
+}
+
+#if defined __linux__
+/* Aggiunge un elemento ai descrittori, con GSO se segment_size > 0 */
+static void batch_add(int slot, const uint8_t *data, int length, int segment_size, const endpoint_addr_t *addr) {
+	struct msghdr *hdr = &batch_msgs[slot].msg_hdr;
+	memset(hdr, 0, sizeof(*hdr));
+	batch_iovs[slot].iov_base = (void *)data;
+	batch_iovs[slot].iov_len = (size_t)length;
+	hdr->msg_name = (void *)addr;
+	hdr->msg_namelen = (socklen_t)endpoint_addr_size(addr);
+	hdr->msg_iov = &batch_iovs[slot];
+	hdr->msg_iovlen = 1;
+	batch_segment_size[slot] = segment_size;
+
+	// GSO: il kernel divide il payload in segmenti da segment_size byte
+	if (segment_size > 0) {
+		hdr->msg_control = batch_controls[slot].buf;
+		hdr->msg_controllen = sizeof(batch_controls[slot].buf);
+		struct cmsghdr *cm = CMSG_FIRSTHDR(hdr);
+		cm->cmsg_level = SOL_UDP;
+		cm->cmsg_type = UDP_SEGMENT;
+		cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+		uint16_t gso_size = (uint16_t)segment_size;
+		memcpy(CMSG_DATA(cm), &gso_size, sizeof(gso_size));
+	}
+}
+
+/* Invia i primi count descrittori */
+static void batch_flush(transport_socket_t *state, int sock, int count) {
+	static const transport_t plain = { transport_socket_send, NULL, NULL };
+	int sent = 0;
+	while (sent < count) {
+		int rc = sendmmsg(sock, &batch_msgs[sent], (unsigned int)(count - sent), 0);
+		if (rc > 0) {
+			sent += rc;
+			continue;
+		}
+		if (rc < 0 && errno == EINTR) {
+			continue;
+		}
+
+		// L'elemento "sent" è stato rifiutato con GSO perché il kernel (o la
+		// scheda) non lo supporta: GSO spento, il resto del lotto un segmento
+		// per datagramma. Errori transitori (ENOBUFS, EAGAIN) lasciano GSO attivo
+		if (batch_segment_size[sent] > 0 && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP)) {
+			state->gso_enabled = 0;
+			for (int i = sent; i < count; i++) {
+				const struct msghdr *hdr = &batch_msgs[i].msg_hdr;
+				send_segmented(&plain, sock, (const uint8_t *)hdr->msg_iov->iov_base, (int)hdr->msg_iov->iov_len,
+				               batch_segment_size[i], (const endpoint_addr_t *)hdr->msg_name);
+			}
+			return;
+		}
+		sent++; // Scarta il datagramma (UDP: nessuna garanzia di consegna)
+	}
+}
+#endif
+
+int transport_socket_send_batch(void *context, int sock, const transport_message_t *messages, int count) {
+	transport_socket_t *state = (transport_socket_t *)context;
+
+#if defined __linux__
+	// LOTTI: GSO per i messaggi a più segmenti, altrimenti un elemento per segmento
+	int used = 0;
+	for (int i = 0; i < count; i++) {
+		const transport_message_t *message = &messages[i];
+		int segment_size = message->segment_size > 0 ? message->segment_size : message->length;
+		int gso = state->gso_enabled && message->length > segment_size;
+
+		for (int offset = 0; offset < message->length; offset += segment_size) {
+			if (used == TRANSPORT_BATCH_MAX) {
+				batch_flush(state, sock, used);
+				used = 0;
+			}
+			if (gso) {
+				batch_add(used++, message->data, message->length, segment_size, message->addr);
+				break;
+			}
+			int part = message->length - offset < segment_size ? message->length - offset : segment_size;
+			batch_add(used++, message->data + offset, part, 0, message->addr);
+		}
+	}
+	if (used > 0) {
+		batch_flush(state, sock, used);
+	}
+#else
+	static const transport_t plain = { transport_socket_send, NULL, NULL };
+	(void)state;
+	for (int i = 0; i < count; i++) {
+		send_segmented(&plain, sock, messages[i].data, messages[i].length, messages[i].segment_size,
+		               messages[i].addr);
+	}
+#endif
+
+	return count;
+}
@@ -0,0 +1,91 @@
+/*
+ * transport.h
+ *
+ * Invio dei datagrammi del server, separato dai moduli che li producono:
+ * risposte (service.c), push delle sottoscrizioni (subscription.c) e
+ * snapshot multicast (publisher.c) passano tutti da un transport_t.
+ * Sui socket (transport.c) l'invio singolo è sendto() e quello a lotti
+ * sendmmsg() con UDP GSO; la simulazione di rete (bench/netsim.c) fornisce
+ * solo send e riceve i lotti un segmento alla volta.
+ */
+
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include <stdint.h>
+#include "endpoints.h"
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define TRANSPORT_BATCH_MAX 64          // Datagrammi per sendmmsg() al più
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+/*
+ * Messaggio di un lotto: con segment_size > 0 data è una sequenza di
+ * segmenti da segment_size byte, ciascuno un datagramma per addr
+ */
+typedef struct {
+	const uint8_t *data;
+	int length;
+	int segment_size;
+	const endpoint_addr_t *addr;
+} transport_message_t;
+
+/* Invio di un datagramma: ritorna i byte inviati, -1 in caso di errore */
+typedef int (*transport_send_fn)(void *context, int sock, const uint8_t *data, int length,
+                                 const endpoint_addr_t *addr, int addr_len);
+
+/* Invio di un lotto dallo stesso socket: ritorna i messaggi elaborati */
+typedef int (*transport_send_batch_fn)(void *context, int sock, const transport_message_t *messages, int count);
+
+typedef struct {
+	transport_send_fn send;
+	transport_send_batch_fn send_batch; // NULL: un send per segmento
+	void *context;
+} transport_t;
+
+/* Stato del trasporto sui socket */
+typedef struct {
+	int gso_enabled;                    // UDP GSO accettato dal kernel (Linux)
+} transport_socket_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Trasporto sui socket con stato in state
+ * I lotti usano descrittori statici: send_batch solo dal thread del loop
+ */
+void transport_socket_init(transport_t *transport, transport_socket_t *state);
+
+/*
+ * Trasporto sui socket: sendto() verso addr
+ */
+int transport_socket_send(void *context, int sock, const uint8_t *data, int length,
+                          const endpoint_addr_t *addr, int addr_len);
+
+/*
+ * Trasporto sui socket: sendmmsg() a gruppi di TRANSPORT_BATCH_MAX, GSO per i
+ * messaggi a più segmenti finché il kernel lo accetta
+ */
+int transport_socket_send_batch(void *context, int sock, const transport_message_t *messages, int count);
+
+/*
+ * Invio di un lotto con transport: send_batch se presente, altrimenti un
+ * send per segmento
+ */
+int transport_send_batch(const transport_t *transport, int sock, const transport_message_t *messages, int count);
+
+#endif /* TRANSPORT_H_ */
@@ -0,0 +1,457 @@
+/*
+ * xdp_filter.c
+ *
+ * Filtro XDP: programma eBPF assemblato qui, caricato con la syscall bpf()
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "protocol.h"
+#include "xdp_filter.h"
+
+#if defined __linux__
+
+#include <errno.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/if_link.h>
+
+#define XDP_MAX_INSNS 256
+#define XDP_MAX_LABELS 64
+#define XDP_LOG_SIZE 65536
+
+/*
+ * ============================================================================
+ * ASSEMBLATORE
+ * ============================================================================
+ * Istruzioni in un array, salti verso etichette risolti alla fine
+ */
+
+typedef struct {
+	struct bpf_insn insns[XDP_MAX_INSNS];
+	int count;
+	int label_pos[XDP_MAX_LABELS];
+	int label_count;
+	int jump_label[XDP_MAX_INSNS];   // Etichetta di destinazione del salto (-1 = nessuna)
+	int overflow;
+} xdp_program_t;
+
+static void emit(xdp_program_t *p, uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm) {
+	if (p->count >= XDP_MAX_INSNS) {
+		p->overflow = 1;
+		return;
+	}
+	struct bpf_insn *insn = &p->insns[p->count];
+	memset(insn, 0, sizeof(*insn));
+	insn->code = code;
+	insn->dst_reg = dst;
+	insn->src_reg = src;
+	insn->off = off;
+	insn->imm = imm;
+	p->jump_label[p->count] = -1;
+	p->count++;
+}
+
+static int new_label(xdp_program_t *p) {
+	if (p->label_count >= XDP_MAX_LABELS) {
+		p->overflow = 1;
+		return 0;
+	}
+	p->label_pos[p->label_count] = -1;
+	return p->label_count++;
+}
+
+static void place_label(xdp_program_t *p, int label) {
+	p->label_pos[label] = p->count;
+}
+
+/* Salto condizionale (op BPF_JEQ, BPF_JNE, BPF_JGT...) con immediato */
+static void jump_imm(xdp_program_t *p, uint8_t op, uint8_t dst, int32_t imm, int label) {
+	emit(p, BPF_JMP | op | BPF_K, dst, 0, 0, imm);
+	if (!p->overflow) {
+		p->jump_label[p->count - 1] = label;
+	}
+}
+
+/* Salto condizionale tra due registri */
+static void jump_reg(xdp_program_t *p, uint8_t op, uint8_t dst, uint8_t src, int label) {
+	emit(p, BPF_JMP | op | BPF_X, dst, src, 0, 0);
+	if (!p->overflow) {
+		p->jump_label[p->count - 1] = label;
+	}
+}
+
+static void jump(xdp_program_t *p, int label) {
+	emit(p, BPF_JMP | BPF_JA, 0, 0, 0, 0);
+	if (!p->overflow) {
+		p->jump_label[p->count - 1] = label;
+	}
+}
+
+static void load_map_fd(xdp_program_t *p, uint8_t dst, int map_fd) {
+	emit(p, BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, map_fd);
+	emit(p, 0, 0, 0, 0, 0); // Seconda metà dell'immediato a 64 bit
+}
+
+static int resolve_labels(xdp_program_t *p) {
+	for (int i = 0; i < p->count; i++) {
+		int label = p->jump_label[i];
+		if (label < 0) {
+			continue;
+		}
+		if (p->label_pos[label] < 0) {
+			return -1;
+		}
+		p->insns[i].off = (int16_t)(p->label_pos[label] - (i + 1));
+	}
+	return p->overflow ? -1 : 0;
+}
+
+/* Incrementa il contatore index della mappa per CPU (r0-r5 sovrascritti) */
+static void emit_count(xdp_program_t *p, int counters_fd, int32_t index) {
+	int done = new_label(p);
+	emit(p, BPF_ST | BPF_W | BPF_MEM, BPF_REG_10, 0, -32, index);
+	load_map_fd(p, BPF_REG_1, counters_fd);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -32);
+	emit(p, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem);
+	jump_imm(p, BPF_JEQ, BPF_REG_0, 0, done);
+	emit(p, BPF_LDX | BPF_DW | BPF_MEM, BPF_REG_1, BPF_REG_0, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_1, 0, 0, 1);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_0, BPF_REG_1, 0, 0);
+	place_label(p, done);
+}
+
+static void emit_return(xdp_program_t *p, int32_t verdict) {
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, verdict);
+	emit(p, BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+}
+
+/*
+ * Programma del filtro
+ * Offset fissi: Ethernet (14) + IPv4 senza opzioni (20) + UDP (8) = 42 byte
+ * Stack: chiave sorgente a -4, valore (finestra, conteggio) a -24, indice contatore a -32
+ */
+static int build_program(xdp_program_t *p, const uint16_t *ports, int port_count, uint32_t rate_limit,
+                         int counters_fd, int sources_fd) {
+	static const int32_t sizes[] = { (int32_t)REQUEST_SIZE, (int32_t)SUGGEST_REQUEST_SIZE, (int32_t)SUBSCRIBE_SIZE,
+	                                 (int32_t)AGGREGATE_REQUEST_SIZE, (int32_t)NEAREST_REQUEST_SIZE };
+	memset(p, 0, sizeof(*p));
+	int pass = new_label(p);
+	int port_ok = new_label(p);
+	int size_ok = new_label(p);
+	int new_source = new_label(p);
+	int reset = new_label(p);
+	int accept = new_label(p);
+	int over = new_label(p);
+
+	// INTESTAZIONI: r2 = data, r3 = data_end
+	emit(p, BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_1, (int16_t)offsetof(struct xdp_md, data), 0);
+	emit(p, BPF_LDX | BPF_W | BPF_MEM, BPF_REG_3, BPF_REG_1, (int16_t)offsetof(struct xdp_md, data_end), 0);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_4, BPF_REG_2, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_4, 0, 0, 42);
+	jump_reg(p, BPF_JGT, BPF_REG_4, BPF_REG_3, pass);
+
+	// IPv4 (ethertype 0x0800 letto in little endian), senza opzioni, UDP, non frammentato
+	emit(p, BPF_LDX | BPF_H | BPF_MEM, BPF_REG_4, BPF_REG_2, 12, 0);
+	jump_imm(p, BPF_JNE, BPF_REG_4, 0x0008, pass);
+	emit(p, BPF_LDX | BPF_B | BPF_MEM, BPF_REG_4, BPF_REG_2, 14, 0);
+	jump_imm(p, BPF_JNE, BPF_REG_4, 0x45, pass);
+	emit(p, BPF_LDX | BPF_B | BPF_MEM, BPF_REG_4, BPF_REG_2, 23, 0);
+	jump_imm(p, BPF_JNE, BPF_REG_4, 17, pass);
+	emit(p, BPF_LDX | BPF_H | BPF_MEM, BPF_REG_4, BPF_REG_2, 20, 0);
+	emit(p, BPF_ALU64 | BPF_AND | BPF_K, BPF_REG_4, 0, 0, 0xFF3F); // MF e offset, in network order
+	jump_imm(p, BPF_JNE, BPF_REG_4, 0, pass);
+
+	// PORTA DI DESTINAZIONE: una delle porte del server
+	emit(p, BPF_LDX | BPF_H | BPF_MEM, BPF_REG_4, BPF_REG_2, 36, 0);
+	for (int i = 0; i < port_count; i++) {
+		uint16_t network_port = (uint16_t)((ports[i] >> 8) | (ports[i] << 8));
+		jump_imm(p, BPF_JEQ, BPF_REG_4, network_port, port_ok);
+	}
+	jump(p, pass);
+	place_label(p, port_ok);
+
+	// DIMENSIONE: r7 = lunghezza UDP - 8, r6 = indirizzo sorgente
+	emit(p, BPF_LDX | BPF_H | BPF_MEM, BPF_REG_7, BPF_REG_2, 38, 0);
+	emit(p, BPF_ALU | BPF_END | BPF_TO_BE, BPF_REG_7, 0, 0, 16);
+	emit(p, BPF_ALU64 | BPF_SUB | BPF_K, BPF_REG_7, 0, 0, 8);
+	emit(p, BPF_LDX | BPF_W | BPF_MEM, BPF_REG_6, BPF_REG_2, 26, 0);
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		jump_imm(p, BPF_JEQ, BPF_REG_7, sizes[i], size_ok);
+	}
+	emit_count(p, counters_fd, XDP_COUNTER_DROPPED_SIZE);
+	emit_return(p, XDP_DROP);
+	place_label(p, size_ok);
+
+	// FREQUENZA: finestra di un secondo per sorgente
+	emit(p, BPF_STX | BPF_W | BPF_MEM, BPF_REG_10, BPF_REG_6, -4, 0);
+	load_map_fd(p, BPF_REG_1, sources_fd);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4);
+	emit(p, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem);
+	jump_imm(p, BPF_JEQ, BPF_REG_0, 0, new_source);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0);
+	emit(p, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_ktime_get_ns);
+	emit(p, BPF_LDX | BPF_DW | BPF_MEM, BPF_REG_1, BPF_REG_8, 0, 0);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_0, 0, 0);
+	emit(p, BPF_ALU64 | BPF_SUB | BPF_X, BPF_REG_2, BPF_REG_1, 0, 0);
+	jump_imm(p, BPF_JGT, BPF_REG_2, 1000000000, reset);
+	emit(p, BPF_LDX | BPF_DW | BPF_MEM, BPF_REG_1, BPF_REG_8, 8, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_1, 0, 0, 1);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_8, BPF_REG_1, 8, 0);
+	jump_imm(p, BPF_JGT, BPF_REG_1, (int32_t)rate_limit, over);
+	jump(p, accept);
+
+	place_label(p, reset);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_8, BPF_REG_0, 0, 0);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, 1);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_8, BPF_REG_1, 8, 0);
+	jump(p, accept);
+
+	place_label(p, new_source);
+	emit(p, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_ktime_get_ns);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_10, BPF_REG_0, -24, 0);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, 1);
+	emit(p, BPF_STX | BPF_DW | BPF_MEM, BPF_REG_10, BPF_REG_1, -16, 0);
+	load_map_fd(p, BPF_REG_1, sources_fd);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_3, BPF_REG_10, 0, 0);
+	emit(p, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_3, 0, 0, -24);
+	emit(p, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_4, 0, 0, BPF_ANY);
+	emit(p, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_update_elem);
+
+	// VERDETTI
+	place_label(p, accept);
+	emit_count(p, counters_fd, XDP_COUNTER_PASSED);
+	emit_return(p, XDP_PASS);
+
+	place_label(p, over);
+	emit_count(p, counters_fd, XDP_COUNTER_DROPPED_RATE);
+	emit_return(p, XDP_DROP);
+
+	place_label(p, pass);
+	emit_return(p, XDP_PASS);
+
+	return resolve_labels(p);
+}
+
+/*
+ * ============================================================================
+ * CARICAMENTO
+ * ============================================================================
+ */
+
+static long sys_bpf(int cmd, union bpf_attr *attr) {
+	return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int create_map(uint32_t type, uint32_t key_size, uint32_t value_size, uint32_t entries, const char *name) {
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.map_type = type;
+	attr.key_size = key_size;
+	attr.value_size = value_size;
+	attr.max_entries = entries;
+	strncpy(attr.map_name, name, sizeof(attr.map_name) - 1);
+	int fd = (int)sys_bpf(BPF_MAP_CREATE, &attr);
+	if (fd < 0) {
+		fprintf(stderr, "Errore: creazione della mappa BPF %s fallita (%s).\n", name, strerror(errno));
+	}
+	return fd;
+}
+
+/* CPU possibili: dimensione dei valori delle mappe per CPU */
+static int possible_cpus(void) {
+	FILE *file = fopen("/sys/devices/system/cpu/possible", "r");
+	int first = 0;
+	int last = -1;
+	if (file) {
+		if (fscanf(file, "%d-%d", &first, &last) == 1) {
+			last = first;
+		}
+		fclose(file);
+	}
+	if (last < 0) {
+		long configured = sysconf(_SC_NPROCESSORS_CONF);
+		return configured > 0 ? (int)configured : 1;
+	}
+	return last + 1;
+}
+
+static void close_fd(int *fd) {
+	if (*fd >= 0) {
+		close(*fd);
+		*fd = -1;
+	}
+}
+
+static void release(xdp_filter_t *filter) {
+	close_fd(&filter->link_fd);
+	close_fd(&filter->prog_fd);
+	close_fd(&filter->counters_fd);
+	close_fd(&filter->sources_fd);
+	filter->enabled = 0;
+}
+
+int xdp_filter_attach(xdp_filter_t *filter, const char *ifname, const uint16_t *ports, int port_count,
+                      uint32_t rate_limit, int inherited_link) {
+	if (!filter) {
+		return -1;
+	}
+	memset(filter, 0, sizeof(*filter));
+	filter->prog_fd = -1;
+	filter->link_fd = -1;
+	filter->counters_fd = -1;
+	filter->sources_fd = -1;
+	if (!ifname || port_count <= 0 || port_count > XDP_MAX_PORTS || rate_limit == 0 || rate_limit > INT32_MAX) {
+		return -1;
+	}
+	strncpy(filter->ifname, ifname, sizeof(filter->ifname) - 1);
+	filter->rate_limit = rate_limit;
+	filter->ifindex = (int)if_nametoindex(ifname);
+	if (filter->ifindex == 0) {
+		fprintf(stderr, "Errore: interfaccia %s non trovata.\n", ifname);
+		return -1;
+	}
+
+	// MAPPE: contatori per CPU, finestre per sorgente
+	filter->counters_fd = create_map(BPF_MAP_TYPE_PERCPU_ARRAY, sizeof(uint32_t), sizeof(uint64_t), XDP_COUNTERS,
+	                                 "weather_count");
+	filter->sources_fd = create_map(BPF_MAP_TYPE_LRU_HASH, sizeof(uint32_t), 2 * sizeof(uint64_t), XDP_SOURCES,
+	                                "weather_rate");
+	if (filter->counters_fd < 0 || filter->sources_fd < 0) {
+		release(filter);
+		return -1;
+	}
+
+	// PROGRAMMA
+	static xdp_program_t program;
+	if (build_program(&program, ports, port_count, rate_limit, filter->counters_fd, filter->sources_fd) != 0) {
+		fprintf(stderr, "Errore: assemblaggio del programma XDP fallito.\n");
+		release(filter);
+		return -1;
+	}
+	char *log = (char *)malloc(XDP_LOG_SIZE);
+	union bpf_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.expected_attach_type = BPF_XDP;
+	attr.insns = (uint64_t)(uintptr_t)program.insns;
+	attr.insn_cnt = (uint32_t)program.count;
+	attr.license = (uint64_t)(uintptr_t)"GPL";
+	strncpy(attr.prog_name, "weather_xdp", sizeof(attr.prog_name) - 1);
+	if (log) {
+		log[0] = '\0';
+		attr.log_buf = (uint64_t)(uintptr_t)log;
+		attr.log_size = XDP_LOG_SIZE;
+		attr.log_level = 1;
+	}
+	filter->prog_fd = (int)sys_bpf(BPF_PROG_LOAD, &attr);
+	if (filter->prog_fd < 0) {
+		fprintf(stderr, "Errore: caricamento del programma XDP fallito (%s).\n%s", strerror(errno), log ? log : "");
+		free(log);
+		release(filter);
+		return -1;
+	}
+	free(log);
+
+	// AGGANCIO: sostituzione atomica del programma del predecessore, altrimenti un nuovo collegamento
+	memset(&attr, 0, sizeof(attr));
+	if (inherited_link >= 0) {
+		attr.link_update.link_fd = (uint32_t)inherited_link;
+		attr.link_update.new_prog_fd = (uint32_t)filter->prog_fd;
+		if (sys_bpf(BPF_LINK_UPDATE, &attr) == 0) {
+			filter->link_fd = inherited_link;
+		} else {
+			fprintf(stderr, "Attenzione: programma XDP ereditato non sostituibile (%s).\n", strerror(errno));
+			close(inherited_link);
+			memset(&attr, 0, sizeof(attr));
+		}
+	}
+	if (filter->link_fd < 0) {
+		attr.link_create.prog_fd = (uint32_t)filter->prog_fd;
+		attr.link_create.target_ifindex = (uint32_t)filter->ifindex;
+		attr.link_create.attach_type = BPF_XDP;
+		attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+		filter->link_fd = (int)sys_bpf(BPF_LINK_CREATE, &attr);
+	}
+	if (filter->link_fd < 0) {
+		fprintf(stderr, "Errore: aggancio XDP a %s fallito (%s).\n", ifname, strerror(errno));
+		release(filter);
+		return -1;
+	}
+
+	filter->enabled = 1;
+	return 0;
+}
+
+int xdp_filter_read(const xdp_filter_t *filter, xdp_counters_t *counters) {
+	if (!filter || !filter->enabled || !counters) {
+		return -1;
+	}
+	memset(counters, 0, sizeof(*counters));
+	int cpus = possible_cpus();
+	uint64_t *values = (uint64_t *)calloc((size_t)cpus, sizeof(uint64_t));
+	if (!values) {
+		return -1;
+	}
+
+	uint64_t totals[XDP_COUNTERS];
+	for (uint32_t key = 0; key < XDP_COUNTERS; key++) {
+		union bpf_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.map_fd = (uint32_t)filter->counters_fd;
+		attr.key = (uint64_t)(uintptr_t)&key;
+		attr.value = (uint64_t)(uintptr_t)values;
+		totals[key] = 0;
+		if (sys_bpf(BPF_MAP_LOOKUP_ELEM, &attr) != 0) {
+			free(values);
+			return -1;
+		}
+		for (int cpu = 0; cpu < cpus; cpu++) {
+			totals[key] += values[cpu];
+		}
+	}
+	free(values);
+
+	counters->passed = totals[XDP_COUNTER_PASSED];
+	counters->dropped_size = totals[XDP_COUNTER_DROPPED_SIZE];
+	counters->dropped_rate = totals[XDP_COUNTER_DROPPED_RATE];
+	return 0;
+}
+
+void xdp_filter_detach(xdp_filter_t *filter) {
+	if (!filter || !filter->enabled) {
+		return;
+	}
+	release(filter);
+}
+
+#else /* !__linux__ */
+
+int xdp_filter_attach(xdp_filter_t *filter, const char *ifname, const uint16_t *ports, int port_count,
+                      uint32_t rate_limit, int inherited_link) {
+	(void)ifname; (void)ports; (void)port_count; (void)rate_limit; (void)inherited_link;
+	if (filter) {
+		memset(filter, 0, sizeof(*filter));
+	}
+	fprintf(stderr, "Errore: filtro XDP disponibile solo su Linux.\n");
+	return -1;
+}
+
+int xdp_filter_read(const xdp_filter_t *filter, xdp_counters_t *counters) {
+	(void)filter; (void)counters;
+	return -1;
+}
+
+void xdp_filter_detach(xdp_filter_t *filter) {
+	(void)filter;
+}
+
+#endif /* __linux__ */
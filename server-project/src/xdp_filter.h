@@ -0,0 +1,90 @@
+/*
+ * xdp_filter.h
+ *
+ * Filtro XDP davanti ai socket del server (-X)
+ * Un programma eBPF, assemblato e caricato dal server senza toolchain
+ * esterne, esamina ogni frame in ingresso sull'interfaccia prima dello
+ * stack di rete. Per i datagrammi UDP/IPv4 diretti alle porte del server:
+ *  - dimensione del payload diversa da quelle del protocollo: scartato
+ *  - oltre rate_limit datagrammi al secondo dalla stessa sorgente: scartato
+ *    (finestra fissa di un secondo per indirizzo, mappa LRU)
+ *  - altrimenti prosegue verso il socket come prima
+ * Il resto del traffico (altre porte, IPv6, frammenti, opzioni IP) passa
+ * senza controlli. I contatori sono una mappa per CPU letta dal server.
+ *
+ * Modalità generica (XDP_FLAGS_SKB_MODE): funziona su ogni interfaccia,
+ * veth e loopback comprese. Richiede CAP_BPF e CAP_NET_ADMIN.
+ * Disponibile solo su Linux.
+ */
+
+#ifndef XDP_FILTER_H_
+#define XDP_FILTER_H_
+
+#include <stdint.h>
+
+/*
+ * ============================================================================
+ * COSTANTI
+ * ============================================================================
+ */
+
+#define XDP_DEFAULT_RATE 5000           // Datagrammi al secondo per sorgente
+#define XDP_MAX_PORTS 17                // Porte di servizio filtrate (ENDPOINT_MAX + prioritaria)
+#define XDP_SOURCES 65536               // Sorgenti ricordate dalla mappa LRU
+#define XDP_IFNAME_SIZE 16              // IF_NAMESIZE
+
+#define XDP_COUNTER_PASSED 0            // Datagrammi del server lasciati passare
+#define XDP_COUNTER_DROPPED_SIZE 1      // Scartati per dimensione
+#define XDP_COUNTER_DROPPED_RATE 2      // Scartati per frequenza della sorgente
+#define XDP_COUNTERS 3
+
+/*
+ * ============================================================================
+ * STRUTTURE DATI
+ * ============================================================================
+ */
+
+typedef struct {
+	int enabled;
+	char ifname[XDP_IFNAME_SIZE];
+	int ifindex;
+	uint32_t rate_limit;
+	int prog_fd;
+	int link_fd;                    // Chiuderlo stacca il programma (se nessun altro lo tiene)
+	int counters_fd;                // BPF_MAP_TYPE_PERCPU_ARRAY, XDP_COUNTERS elementi
+	int sources_fd;                 // BPF_MAP_TYPE_LRU_HASH: indirizzo -> finestra e conteggio
+} xdp_filter_t;
+
+typedef struct {
+	uint64_t passed;
+	uint64_t dropped_size;
+	uint64_t dropped_rate;
+} xdp_counters_t;
+
+/*
+ * ============================================================================
+ * FUNZIONI
+ * ============================================================================
+ */
+
+/*
+ * Carica il programma per le porte indicate (host byte order) e lo aggancia
+ * all'interfaccia; inherited_link è il collegamento di un predecessore
+ * (handoff.h), sostituito in modo atomico, oppure -1
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int xdp_filter_attach(xdp_filter_t *filter, const char *ifname, const uint16_t *ports, int port_count,
+                      uint32_t rate_limit, int inherited_link);
+
+/*
+ * Somma i contatori di tutte le CPU
+ * Ritorna 0 in caso di successo, -1 in caso di errore
+ */
+int xdp_filter_read(const xdp_filter_t *filter, xdp_counters_t *counters);
+
+/*
+ * Stacca il programma e chiude le mappe
+ */
+void xdp_filter_detach(xdp_filter_t *filter);
+
+#endif /* XDP_FILTER_H_ */